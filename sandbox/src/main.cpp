@@ -1,6 +1,6 @@
 #include "entry.h"
 
-int main()
+int main(int argc, char** argv)
 {
     std::cout << "Hello Sogas!\n";
     SFATAL("This is a test %d right %s?", 45, "Pau");
@@ -9,5 +9,5 @@ int main()
     SDEBUG("This is a test %d right %s?", 45, "Pau");
     STRACE("This is a test %d right %s?", 45, "Pau");
 
-    return Sogas::GameEntry();
+    return Sogas::GameEntry(argc, argv);
 }
\ No newline at end of file
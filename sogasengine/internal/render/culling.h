@@ -0,0 +1,43 @@
+#pragma once
+
+#include <functional>
+
+namespace Sogas
+{
+// Bounds stored as structure of arrays, so several boxes are tested per instruction.
+struct CullingBounds
+{
+    std::vector<f32> CenterX;
+    std::vector<f32> CenterY;
+    std::vector<f32> CenterZ;
+    std::vector<f32> HalfX;
+    std::vector<f32> HalfY;
+    std::vector<f32> HalfZ;
+
+    void Resize(u32 count);
+    void Set(u32 index, const AABB& aabb);
+    // Box that is never culled, for objects without bounds.
+    void SetInfinite(u32 index);
+    u32  Size() const { return static_cast<u32>(CenterX.size()); }
+};
+
+// Tests boxes [begin, end) against the 6 planes (pointing inside) and writes 1 in visible for the ones touching the frustum.
+// Groups of 8 boxes are tested at once with AVX when the cpu supports it, 4 with SSE. Returns the number of visible boxes.
+u32 CullAABBs(const glm::vec4* planes, const CullingBounds& bounds, u32 begin, u32 end, u8* visible);
+
+// Instruction set picked by CullAABBs on this cpu, for reports.
+const char* GetCullingInstructionSet();
+
+u32 CullAABBsScalar(const glm::vec4* planes, const CullingBounds& bounds, u32 begin, u32 end, u8* visible);
+
+// Splits the boxes in batches across the thread pool. When given, gather fills the bounds of each batch right before it is tested.
+u32 CullAABBsParallel(const glm::vec4*                               planes,
+                      const CullingBounds&                           bounds,
+                      u32                                            count,
+                      u8*                                            visible,
+                      const std::function<void(u32 begin, u32 end)>& gather = nullptr);
+
+// Times scalar, SIMD and multithreaded culling of nObjects random boxes.
+void BenchmarkFrustumCulling(u32 nObjects = 100000);
+
+} // namespace Sogas
@@ -2,39 +2,146 @@
 
 #include "commandbuffer.h"
 #include "handle/handle.h"
+#include "render/culling.h"
 #include "render_types.h"
+#include <functional>
 
 namespace Sogas
 {
 class CMesh;
 class Material;
 
+namespace Renderer
+{
+class GPU_device;
+}
+
 class CRenderManager
 {
   public:
     struct Key
     {
+        u64             SortKey;
         const CMesh*    Mesh;
         const Material* Material;
         CHandle         Owner;
         CHandle         Transform;
         CHandle         AABB;
+        u16             Pipeline; // Sorting group only, the forward pipeline draws every key with one gpu pipeline.
+        u16             MaterialId;
+        u16             MeshId;
+        u16             Depth;
+        DrawChannel     Channel;
 
         bool RenderInMenu();
     };
 
+    // Per instance vertex stream, matches the instance attributes of the forward shader.
+    struct InstanceData
+    {
+        glm::mat4 Model;
+        glm::vec4 Color;
+    };
+
+    struct Stats
+    {
+        u32 DrawCalls[static_cast<u32>(DrawChannel::COUNT)]    = {};
+        u32 Instances[static_cast<u32>(DrawChannel::COUNT)]    = {};
+        u32 StateChanges[static_cast<u32>(DrawChannel::COUNT)] = {};
+        u32 Sorts                                              = 0;
+        u32 Culled                                             = 0;
+        f32 RecordMs                                           = 0.0f; // Cpu time recording the draws of the frame.
+        u32 RecordThreads                                      = 0;
+    };
+
     using VKeys = std::vector<Key>;
 
     CRenderManager();
 
-    void AddKey(CHandle owner, const CMesh* mesh, const Material* InMaterial);
-    //void RenderAll(CHandle camera, Renderer::DrawChannel channel, Renderer::CommandBuffer cmd);
+    void AddKey(CHandle owner, const CMesh* mesh, const Material* InMaterial, DrawChannel channel = DrawChannel::SOLID, u16 pipeline = 0);
     void DeleteKeysFromOwner(CHandle owner);
 
+    // Refreshes depths from the eye, sorts if anything changed, culls against the frustum planes
+    // and counts the state changes of the frame.
+    void PrepareFrame(const glm::vec3& eye, const glm::vec4* frustumPlanes);
+
+    // Writes the instances of every visible key in draw order. Consecutive keys sharing pipeline, mesh and material
+    // become a single instanced batch. Returns the number of instances written.
+    u32 BuildInstances(InstanceData* instances, u32 maxInstances, f32 alpha);
+    // Draws the batches of the channel, the instance buffer must be bound by the caller.
+    void RenderAll(DrawChannel channel, Renderer::CommandBuffer* cmd);
+    // Threads worth recording the channel with, 1 when there are too few batches to split.
+    u32 GetRecordingThreads(DrawChannel channel, u32 maxThreads) const;
+    // Splits the batches of the channel in one secondary command buffer per thread, recorded by the thread pool and
+    // executed from cmd. The pass must be bound for secondaries, bindState sets the pipeline, descriptors, instance
+    // buffer and dynamic state of each secondary.
+    void RenderAllParallel(DrawChannel channel, Renderer::GPU_device* device, Renderer::CommandBuffer* cmd, u32 nThreads,
+                           const std::function<void(Renderer::CommandBuffer*)>& bindState);
+
+    // Visible keys of the channel in draw order. Valid until keys are added or removed.
+    template <typename TFn>
+    void ForEachKey(DrawChannel channel, TFn fn) const
+    {
+        const auto& range = VisibleRanges[static_cast<u32>(channel)];
+        for (u32 i = range.first; i < range.second; ++i)
+        {
+            const Key& key = keys[VisibleKeys[i]];
+            if (key.Mesh)
+            {
+                fn(key);
+            }
+        }
+    }
+
+    const Stats& GetStats() const { return FrameStats; }
+    u32          GetVisibleCount() const { return static_cast<u32>(VisibleKeys.size()); }
+
   private:
-    std::vector<u32> DrawCallsPerChannel;
-    VKeys            keys;
-    bool             KeysAreDirty = false;
+    struct OwnerRange
+    {
+        u32 First;
+        u32 Count;
+    };
+
+    struct DrawBatch
+    {
+        const CMesh*    Mesh;
+        const Material* Material;
+        u32             FirstInstance;
+        u32             InstanceCount;
+    };
+
+    u16  GetResourceId(const void* resource);
+    u64  ComputeSortKey(const Key& key) const;
+    void Compact();
+    void Sort();
+    void Cull(const glm::vec4* frustumPlanes);
+    void RecordBatches(u32 first, u32 last, Renderer::CommandBuffer* cmd) const;
+
+    VKeys                                keys;
+    bool                                 KeysAreDirty = false;
+    u32                                  nDeadKeys    = 0;
+    std::unordered_map<u32, OwnerRange>  OwnerRanges;
+    std::unordered_map<const void*, u16> ResourceIds;
+
+    // Sorted indices into keys, plus scratch buffers for the radix sort.
+    std::vector<u32>                 SortedKeys;
+    std::vector<std::pair<u64, u32>> SortBuffer;
+    std::vector<std::pair<u64, u32>> SortScratch;
+    std::pair<u32, u32>              ChannelRanges[static_cast<u32>(DrawChannel::COUNT)] = {};
+
+    // Culling results, in sorted order and compacted per channel.
+    CullingBounds       Bounds;
+    std::vector<u8>     Visible;
+    std::vector<u32>    VisibleKeys;
+    std::pair<u32, u32> VisibleRanges[static_cast<u32>(DrawChannel::COUNT)] = {};
+
+    std::vector<DrawBatch> Batches;
+    std::pair<u32, u32>    BatchRanges[static_cast<u32>(DrawChannel::COUNT)] = {};
+
+    std::vector<Renderer::CommandBuffer*> Secondaries;
+
+    Stats FrameStats;
 };
 
 extern CRenderManager RenderManager;
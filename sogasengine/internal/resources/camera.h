@@ -23,12 +23,17 @@ namespace Sogas
 
         bool bIsOrthogonal;
 
+        // Normalized, pointing inside: left, right, bottom, top, near, far.
+        glm::vec4 frustumPlanes[6];
+
     public:
         const glm::mat4 GetView() const { return view; }
         const glm::mat4 GetProjection() const { return projection; }
         const glm::mat4 GetViewProjection() const { return view_projection; }
+        const glm::vec4* GetFrustumPlanes() const { return frustumPlanes; }
 
         void updateViewProjection();
+        void updateFrustumPlanes();
         void lookAt(const glm::vec3 eye, const glm::vec3 target, const glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f));
         void setProjectionParams(const f32 fovDeg, const f32 aspectRatio, const f32 near, const f32 far);
         // TODO setOrthogonalParams
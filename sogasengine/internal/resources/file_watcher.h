@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+namespace Sogas
+{
+    /** Watches files from a background thread. Uses inotify on Linux and polls the modification times elsewhere.
+        A change is reported once the file stays untouched for a moment, editors saving in several writes trigger a
+        single reload. */
+    class CFileWatcher
+    {
+    public:
+        ~CFileWatcher() { Stop(); }
+
+        /** Files must be added before Start. */
+        void Watch(const std::string& filename);
+
+        void Start();
+        void Stop();
+
+        /** Returns the watched files modified since the last call. */
+        std::vector<std::string> PollChanges();
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        void WatchLoop();
+        void MarkChanged(const std::string& filename);
+
+        std::vector<std::string> Files; // Canonical paths.
+        std::unordered_map<std::string, Clock::time_point> Changed; // Last time each modified file was touched.
+        std::mutex Mutex;
+        std::thread Thread;
+        std::atomic<bool> bStopping{false};
+    };
+
+} // Sogas
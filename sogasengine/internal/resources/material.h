@@ -5,19 +5,39 @@
 
 namespace Sogas
 {
+namespace Renderer
+{
+class CommandBuffer;
+}
+
 class Texture;
 class Material : public IResource
 {
+  public:
+    // Bindless indices of the textures, pushed as constants. Matches the MaterialConstants block of the shaders.
+    struct Constants
+    {
+        u32 albedo             = 0;
+        u32 normal             = 0;
+        u32 metallic_roughness = 0;
+        u32 emissive           = 0;
+    };
+
+  private:
     const Texture* albedo             = nullptr;
     const Texture* normal             = nullptr;
     const Texture* metallic_roughness = nullptr;
     const Texture* emissive           = nullptr;
 
+    Constants constants;
+    bool      bindless = false; // Constants are only pushed when the device has a bindless heap.
+
   public:
     bool CreateFromJson(const json& j);
 
     void Destroy() override;
 
-    //void Activate(Renderer::CommandBuffer cmd) const;
+    // Pushes the texture indices, the bound pipeline must declare the material constants when bindless is supported.
+    void Activate(Renderer::CommandBuffer* cmd) const;
 };
 } // namespace Sogas
@@ -13,18 +13,22 @@ class CMesh : public IResource
   public:
     bool Create(std::vector<VertexLayout> vertices, std::vector<u32> indices, PrimitiveTopology topology);
 
-    // void Activate(CommandBuffer cmd) const;
-    // void Render(CommandBuffer cmd) const;
+    void Activate(CommandBuffer* cmd) const;
+    void Render(CommandBuffer* cmd, u32 instanceCount = 1, u32 firstInstance = 0) const;
 
     void Destroy();
 
+    // Local space bounds, computed from the vertices on creation.
+    const AABB& GetAABB() const { return aabb; }
+
     u32 vertexCount  = 0;
     u32 vertexOffset = 0;
     u32 indexCount   = 0;
     u32 indexOffset  = 0;
 
-    //std::shared_ptr<Buffer> vertexBuffer;
-    //std::shared_ptr<Buffer> indexBuffer;
+    // Interleaved VertexLayout, bound at binding 0.
+    BufferHandle vertexBuffer = INVALID_BUFFER;
+    BufferHandle indexBuffer  = INVALID_BUFFER;
     PrimitiveTopology Topology = PrimitiveTopology::UNDEFINED;
     bool              Indexed  = false;
 
@@ -35,7 +39,7 @@ class CMesh : public IResource
     std::string               name;
     std::vector<VertexLayout> vertices;
     std::vector<u32>          indices;
-    // AABB
+    AABB                      aabb;
     // Mesh group
 };
 } // namespace Sogas
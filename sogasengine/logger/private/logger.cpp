@@ -1,50 +1,421 @@
 #include "logger.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
 #include <windows.h>
+#include <io.h>
+#define LOG_ISATTY(file) _isatty(_fileno(file))
+#else
+#include <unistd.h>
+#define LOG_ISATTY(file) isatty(fileno(file))
+#endif
 
 #define LOG_BUFFER_SIZE 1024 * 8
+#define LOG_RING_SIZE 1024 * 64
 
-void FormatString(char* out, const char* format, ...)
+namespace
 {
-    char buffer[LOG_BUFFER_SIZE];
-    va_list args;
-    va_start(args, format);
-    int32_t written = vsnprintf(buffer, LOG_BUFFER_SIZE, format, args);
-    va_end(args);
+    // Records are stored contiguously, aligned to the header size so a padding
+    // header always fits at the end of the ring.
+    struct RecordHeader
+    {
+        uint32_t size;
+        uint32_t level;
+        uint64_t sequence;
+    };
+
+    static_assert(sizeof(RecordHeader) == 16, "Record header expected to be 16 bytes.");
+
+    const uint32_t PaddingRecord = 0xFFFFFFFF;
+
+    // Single producer (owning thread), single consumer (writer thread).
+    struct ThreadRing
+    {
+        static const uint64_t Capacity = LOG_RING_SIZE;
+        static const uint64_t Mask = Capacity - 1;
+
+        alignas(16) char data[Capacity];
+        std::atomic<uint64_t> head{0};
+        std::atomic<uint64_t> tail{0};
+    };
+
+    struct PendingRecord
+    {
+        uint64_t sequence;
+        uint32_t level;
+        std::string text;
+    };
+
+    struct Logger
+    {
+        std::atomic<int> level{LOG_LEVEL_TRACE};
+        std::atomic<uint32_t> sinks{LOG_SINK_STDOUT};
+        std::atomic<uint64_t> nextSequence{0};
+        std::atomic<uint64_t> writtenSequence{0};
+        std::atomic<bool> running{false};
+        std::atomic<bool> stopped{false};
+
+        std::mutex ringsMutex;
+        std::vector<std::unique_ptr<ThreadRing>> rings;
+
+        std::mutex wakeMutex;
+        std::condition_variable wake;
+        std::condition_variable flushed;
+
+        std::mutex fileMutex;
+        std::ofstream file;
+
+        std::thread writer;
+        bool colors = false;
+    };
+
+    Logger& GetLogger()
+    {
+        // Never destroyed so messages logged from static destructors are still safe.
+        static Logger* logger = new Logger();
+        return *logger;
+    }
+
+    thread_local ThreadRing* localRing = nullptr;
+
+    const char* LogTypes[6] = {"[FATAL]: ", "[ERROR]: ", "[WARNING]: ", "[INFO]: ", "[DEBUG]: ", "[TRACE]: "};
+    const char* LogColors[6] = {"\x1b[41;97m", "\x1b[31m", "\x1b[33m", "\x1b[36m", "\x1b[32m", "\x1b[97m"};
+
+    void WriteToSinks(Logger& logger, uint32_t level, const char* text, size_t length)
+    {
+        const uint32_t sinks = logger.sinks.load(std::memory_order_relaxed);
+
+        if(sinks & LOG_SINK_STDOUT)
+        {
+            if(logger.colors)
+            {
+                fputs(LogColors[level], stdout);
+                fwrite(text, 1, length, stdout);
+                fputs("\x1b[0m", stdout);
+            }
+            else
+            {
+                fwrite(text, 1, length, stdout);
+            }
+        }
+
+        if(sinks & LOG_SINK_FILE)
+        {
+            std::lock_guard<std::mutex> lock(logger.fileMutex);
+            if(logger.file.is_open())
+                logger.file.write(text, static_cast<std::streamsize>(length));
+        }
+    }
+
+    // Collects every record available, returns false if there was nothing to write.
+    bool Drain(Logger& logger, std::vector<PendingRecord>& pending, std::vector<std::pair<ThreadRing*, uint64_t>>& tails)
+    {
+        pending.clear();
+        tails.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(logger.ringsMutex);
+            for(auto& ring : logger.rings)
+            {
+                uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+                const uint64_t head = ring->head.load(std::memory_order_acquire);
+
+                while(tail < head)
+                {
+                    const char* record = ring->data + (tail & ThreadRing::Mask);
+                    RecordHeader header;
+                    memcpy(&header, record, sizeof(header));
+
+                    if(header.level != PaddingRecord)
+                        pending.push_back({header.sequence, header.level, std::string(record + sizeof(header))});
+
+                    tail += header.size;
+                }
+
+                tails.push_back({ring.get(), tail});
+            }
+        }
+
+        // Tails are released once written, an empty ring means its messages reached the sinks.
+        auto releaseTails = [&tails]() {
+            for(auto& tail : tails)
+                tail.first->tail.store(tail.second, std::memory_order_release);
+        };
+
+        if(pending.empty())
+        {
+            releaseTails();
+            return false;
+        }
+
+        // Each ring is ordered, the sequence restores the order between threads.
+        std::sort(pending.begin(), pending.end(), [](const PendingRecord& a, const PendingRecord& b) { return a.sequence < b.sequence; });
+
+        for(const auto& record : pending)
+            WriteToSinks(logger, record.level, record.text.data(), record.text.size());
+
+        fflush(stdout);
+        {
+            std::lock_guard<std::mutex> lock(logger.fileMutex);
+            if(logger.file.is_open())
+                logger.file.flush();
+        }
+
+        releaseTails();
+        logger.writtenSequence.store(pending.back().sequence + 1, std::memory_order_release);
+        return true;
+    }
+
+    void WriterLoop()
+    {
+        Logger& logger = GetLogger();
+        std::vector<PendingRecord> pending;
+        std::vector<std::pair<ThreadRing*, uint64_t>> tails;
+
+        while(logger.running.load(std::memory_order_acquire))
+        {
+            {
+                std::unique_lock<std::mutex> lock(logger.wakeMutex);
+                logger.wake.wait_for(lock, std::chrono::milliseconds(10));
+            }
+
+            if(Drain(logger, pending, tails))
+                logger.flushed.notify_all();
+        }
+
+        Drain(logger, pending, tails);
+        logger.flushed.notify_all();
+    }
+
+    void StartWriter(Logger& logger)
+    {
+        std::lock_guard<std::mutex> lock(logger.ringsMutex);
+        if(logger.running.load(std::memory_order_acquire) || logger.stopped.load(std::memory_order_acquire))
+            return;
+
+        logger.colors = LOG_ISATTY(stdout) != 0;
+
+#ifdef _WIN32
+        // Colors are written as ANSI escape codes, the console needs to be told to process them.
+        HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+        DWORD mode = 0;
+        if(logger.colors && GetConsoleMode(console, &mode))
+            SetConsoleMode(console, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+#endif
+        logger.running.store(true, std::memory_order_release);
+        logger.writer = std::thread(WriterLoop);
+        std::atexit(ShutdownLog);
+    }
+
+    ThreadRing* GetThreadRing(Logger& logger)
+    {
+        if(!localRing)
+        {
+            std::lock_guard<std::mutex> lock(logger.ringsMutex);
+            logger.rings.push_back(std::make_unique<ThreadRing>());
+            localRing = logger.rings.back().get();
+        }
+        return localRing;
+    }
+
+    // Waits for the writer when the ring is full, the caller never drops messages.
+    void WaitForSpace(Logger& logger, ThreadRing* ring, uint64_t end)
+    {
+        while(end - ring->tail.load(std::memory_order_acquire) > ThreadRing::Capacity)
+        {
+            logger.wake.notify_one();
+            std::this_thread::yield();
+        }
+    }
+
+    void Push(Logger& logger, uint32_t level, const char* text, size_t length)
+    {
+        ThreadRing* ring = GetThreadRing(logger);
+
+        const uint64_t size = (sizeof(RecordHeader) + length + 1 + 15) & ~uint64_t(15);
+        uint64_t head = ring->head.load(std::memory_order_relaxed);
+
+        const uint64_t offset = head & ThreadRing::Mask;
+        if(offset + size > ThreadRing::Capacity)
+        {
+            // Not enough contiguous space, skip the end of the ring.
+            const uint64_t padding = ThreadRing::Capacity - offset;
+            WaitForSpace(logger, ring, head + padding);
+
+            RecordHeader header = {static_cast<uint32_t>(padding), PaddingRecord, 0};
+            memcpy(ring->data + offset, &header, sizeof(header));
+            head += padding;
+        }
+
+        WaitForSpace(logger, ring, head + size);
 
-    memcpy(out, buffer, written);
+        RecordHeader header = {static_cast<uint32_t>(size), level, logger.nextSequence.fetch_add(1, std::memory_order_relaxed)};
+        char* record = ring->data + (head & ThreadRing::Mask);
+        memcpy(record, &header, sizeof(header));
+        memcpy(record + sizeof(header), text, length);
+        record[sizeof(header) + length] = '\0';
 
+        ring->head.store(head + size, std::memory_order_release);
+    }
+
+    void VLogMessage(LogLevel level, const char* message, va_list args)
+    {
+        Logger& logger = GetLogger();
+
+        char buffer[LOG_BUFFER_SIZE];
+        const size_t prefixLength = strlen(LogTypes[level]);
+        memcpy(buffer, LogTypes[level], prefixLength);
+
+        int written = vsnprintf(buffer + prefixLength, LOG_BUFFER_SIZE - prefixLength - 1, message, args);
+        size_t length = prefixLength + (written < 0 ? 0 : std::min<size_t>(static_cast<size_t>(written), LOG_BUFFER_SIZE - prefixLength - 2));
+        buffer[length++] = '\n';
+        buffer[length] = '\0';
+
+        if(!logger.running.load(std::memory_order_acquire))
+        {
+            StartWriter(logger);
+
+            // Shut down already, write synchronously.
+            if(!logger.running.load(std::memory_order_acquire))
+            {
+                WriteToSinks(logger, level, buffer, length);
+                return;
+            }
+        }
+
+        Push(logger, level, buffer, length);
+
+        if(level <= LOG_LEVEL_ERROR)
+            FlushLog();
+    }
 }
 
 void LogMessage(LogLevel level, const char* message, ...)
 {
-    const char* LogTypes[5] = {"[FATAL]: ", "[ERROR]: ", "[WARNING]: ", "[DEBUG]: ", "[TRACE]: "};
+    if(static_cast<int>(level) > GetLogger().level.load(std::memory_order_relaxed))
+        return;
 
     va_list args;
     va_start(args, message);
-    char buffer[LOG_BUFFER_SIZE];
-    memset(buffer, 0, LOG_BUFFER_SIZE);
-    vsnprintf(buffer, sizeof(buffer), message, args);
+    VLogMessage(level, message, args);
     va_end(args);
-
-    FormatString(buffer, "%s%s\n", LogTypes[level], buffer);
-
-    HANDLE hndl = GetStdHandle(STD_OUTPUT_HANDLE);
-    static uint8_t levels[5] = {64, 4, 6, 2, 15};
-    SetConsoleTextAttribute(hndl, levels[level]);
-    uint64_t length = strlen(buffer);
-    LPDWORD nWritten = 0;
-    WriteConsoleA(GetStdHandle(STD_OUTPUT_HANDLE), buffer, (DWORD)length, nWritten, NULL);
 }
 
 void ReportAssert(const char* expr, const char* message, const char* file, int32_t line, ...)
 {
     va_list args;
-    va_start(args, message);
+    va_start(args, line);
     char buffer[LOG_BUFFER_SIZE];
-    memset(buffer, 0, LOG_BUFFER_SIZE);
     vsnprintf(buffer, sizeof(buffer), message, args);
     va_end(args);
 
     LogMessage(LOG_LEVEL_FATAL, "Assertion failed: '%s'.\n Message: '%s', in file '%s', line '%d'.", expr, buffer, file, line);
 }
+
+void SetLogLevel(LogLevel level)
+{
+    GetLogger().level.store(level, std::memory_order_relaxed);
+}
+
+LogLevel GetLogLevel()
+{
+    return static_cast<LogLevel>(GetLogger().level.load(std::memory_order_relaxed));
+}
+
+void SetLogSinks(uint32_t sinks)
+{
+    GetLogger().sinks.store(sinks, std::memory_order_relaxed);
+}
+
+bool SetLogFile(const char* filename)
+{
+    Logger& logger = GetLogger();
+    {
+        std::lock_guard<std::mutex> lock(logger.fileMutex);
+        if(logger.file.is_open())
+            logger.file.close();
+
+        logger.file.open(filename, std::ios::out | std::ios::trunc);
+        if(!logger.file.is_open())
+            return false;
+    }
+
+    logger.sinks.fetch_or(LOG_SINK_FILE, std::memory_order_relaxed);
+    return true;
+}
+
+void FlushLog()
+{
+    Logger& logger = GetLogger();
+    if(!logger.running.load(std::memory_order_acquire))
+        return;
+
+    const uint64_t target = logger.nextSequence.load(std::memory_order_relaxed);
+    const uint64_t localHead = localRing ? localRing->head.load(std::memory_order_relaxed) : 0;
+
+    auto isFlushed = [&]() {
+        return logger.writtenSequence.load(std::memory_order_acquire) >= target
+            && (!localRing || localRing->tail.load(std::memory_order_acquire) >= localHead);
+    };
+
+    std::unique_lock<std::mutex> lock(logger.wakeMutex);
+    logger.wake.notify_one();
+    while(!isFlushed() && logger.running.load(std::memory_order_acquire))
+        logger.flushed.wait_for(lock, std::chrono::milliseconds(1));
+}
+
+void ShutdownLog()
+{
+    Logger& logger = GetLogger();
+
+    {
+        std::lock_guard<std::mutex> lock(logger.ringsMutex);
+        logger.stopped.store(true, std::memory_order_release);
+        if(!logger.running.exchange(false))
+            return;
+    }
+
+    logger.wake.notify_one();
+    if(logger.writer.joinable())
+        logger.writer.join();
+
+    std::lock_guard<std::mutex> lock(logger.fileMutex);
+    if(logger.file.is_open())
+        logger.file.close();
+}
+
+double MeasureLogOverhead(uint32_t iterations)
+{
+    Logger& logger = GetLogger();
+
+    const uint32_t previousSinks = logger.sinks.exchange(0);
+    const LogLevel previousLevel = GetLogLevel();
+    SetLogLevel(LOG_LEVEL_TRACE);
+
+    const auto start = std::chrono::steady_clock::now();
+    for(uint32_t i = 0; i < iterations; ++i)
+        LogMessage(LOG_LEVEL_TRACE, "Measuring log overhead %d, %s, %f.", i, "string argument", 3.14);
+    const auto end = std::chrono::steady_clock::now();
+
+    FlushLog();
+    SetLogLevel(previousLevel);
+    logger.sinks.store(previousSinks);
+
+    const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return iterations ? ns / iterations : 0.0;
+}
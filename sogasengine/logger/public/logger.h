@@ -5,34 +5,71 @@
 
 #define LOG_WARN_ENABLED true
 #define LOG_ERROR_ENABLED true
-#define LOG_ERROR_ENABLED true
+#define LOG_INFO_ENABLED true
 
 #ifdef NDEBUG
     #define LOG_DEBUG_ENABLED false
-    #define LOG_DEBUG_TRACE false
+    #define LOG_TRACE_ENABLED false
 #else
     #define LOG_DEBUG_ENABLED true
-    #define LOG_DEBUG_TRACE true
+    #define LOG_TRACE_ENABLED true
 #endif
 
-enum LogLevel 
+enum LogLevel
 {
     LOG_LEVEL_FATAL = 0,
     LOG_LEVEL_ERROR = 1,
     LOG_LEVEL_WARNING = 2,
-    LOG_LEVEL_DEBUG = 3,
-    LOG_LEVEL_TRACE = 4
+    LOG_LEVEL_INFO = 3,
+    LOG_LEVEL_DEBUG = 4,
+    LOG_LEVEL_TRACE = 5
+};
+
+enum LogSink
+{
+    LOG_SINK_STDOUT = 1 << 0,
+    LOG_SINK_FILE = 1 << 1
 };
 
+// Messages are formatted by the caller into a per thread buffer and written by a background thread.
 void LogMessage(LogLevel level, const char* message, ...);
 
 void ReportAssert(const char* expr, const char* message, const char* file, int32_t line, ...);
 
+// Messages above this level are discarded before being formatted.
+void SetLogLevel(LogLevel level);
+LogLevel GetLogLevel();
+
+// Combination of LogSink flags.
+void SetLogSinks(uint32_t sinks);
+// Opens the file and enables the file sink.
+bool SetLogFile(const char* filename);
+
+// Blocks until every message logged so far has been written.
+void FlushLog();
+void ShutdownLog();
+
+// Average cost in nanoseconds of a LogMessage call on the calling thread, sinks disabled.
+double MeasureLogOverhead(uint32_t iterations);
+
 #define SFATAL(message, ...) LogMessage(LOG_LEVEL_FATAL, message, ##__VA_ARGS__);
 #define SERROR(message, ...) LogMessage(LOG_LEVEL_ERROR, message, ##__VA_ARGS__);
 #define SWARNING(message, ...) LogMessage(LOG_LEVEL_WARNING, message, ##__VA_ARGS__);
-#define SDEBUG(message, ...) LogMessage(LOG_LEVEL_DEBUG, message, ##__VA_ARGS__);
-#define STRACE(message, ...) LogMessage(LOG_LEVEL_TRACE, message, ##__VA_ARGS__);
+// Results meant for the user, statistics and benchmark timings. Kept in release builds.
+#define SINFO(message, ...) LogMessage(LOG_LEVEL_INFO, message, ##__VA_ARGS__);
+
+// Disabled levels are compiled out, arguments are kept referenced so they don't trigger unused warnings.
+#if LOG_DEBUG_ENABLED
+    #define SDEBUG(message, ...) LogMessage(LOG_LEVEL_DEBUG, message, ##__VA_ARGS__);
+#else
+    #define SDEBUG(message, ...) do { if(false) LogMessage(LOG_LEVEL_DEBUG, message, ##__VA_ARGS__); } while(0);
+#endif
+
+#if LOG_TRACE_ENABLED
+    #define STRACE(message, ...) LogMessage(LOG_LEVEL_TRACE, message, ##__VA_ARGS__);
+#else
+    #define STRACE(message, ...) do { if(false) LogMessage(LOG_LEVEL_TRACE, message, ##__VA_ARGS__); } while(0);
+#endif
 
 // ASSERTS
 
@@ -1,5 +1,11 @@
 #include "application.h"
+#include "components/name_component.h"
 #include "engine.h"
+#include "render/culling.h"
+#include "render/module_render.h"
+
+#include <chrono>
+#include <cstdlib>
 
 namespace Sogas
 {
@@ -11,6 +17,44 @@ namespace Sogas
         bQuitting = false;
     }
 
+    void CApplication::ParseCommandLine(int argc, char** argv)
+    {
+        for(int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            if(arg == "--headless")
+            {
+                bHeadless = true;
+            }
+            else if(arg == "--null-device")
+            {
+                bHeadless = true;
+                bNullDevice = true;
+            }
+            else if(arg == "--pipeline-statistics")
+            {
+                bPipelineStatistics = true;
+            }
+            else if(arg == "--frames" && i + 1 < argc)
+            {
+                HeadlessFrames = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+            }
+            else if(arg == "--capture" && i + 1 < argc)
+            {
+                CapturePath = argv[++i];
+            }
+            else if(arg == "--bench" && i + 1 < argc)
+            {
+                bHeadless = true;
+                Benchmarks.push_back(argv[++i]);
+            }
+            else
+            {
+                SWARNING("Unknown argument %s.", argv[i]);
+            }
+        }
+    }
+
     // This should read a json configuration file
     bool CApplication::Init()
     {
@@ -26,6 +70,12 @@ namespace Sogas
 
     void CApplication::InitInstance()
     {
+        if(bHeadless)
+        {
+            STRACE("Headless application, no window is created.");
+            return;
+        }
+
         // Open Window ...
         STRACE("Initializing application instance ...");
         STRACE("\tInitializing GLFW ... ");
@@ -34,23 +84,135 @@ namespace Sogas
 
         STRACE("\tCreating a GLFW window ...");
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-        window = glfwCreateWindow(640, 480, "SogasEngine", nullptr, nullptr);
+        window = glfwCreateWindow(Width, Height, "SogasEngine", nullptr, nullptr);
         STRACE("\tGLFW window created.");
         STRACE("Application instance initialized.\n");
     }
 
     void CApplication::Run()
     {
+        if(!Benchmarks.empty())
+        {
+            RunBenchmarks();
+            return;
+        }
+
+        if(bHeadless)
+        {
+            RunHeadless();
+            return;
+        }
+
         while(!glfwWindowShouldClose(window)){
             glfwPollEvents();
             CEngine::Get()->DoFrame();
         }
     }
 
+    static void ReportMemoryStats(const char* label, const Renderer::GPUMemoryStats& stats)
+    {
+        // Share of the free block memory a single allocation can't use.
+        const u64 free_bytes = stats.reserved_bytes - stats.used_bytes;
+        const f64 fragmentation = free_bytes > 0 ? 1.0 - static_cast<f64>(stats.largest_free_range) / static_cast<f64>(free_bytes) : 0.0;
+
+        SINFO("\t%s: %d blocks, %d KB reserved, %d KB used, largest free range %d KB, %.1f%% fragmented.", label, stats.block_count,
+              static_cast<u32>(stats.reserved_bytes / 1024), static_cast<u32>(stats.used_bytes / 1024), static_cast<u32>(stats.largest_free_range / 1024), fragmentation * 100.0);
+    }
+
+    void CApplication::RunHeadless()
+    {
+        STRACE("Rendering %d headless frames ...", HeadlessFrames);
+
+        auto device = CEngine::Get()->GetRenderModule()->GetGraphicsDevice();
+
+        f64 total_ms = 0.0;
+        f64 peak_ms = 0.0;
+        f64 gpu_total_ms = 0.0;
+        u32 gpu_frames = 0;
+        for(u32 i = 0; i < HeadlessFrames; ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            CEngine::Get()->DoFrame();
+            const f64 frame_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            // Timings of the last frame the gpu finished, a few frames behind this one.
+            f64 gpu_ms = 0.0;
+            for(const Renderer::GPUZoneTiming& zone : device->GetGpuTimings())
+            {
+                gpu_ms = std::max(gpu_ms, zone.start_ms + zone.duration_ms);
+            }
+
+            STRACE("\tFrame %d: %.3f ms, gpu %.3f ms", i, frame_ms, gpu_ms);
+            total_ms += frame_ms;
+            peak_ms = std::max(peak_ms, frame_ms);
+            if(gpu_ms > 0.0)
+            {
+                gpu_total_ms += gpu_ms;
+                ++gpu_frames;
+            }
+        }
+
+        if(HeadlessFrames > 0)
+        {
+            SINFO("Cpu frame time: %.3f ms average, %.3f ms peak.", total_ms / HeadlessFrames, peak_ms);
+        }
+
+        if(gpu_frames > 0)
+        {
+            SINFO("Gpu frame time: %.3f ms average.", gpu_total_ms / gpu_frames);
+        }
+
+        for(const Renderer::GPUZoneTiming& zone : device->GetGpuTimings())
+        {
+            if(!zone.bStatistics)
+                continue;
+
+            const u64* stats = zone.statistics;
+            SINFO("\t%s: %.3f ms, %llu vertices, %llu primitives, %llu vertex and %llu fragment invocations.", zone.name, zone.duration_ms,
+                  static_cast<unsigned long long>(stats[static_cast<u32>(Renderer::PipelineStatistic::INPUT_VERTICES)]),
+                  static_cast<unsigned long long>(stats[static_cast<u32>(Renderer::PipelineStatistic::INPUT_PRIMITIVES)]),
+                  static_cast<unsigned long long>(stats[static_cast<u32>(Renderer::PipelineStatistic::VERTEX_INVOCATIONS)]),
+                  static_cast<unsigned long long>(stats[static_cast<u32>(Renderer::PipelineStatistic::FRAGMENT_INVOCATIONS)]));
+        }
+
+        // Loading is done, compacting the blocks is what a level transition would do.
+        const Renderer::GPUMemoryStats before = device->GetMemoryStats();
+        const u32 moves = device->Defragment(256);
+        const Renderer::GPUMemoryStats after = device->GetMemoryStats();
+        SINFO("Defragmentation moved %d allocations:", moves);
+        ReportMemoryStats("before", before);
+        ReportMemoryStats("after", after);
+
+        if(!CapturePath.empty() && !CEngine::Get()->GetRenderModule()->CaptureFrame(CapturePath))
+        {
+            SERROR("Failed to capture the last frame to %s.", CapturePath.c_str());
+        }
+    }
+
+    void CApplication::RunBenchmarks()
+    {
+        for(const std::string& name : Benchmarks)
+        {
+            STRACE("Running benchmark %s ...", name.c_str());
+            if(name == "names")
+                BenchmarkNameLookup();
+            else if(name == "culling")
+                BenchmarkFrustumCulling();
+            else if(name == "log")
+            {
+                SINFO("Log overhead: %.1f ns per message.", MeasureLogOverhead(100000));
+            }
+            else
+                SWARNING("Unknown benchmark %s.", name.c_str());
+        }
+    }
+
     void CApplication::Shutdown()
     {
         STRACE("Shutting down ... ");
         CEngine::Get()->Shutdown();
+        if(bHeadless)
+            return;
         STRACE("Terminating GLFW ... ");
         glfwDestroyWindow(window);
         glfwTerminate();
@@ -0,0 +1,52 @@
+#include "aabb_component.h"
+#include "render_component.h"
+#include "transform_component.h"
+#include "resources/mesh.h"
+
+namespace Sogas
+{
+    DECL_OBJ_MANAGER("aabb", TCompAABB);
+
+    void TCompAABB::Load(const json& j)
+    {
+        if(j.is_object() && j.count("half_size"))
+        {
+            local.center = LoadVec3(j, "center");
+            local.halfSize = LoadVec3(j, "half_size");
+            bFromRender = false;
+        }
+    }
+
+    void TCompAABB::OnEntityCreated()
+    {
+        if(bFromRender)
+        {
+            TCompRender* render = Get<TCompRender>();
+            if(render)
+            {
+                bool bFirst = true;
+                for(const auto& dc : render->DrawCalls)
+                {
+                    if(!dc.mesh)
+                        continue;
+                    local = bFirst ? dc.mesh->GetAABB() : local.Merged(dc.mesh->GetAABB());
+                    bFirst = false;
+                }
+            }
+        }
+
+        UpdateWorld();
+    }
+
+    void TCompAABB::Update(f32 /*dt*/)
+    {
+        UpdateWorld();
+    }
+
+    void TCompAABB::UpdateWorld()
+    {
+        TCompTransform* transform = Get<TCompTransform>();
+        world = transform ? local.Transformed(transform->AsMatrix()) : local;
+    }
+
+} // Sogas
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "base_component.h"
+#include "entity/entity.h"
+
+namespace Sogas
+{
+    class TCompAABB : public TCompBase
+    {
+        DECL_SIBILING_ACCESS();
+
+        bool bFromRender = true;
+
+    public:
+        AABB local;
+        AABB world;
+
+        /** Bounds can be given as center and half_size, otherwise the meshes of the render component are used.*/
+        void Load(const json& j);
+        void OnEntityCreated();
+        void Update(f32 dt);
+        void UpdateWorld();
+    };
+
+} // Sogas
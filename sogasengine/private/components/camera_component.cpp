@@ -23,4 +23,13 @@ namespace Sogas
         lookAt(transform->GetPosition(), transform->GetPosition() + forward);
     }
 
+    void TCompCamera::UpdateInterpolated(const f32 alpha)
+    {
+        TCompTransform* transform = Get<TCompTransform>();
+        SASSERT(transform);
+        const glm::vec3 position = transform->GetInterpolatedPosition(alpha);
+        const glm::vec3 forward = glm::normalize(glm::mat3_cast(transform->GetInterpolatedRotation(alpha))[2]);
+        lookAt(position, position + forward);
+    }
+
 } // Sogas
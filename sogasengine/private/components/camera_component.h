@@ -13,6 +13,8 @@ namespace Sogas
     public:
         void Load(const json& j);
         void Update(const f32 dt);
+        /** Recomputes the view from the transform interpolated between the last two fixed steps.*/
+        void UpdateInterpolated(const f32 alpha);
     };
     
 } // Sogas
@@ -14,32 +14,38 @@ namespace Sogas
 
     void CompCameraController::Update(f32 dt)
     {
+        GLFWwindow* window = CApplication::Get()->GetWindow();
+        if (!window)
+        {
+            return;
+        }
+
         TCompTransform* transform = Get<TCompTransform>();
         SASSERT(transform);
 
         f32 movement_speed = speed * dt;
 
-        if (glfwGetKey(CApplication::Get()->GetWindow(), GLFW_KEY_W))
+        if (glfwGetKey(window, GLFW_KEY_W))
         {
             transform->SetPosition(transform->GetPosition() + movement_speed * transform->GetForward());
         }
-        else if (glfwGetKey(CApplication::Get()->GetWindow(), GLFW_KEY_A))
+        else if (glfwGetKey(window, GLFW_KEY_A))
         {
             transform->SetPosition(transform->GetPosition() + movement_speed * transform->GetRight());
         }
-        else if (glfwGetKey(CApplication::Get()->GetWindow(), GLFW_KEY_S))
+        else if (glfwGetKey(window, GLFW_KEY_S))
         {
             transform->SetPosition(transform->GetPosition() - movement_speed * transform->GetForward());
         }
-        else if (glfwGetKey(CApplication::Get()->GetWindow(), GLFW_KEY_D))
+        else if (glfwGetKey(window, GLFW_KEY_D))
         {
             transform->SetPosition(transform->GetPosition() - movement_speed * transform->GetRight());
         }
-        else if (glfwGetKey(CApplication::Get()->GetWindow(), GLFW_KEY_SPACE))
+        else if (glfwGetKey(window, GLFW_KEY_SPACE))
         {
             transform->SetPosition(transform->GetPosition() + movement_speed * transform->GetUp());
         }
-        else if (glfwGetKey(CApplication::Get()->GetWindow(), GLFW_KEY_LEFT_SHIFT))
+        else if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT))
         {
             transform->SetPosition(transform->GetPosition() - movement_speed * transform->GetUp());
         }
@@ -1,9 +1,133 @@
 #include "name_component.h"
 
+#include <chrono>
+
 namespace Sogas
 {
     DECL_OBJ_MANAGER("name", CompName);
-    std::unordered_map<std::string, CHandle> CompName::allNames;
+    CNameIndex CompName::allNames;
+
+    void CNameIndex::Grow(u32 NewCapacity)
+    {
+        std::vector<Slot> OldSlots = std::move(Slots);
+        Slots.clear();
+        Slots.resize(NewCapacity);
+        nUsed = 0;
+        nOccupied = 0;
+
+        for(const auto& slot : OldSlots)
+        {
+            if(slot.id != NameId::Invalid && slot.id != Tombstone)
+                Register(NameId(slot.id), slot.handle);
+        }
+    }
+
+    void CNameIndex::Reserve(u32 nEntries)
+    {
+        // Keep load factor under 0.5 after reserving.
+        u32 capacity = 16;
+        while(capacity < nEntries * 2)
+            capacity <<= 1;
+
+        if(capacity > GetCapacity())
+            Grow(capacity);
+    }
+
+    void CNameIndex::Register(NameId InName, CHandle InHandle)
+    {
+        SASSERT(InName.IsValid() && InName.id != Tombstone);
+
+        // Rehash when above 0.75 load, only doubling if tombstones are not the reason.
+        const u32 capacity = GetCapacity();
+        if((nOccupied + 1) * 4 > capacity * 3)
+            Grow(capacity == 0 ? 16 : ((nUsed + 1) * 2 > capacity ? capacity * 2 : capacity));
+
+        const u32 mask = GetCapacity() - 1;
+        u32 idx = static_cast<u32>(InName.id) & mask;
+        u32 firstTombstone = INVALID_ID;
+
+        while(Slots[idx].id != NameId::Invalid)
+        {
+            if(Slots[idx].id == InName.id)
+            {
+                if(Slots[idx].handle != InHandle)
+                    SWARNING("Name already registered, overriding previous entry.");
+                Slots[idx].handle = InHandle;
+                return;
+            }
+
+            if(Slots[idx].id == Tombstone && firstTombstone == INVALID_ID)
+                firstTombstone = idx;
+
+            idx = (idx + 1) & mask;
+        }
+
+        if(firstTombstone != INVALID_ID)
+            idx = firstTombstone;
+        else
+            ++nOccupied;
+
+        Slots[idx].id = InName.id;
+        Slots[idx].handle = InHandle;
+        ++nUsed;
+    }
+
+    void CNameIndex::Unregister(NameId InName, CHandle InHandle)
+    {
+        if(!InName.IsValid() || Slots.empty())
+            return;
+
+        const u32 mask = GetCapacity() - 1;
+        u32 idx = static_cast<u32>(InName.id) & mask;
+
+        while(Slots[idx].id != NameId::Invalid)
+        {
+            if(Slots[idx].id == InName.id)
+            {
+                // Only remove it if it still points to the caller, the name may have been reassigned.
+                if(Slots[idx].handle == InHandle)
+                {
+                    Slots[idx].id = Tombstone;
+                    Slots[idx].handle = CHandle();
+                    --nUsed;
+                }
+                return;
+            }
+            idx = (idx + 1) & mask;
+        }
+    }
+
+    CHandle CNameIndex::Find(NameId InName) const
+    {
+        if(!InName.IsValid() || Slots.empty())
+            return CHandle();
+
+        const u32 mask = GetCapacity() - 1;
+        u32 idx = static_cast<u32>(InName.id) & mask;
+
+        while(Slots[idx].id != NameId::Invalid)
+        {
+            if(Slots[idx].id == InName.id)
+                return Slots[idx].handle;
+            idx = (idx + 1) & mask;
+        }
+
+        return CHandle();
+    }
+
+    void CNameIndex::Clear()
+    {
+        Slots.clear();
+        nUsed = 0;
+        nOccupied = 0;
+    }
+
+    CompName::~CompName()
+    {
+        // Objects are destroyed while their handle is still resolvable.
+        if(nameId.IsValid())
+            allNames.Unregister(nameId, CHandle(this));
+    }
 
     void CompName::Load(const json& j)
     {
@@ -13,18 +137,90 @@ namespace Sogas
 
     void CompName::setName(const char* newName)
     {
-        strcpy_s(name, newName);
-        allNames[name] = CHandle(this);
+        SASSERT(newName);
+
+        CHandle self(this);
+        if(nameId.IsValid())
+            allNames.Unregister(nameId, self);
+
+        if(strlen(newName) >= MaxNameLength)
+            SWARNING("Name '%s' is too long, it will be truncated to %d characters.", newName, MaxNameLength - 1);
+
+        snprintf(name, MaxNameLength, "%s", newName);
+        nameId = NameId(HashName(name));
+        allNames.Register(nameId, self);
     }
 
-    CHandle getEntityByName(const std::string& name)
+    CHandle getEntityByName(NameId name)
     {
-        auto it = CompName::allNames.find(name);
-        if (it == CompName::allNames.end())
+        CHandle h = CompName::allNames.Find(name);
+        if(!h.IsValid())
             return CHandle();
 
-        CHandle h = it->second;
         return h.GetOwner();
     }
 
+    CHandle getEntityByName(const std::string& name)
+    {
+        return getEntityByName(NameId(name));
+    }
+
+    CHandle CCachedEntity::GetHandle()
+    {
+        if(!Handle.IsValid())
+            Handle = getEntityByName(Name);
+        return Handle;
+    }
+
+    CEntity* CCachedEntity::Get()
+    {
+        return GetHandle();
+    }
+
+    void BenchmarkNameLookup(u32 nNames)
+    {
+        using clock = std::chrono::high_resolution_clock;
+
+        std::vector<std::string> names(nNames);
+        for(u32 i = 0; i < nNames; ++i)
+            names[i] = "entity_" + std::to_string(i);
+
+        // Handles are only used as payload, they don't need to be alive.
+        auto fakeHandle = [](u32 i) { return CHandle(1, i & ((1 << CHandle::nBitsIndex) - 1), i >> CHandle::nBitsIndex); };
+
+        std::unordered_map<std::string, CHandle> map;
+        CNameIndex index;
+        index.Reserve(nNames);
+
+        std::vector<NameId> ids(nNames);
+        for(u32 i = 0; i < nNames; ++i)
+        {
+            map[names[i]] = fakeHandle(i);
+            ids[i] = NameId(names[i]);
+            index.Register(ids[i], fakeHandle(i));
+        }
+
+        u32 found = 0;
+
+        auto start = clock::now();
+        for(u32 i = 0; i < nNames; ++i)
+            found += map.find(names[i]) != map.end();
+        f64 mapTime = std::chrono::duration<f64, std::milli>(clock::now() - start).count();
+
+        start = clock::now();
+        for(u32 i = 0; i < nNames; ++i)
+            found += index.Find(NameId(names[i])) == fakeHandle(i);
+        f64 hashAndFindTime = std::chrono::duration<f64, std::milli>(clock::now() - start).count();
+
+        start = clock::now();
+        for(u32 i = 0; i < nNames; ++i)
+            found += index.Find(ids[i]) == fakeHandle(i);
+        f64 internedTime = std::chrono::duration<f64, std::milli>(clock::now() - start).count();
+
+        SASSERT(found == nNames * 3);
+
+        SINFO("Name lookup of %d entries: unordered_map<string> %.3f ms, hash + index %.3f ms, interned index %.3f ms.",
+            nNames, mapTime, hashAndFindTime, internedTime);
+    }
+
 } // Sogas
@@ -5,17 +5,72 @@
 
 namespace Sogas
 {
+    /** Open addressing table from interned name to the CompName handle owning it.
+     *  Linear probing with tombstones, capacity is always a power of two. */
+    class CNameIndex
+    {
+        struct Slot
+        {
+            u64     id = NameId::Invalid;
+            CHandle handle;
+        };
+
+        static const u64 Tombstone = ~0ull;
+
+        std::vector<Slot> Slots;
+        u32 nUsed = 0;      // Live entries.
+        u32 nOccupied = 0;  // Live entries plus tombstones.
+
+        void Grow(u32 NewCapacity);
+
+    public:
+        void Reserve(u32 nEntries);
+        void Register(NameId InName, CHandle InHandle);
+        void Unregister(NameId InName, CHandle InHandle);
+        CHandle Find(NameId InName) const;
+        void Clear();
+
+        u32 GetSize() const { return nUsed; }
+        u32 GetCapacity() const { return static_cast<u32>(Slots.size()); }
+    };
+
     class CompName : public TCompBase
     {
         DECL_SIBILING_ACCESS();
 
-        char name[64];
+        static const u32 MaxNameLength = 64;
+
+        char name[MaxNameLength] = {};
+        NameId nameId;
 
     public:
-        static std::unordered_map<std::string, CHandle> allNames;
+        static CNameIndex allNames;
+
+        CompName() = default;
+        CompName(CompName&& other) = default;
+        ~CompName();
 
         void Load(const json& j);
         void setName(const char* newName);
         const char* getName() const { return name; }
+        NameId getNameId() const { return nameId; }
     };
+
+    /** Caches the entity resolved from a name. The index is only probed again
+     *  when the cached handle is no longer valid. */
+    class CCachedEntity
+    {
+        NameId  Name;
+        CHandle Handle;
+
+    public:
+        explicit CCachedEntity(NameId InName) : Name(InName) {}
+
+        CEntity* Get();
+        CHandle GetHandle();
+        void Invalidate() { Handle = CHandle(); }
+    };
+
+    // Times lookups of nNames synthetic entries in CNameIndex against the string keyed map.
+    void BenchmarkNameLookup(u32 nNames = 100000);
 } // Sogas
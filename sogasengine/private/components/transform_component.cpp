@@ -26,6 +26,31 @@ namespace Sogas
             * glm::translate(glm::mat4(1), position);
     }
 
+    void TCompTransform::StorePreviousState()
+    {
+        previousPosition = position;
+        previousRotation = rotation;
+        previousScale = scale;
+    }
+
+    glm::vec3 TCompTransform::GetInterpolatedPosition(f32 alpha) const
+    {
+        return glm::mix(previousPosition, position, alpha);
+    }
+
+    glm::quat TCompTransform::GetInterpolatedRotation(f32 alpha) const
+    {
+        return glm::slerp(previousRotation, rotation, alpha);
+    }
+
+    /** alpha is the fraction of fixed step elapsed since the last simulation step.*/
+    glm::mat4 TCompTransform::AsInterpolatedMatrix(f32 alpha) const
+    {
+        return glm::scale(glm::mat4(1), glm::mix(previousScale, scale, alpha))
+            * glm::mat4_cast(GetInterpolatedRotation(alpha))
+            * glm::translate(glm::mat4(1), GetInterpolatedPosition(alpha));
+    }
+
     void TCompTransform::FromMatrix(glm::mat4 matrix)
     {
         glm::vec3 dummy_vec3;
@@ -117,6 +142,8 @@ namespace Sogas
     void TCompTransform::Load(const json& j)
     {
         FromJson(j);
+        // Do not interpolate from the default state.
+        StorePreviousState();
     }
 
 } // Sogas
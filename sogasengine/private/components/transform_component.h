@@ -5,9 +5,14 @@ namespace Sogas
 {
     class TCompTransform : public TCompBase
     {
-        glm::vec3 position;
-        glm::quat rotation;
-        glm::vec3 scale;
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        glm::vec3 scale = glm::vec3(1.0f);
+
+        // State at the beginning of the last fixed step, used to interpolate when rendering.
+        glm::vec3 previousPosition = glm::vec3(0.0f);
+        glm::quat previousRotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        glm::vec3 previousScale = glm::vec3(1.0f);
 
     public:       
         void SetPosition(const glm::vec3& new_position) { position = new_position; }
@@ -23,6 +28,11 @@ namespace Sogas
         glm::vec3 GetUp() const;
 
         glm::mat4 AsMatrix() const;
+
+        void StorePreviousState();
+        glm::vec3 GetInterpolatedPosition(f32 alpha) const;
+        glm::quat GetInterpolatedRotation(f32 alpha) const;
+        glm::mat4 AsInterpolatedMatrix(f32 alpha) const;
         void FromMatrix(glm::mat4 matrix);
 
         void SetEulerAngles(f32 yaw, f32 pitch, f32 roll);
@@ -1,5 +1,7 @@
+#include "application.h"
 #include "engine.h"
 
+#include "jobs/thread_pool.h"
 #include "modules/module_boot.h"
 #include "modules/module_entities.h"
 #include "render/module_render.h"
@@ -10,6 +12,8 @@
 
 #include "GLFW/glfw3.h"
 
+#include <cmath>
+
 namespace Sogas
 {
     CEngine* CEngine::engine = nullptr;
@@ -53,6 +57,9 @@ namespace Sogas
         STRACE("Initializing Engine ... ");
         static CModuleBoot boot("boot");
 
+        SPROFILE_THREAD("Main");
+        CThreadPool::Get()->Init();
+
         CResourceManager::Get()->RegisterResourceType(GetResourceType<CMesh>());
         CResourceManager::Get()->RegisterResourceType(GetResourceType<Texture>());
         CResourceManager::Get()->RegisterResourceType(GetResourceType<Material>());
@@ -74,16 +81,50 @@ namespace Sogas
 
     void CEngine::DoFrame()
     {
-        static f64 previousTime = 0.0;
-        f64 currentTime = glfwGetTime();
-        f64 elapsed = currentTime - previousTime;
-        update(static_cast<f32>(elapsed));
+        // Headless runs step once per frame, the same frames are simulated whatever the machine speed.
+        f64 elapsed = FixedDeltaTime;
+        if(!CApplication::Get()->IsHeadless())
+        {
+            static f64 previousTime = glfwGetTime();
+            f64 currentTime = glfwGetTime();
+            elapsed = currentTime - previousTime;
+            previousTime = currentTime;
+        }
+
+        Accumulator += elapsed;
+
+        // Simulation always advances in fixed steps, render interpolates the remainder.
+        u32 steps = 0;
+        while(Accumulator >= FixedDeltaTime && steps < MaxCatchUpSteps)
+        {
+            EntityModule->StoreInterpolationState();
+            update(FixedDeltaTime);
+            Accumulator -= FixedDeltaTime;
+            ++steps;
+        }
+
+        // Too far behind, drop the time we can't catch up instead of spiraling.
+        if(Accumulator >= FixedDeltaTime)
+        {
+            STRACE("Simulation is behind, dropping %.3f s.", Accumulator - std::fmod(Accumulator, static_cast<f64>(FixedDeltaTime)));
+            Accumulator = std::fmod(Accumulator, static_cast<f64>(FixedDeltaTime));
+        }
+
+        InterpolationAlpha = static_cast<f32>(Accumulator / FixedDeltaTime);
+
+        if(steps > 0)
+            ModuleManager.UpdateAhead(FixedDeltaTime);
+
         RenderModule->DoFrame();
-        previousTime = currentTime;
+
+        SPROFILE_END_FRAME();
     }
 
     void CEngine::Shutdown()
     {
+        // Queued jobs, modules running ahead and pipeline compiles, finish before anything they use is released.
+        CThreadPool::Destroy();
+
         ReleasePrimitives();
         CResourceManager::Get()->Destroy();
         ModuleManager.Clear();
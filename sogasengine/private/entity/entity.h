@@ -38,5 +38,6 @@ namespace Sogas
     };
 
     extern CHandle getEntityByName(const std::string &name);
+    extern CHandle getEntityByName(NameId name);
 
 } // namespace Sogas
@@ -111,6 +111,7 @@ namespace Sogas
 
         void UpdateAll(f32 dt) override
         {
+            SPROFILE_ZONE(Name);
             SASSERT(Objects);
 
             if(!nObjectsUsed)
@@ -0,0 +1,135 @@
+#include "jobs/thread_pool.h"
+
+namespace Sogas
+{
+    CThreadPool* CThreadPool::ThreadPool = nullptr;
+
+    void CThreadPool::Destroy()
+    {
+        if(!ThreadPool)
+            return;
+
+        ThreadPool->Shutdown();
+        delete ThreadPool;
+        ThreadPool = nullptr;
+    }
+
+    void CThreadPool::Init(u32 nThreads)
+    {
+        SASSERT(Workers.empty());
+
+        if(nThreads == 0)
+        {
+            const u32 hardwareThreads = std::thread::hardware_concurrency();
+            nThreads = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+        }
+
+        STRACE("Initializing thread pool with %d workers.", nThreads);
+
+        bStopping = false;
+        Workers.reserve(nThreads);
+        for(u32 i = 0; i < nThreads; ++i)
+            Workers.emplace_back(&CThreadPool::WorkerLoop, this);
+    }
+
+    void CThreadPool::Shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            bStopping = true;
+        }
+        JobAvailable.notify_all();
+
+        for(auto& worker : Workers)
+            worker.join();
+
+        Workers.clear();
+        Jobs.clear();
+    }
+
+    void CThreadPool::Submit(Job job)
+    {
+        // Without workers the job is executed in place.
+        if(Workers.empty())
+        {
+            job();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            Jobs.push_back(std::move(job));
+        }
+        JobAvailable.notify_one();
+    }
+
+    void CThreadPool::ParallelFor(u32 count, u32 batchSize, const std::function<void(u32 begin, u32 end)>& fn)
+    {
+        SASSERT(batchSize > 0);
+
+        const u32 nBatches = (count + batchSize - 1) / batchSize;
+        if(nBatches <= 1 || Workers.empty())
+        {
+            if(count > 0)
+                fn(0, count);
+            return;
+        }
+
+        struct State
+        {
+            std::atomic<u32> nextBatch{0};
+            std::atomic<u32> nDone{0};
+            std::mutex mutex;
+            std::condition_variable finished;
+        };
+        auto state = std::make_shared<State>();
+
+        // Helpers starting after every batch was taken find nothing to do and never call fn.
+        auto work = [state, &fn, count, batchSize, nBatches]()
+        {
+            u32 batch;
+            while((batch = state->nextBatch.fetch_add(1)) < nBatches)
+            {
+                const u32 begin = batch * batchSize;
+                fn(begin, std::min(begin + batchSize, count));
+
+                if(state->nDone.fetch_add(1) + 1 == nBatches)
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    state->finished.notify_all();
+                }
+            }
+        };
+
+        const u32 nHelpers = std::min(static_cast<u32>(Workers.size()), nBatches - 1);
+        for(u32 i = 0; i < nHelpers; ++i)
+            Submit(work);
+
+        work();
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->finished.wait(lock, [&state, nBatches]() { return state->nDone.load() == nBatches; });
+    }
+
+    void CThreadPool::WorkerLoop()
+    {
+        SPROFILE_THREAD("Worker");
+
+        while(true)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(Mutex);
+                JobAvailable.wait(lock, [this]() { return bStopping || !Jobs.empty(); });
+
+                if(bStopping && Jobs.empty())
+                    return;
+
+                job = std::move(Jobs.front());
+                Jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+} // Sogas
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace Sogas
+{
+    class CThreadPool
+    {
+    public:
+        using Job = std::function<void()>;
+
+        static CThreadPool* Get()
+        {
+            if(!ThreadPool)
+                ThreadPool = new CThreadPool();
+            return ThreadPool;
+        }
+
+        /** Joins the workers, after they finish the queued jobs, and deletes the pool. */
+        static void Destroy();
+
+        /** Spawns nThreads workers. 0 picks hardware concurrency minus the main thread. */
+        void Init(u32 nThreads = 0);
+        void Shutdown();
+
+        void Submit(Job job);
+
+        /** Splits [0, count) in batches run by the workers and the calling thread. Returns once every batch is done. */
+        void ParallelFor(u32 count, u32 batchSize, const std::function<void(u32 begin, u32 end)>& fn);
+
+        u32 GetNumThreads() const { return static_cast<u32>(Workers.size()); }
+
+    private:
+        CThreadPool() = default;
+        CThreadPool(const CThreadPool&) = delete;
+
+        void WorkerLoop();
+
+        static CThreadPool* ThreadPool;
+
+        std::vector<std::thread> Workers;
+        std::deque<Job> Jobs;
+        std::mutex Mutex;
+        std::condition_variable JobAvailable;
+        bool bStopping = false;
+    };
+
+} // Sogas
@@ -25,4 +25,31 @@ namespace Sogas
         f32 mdo = sqrtf(front.x * front.x + front.z * front.z);
         *pitch = atan2f(-front.y, mdo);
     }
+
+    AABB AABB::FromMinMax(const glm::vec3& min, const glm::vec3& max)
+    {
+        AABB aabb;
+        aabb.center = (min + max) * 0.5f;
+        aabb.halfSize = (max - min) * 0.5f;
+        return aabb;
+    }
+
+    AABB AABB::Transformed(const glm::mat4& matrix) const
+    {
+        // Extents are projected over the absolute basis (Arvo).
+        const glm::mat3 basis(matrix);
+        const glm::mat3 absBasis(glm::abs(basis[0]), glm::abs(basis[1]), glm::abs(basis[2]));
+
+        AABB aabb;
+        aabb.center = glm::vec3(matrix * glm::vec4(center, 1.0f));
+        aabb.halfSize = absBasis * halfSize;
+        return aabb;
+    }
+
+    AABB AABB::Merged(const AABB& other) const
+    {
+        const glm::vec3 min = glm::min(center - halfSize, other.center - other.halfSize);
+        const glm::vec3 max = glm::max(center + halfSize, other.center + other.halfSize);
+        return FromMinMax(min, max);
+    }
 } // Sogas
@@ -6,6 +6,8 @@ namespace Sogas
 
     static void PaserScene(const std::string filename)
     {
+        SPROFILE_FUNCTION();
+
         json j = LoadJson(CEngine::FindFile(filename));
 
         SASSERT(j.is_array());
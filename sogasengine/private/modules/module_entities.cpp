@@ -1,4 +1,5 @@
 #include "module_entities.h"
+#include "components/transform_component.h"
 
 namespace Sogas
 {
@@ -51,6 +52,8 @@ namespace Sogas
 
     void CEntityModule::Update(f32 dt)
     {
+        SPROFILE_FUNCTION();
+
         for (auto &objectManager : ObjectManagerToUpdate)
         {
             objectManager->UpdateAll(dt);
@@ -59,6 +62,13 @@ namespace Sogas
         }
     }
 
+    void CEntityModule::StoreInterpolationState()
+    {
+        GetObjectManager<TCompTransform>()->ForEach([](TCompTransform* transform){
+            transform->StorePreviousState();
+        });
+    }
+
     void CEntityModule::Render() {}
     void CEntityModule::RenderDebug() {}
     void CEntityModule::RenderInMenu() {}
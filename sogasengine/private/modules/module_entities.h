@@ -21,6 +21,9 @@ namespace Sogas
         void RenderUI() override ;
         void RenderUIDebug() override ;
 
+        // Called before every fixed simulation step.
+        void StoreInterpolationState();
+
     private:
 
         std::vector<CHandleManager*> ObjectManagerToUpdate;
@@ -9,6 +9,9 @@ namespace Sogas
         ParseModules(std::move(CEngine::FindFile("modules.json")));
         ParseGameStates(std::move(CEngine::FindFile("gamestates.json")));
 
+        // Services are already running, build the graph in case no game state is ever requested.
+        Scheduler.Build(UpdateModules, RenderModules);
+
         if(!BootGameState.empty())
         {
             // Change to game state.
@@ -18,6 +21,8 @@ namespace Sogas
 
     void CModuleManager::Clear()
     {
+        Scheduler.Wait();
+
         // Set game state to nullptr.
 
         StopModules(Services);
@@ -63,15 +68,17 @@ namespace Sogas
 
     void CModuleManager::Update(f32 dt)
     {
+        SPROFILE_FUNCTION();
+
         ChangeToRequestedGameState();
 
-        for(auto module : UpdateModules)
-        {
-            if(module->IsActive())
-            {
-                module->Update(dt);
-            }
-        }
+        Scheduler.Run(dt);
+    }
+
+    void CModuleManager::UpdateAhead(f32 dt)
+    {
+        // Launches next frame modules independent from render while it is being submitted.
+        Scheduler.RunAhead(dt);
     }
 
     void CModuleManager::Render()
@@ -149,6 +156,7 @@ namespace Sogas
         
         json jUpdateList = j["update"];
         json jRenderList = j["render"];
+        json jDependencies = j.value("dependencies", json::object());
 
         for(auto jModule : jUpdateList)
         {
@@ -171,6 +179,8 @@ namespace Sogas
                 RenderModules.push_back(module);
             }
         }
+
+        Scheduler.ParseDependencies(jDependencies, RegisteredModules);
     }
 
     void CModuleManager::ParseGameStates(const std::string& filename)
@@ -206,6 +216,9 @@ namespace Sogas
         if(RequestedGameState == nullptr || RequestedGameState == CurrentGameState)
             return;
 
+        // Modules running ahead must finish before being stopped.
+        Scheduler.Wait();
+
         if(CurrentGameState)
         {
             StopModules(*CurrentGameState);
@@ -218,6 +231,8 @@ namespace Sogas
             CurrentGameState = RequestedGameState;
             RequestedGameState = nullptr;
         }
+
+        Scheduler.Build(UpdateModules, RenderModules);
     }
 
 }   // Sogas
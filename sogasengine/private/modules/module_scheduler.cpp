@@ -0,0 +1,312 @@
+#include "modules/module_scheduler.h"
+#include "jobs/thread_pool.h"
+
+#include <chrono>
+
+namespace Sogas
+{
+    using SchedulerClock = std::chrono::high_resolution_clock;
+
+    static f64 ElapsedMs(SchedulerClock::time_point start)
+    {
+        return std::chrono::duration<f64, std::milli>(SchedulerClock::now() - start).count();
+    }
+
+    u64 CModuleScheduler::GetResourceBit(const std::string& resource)
+    {
+        auto it = ResourceBits.find(resource);
+        if(it != ResourceBits.end())
+            return 1ull << it->second;
+
+        const u32 bit = static_cast<u32>(ResourceBits.size());
+        SASSERT_MSG(bit < 64, "Too many module resources declared.");
+        ResourceBits[resource] = bit;
+        return 1ull << bit;
+    }
+
+    void CModuleScheduler::ParseDependencies(const json& j, const std::map<std::string, IModule*>& modules)
+    {
+        Accesses.clear();
+
+        for(const auto& jModule : j.items())
+        {
+            auto it = modules.find(jModule.key());
+            SASSERT_MSG(it != modules.end(), "Dependencies declared for an unknown module.");
+            if(it == modules.end())
+                continue;
+
+            const json& jAccess = jModule.value();
+
+            ModuleAccess access;
+            access.reads = 0;
+            access.writes = 0;
+            access.bMainThread = jAccess.value("main_thread", false);
+
+            for(const auto& jResource : jAccess.value("reads", json::array()))
+                access.reads |= GetResourceBit(jResource.get<std::string>());
+
+            for(const auto& jResource : jAccess.value("writes", json::array()))
+                access.writes |= GetResourceBit(jResource.get<std::string>());
+
+            Accesses[it->second] = access;
+        }
+    }
+
+    void CModuleScheduler::Build(const VModules& updateModules, const VModules& renderModules)
+    {
+        Wait();
+
+        // Rebuilt between RunAhead and Run on game state changes, modules that already ran this frame must not run again.
+        std::set<IModule*> done;
+        for(const auto& node : Nodes)
+        {
+            if(node.bDone)
+                done.insert(node.module);
+        }
+
+        Nodes.clear();
+
+        for(auto module : updateModules)
+        {
+            if(!module->IsActive())
+                continue;
+
+            Node node;
+            node.module = module;
+            node.zone_name = Profiler::InternName(module->GetName().c_str());
+            node.bDone = done.count(module) > 0;
+
+            auto it = Accesses.find(module);
+            if(it != Accesses.end())
+                node.access = it->second;
+
+            Nodes.push_back(std::move(node));
+        }
+
+        // Modules without declared dependencies conflict with everything, keeping the serial order.
+        ModuleAccess renderAccess;
+        renderAccess.reads = 0;
+        renderAccess.writes = 0;
+        for(auto module : renderModules)
+        {
+            auto it = Accesses.find(module);
+            const ModuleAccess access = it != Accesses.end() ? it->second : ModuleAccess();
+            renderAccess.reads |= access.reads;
+            renderAccess.writes |= access.writes;
+        }
+
+        // Nodes are already in topological order, edges always go from lower to higher index.
+        for(u32 i = 0; i < Nodes.size(); ++i)
+        {
+            Node& node = Nodes[i];
+            for(u32 j = i + 1; j < Nodes.size(); ++j)
+            {
+                if(node.access.ConflictsWith(Nodes[j].access))
+                {
+                    node.successors.push_back(j);
+                    Nodes[j].predecessors.push_back(i);
+                }
+            }
+
+            node.bRunAhead = !node.access.bMainThread && !node.access.ConflictsWith(renderAccess);
+            for(auto p : node.predecessors)
+                node.bRunAhead = node.bRunAhead && Nodes[p].bRunAhead;
+        }
+
+        Stats.criticalPath.clear();
+    }
+
+    void CModuleScheduler::Dispatch(const std::vector<u32>& ready, f32 dt)
+    {
+        bool bMainThreadWork = false;
+
+        for(auto index : ready)
+        {
+            if(Nodes[index].access.bMainThread)
+            {
+                std::lock_guard<std::mutex> lock(Mutex);
+                MainThreadQueue.push_back(index);
+                bMainThreadWork = true;
+            }
+            else
+            {
+                CThreadPool::Get()->Submit([this, index, dt]() { Execute(index, dt); });
+            }
+        }
+
+        if(bMainThreadWork)
+            Finished.notify_all();
+    }
+
+    void CModuleScheduler::Launch(f32 dt, bool bAhead)
+    {
+        std::vector<u32> ready;
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+
+            for(auto& node : Nodes)
+                node.bInRun = bAhead ? node.bRunAhead : !node.bDone;
+
+            nRunning = 0;
+            for(u32 i = 0; i < Nodes.size(); ++i)
+            {
+                Node& node = Nodes[i];
+                if(!node.bInRun)
+                    continue;
+
+                node.pending = 0;
+                for(auto p : node.predecessors)
+                    node.pending += Nodes[p].bInRun ? 1 : 0;
+
+                if(node.pending == 0)
+                    ready.push_back(i);
+
+                ++nRunning;
+            }
+        }
+
+        Dispatch(ready, dt);
+    }
+
+    void CModuleScheduler::Execute(u32 index, f32 dt)
+    {
+        Node& node = Nodes[index];
+
+        SPROFILE_ZONE(node.zone_name);
+
+        auto start = SchedulerClock::now();
+        if(node.module->IsActive())
+            node.module->Update(dt);
+        node.duration = ElapsedMs(start);
+
+        OnNodeFinished(index, dt);
+    }
+
+    void CModuleScheduler::OnNodeFinished(u32 index, f32 dt)
+    {
+        std::vector<u32> ready;
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+
+            Node& node = Nodes[index];
+            node.bDone = true;
+
+            for(auto s : node.successors)
+            {
+                Node& successor = Nodes[s];
+                if(successor.bInRun && --successor.pending == 0)
+                    ready.push_back(s);
+            }
+
+            --nRunning;
+        }
+
+        Dispatch(ready, dt);
+        Finished.notify_all();
+    }
+
+    void CModuleScheduler::RunAhead(f32 dt)
+    {
+        Wait();
+
+        bool bAnyAhead = false;
+        for(const auto& node : Nodes)
+            bAnyAhead = bAnyAhead || node.bRunAhead;
+
+        if(!bAnyAhead)
+            return;
+
+        bAheadInFlight = true;
+        Launch(dt, true);
+    }
+
+    void CModuleScheduler::Wait()
+    {
+        if(!bAheadInFlight)
+            return;
+
+        std::unique_lock<std::mutex> lock(Mutex);
+        Finished.wait(lock, [this]() { return nRunning == 0; });
+        bAheadInFlight = false;
+    }
+
+    void CModuleScheduler::Run(f32 dt)
+    {
+        Wait();
+
+        auto start = SchedulerClock::now();
+
+        Stats.nModulesRunAhead = 0;
+        for(const auto& node : Nodes)
+            Stats.nModulesRunAhead += node.bDone ? 1 : 0;
+
+        Launch(dt, false);
+
+        // The calling thread executes the modules bound to it and waits for the rest.
+        {
+            std::unique_lock<std::mutex> lock(Mutex);
+            while(nRunning > 0)
+            {
+                if(!MainThreadQueue.empty())
+                {
+                    const u32 index = MainThreadQueue.back();
+                    MainThreadQueue.pop_back();
+
+                    lock.unlock();
+                    Execute(index, dt);
+                    lock.lock();
+                    continue;
+                }
+
+                Finished.wait(lock);
+            }
+        }
+
+        Stats.wallTime = ElapsedMs(start);
+
+        ComputeCriticalPath();
+
+        for(auto& node : Nodes)
+            node.bDone = false;
+    }
+
+    void CModuleScheduler::ComputeCriticalPath()
+    {
+        std::vector<f64> longest(Nodes.size(), 0.0);
+        std::vector<u32> previous(Nodes.size(), INVALID_ID);
+
+        u32 last = INVALID_ID;
+        for(u32 i = 0; i < Nodes.size(); ++i)
+        {
+            for(auto p : Nodes[i].predecessors)
+            {
+                if(longest[p] > longest[i])
+                {
+                    longest[i] = longest[p];
+                    previous[i] = p;
+                }
+            }
+            longest[i] += Nodes[i].duration;
+
+            if(last == INVALID_ID || longest[i] > longest[last])
+                last = i;
+        }
+
+        std::vector<IModule*> path;
+        for(u32 i = last; i != INVALID_ID; i = previous[i])
+            path.insert(path.begin(), Nodes[i].module);
+
+        Stats.criticalPathTime = last != INVALID_ID ? longest[last] : 0.0;
+
+        if(path != Stats.criticalPath)
+        {
+            std::string report;
+            for(auto module : path)
+                report += (report.empty() ? "" : " -> ") + module->GetName();
+            STRACE("Update critical path changed: %s (%.3f ms).", report.c_str(), Stats.criticalPathTime);
+        }
+
+        Stats.criticalPath = std::move(path);
+    }
+
+} // Sogas
@@ -0,0 +1,265 @@
+#include "render/culling.h"
+#include "jobs/thread_pool.h"
+#include "resources/camera.h"
+
+#include <chrono>
+#include <random>
+
+// SSE is the baseline, the AVX path is compiled for AVX only and taken when the cpu supports it, the engine itself
+// is not built for AVX.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define SGS_CULLING_SSE 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+        #define SGS_TARGET_AVX
+    #else
+        #define SGS_TARGET_AVX __attribute__((target("avx")))
+    #endif
+#endif
+
+namespace Sogas
+{
+    // Multiple of 8 so every batch starts at a full SIMD group.
+    static const u32 CullingBatchSize = 4096;
+
+    void CullingBounds::Resize(u32 count)
+    {
+        CenterX.resize(count);
+        CenterY.resize(count);
+        CenterZ.resize(count);
+        HalfX.resize(count);
+        HalfY.resize(count);
+        HalfZ.resize(count);
+    }
+
+    void CullingBounds::Set(u32 index, const AABB& aabb)
+    {
+        CenterX[index] = aabb.center.x;
+        CenterY[index] = aabb.center.y;
+        CenterZ[index] = aabb.center.z;
+        HalfX[index] = aabb.halfSize.x;
+        HalfY[index] = aabb.halfSize.y;
+        HalfZ[index] = aabb.halfSize.z;
+    }
+
+    void CullingBounds::SetInfinite(u32 index)
+    {
+        // Big enough to touch every plane, small enough to not overflow the dot products.
+        Set(index, AABB{glm::vec3(0.0f), glm::vec3(1e30f)});
+    }
+
+    u32 CullAABBsScalar(const glm::vec4* planes, const CullingBounds& bounds, u32 begin, u32 end, u8* visible)
+    {
+        u32 nVisible = 0;
+        for(u32 i = begin; i < end; ++i)
+        {
+            bool bInside = true;
+            for(u32 p = 0; p < 6 && bInside; ++p)
+            {
+                const glm::vec4& plane = planes[p];
+                const f32 distance = plane.x * bounds.CenterX[i] + plane.y * bounds.CenterY[i] + plane.z * bounds.CenterZ[i] + plane.w;
+                const f32 radius = std::abs(plane.x) * bounds.HalfX[i] + std::abs(plane.y) * bounds.HalfY[i] + std::abs(plane.z) * bounds.HalfZ[i];
+                bInside = distance + radius >= 0.0f;
+            }
+            visible[i] = bInside ? 1 : 0;
+            nVisible += visible[i];
+        }
+        return nVisible;
+    }
+
+#if SGS_CULLING_SSE
+
+    static bool CpuSupportsAVX()
+    {
+    #if defined(_MSC_VER) && !defined(__clang__)
+        // The cpu has AVX and the OS saves the ymm registers.
+        int info[4];
+        __cpuid(info, 1);
+        const bool bAVX = (info[2] & (1 << 28)) != 0;
+        const bool bOSXSave = (info[2] & (1 << 27)) != 0;
+        return bAVX && bOSXSave && (_xgetbv(0) & 6) == 6;
+    #else
+        return __builtin_cpu_supports("avx");
+    #endif
+    }
+
+    static SGS_TARGET_AVX u32 CullAABBsAVX(const glm::vec4* planes, const CullingBounds& bounds, u32 begin, u32 end, u8* visible)
+    {
+        // Plane coefficients broadcasted once: x, y, z, w, |x|, |y|, |z|.
+        __m256 coefficients[6][7];
+        for(u32 p = 0; p < 6; ++p)
+        {
+            const glm::vec4& plane = planes[p];
+            const f32 values[7] = {plane.x, plane.y, plane.z, plane.w, std::abs(plane.x), std::abs(plane.y), std::abs(plane.z)};
+            for(u32 c = 0; c < 7; ++c)
+                coefficients[p][c] = _mm256_set1_ps(values[c]);
+        }
+
+        const __m256 zero = _mm256_setzero_ps();
+
+        u32 nVisible = 0;
+        u32 i = begin;
+        for(; i + 8 <= end; i += 8)
+        {
+            const __m256 cx = _mm256_loadu_ps(&bounds.CenterX[i]);
+            const __m256 cy = _mm256_loadu_ps(&bounds.CenterY[i]);
+            const __m256 cz = _mm256_loadu_ps(&bounds.CenterZ[i]);
+            const __m256 hx = _mm256_loadu_ps(&bounds.HalfX[i]);
+            const __m256 hy = _mm256_loadu_ps(&bounds.HalfY[i]);
+            const __m256 hz = _mm256_loadu_ps(&bounds.HalfZ[i]);
+
+            __m256 outside = zero;
+            for(u32 p = 0; p < 6; ++p)
+            {
+                const __m256* c = coefficients[p];
+                __m256 distance = _mm256_add_ps(_mm256_mul_ps(c[0], cx), c[3]);
+                distance = _mm256_add_ps(distance, _mm256_mul_ps(c[1], cy));
+                distance = _mm256_add_ps(distance, _mm256_mul_ps(c[2], cz));
+                __m256 radius = _mm256_mul_ps(c[4], hx);
+                radius = _mm256_add_ps(radius, _mm256_mul_ps(c[5], hy));
+                radius = _mm256_add_ps(radius, _mm256_mul_ps(c[6], hz));
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_LT_OQ));
+            }
+
+            const u32 mask = static_cast<u32>(_mm256_movemask_ps(outside));
+            for(u32 k = 0; k < 8; ++k)
+            {
+                visible[i + k] = static_cast<u8>(((mask >> k) & 1) ^ 1);
+                nVisible += visible[i + k];
+            }
+        }
+
+        return nVisible + CullAABBsScalar(planes, bounds, i, end, visible);
+    }
+
+    static u32 CullAABBsSSE(const glm::vec4* planes, const CullingBounds& bounds, u32 begin, u32 end, u8* visible)
+    {
+        // Plane coefficients broadcasted once: x, y, z, w, |x|, |y|, |z|.
+        __m128 coefficients[6][7];
+        for(u32 p = 0; p < 6; ++p)
+        {
+            const glm::vec4& plane = planes[p];
+            const f32 values[7] = {plane.x, plane.y, plane.z, plane.w, std::abs(plane.x), std::abs(plane.y), std::abs(plane.z)};
+            for(u32 c = 0; c < 7; ++c)
+                coefficients[p][c] = _mm_set1_ps(values[c]);
+        }
+
+        const __m128 zero = _mm_setzero_ps();
+
+        u32 nVisible = 0;
+        u32 i = begin;
+        for(; i + 4 <= end; i += 4)
+        {
+            const __m128 cx = _mm_loadu_ps(&bounds.CenterX[i]);
+            const __m128 cy = _mm_loadu_ps(&bounds.CenterY[i]);
+            const __m128 cz = _mm_loadu_ps(&bounds.CenterZ[i]);
+            const __m128 hx = _mm_loadu_ps(&bounds.HalfX[i]);
+            const __m128 hy = _mm_loadu_ps(&bounds.HalfY[i]);
+            const __m128 hz = _mm_loadu_ps(&bounds.HalfZ[i]);
+
+            __m128 outside = zero;
+            for(u32 p = 0; p < 6; ++p)
+            {
+                const __m128* c = coefficients[p];
+                __m128 distance = _mm_add_ps(_mm_mul_ps(c[0], cx), c[3]);
+                distance = _mm_add_ps(distance, _mm_mul_ps(c[1], cy));
+                distance = _mm_add_ps(distance, _mm_mul_ps(c[2], cz));
+                __m128 radius = _mm_mul_ps(c[4], hx);
+                radius = _mm_add_ps(radius, _mm_mul_ps(c[5], hy));
+                radius = _mm_add_ps(radius, _mm_mul_ps(c[6], hz));
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+            }
+
+            const u32 mask = static_cast<u32>(_mm_movemask_ps(outside));
+            for(u32 k = 0; k < 4; ++k)
+            {
+                visible[i + k] = static_cast<u8>(((mask >> k) & 1) ^ 1);
+                nVisible += visible[i + k];
+            }
+        }
+
+        return nVisible + CullAABBsScalar(planes, bounds, i, end, visible);
+    }
+
+    static const bool bCullingAVX = CpuSupportsAVX();
+
+    u32 CullAABBs(const glm::vec4* planes, const CullingBounds& bounds, u32 begin, u32 end, u8* visible)
+    {
+        return bCullingAVX ? CullAABBsAVX(planes, bounds, begin, end, visible) : CullAABBsSSE(planes, bounds, begin, end, visible);
+    }
+
+    const char* GetCullingInstructionSet()
+    {
+        return bCullingAVX ? "avx" : "sse";
+    }
+
+#else
+
+    u32 CullAABBs(const glm::vec4* planes, const CullingBounds& bounds, u32 begin, u32 end, u8* visible)
+    {
+        return CullAABBsScalar(planes, bounds, begin, end, visible);
+    }
+
+    const char* GetCullingInstructionSet()
+    {
+        return "scalar";
+    }
+
+#endif
+
+    u32 CullAABBsParallel(const glm::vec4* planes, const CullingBounds& bounds, u32 count, u8* visible, const std::function<void(u32 begin, u32 end)>& gather)
+    {
+        std::atomic<u32> nVisible{0};
+        CThreadPool::Get()->ParallelFor(count, CullingBatchSize, [&](u32 begin, u32 end)
+        {
+            if(gather)
+                gather(begin, end);
+            nVisible += CullAABBs(planes, bounds, begin, end, visible);
+        });
+        return nVisible.load();
+    }
+
+    void BenchmarkFrustumCulling(u32 nObjects)
+    {
+        using clock = std::chrono::high_resolution_clock;
+        const u32 nIterations = 20;
+
+        // Boxes spread around a camera looking down -z, roughly a quarter of them visible.
+        std::mt19937 random(1234);
+        std::uniform_real_distribution<f32> position(-500.0f, 500.0f);
+        std::uniform_real_distribution<f32> size(0.5f, 5.0f);
+
+        CullingBounds bounds;
+        bounds.Resize(nObjects);
+        for(u32 i = 0; i < nObjects; ++i)
+            bounds.Set(i, AABB{glm::vec3(position(random), position(random), position(random)), glm::vec3(size(random))});
+
+        CCamera camera;
+        camera.setProjectionParams(60.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+        camera.lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+        const glm::vec4* planes = camera.GetFrustumPlanes();
+
+        std::vector<u8> visible(nObjects);
+
+        auto measure = [&](auto fn)
+        {
+            auto start = clock::now();
+            u32 nVisible = 0;
+            for(u32 i = 0; i < nIterations; ++i)
+                nVisible = fn();
+            const f64 time = std::chrono::duration<f64, std::milli>(clock::now() - start).count() / nIterations;
+            return std::make_pair(time, nVisible);
+        };
+
+        auto scalar = measure([&]() { return CullAABBsScalar(planes, bounds, 0, nObjects, visible.data()); });
+        auto simd = measure([&]() { return CullAABBs(planes, bounds, 0, nObjects, visible.data()); });
+        auto parallel = measure([&]() { return CullAABBsParallel(planes, bounds, nObjects, visible.data()); });
+
+        SASSERT(scalar.second == simd.second && simd.second == parallel.second);
+
+        SINFO("Frustum culling of %d boxes (%d visible): scalar %.3f ms, %s %.3f ms, %s + %d workers %.3f ms.",
+            nObjects, simd.second, scalar.first, GetCullingInstructionSet(), simd.first, GetCullingInstructionSet(), CThreadPool::Get()->GetNumThreads(), parallel.first);
+    }
+
+} // Sogas
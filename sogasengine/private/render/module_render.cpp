@@ -18,18 +18,37 @@ bool CRenderModule::Start()
 
     allocator.init(4 * 1024 * 1024);
 
-    // Start selected renderer. Vulkan only at the moment and by default.
-    u32                      extensionsCount = 0;
-    const char**             extensions      = glfwGetRequiredInstanceExtensions(&extensionsCount);
-    std::vector<const char*> extensions_vector(extensions, extensions + extensionsCount);
-
-    renderer = Renderer::GPU_device::create(Renderer::GraphicsAPI::Vulkan, extensions_vector);
+    // Start selected renderer. Vulkan by default, the null device profiles the cpu side without a gpu.
+    const bool                  bHeadless = CApplication::Get()->IsHeadless();
+    const Renderer::GraphicsAPI api       = CApplication::Get()->IsNullDevice() ? Renderer::GraphicsAPI::Null : Renderer::GraphicsAPI::Vulkan;
+    std::vector<const char*>    extensions_vector;
+    if (!bHeadless)
+    {
+        u32          extensionsCount = 0;
+        const char** extensions      = glfwGetRequiredInstanceExtensions(&extensionsCount);
+        extensions_vector.assign(extensions, extensions + extensionsCount);
+    }
+
+    renderer = Renderer::GPU_device::create(api, extensions_vector);
 
     i32 width, height;
     CApplication::Get()->GetWindowSize(&width, &height);
     Renderer::DeviceDescriptor dc;
-    dc.SetWindow(CApplication::Get()->GetWindow(), static_cast<u16>(width), static_cast<u16>(height)).SetAllocator(&allocator);
-    renderer->Init(dc);
+    if (bHeadless)
+    {
+        dc.SetHeadless(static_cast<u16>(width), static_cast<u16>(height));
+    }
+    else
+    {
+        dc.SetWindow(CApplication::Get()->GetWindow(), static_cast<u16>(width), static_cast<u16>(height));
+    }
+    dc.SetAllocator(&allocator);
+    dc.SetGpuProfiling(true, CApplication::Get()->IsPipelineStatisticsEnabled());
+    if (!renderer->Init(dc))
+    {
+        SERROR("Failed to initialize the graphics device.");
+        return false;
+    }
 
     forwardPipeline = std::make_shared<ForwardPipeline>(renderer);
 
@@ -60,4 +79,45 @@ void CRenderModule::DoFrame()
 {
     forwardPipeline->render();
 }
+
+bool CRenderModule::CaptureFrame(const std::string& InPath)
+{
+    Renderer::TextureReadback readback;
+    if (!renderer->ReadbackTexture(renderer->GetBackbufferTexture(), readback))
+    {
+        return false;
+    }
+
+    if (readback.data.size() != static_cast<size_t>(readback.width) * readback.height * 4)
+    {
+        SERROR("Only 4 channel 8 bit formats can be captured.");
+        return false;
+    }
+
+    // Binary PPM, alpha is dropped. Simple enough to be diffed byte per byte against a reference capture.
+    std::ofstream file(InPath, std::ios::binary);
+    if (!file.is_open())
+    {
+        SERROR("Failed to open %s.", InPath.c_str());
+        return false;
+    }
+
+    file << "P6\n" << readback.width << " " << readback.height << "\n255\n";
+
+    std::vector<u8> row(static_cast<size_t>(readback.width) * 3);
+    for (u16 y = 0; y < readback.height; ++y)
+    {
+        const u8* pixels = readback.data.data() + static_cast<size_t>(y) * readback.width * 4;
+        for (u16 x = 0; x < readback.width; ++x)
+        {
+            row[x * 3 + 0] = pixels[x * 4 + 0];
+            row[x * 3 + 1] = pixels[x * 4 + 1];
+            row[x * 3 + 2] = pixels[x * 4 + 2];
+        }
+        file.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+    }
+
+    STRACE("Frame captured to %s.", InPath.c_str());
+    return true;
+}
 } // namespace Sogas
@@ -2,38 +2,20 @@
 #include "render/pipelines/forward_pipeline.h"
 #include "components/camera_component.h"
 #include "components/light_point_component.h"
+#include "components/name_component.h"
+#include "jobs/thread_pool.h"
 #include "render/render_manager.h"
 #include "renderer/public/buffer.h"
 #include "renderer/public/render_device.h"
+#include "renderer/public/render_graph.h"
 #include "renderer/public/render_types.h"
 #include "renderer/public/renderpass.h"
+#include "resources/file_watcher.h"
 
-std::vector<Sogas::Renderer::VertexLayout> quad = {
-  {{1.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, {1.0f, 1.0f}, {1.0f, 1.0f, 1.0f, 1.0f}},
-  {{-1.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f, 1.0f, 1.0f}},
-  {{-1.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f}, {1.0f, 1.0f, 1.0f, 1.0f}},
-  {{1.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f, 1.0f, 1.0f}},
-};
-
-std::vector<u32> quadIdx = {0, 1, 2, 2, 3, 0};
-
-Sogas::Renderer::BufferHandle buffer_quad;
-Sogas::Renderer::BufferHandle buffer_quad_index;
+#include <filesystem>
 
-std::vector<glm::vec3> quad_positions = { {1.0f, 1.0f, 0.0f}, {-1.0f, 1.0f, 0.0f}, {-1.0f, -1.0f, 0.0f}, {1.0f, -1.0f, 0.0f} };
-std::vector<glm::vec3> quad_normals = { {0.0f, 1.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 1.0f, 0.0f} };
-std::vector<glm::vec2> quad_uvs = { {1.0f, 1.0f}, {0.0f, 1.0f}, {0.0f, 0.0f}, {1.0f, 0.0f} };
-std::vector<glm::vec4> quad_colors = { {1.0f, 1.0f, 1.0f, 1.0f}, {1.0f, 1.0f, 1.0f, 1.0f}, {1.0f, 1.0f, 1.0f, 1.0f}, {1.0f, 1.0f, 1.0f, 1.0f} };
-
-struct MeshTest
-{
-    Sogas::Renderer::BufferHandle position_buffer;
-    Sogas::Renderer::BufferHandle normal_buffer;
-    Sogas::Renderer::BufferHandle uvs_buffer;
-    Sogas::Renderer::BufferHandle color_buffer;
-};
-
-MeshTest mesh;
+// Resolved once and revalidated through its handle, no string hashing per frame.
+Sogas::CCachedEntity camera_entity(SGS_NAME("camera"));
 
 struct ConstantsCamera
 {
@@ -57,211 +39,324 @@ struct Light
     f32       radius;
 };
 
-Light lights[10];
-
-struct ConstantsMesh
-{
-    glm::mat4 model;
-    glm::vec4 color;
-};
+// Matches MAX_LIGHTS in forward.frag.
+static const u32 MaxShaderLights = 2;
 
 namespace Sogas
 {
 
 using namespace Renderer;
 
-ForwardPipeline::ForwardPipeline(std::shared_ptr<Renderer::GPU_device> InRenderer)
-: renderer(InRenderer)
+// Sources in the repository are preferred when the build knows where they are, edits are picked up without copying
+// them to the data folder.
+static std::string FindShaderSource(const std::string& InFilename)
 {
-    SASSERT(renderer != nullptr);
+#ifdef SGS_SHADER_SOURCE_DIR
+    const std::string path = std::string(SGS_SHADER_SOURCE_DIR) + InFilename;
+    if (std::ifstream(path).good())
+    {
+        return path;
+    }
+#endif
+    return CEngine::FindFile(InFilename);
+}
 
-    // Create pipeline state
-    PipelineDescriptor pipeline_creation;
+static bool ReadSource(const std::string& InFilename, std::string& OutSource)
+{
+    std::ifstream file(InFilename, std::ios::binary);
+    if (!file)
+    {
+        SERROR("Could not read shader %s.", InFilename.c_str());
+        return false;
+    }
+
+    OutSource.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
 
-    // Vertex input
-    pipeline_creation.vertexInputState.AddVertexAttribute({0, 0, 0, VertexFormat::FLOAT3}); // position
-    pipeline_creation.vertexInputState.AddVertexStream({0, sizeof(glm::vec3), VertexInputRate::PER_VERTEX});
+ForwardPipeline::ShaderSources ForwardPipeline::LoadShaders(GPU_device* InRenderer, const std::string& InVertexPath, const std::string& InFragmentPath)
+{
+    ShaderSources sources;
+    sources.bBindless         = InRenderer->IsBindlessSupported();
+    sources.include_directory = std::filesystem::path(InVertexPath).parent_path().string();
+    if (!ReadSource(InVertexPath, sources.vertex) || !ReadSource(InFragmentPath, sources.fragment))
+    {
+        return sources;
+    }
+
+    ShaderStateDescriptor shaders;
+    SetShaders(shaders, sources);
+    sources.bCompiled = InRenderer->CompileShaders(shaders);
+    return sources;
+}
 
-    pipeline_creation.vertexInputState.AddVertexAttribute({1, 1, 0, VertexFormat::FLOAT3}); // normal
-    pipeline_creation.vertexInputState.AddVertexStream({1, sizeof(glm::vec3), VertexInputRate::PER_VERTEX});
+void ForwardPipeline::SetShaders(ShaderStateDescriptor& OutShaders, const ShaderSources& InSources)
+{
+    OutShaders.Reset()
+        .SetName("Forward")
+        .AddStage(InSources.vertex.data(), static_cast<u32>(InSources.vertex.size()), ShaderStageType::VERTEX)
+        .AddStage(InSources.fragment.data(), static_cast<u32>(InSources.fragment.size()), ShaderStageType::FRAGMENT)
+        .SetIncludeDirectory(InSources.include_directory)
+        .SetSpvInput(false);
+
+    if (InSources.bBindless)
+    {
+        OutShaders.AddDefine("BINDLESS");
+    }
+}
 
-    pipeline_creation.vertexInputState.AddVertexAttribute({2, 2, 0, VertexFormat::FLOAT2}); // uvs
-    pipeline_creation.vertexInputState.AddVertexStream({2, sizeof(glm::vec2), VertexInputRate::PER_VERTEX});
+ForwardPipeline::ForwardPipeline(std::shared_ptr<Renderer::GPU_device> InRenderer)
+: renderer(InRenderer)
+{
+    SASSERT(renderer != nullptr);
 
-    pipeline_creation.vertexInputState.AddVertexAttribute({3, 3, 0, VertexFormat::FLOAT4}); // color
-    pipeline_creation.vertexInputState.AddVertexStream({3, sizeof(glm::vec4), VertexInputRate::PER_VERTEX});
+    // Create pipeline state
+    PipelineDescriptor& pipeline_creation = pipeline_descriptor;
+
+    // Interleaved mesh vertices and per instance data. The attributes are reflected from forward.vert, its inputs
+    // are declared in the order of the VertexLayout and InstanceData members.
+    pipeline_creation.vertexInputState.AddVertexStream({0, sizeof(VertexLayout), VertexInputRate::PER_VERTEX});
+    pipeline_creation.vertexInputState.AddVertexStream({1, sizeof(CRenderManager::InstanceData), VertexInputRate::PER_INSTANCE});
+
+    // The frame is a single pass drawing the scene to the swapchain, barriers and attachments of the passes added
+    // in front of it are handled by the graph.
+    graph = std::make_unique<RenderGraph>();
+    graph->Init(renderer.get());
+
+    RenderGraphPassDescriptor forward_pass;
+    forward_pass.Reset()
+      .SetName("Forward")
+      .SetType(RenderPassType::SWAPCHAIN)
+      .SetExecute([this](CommandBuffer* cmd, RenderPassHandle pass) { render_forward(cmd, pass); });
+    const RenderGraphPass forward = graph->AddPass(forward_pass);
+    graph->Compile();
 
     // Render pass
-    pipeline_creation.render_pass = renderer->GetSwapchainOutput();
+    pipeline_creation.render_pass = graph->GetPassOutput(forward);
     // Depth
     pipeline_creation.depthStencilState.SetDepth(true, CompareOperation::LESS_OR_EQUAL);
 
-    auto forward_vs = renderer->ReadShaderBinary(std::move(CEngine::FindFile("forward.vert.spv")));
-    auto forward_ps = renderer->ReadShaderBinary(std::move(CEngine::FindFile("forward.frag.spv")));
-
-    //u32 forward_vs_size = 0;
-    //u32 forward_ps_size = 0;
-    //auto forward_vs = renderer->ReadShader(std::move(CEngine::FindFile("forward.vert")), forward_vs_size);
-    //auto forward_ps = renderer->ReadShader(std::move(CEngine::FindFile("forward.frag")), forward_ps_size);
-
-    pipeline_creation.shaders
-        .SetName("Forward")
-        .AddStage(reinterpret_cast<char*>(forward_vs.data()), static_cast<u32>(forward_vs.size()), ShaderStageType::VERTEX)
-        .AddStage(reinterpret_cast<char*>(forward_ps.data()), static_cast<u32>(forward_ps.size()), ShaderStageType::FRAGMENT)
-        .SetSpvInput(true);
-
-    DescriptorSetLayoutDescriptor descLayoutDescriptor{};
-    descLayoutDescriptor.AddBinding({DescriptorType::UNIFORM_BUFFER, 0, 1, "UniformBufferObject"});
-    descLayoutDescriptor.AddBinding({DescriptorType::UNIFORM_BUFFER, 1, 1, "MeshObject"});
-    descLayoutDescriptor.AddBinding({DescriptorType::UNIFORM_BUFFER, 2, 2, "Lights"});
+    // GLSL is compiled by the device, the sources are watched and the pipeline rebuilt when they change.
+    vertex_path   = FindShaderSource("forward.vert");
+    fragment_path = FindShaderSource("forward.frag");
 
-    descriptorLayout = renderer->CreateDescriptorSetLayout(std::move(descLayoutDescriptor));
-    pipeline_creation.AddDescriptorSetLayout(descriptorLayout);
+    const ShaderSources sources = LoadShaders(renderer.get(), vertex_path, fragment_path);
 
+    // No layouts given, they are reflected from the shaders. Reloaded shaders with the same bindings get the same
+    // layout back, the descriptor set stays valid.
+    SetShaders(pipeline_creation.shaders, sources);
     pipeline = renderer->CreatePipeline(pipeline_creation);
+    pipeline_creation.shaders.Reset(); // Points to the local sources.
 
-    BufferDescriptor ubo_desc;
-    ubo_desc.reset().set(BufferUsage::UNIFORM, BufferType::Static, BufferBindingPoint::Uniform, sizeof(ConstantsCamera)).setName("UniformBufferObject");
-
-    camera_buffer = renderer->CreateBuffer(std::move(ubo_desc));
-
-    BufferDescriptor mesh_desc;
-    mesh_desc.reset().set(BufferUsage::UNIFORM, BufferType::Static, BufferBindingPoint::Uniform, sizeof(ConstantsMesh)).setName("MeshObject");
-
-    mesh_buffer = renderer->CreateBuffer(std::move(mesh_desc));
+    descriptorLayout = renderer->GetDescriptorSetLayout(pipeline, 0);
 
-    BufferDescriptor light_desc;
-    light_desc.reset().set(BufferUsage::UNIFORM, BufferType::Static, BufferBindingPoint::Uniform, sizeof(Light) * 2).setName("Lights");
-
-    light_buffer = renderer->CreateBuffer(std::move(light_desc));
+    shader_watcher = std::make_unique<CFileWatcher>();
+    shader_watcher->Watch(vertex_path);
+    shader_watcher->Watch(fragment_path);
+    shader_watcher->Start();
 
+    // Constants live in the per frame dynamic buffer, the offsets are given when binding the set.
     DescriptorSetDescriptor descriptorSet_desc;
-    descriptorSet_desc.SetLayout(descriptorLayout).Buffer(camera_buffer, 0).Buffer(mesh_buffer, 1).Buffer(light_buffer, 2);
+    descriptorSet_desc.SetLayout(descriptorLayout)
+      .Buffer(renderer->GetDynamicBuffer(), 0, sizeof(ConstantsCamera))
+      .Buffer(renderer->GetDynamicBuffer(), 2, sizeof(Light) * MaxShaderLights);
 
     descriptorSet = renderer->CreateDescriptorSet(std::move(descriptorSet_desc));
+}
 
-    BufferDescriptor quad_descriptor;
-    quad_descriptor.reset().set(BufferUsage::VERTEX, BufferType::Static, BufferBindingPoint::Vertex, static_cast<u32>(quad.size() * sizeof(VertexLayout))).setData(quad.data());
-
-    BufferDescriptor quad_positions_descriptor;
-    quad_positions_descriptor.reset().set(BufferUsage::VERTEX, BufferType::Static, BufferBindingPoint::Vertex, static_cast<u32>(quad_positions.size() * sizeof(glm::vec3))).setData(quad_positions.data());
-
-    BufferDescriptor quad_normals_descriptor;
-    quad_normals_descriptor.reset().set(BufferUsage::VERTEX, BufferType::Static, BufferBindingPoint::Vertex, static_cast<u32>(quad_normals.size() * sizeof(glm::vec3))).setData(quad_normals.data());
+ForwardPipeline::~ForwardPipeline() = default;
 
-    BufferDescriptor quad_uvs_descriptor;
-    quad_uvs_descriptor.reset().set(BufferUsage::VERTEX, BufferType::Static, BufferBindingPoint::Vertex, static_cast<u32>(quad_uvs.size() * sizeof(glm::vec2))).setData(quad_uvs.data());
+void ForwardPipeline::update_constants()
+{
+}
 
-    BufferDescriptor quad_colors_descriptor;
-    quad_colors_descriptor.reset().set(BufferUsage::VERTEX, BufferType::Static, BufferBindingPoint::Vertex, static_cast<u32>(quad_colors.size() * sizeof(glm::vec2))).setData(quad_colors.data());
+void ForwardPipeline::reload_shaders()
+{
+    // The old pipeline goes through the deletion queue, frames still in flight keep using it.
+    if (reloaded_pipeline.index != INVALID_ID && renderer->IsPipelineReady(reloaded_pipeline))
+    {
+        renderer->DestroyPipeline(pipeline);
+        pipeline          = reloaded_pipeline;
+        reloaded_pipeline = INVALID_PIPELINE;
+
+        const f32 elapsed_ms = std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - reload_start).count();
+        STRACE("Forward shaders reloaded in %.3f ms.", elapsed_ms);
+    }
+    else if (reloaded_pipeline.index != INVALID_ID && renderer->IsPipelineFailed(reloaded_pipeline))
+    {
+        SWARNING("Forward pipeline failed to compile, the previous pipeline is kept.");
+        renderer->DestroyPipeline(reloaded_pipeline);
+        reloaded_pipeline = INVALID_PIPELINE;
+    }
+
+    if (shader_reload.valid())
+    {
+        if (shader_reload.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            return;
+        }
 
-    BufferDescriptor index_quad_descriptor;
-    index_quad_descriptor.reset().set(BufferUsage::INDEX, BufferType::Static, BufferBindingPoint::Index, static_cast<u32>(quadIdx.size() * sizeof(u32))).setData(quadIdx.data());
+        // Shader modules come from the cache filled by the worker, the pipeline itself is built asynchronously.
+        const ShaderSources sources = shader_reload.get();
+        if (sources.bCompiled)
+        {
+            PipelineDescriptor descriptor = pipeline_descriptor;
+            SetShaders(descriptor.shaders, sources);
+
+            // A newer edit replaces a pipeline that was not ready yet.
+            if (reloaded_pipeline.index != INVALID_ID)
+            {
+                renderer->DestroyPipeline(reloaded_pipeline);
+            }
+            reloaded_pipeline = renderer->CreatePipelineAsync(descriptor);
+            if (reloaded_pipeline.index == INVALID_ID)
+            {
+                SWARNING("Forward pipeline could not be created, the previous pipeline is kept.");
+            }
+        }
+        else
+        {
+            SWARNING("Forward shaders failed to compile, the previous pipeline is kept.");
+        }
+    }
 
-    buffer_quad = renderer->CreateBuffer(std::move(quad_descriptor));
+    if (shader_watcher->PollChanges().empty())
+    {
+        return;
+    }
 
-    mesh.position_buffer = renderer->CreateBuffer(std::move(quad_positions_descriptor));
-    mesh.normal_buffer = renderer->CreateBuffer(std::move(quad_normals_descriptor));
-    mesh.uvs_buffer = renderer->CreateBuffer(std::move(quad_uvs_descriptor));
-    mesh.color_buffer = renderer->CreateBuffer(std::move(quad_colors_descriptor));
-    buffer_quad_index = renderer->CreateBuffer(std::move(index_quad_descriptor));
-}
+    reload_start = std::chrono::steady_clock::now();
 
-void ForwardPipeline::update_constants()
-{
+    auto result   = std::make_shared<std::promise<ShaderSources>>();
+    shader_reload = result->get_future();
+    CThreadPool::Get()->Submit([result, device = renderer, vertex = vertex_path, fragment = fragment_path]()
+                               { result->set_value(LoadShaders(device.get(), vertex, fragment)); });
 }
 
 void ForwardPipeline::render()
 {
-    renderer->BeginFrame();
+    SPROFILE_FUNCTION();
 
-    CommandBuffer* cmd = renderer->GetCommandBuffer(true);
+    reload_shaders();
 
-    // TODO we may want to send custom viewport and scissors.
-    cmd->set_viewport();
-    cmd->set_scissors();
+    renderer->BeginFrame();
 
-    cmd->bind_pass(renderer->GetSwapchainRenderpass());
-    cmd->bind_pipeline(pipeline);
+    CommandBuffer* cmd = renderer->GetCommandBuffer(true);
 
     // Update constants per frame data.
-    CEntity* eCamera = getEntityByName("camera");
+    CEntity* eCamera = camera_entity.Get();
     SASSERT(eCamera);
     TCompCamera* cCamera = eCamera->Get<TCompCamera>();
     SASSERT(cCamera);
-
-    auto camera_data = renderer->MapBuffer(camera_buffer, sizeof(ConstantsCamera));
-    ConstantsCamera camera_ctes;
-    camera_ctes.camera_view                    = cCamera->GetView();
-    camera_ctes.camera_projection              = cCamera->GetProjection();
-    camera_ctes.camera_view_projection         = cCamera->GetViewProjection();
-    camera_ctes.camera_inverse_view_projection = glm::inverse(cCamera->GetViewProjection());
-
-    memcpy(camera_data, &camera_ctes, sizeof(ConstantsCamera));
-    renderer->UnmapBuffer(camera_buffer);
-
-    auto mesh_data = renderer->MapBuffer(mesh_buffer, sizeof(ConstantsMesh));
-
-    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 5.0f));
-    ConstantsMesh mesh_ctes;
-    mesh_ctes.model = model;
-    mesh_ctes.color = glm::vec4(1.0f);
-
-    memcpy(mesh_data, &mesh_ctes, sizeof(ConstantsMesh));
-    renderer->UnmapBuffer(mesh_buffer);
-
-    u32 i = 0;
-    GetObjectManager<TCompPointLight>()->ForEach(
-        [&](TCompPointLight* light)
-        {
-            Light l;
-            l.color = light->color;
-            l.position = light->position;
-            l.intensity = light->intensity;
-            l.radius = light->radius;
-
-            auto light_data = renderer->MapBuffer(light_buffer, sizeof(Light), sizeof(Light) * i );
-
-            memcpy(light_data, &l, sizeof(Light));
-            renderer->UnmapBuffer(light_buffer);
-
-            ++i;
-        });
-
-    cmd->bind_vertex_buffer(mesh.position_buffer, 0, 0);
-    cmd->bind_vertex_buffer(mesh.normal_buffer, 1, 0);
-    cmd->bind_vertex_buffer(mesh.uvs_buffer, 2, 0);
-    cmd->bind_vertex_buffer(mesh.color_buffer, 3, 0);
-    cmd->bind_index_buffer(buffer_quad_index, 0);
-    cmd->bind_descriptor_set(descriptorSet, nullptr, 0);
-
-    cmd->draw_indexed(6, 1, 0, 0, 0);
+    cCamera->UpdateInterpolated(CEngine::Get()->GetInterpolationAlpha());
+
+    // Keys are only sorted again when something changed since last frame.
+    const glm::vec3 eye = glm::vec3(glm::inverse(cCamera->GetView())[3]);
+    RenderManager.PrepareFrame(eye, cCamera->GetFrustumPlanes());
+
+    const u32 nInstances = RenderManager.GetVisibleCount();
+    DynamicAllocation camera_data   = renderer->AllocateDynamic(sizeof(ConstantsCamera));
+    DynamicAllocation light_data    = renderer->AllocateDynamic(sizeof(Light) * MaxShaderLights);
+    DynamicAllocation instance_data = renderer->AllocateDynamic(static_cast<u32>(nInstances * sizeof(CRenderManager::InstanceData)));
+
+    // Nothing is drawn rather than writing out of the ring when the frame runs out of space, the pass only clears.
+    bDrawScene = camera_data.data && light_data.data && (instance_data.data || nInstances == 0);
+    if (bDrawScene)
+    {
+        ConstantsCamera* camera_ctes = static_cast<ConstantsCamera*>(camera_data.data);
+        camera_ctes->camera_view                    = cCamera->GetView();
+        camera_ctes->camera_projection              = cCamera->GetProjection();
+        camera_ctes->camera_view_projection         = cCamera->GetViewProjection();
+        camera_ctes->camera_inverse_view_projection = glm::inverse(cCamera->GetViewProjection());
+
+        Light* light_ctes = static_cast<Light*>(light_data.data);
+        memset(light_ctes, 0, sizeof(Light) * MaxShaderLights);
+
+        u32 i = 0;
+        GetObjectManager<TCompPointLight>()->ForEach(
+            [&](TCompPointLight* light)
+            {
+                if (i >= MaxShaderLights)
+                    return;
+
+                Light& l = light_ctes[i];
+                l.color = light->color;
+                l.position = light->position;
+                l.intensity = light->intensity;
+                l.radius = light->radius;
+
+                ++i;
+            });
+
+        RenderManager.BuildInstances(static_cast<CRenderManager::InstanceData*>(instance_data.data), nInstances, CEngine::Get()->GetInterpolationAlpha());
+
+        frame_offsets[0]      = camera_data.offset;
+        frame_offsets[1]      = light_data.offset;
+        frame_instance_offset = instance_data.offset;
+    }
+    else
+    {
+        // Clears the batches of the last frame.
+        RenderManager.BuildInstances(nullptr, 0, CEngine::Get()->GetInterpolationAlpha());
+    }
+
+    graph->Execute(cmd);
 
     renderer->QueueCommandBuffer(cmd);
 
     renderer->Present();
+}
 
-    // Bind constants per frame.
-    // Draw mesh instances.
-    // CommandBuffer* cmd;
-    // RenderManager.RenderAll(CHandle(), DrawChannel::SOLID, *cmd);
+void ForwardPipeline::render_forward(CommandBuffer* cmd, RenderPassHandle pass)
+{
+    // Every command buffer recording draws needs the whole state, secondaries don't inherit it from the primary.
+    auto bind_state = [&](CommandBuffer* target)
+    {
+        // TODO we may want to send custom viewport and scissors.
+        target->set_viewport();
+        target->set_scissors();
+        target->bind_pipeline(pipeline);
+        target->bind_descriptor_set(descriptorSet, frame_offsets, 2);
+        target->bind_vertex_buffer(renderer->GetDynamicBuffer(), 1, frame_instance_offset);
+    };
+
+    if (!bDrawScene)
+    {
+        cmd->bind_pass(pass, false);
+        return;
+    }
+
+    // Big scenes are recorded by the thread pool in secondary command buffers.
+    const u32 nRecordingThreads = RenderManager.GetRecordingThreads(DrawChannel::SOLID, renderer->GetMaxRecordingThreads());
+    cmd->bind_pass(pass, nRecordingThreads > 1);
+
+    if (nRecordingThreads > 1)
+    {
+        RenderManager.RenderAllParallel(DrawChannel::SOLID, renderer.get(), cmd, nRecordingThreads, bind_state);
+    }
+    else
+    {
+        bind_state(cmd);
+        RenderManager.RenderAll(DrawChannel::SOLID, cmd);
+    }
 }
 
 void ForwardPipeline::destroy()
 {
-    renderer->DestroyBuffer(buffer_quad);
-    renderer->DestroyBuffer(buffer_quad_index);
-
-    renderer->DestroyBuffer(mesh.position_buffer);
-    renderer->DestroyBuffer(mesh.normal_buffer);
-    renderer->DestroyBuffer(mesh.uvs_buffer);
-    renderer->DestroyBuffer(mesh.color_buffer);
-
-    renderer->DestroyBuffer(camera_buffer);
-    renderer->DestroyBuffer(mesh_buffer);
-    renderer->DestroyBuffer(light_buffer);
+    shader_watcher->Stop();
+    if (shader_reload.valid())
+    {
+        shader_reload.wait();
+    }
+    if (reloaded_pipeline.index != INVALID_ID)
+    {
+        renderer->DestroyPipeline(reloaded_pipeline);
+    }
+
+    graph->Shutdown();
+
+    // The layout belongs to the device.
     renderer->DestroyDescriptorSet(descriptorSet);
-    renderer->DestroyDescriptorSetLayout(descriptorLayout);
     renderer->DestroyPipeline(pipeline);
 }
 } // namespace Sogas
@@ -1,113 +1,458 @@
 
+#include "components/aabb_component.h"
 #include "components/transform_component.h"
 #include "engine.h"
+#include "jobs/thread_pool.h"
 #include "entity/entity.h"
 #include "render/module_render.h"
 #include "render/render_manager.h"
+#include "renderer/public/render_device.h"
 #include "resources/mesh.h"
 #include "resources/material.h"
 
+#include <chrono>
+
 namespace Sogas
 {
     CRenderManager RenderManager;
 
-    struct ConstantsMesh
+    static u32 HandleAsKey(CHandle h)
+    {
+        return (h.GetType() << (CHandle::nBitsIndex + CHandle::nBitsAge))
+            | (h.GetExternalIndex() << CHandle::nBitsAge)
+            | h.GetAge();
+    }
+
+    // Splitting fewer batches costs more in secondary begin and state binds than it saves.
+    static const u32 MinBatchesPerRecordingThread = 256;
+
+    using RecordClock = std::chrono::high_resolution_clock;
+
+    static f32 ElapsedMs(RecordClock::time_point start)
     {
-        glm::mat4 model;
-        glm::vec4 color;
-    };
+        return std::chrono::duration<f32, std::milli>(RecordClock::now() - start).count();
+    }
+
+    // Depth is quantized in a log scale, coarse enough so small camera moves don't force a sort.
+    static const f32 MaxSortDepth = 1000.0f;
+    static const u32 DepthBits = 10;
+
+    static u16 QuantizeDepth(f32 distance)
+    {
+        const f32 normalized = std::clamp(std::log2(1.0f + distance) / std::log2(1.0f + MaxSortDepth), 0.0f, 1.0f);
+        const u32 quantized = static_cast<u32>(normalized * ((1 << DepthBits) - 1));
+        return static_cast<u16>(quantized << (16 - DepthBits));
+    }
 
     CRenderManager::CRenderManager()
     {
-        DrawCallsPerChannel.resize(static_cast<u32>(DrawChannel::COUNT));
+        keys.reserve(1024);
     }
 
-    void CRenderManager::AddKey(CHandle owner, const CMesh* mesh, const Material* InMaterial)
+    u16 CRenderManager::GetResourceId(const void* resource)
+    {
+        auto it = ResourceIds.find(resource);
+        if(it != ResourceIds.end())
+            return it->second;
+
+        // 0 is reserved for no resource.
+        if(ResourceIds.size() >= 0xFFFF)
+        {
+            SWARNING("Too many resources to sort render keys, sorting may not be optimal.");
+            return 0xFFFF;
+        }
+
+        const u16 id = static_cast<u16>(ResourceIds.size() + 1);
+        ResourceIds[resource] = id;
+        return id;
+    }
+
+    /** Opaque channels are sorted by state first and front to back, transparent back to front.*/
+    u64 CRenderManager::ComputeSortKey(const Key& key) const
+    {
+        const u64 channel = static_cast<u64>(key.Channel) & 0xF;
+        const u64 pipeline = key.Pipeline & 0xFFF;
+
+        if(key.Channel == DrawChannel::TRANSPARENT)
+        {
+            const u64 depth = 0xFFFF - key.Depth;
+            return (channel << 60) | (depth << 44) | (pipeline << 32) | (static_cast<u64>(key.MaterialId) << 16) | key.MeshId;
+        }
+
+        return (channel << 60) | (pipeline << 48) | (static_cast<u64>(key.MaterialId) << 32) | (static_cast<u64>(key.MeshId) << 16) | key.Depth;
+    }
+
+    void CRenderManager::AddKey(CHandle owner, const CMesh* mesh, const Material* InMaterial, DrawChannel channel, u16 pipeline)
     {
         SASSERT(owner.IsValid());
         SASSERT(mesh);
         SASSERT(InMaterial);
 
+        // Keys of an owner must be contiguous, move them to the end if someone was added after it.
+        const u32 ownerKey = HandleAsKey(owner);
+        auto it = OwnerRanges.find(ownerKey);
+        if(it != OwnerRanges.end() && it->second.First + it->second.Count != keys.size())
+        {
+            const OwnerRange range = it->second;
+            it->second = {static_cast<u32>(keys.size()), 0};
+            for(u32 i = range.First; i < range.First + range.Count; ++i)
+            {
+                keys.push_back(keys[i]);
+                keys[i].Mesh = nullptr;
+                ++it->second.Count;
+                ++nDeadKeys;
+            }
+        }
+        else if(it == OwnerRanges.end())
+        {
+            it = OwnerRanges.insert({ownerKey, {static_cast<u32>(keys.size()), 0}}).first;
+        }
+
         Key key;
         key.Mesh        = mesh;
         key.Material    = InMaterial;
         key.Owner       = owner;
         key.Transform   = CHandle();
         key.AABB        = CHandle();
+        key.Pipeline    = pipeline;
+        key.MaterialId  = GetResourceId(InMaterial);
+        key.MeshId      = GetResourceId(mesh);
+        key.Depth       = 0;
+        key.Channel     = channel;
 
         CEntity* entity = owner.GetOwner();
         SASSERT(entity);
 
         key.Transform = entity->Get<TCompTransform>();
+        key.AABB = entity->Get<TCompAABB>();
+        key.SortKey = ComputeSortKey(key);
 
         keys.push_back(key);
+        ++it->second.Count;
+        KeysAreDirty = true;
+    }
+
+    void CRenderManager::Compact()
+    {
+        u32 dst = 0;
+        for(u32 src = 0; src < keys.size(); ++src)
+        {
+            if(!keys[src].Mesh)
+                continue;
+
+            const u32 ownerKey = HandleAsKey(keys[src].Owner);
+            OwnerRange& range = OwnerRanges[ownerKey];
+            // First key found of this owner, ranges keep being contiguous after compacting.
+            if(dst == 0 || HandleAsKey(keys[dst - 1].Owner) != ownerKey)
+                range.First = dst;
+
+            if(src != dst)
+                keys[dst] = keys[src];
+            ++dst;
+        }
+
+        keys.resize(dst);
+        nDeadKeys = 0;
         KeysAreDirty = true;
     }
 
-    // void CRenderManager::RenderAll(CHandle /*camera_handle*/, DrawChannel channel, CommandBuffer cmd)
-    // {
-    //     auto renderer = CEngine::Get()->GetRenderModule()->GetGraphicsDevice();
+    void CRenderManager::Sort()
+    {
+        const u32 nKeys = static_cast<u32>(keys.size());
 
-    //     // TODO If keys are dirty, sort keys
+        SortBuffer.resize(nKeys);
+        SortScratch.resize(nKeys);
+        for(u32 i = 0; i < nKeys; ++i)
+        {
+            keys[i].SortKey = ComputeSortKey(keys[i]);
+            SortBuffer[i] = {keys[i].SortKey, i};
+        }
 
-    //     u32 nDrawCalls = 0;
-    //     DrawCallsPerChannel[static_cast<u32>(channel)] = 0;
+        // LSD radix sort, 8 bits per pass. Passes where every key shares the digit are skipped.
+        u32 histograms[8][256] = {};
+        for(const auto& entry : SortBuffer)
+        {
+            for(u32 pass = 0; pass < 8; ++pass)
+                ++histograms[pass][(entry.first >> (pass * 8)) & 0xFF];
+        }
 
-    //     auto it = keys.begin();
+        for(u32 pass = 0; pass < 8; ++pass)
+        {
+            u32* histogram = histograms[pass];
+            if(nKeys == 0 || histogram[(SortBuffer[0].first >> (pass * 8)) & 0xFF] == nKeys)
+                continue;
 
-    //     Key null_key = Key{};
-    //     const Key* prev_key = &null_key;
-    //     const Key* key = &null_key;
+            u32 offset = 0;
+            for(u32 i = 0; i < 256; ++i)
+            {
+                const u32 count = histogram[i];
+                histogram[i] = offset;
+                offset += count;
+            }
 
-    //     while(it != keys.end())
-    //     {
-    //         key = &(*it);
+            for(const auto& entry : SortBuffer)
+                SortScratch[histogram[(entry.first >> (pass * 8)) & 0xFF]++] = entry;
 
-    //         // Check if visible by culling test.
+            std::swap(SortBuffer, SortScratch);
+        }
 
-    //         if (key->Transform.IsValid())
-    //         {
-    //             CEntity* e = key->Owner.GetOwner();
-    //             TCompTransform* transform = e->Get<TCompTransform>();
-    //             SASSERT(transform);
-    //             glm::vec4 color = glm::vec4(1.0f);
+        SortedKeys.resize(nKeys);
+        for(u32 i = 0; i < nKeys; ++i)
+            SortedKeys[i] = SortBuffer[i].second;
 
-    //             // Activate model and color
-    //             ConstantsMesh cte;
-    //             cte.model = transform->AsMatrix();
-    //             cte.color = color;
-                
-    //             //renderer->PushConstants(&cte, sizeof(ConstantsMesh), cmd);
-    //         }
+        // Channel lives in the top bits, each channel is a contiguous range.
+        u32 first = 0;
+        for(u32 c = 0; c < static_cast<u32>(DrawChannel::COUNT); ++c)
+        {
+            u32 last = first;
+            while(last < nKeys && (SortBuffer[last].first >> 60) == c)
+                ++last;
+            ChannelRanges[c] = {first, last};
+            first = last;
+        }
 
-    //         // Activate material
-    //         if (key->Material != prev_key->Material) {
-    //             key->Material->Activate(cmd);
-    //         }
+        KeysAreDirty = false;
+        ++FrameStats.Sorts;
+    }
 
-    //         // Activate mesh
-    //         if( key->Mesh != prev_key->Mesh)
-    //         {
-    //             key->Mesh->Activate(cmd);
-    //         }
+    void CRenderManager::Cull(const glm::vec4* frustumPlanes)
+    {
+        SPROFILE_FUNCTION();
 
-    //         //renderer->UpdateDescriptorSet(cmd.activePipeline);
+        const u32 nKeys = static_cast<u32>(SortedKeys.size());
+        Bounds.Resize(nKeys);
+        Visible.resize(nKeys);
 
-    //         key->Mesh->Render(cmd);
-            
-    //         prev_key = key;
-    //         ++nDrawCalls;
-    //         ++it;
-    //     }
+        // Bounds are gathered in sorted order by the same batch that tests them.
+        const u32 nVisible = CullAABBsParallel(frustumPlanes, Bounds, nKeys, Visible.data(), [this](u32 begin, u32 end)
+        {
+            for(u32 i = begin; i < end; ++i)
+            {
+                TCompAABB* aabb = keys[SortedKeys[i]].AABB;
+                if(aabb)
+                    Bounds.Set(i, aabb->world);
+                else
+                    Bounds.SetInfinite(i);
+            }
+        });
 
-    //     DrawCallsPerChannel[static_cast<u32>(channel)] = nDrawCalls;
-    // }
+        VisibleKeys.resize(nVisible);
+        u32 nWritten = 0;
+        for(u32 c = 0; c < static_cast<u32>(DrawChannel::COUNT); ++c)
+        {
+            const auto& range = ChannelRanges[c];
+            VisibleRanges[c].first = nWritten;
+            for(u32 i = range.first; i < range.second; ++i)
+            {
+                if(Visible[i])
+                    VisibleKeys[nWritten++] = SortedKeys[i];
+            }
+            VisibleRanges[c].second = nWritten;
+        }
 
-    void CRenderManager::DeleteKeysFromOwner(CHandle owner)
+        FrameStats.Culled = nKeys - nVisible;
+    }
+
+    void CRenderManager::PrepareFrame(const glm::vec3& eye, const glm::vec4* frustumPlanes)
+    {
+        SPROFILE_FUNCTION();
+
+        if(nDeadKeys)
+            Compact();
+
+        for(auto& key : keys)
+        {
+            TCompTransform* transform = key.Transform;
+            if(!transform)
+                continue;
+
+            const u16 depth = QuantizeDepth(glm::length(transform->GetPosition() - eye));
+            if(depth != key.Depth)
+            {
+                key.Depth = depth;
+                KeysAreDirty = true;
+            }
+        }
+
+        if(KeysAreDirty)
+            Sort();
+
+        Cull(frustumPlanes);
+
+        // Count the draws and binds the frame will need.
+        for(u32 c = 0; c < static_cast<u32>(DrawChannel::COUNT); ++c)
+        {
+            u32 nDrawCalls = 0;
+            u32 nInstances = 0;
+            u32 nStateChanges = 0;
+            const Key* previous = nullptr;
+
+            // Keys sharing pipeline, material and mesh with the previous one are drawn as an instance of it.
+            ForEachKey(static_cast<DrawChannel>(c), [&](const Key& key)
+            {
+                const u32 nChanges = ((!previous || previous->Pipeline != key.Pipeline) ? 1 : 0)
+                    + ((!previous || previous->Material != key.Material) ? 1 : 0)
+                    + ((!previous || previous->Mesh != key.Mesh) ? 1 : 0);
+                nStateChanges += nChanges;
+                nDrawCalls += nChanges > 0 ? 1 : 0;
+                previous = &key;
+                ++nInstances;
+            });
+
+            FrameStats.DrawCalls[c] = nDrawCalls;
+            FrameStats.Instances[c] = nInstances;
+            FrameStats.StateChanges[c] = nStateChanges;
+        }
+    }
+
+    u32 CRenderManager::BuildInstances(InstanceData* instances, u32 maxInstances, f32 alpha)
+    {
+        SPROFILE_FUNCTION();
+
+        Batches.clear();
+
+        u32 nInstances = 0;
+        for(u32 c = 0; c < static_cast<u32>(DrawChannel::COUNT); ++c)
+        {
+            BatchRanges[c].first = static_cast<u32>(Batches.size());
+
+            const Key* previous = nullptr;
+            ForEachKey(static_cast<DrawChannel>(c), [&](const Key& key)
+            {
+                if(nInstances >= maxInstances)
+                    return;
+
+                TCompTransform* transform = key.Transform;
+                InstanceData& instance = instances[nInstances];
+                instance.Model = transform ? transform->AsInterpolatedMatrix(alpha) : glm::mat4(1.0f);
+                instance.Color = glm::vec4(1.0f);
+
+                const bool bMerge = previous
+                    && previous->Pipeline == key.Pipeline
+                    && previous->Mesh == key.Mesh
+                    && previous->Material == key.Material;
+
+                if(bMerge)
+                    ++Batches.back().InstanceCount;
+                else
+                    Batches.push_back({key.Mesh, key.Material, nInstances, 1});
+
+                previous = &key;
+                ++nInstances;
+            });
+
+            BatchRanges[c].second = static_cast<u32>(Batches.size());
+        }
+
+        if(nInstances >= maxInstances)
+        {
+            SWARNING("Instance buffer full, only %d instances are drawn.", maxInstances);
+        }
+
+        return nInstances;
+    }
+
+    void CRenderManager::RecordBatches(u32 first, u32 last, CommandBuffer* cmd) const
+    {
+        // The render pipeline binds its single pipeline before recording, the key pipeline only groups the batches.
+        const CMesh* activeMesh = nullptr;
+        const Material* activeMaterial = nullptr;
+
+        for(u32 i = first; i < last; ++i)
+        {
+            const DrawBatch& batch = Batches[i];
+
+            if(batch.Material && batch.Material != activeMaterial)
+            {
+                batch.Material->Activate(cmd);
+                activeMaterial = batch.Material;
+            }
+
+            if(batch.Mesh != activeMesh)
+            {
+                batch.Mesh->Activate(cmd);
+                activeMesh = batch.Mesh;
+            }
+
+            batch.Mesh->Render(cmd, batch.InstanceCount, batch.FirstInstance);
+        }
+    }
+
+    void CRenderManager::RenderAll(DrawChannel channel, CommandBuffer* cmd)
+    {
+        SPROFILE_FUNCTION();
+
+        const auto start = RecordClock::now();
+
+        const auto& range = BatchRanges[static_cast<u32>(channel)];
+        RecordBatches(range.first, range.second, cmd);
+
+        FrameStats.RecordMs = ElapsedMs(start);
+        FrameStats.RecordThreads = 1;
+    }
+
+    u32 CRenderManager::GetRecordingThreads(DrawChannel channel, u32 maxThreads) const
+    {
+        const auto& range = BatchRanges[static_cast<u32>(channel)];
+        const u32 nBatches = range.second - range.first;
+        const u32 nThreads = std::min(maxThreads, CThreadPool::Get()->GetNumThreads() + 1);
+        return std::max(1u, std::min(nThreads, nBatches / MinBatchesPerRecordingThread));
+    }
+
+    void CRenderManager::RenderAllParallel(DrawChannel channel, GPU_device* device, CommandBuffer* cmd, u32 nThreads,
+        const std::function<void(CommandBuffer*)>& bindState)
     {
-        auto it = std::remove_if(keys.begin(), keys.end(), [owner](const Key& k){
-            return k.Owner == owner;
+        SPROFILE_FUNCTION();
+
+        const auto start = RecordClock::now();
+
+        const auto& range = BatchRanges[static_cast<u32>(channel)];
+        const u32 nBatches = range.second - range.first;
+        const u32 batchesPerThread = (nBatches + nThreads - 1) / nThreads;
+
+        Secondaries.assign(nThreads, nullptr);
+
+        // One batch per job, the job index picks the command pool so no pool is recorded from two threads.
+        CThreadPool::Get()->ParallelFor(nThreads, 1, [&](u32 begin, u32 end)
+        {
+            for(u32 t = begin; t < end; ++t)
+            {
+                CommandBuffer* secondary = device->GetSecondaryCommandBuffer(t, cmd);
+                if(!secondary)
+                    continue;
+
+                const u32 first = range.first + std::min(nBatches, t * batchesPerThread);
+                const u32 last = range.first + std::min(nBatches, (t + 1) * batchesPerThread);
+
+                bindState(secondary);
+                RecordBatches(first, last, secondary);
+                secondary->end();
+
+                Secondaries[t] = secondary;
+            }
         });
-        keys.erase(it, keys.end());
+
+        // Secondaries that couldn't be allocated are skipped, their batches are not drawn this frame.
+        Secondaries.erase(std::remove(Secondaries.begin(), Secondaries.end(), nullptr), Secondaries.end());
+        cmd->execute_commands(Secondaries.data(), static_cast<u32>(Secondaries.size()));
+
+        FrameStats.RecordMs = ElapsedMs(start);
+        FrameStats.RecordThreads = nThreads;
+    }
+
+    void CRenderManager::DeleteKeysFromOwner(CHandle owner)
+    {
+        auto it = OwnerRanges.find(HandleAsKey(owner));
+        if(it == OwnerRanges.end())
+            return;
+
+        // Keys are only flagged, they are compacted before the next sort.
+        const OwnerRange range = it->second;
+        for(u32 i = range.First; i < range.First + range.Count; ++i)
+            keys[i].Mesh = nullptr;
+
+        nDeadKeys += range.Count;
+        OwnerRanges.erase(it);
+        KeysAreDirty = true;
     }
 } // Sogas
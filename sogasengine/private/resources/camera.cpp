@@ -5,6 +5,22 @@ namespace Sogas
     void CCamera::updateViewProjection()
     {
         view_projection = view * projection;
+        updateFrustumPlanes();
+    }
+
+    void CCamera::updateFrustumPlanes()
+    {
+        // Gribb-Hartmann, planes are the rows of the clip matrix combined.
+        const glm::mat4 m = glm::transpose(projection * view);
+        frustumPlanes[0] = m[3] + m[0];
+        frustumPlanes[1] = m[3] - m[0];
+        frustumPlanes[2] = m[3] + m[1];
+        frustumPlanes[3] = m[3] - m[1];
+        frustumPlanes[4] = m[3] + m[2];
+        frustumPlanes[5] = m[3] - m[2];
+
+        for(auto& plane : frustumPlanes)
+            plane /= glm::length(glm::vec3(plane));
     }
 
     void CCamera::lookAt(const glm::vec3 eye, const glm::vec3 target, const glm::vec3 up)
@@ -0,0 +1,149 @@
+#include "resources/file_watcher.h"
+
+#include <filesystem>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace Sogas
+{
+    // Time a file must stay untouched before its change is reported.
+    static const std::chrono::milliseconds SettleTime(100);
+    // How often the thread checks for changes or for Stop.
+    static const std::chrono::milliseconds PollInterval(100);
+
+    void CFileWatcher::Watch(const std::string& filename)
+    {
+        SASSERT(!Thread.joinable());
+
+        std::error_code error;
+        const std::filesystem::path path = std::filesystem::weakly_canonical(filename, error);
+        Files.push_back(error ? filename : path.string());
+    }
+
+    void CFileWatcher::Start()
+    {
+        if(Thread.joinable() || Files.empty())
+            return;
+
+        bStopping = false;
+        Thread = std::thread(&CFileWatcher::WatchLoop, this);
+    }
+
+    void CFileWatcher::Stop()
+    {
+        if(!Thread.joinable())
+            return;
+
+        bStopping = true;
+        Thread.join();
+    }
+
+    std::vector<std::string> CFileWatcher::PollChanges()
+    {
+        std::vector<std::string> changes;
+        const Clock::time_point now = Clock::now();
+
+        std::lock_guard<std::mutex> lock(Mutex);
+        for(auto it = Changed.begin(); it != Changed.end();)
+        {
+            if(now - it->second >= SettleTime)
+            {
+                changes.push_back(it->first);
+                it = Changed.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        return changes;
+    }
+
+    void CFileWatcher::MarkChanged(const std::string& filename)
+    {
+        if(std::find(Files.begin(), Files.end(), filename) == Files.end())
+            return;
+
+        std::lock_guard<std::mutex> lock(Mutex);
+        Changed[filename] = Clock::now();
+    }
+
+#if defined(__linux__)
+    void CFileWatcher::WatchLoop()
+    {
+        const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if(fd < 0)
+        {
+            SERROR("Could not initialize inotify, file changes are not watched.");
+            return;
+        }
+
+        // Directories are watched instead of the files, editors often save by writing a new file and renaming it.
+        std::unordered_map<int, std::string> directories;
+        for(const auto& file : Files)
+        {
+            const std::string directory = std::filesystem::path(file).parent_path().string();
+            const int wd = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+            if(wd < 0)
+                SWARNING("Could not watch directory %s.", directory.c_str());
+            else
+                directories[wd] = directory;
+        }
+
+        alignas(inotify_event) char buffer[4096];
+        pollfd descriptor = {fd, POLLIN, 0};
+
+        while(!bStopping)
+        {
+            if(poll(&descriptor, 1, static_cast<int>(PollInterval.count())) <= 0)
+                continue;
+
+            ssize_t length;
+            while((length = read(fd, buffer, sizeof(buffer))) > 0)
+            {
+                for(char* ptr = buffer; ptr < buffer + length;)
+                {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+                    ptr += sizeof(inotify_event) + event->len;
+
+                    auto directory = directories.find(event->wd);
+                    if(event->len > 0 && directory != directories.end())
+                        MarkChanged((std::filesystem::path(directory->second) / event->name).string());
+                }
+            }
+        }
+
+        close(fd);
+    }
+#else
+    void CFileWatcher::WatchLoop()
+    {
+        std::vector<std::filesystem::file_time_type> times(Files.size());
+
+        std::error_code error;
+        for(size_t i = 0; i < Files.size(); ++i)
+            times[i] = std::filesystem::last_write_time(Files[i], error);
+
+        while(!bStopping)
+        {
+            std::this_thread::sleep_for(PollInterval);
+
+            for(size_t i = 0; i < Files.size(); ++i)
+            {
+                const std::filesystem::file_time_type time = std::filesystem::last_write_time(Files[i], error);
+                if(!error && time != times[i])
+                {
+                    times[i] = time;
+                    MarkChanged(Files[i]);
+                }
+            }
+        }
+    }
+#endif
+
+} // Sogas
@@ -47,6 +47,25 @@ bool Material::CreateFromJson(const json& j)
 
     std::string emissive_name = j.value("emissive", "");
     emissive                  = emissive_name.empty() ? CResourceManager::Get()->GetResource("white.text")->As<Texture>() : CResourceManager::Get()->GetResource(emissive_name)->As<Texture>();
+
+    auto renderer = CEngine::Get()->GetRenderModule()->GetGraphicsDevice();
+    bindless      = renderer->IsBindlessSupported();
+    if (bindless)
+    {
+        // Textures that failed to load read the white texture instead of an empty slot.
+        const u32 white_index = renderer->GetBindlessIndex(CResourceManager::Get()->GetResource("white.text")->As<Texture>()->handle);
+        auto      GetIndex    = [&](const Texture* InTexture)
+        {
+            const u32 index = renderer->GetBindlessIndex(InTexture->handle);
+            return index != INVALID_ID ? index : white_index;
+        };
+
+        constants.albedo             = GetIndex(albedo);
+        constants.normal             = GetIndex(normal);
+        constants.metallic_roughness = GetIndex(metallic_roughness);
+        constants.emissive           = GetIndex(emissive);
+    }
+
     return true;
 }
 
@@ -58,14 +77,14 @@ void Material::Destroy()
     emissive           = nullptr;
 }
 
-// void Material::Activate(Renderer::CommandBuffer /*cmd*/) const
-// {
-//     auto renderer = CEngine::Get()->GetRenderModule()->GetGraphicsDevice();
-//     // renderer->BindTexture(albedo, cmd.activePipeline, 0, 1);
-//     // renderer->BindTexture(normal, cmd.activePipeline, 1, 1);
-//     // renderer->BindTexture(metallic_roughness, cmd.activePipeline, 2, 1);
-//     // renderer->BindTexture(emissive, cmd.activePipeline, 3, 1);
-// }
+void Material::Activate(Renderer::CommandBuffer* cmd) const
+{
+    // No descriptor set per material, the shaders read the textures from the bindless heap.
+    if (bindless)
+    {
+        cmd->push_constants(&constants, sizeof(Constants));
+    }
+}
 
 template <>
 IResourceType* GetResourceType<Material>()
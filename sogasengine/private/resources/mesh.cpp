@@ -16,60 +16,79 @@ bool CMesh::Create(std::vector<Renderer::VertexLayout> vs, std::vector<u32> is,
     this->indices     = is;
     this->vertexCount = static_cast<u32>(vs.size());
 
-    // Renderer::BufferDescriptor vertexBufferDescriptor;
-    // vertexBufferDescriptor.binding     = Renderer::BufferBindingPoint::Vertex;
-    // vertexBufferDescriptor.usage       = Renderer::BufferUsage::TRANSFER_DST;
-    // vertexBufferDescriptor.size        = static_cast<u32>(vs.size());
-    // vertexBufferDescriptor.elementSize = sizeof(Renderer::VertexLayout);
-    // vertexBuffer                       = device.lock()->CreateBuffer(vertexBufferDescriptor, vs.data());
+    // Empty meshes get a degenerate box at the origin.
+    glm::vec3 min = vs.empty() ? glm::vec3(0.0f) : vs[0].position;
+    glm::vec3 max = min;
+    for (const auto& v : vs)
+    {
+        min = glm::min(min, v.position);
+        max = glm::max(max, v.position);
+    }
+    aabb = AABB::FromMinMax(min, max);
 
-    // if (!is.empty())
-    // {
-    //     Indexed          = true;
-    //     this->indexCount = static_cast<u32>(is.size());
-    //     Renderer::BufferDescriptor indexBufferDescriptor;
-    //     indexBufferDescriptor.binding     = Renderer::BufferBindingPoint::Index;
-    //     indexBufferDescriptor.usage       = Renderer::BufferUsage::TRANSFER_DST;
-    //     indexBufferDescriptor.size        = static_cast<u32>(indices.size());
-    //     indexBufferDescriptor.elementSize = sizeof(u32);
-    //     indexBuffer                       = device.lock()->CreateBuffer(indexBufferDescriptor, is.data());
-    // }
+    auto renderer = device.lock();
+
+    Renderer::BufferDescriptor vertexBufferDescriptor;
+    vertexBufferDescriptor.reset()
+      .set(BufferUsage::VERTEX, BufferType::Static, BufferBindingPoint::Vertex, static_cast<u32>(vertices.size() * sizeof(VertexLayout)))
+      .setData(vertices.data());
+    vertexBuffer = renderer->CreateBuffer(vertexBufferDescriptor);
+
+    if (!indices.empty())
+    {
+        Indexed          = true;
+        this->indexCount = static_cast<u32>(indices.size());
+
+        Renderer::BufferDescriptor indexBufferDescriptor;
+        indexBufferDescriptor.reset()
+          .set(BufferUsage::INDEX, BufferType::Static, BufferBindingPoint::Index, static_cast<u32>(indices.size() * sizeof(u32)))
+          .setData(indices.data());
+        indexBuffer = renderer->CreateBuffer(indexBufferDescriptor);
+    }
 
     return true;
 }
 
-// void CMesh::Activate(CommandBuffer /*cmd*/) const
-// {
-//     // device.lock()->BindVertexBuffer(vertexBuffer, cmd);
+void CMesh::Activate(CommandBuffer* cmd) const
+{
+    cmd->bind_vertex_buffer(vertexBuffer, 0, 0);
 
-//     // if (Indexed)
-//     // {
-//     //     device.lock()->BindIndexBuffer(indexBuffer, cmd);
-//     // }
-// }
+    if (Indexed)
+    {
+        cmd->bind_index_buffer(indexBuffer, 0);
+    }
+}
 
-// void CMesh::Render(CommandBuffer cmd) const
-// {
-//     if (Indexed)
-//     {
-//         device.lock()->DrawIndexed(static_cast<u32>(indices.size()), indexOffset, cmd);
-//     }
-//     else
-//     {
-//         device.lock()->Draw(static_cast<u32>(vertices.size()), vertexOffset, cmd);
-//     }
-// }
+void CMesh::Render(CommandBuffer* cmd, u32 instanceCount, u32 firstInstance) const
+{
+    if (Indexed)
+    {
+        cmd->draw_indexed(indexCount, instanceCount, indexOffset, static_cast<i32>(vertexOffset), firstInstance);
+    }
+    else
+    {
+        cmd->draw(vertexOffset, vertexCount, firstInstance, instanceCount);
+    }
+}
 
 void CMesh::Destroy()
 {
-    // if (vertexBuffer && vertexBuffer->isValid())
-    // {
-    //     vertexBuffer->Release();
-    // }
-    // if (indexBuffer && indexBuffer->isValid())
-    // {
-    //     indexBuffer->Release();
-    // }
+    auto renderer = device.lock();
+    if (!renderer)
+    {
+        return;
+    }
+
+    if (vertexBuffer.index != INVALID_ID)
+    {
+        renderer->DestroyBuffer(vertexBuffer);
+        vertexBuffer = INVALID_BUFFER;
+    }
+    if (indexBuffer.index != INVALID_ID)
+    {
+        renderer->DestroyBuffer(indexBuffer);
+        indexBuffer = INVALID_BUFFER;
+    }
 }
 
 } // namespace Sogas
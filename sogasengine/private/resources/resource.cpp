@@ -35,7 +35,11 @@ namespace Sogas
         SASSERT(resourceType);
 
         // Load resource.
-        IResource *newResource = resourceType->Create(name);
+        IResource *newResource = nullptr;
+        {
+            SPROFILE_ZONE("Resource load");
+            newResource = resourceType->Create(name);
+        }
 
         if (newResource == nullptr)
         {
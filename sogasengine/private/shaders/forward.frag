@@ -1,5 +1,9 @@
 #version 450
 
+#ifdef BINDLESS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
+
 layout(location = 0) in vec4 InColor;
 layout(location = 1) in vec3 InNormal;
 layout(location = 2) in vec2 InUv;
@@ -19,10 +23,18 @@ layout(set = 0, binding = 2) uniform Lights
     Light light[MAX_LIGHTS];
 } LightUniform;
 
-// layout(set = 1, binding = 0) uniform sampler2D diffuse;
-// layout(set = 1, binding = 1) uniform sampler2D normal;
-// layout(set = 1, binding = 2) uniform sampler2D metallic_roughness;
-// layout(set = 1, binding = 3) uniform sampler2D emissive;
+#ifdef BINDLESS
+// Every texture of the device, materials give the indices of theirs.
+layout(set = 1, binding = 0) uniform sampler2D Textures[];
+
+layout(push_constant) uniform MaterialConstants
+{
+    uint albedo;
+    uint normal;
+    uint metallic_roughness;
+    uint emissive;
+} Material;
+#endif
 
 layout(location = 0) out vec4 OutColor;
 
@@ -32,10 +44,17 @@ const vec3 red = vec3(1.0, 0.0, 0.0);
 void main() 
 {
     vec3    N                   = normalize(InNormal);
-    vec3    diffuse_color       = InColor.xyz; // * texture(diffuse, InUv).xyz;
-    vec3    normal_color        = white; //texture(normal, InUv).xyz;
-    vec3    metallic_roughness  = white; //texture(metallic_roughness, InUv).xyz;
-    vec3    emissive            = white; //texture(emissive, InUv).xyz;
+#ifdef BINDLESS
+    vec3    diffuse_color       = InColor.xyz * texture(Textures[Material.albedo], InUv).xyz;
+    vec3    normal_color        = texture(Textures[Material.normal], InUv).xyz;
+    vec3    metallic_roughness  = texture(Textures[Material.metallic_roughness], InUv).xyz;
+    vec3    emissive            = texture(Textures[Material.emissive], InUv).xyz;
+#else
+    vec3    diffuse_color       = InColor.xyz;
+    vec3    normal_color        = white;
+    vec3    metallic_roughness  = white;
+    vec3    emissive            = white;
+#endif
     float   ambientLight        = 0.1;
 
     vec3 light = vec3(ambientLight);
@@ -50,5 +69,5 @@ void main()
     }
 
     //OutColor = vec4(diffuse_color * light, 1.0);
-    OutColor = vec4(InColor.xyz, 1.0);
+    OutColor = vec4(diffuse_color, 1.0);
 }
\ No newline at end of file
@@ -5,6 +5,13 @@ layout(location = 1) in vec3 InNormal;
 layout(location = 2) in vec2 InUv;
 layout(location = 3) in vec4 InColor;
 
+// Per instance
+layout(location = 4) in vec4 InModel0;
+layout(location = 5) in vec4 InModel1;
+layout(location = 6) in vec4 InModel2;
+layout(location = 7) in vec4 InModel3;
+layout(location = 8) in vec4 InInstanceColor;
+
 layout(location = 0) out vec4 OutColor;
 layout(location = 1) out vec3 OutNormal;
 layout(location = 2) out vec2 OutUv;
@@ -18,18 +25,12 @@ layout( set = 0, binding = 0) uniform UniformBufferObject
     mat4 inverse_view_projection;
 } Camera;
 
-layout ( binding = 1 ) uniform MeshObject
-{
-    mat4 model;
-    vec4 color;
-} mesh;
-
 const vec3 red = vec3(1.0, 0.0, 0.0);
 
 void main() 
 {
-    mat4 model          = mesh.model;
-    vec4 color          = mesh.color;
+    mat4 model          = mat4(InModel0, InModel1, InModel2, InModel3);
+    vec4 color          = InInstanceColor;
     vec3 worldPosition  = vec4(model * vec4(InPosition, 1.0)).xyz;
 
     gl_Position = Camera.projection * Camera.view * vec4(worldPosition, 1.0);
@@ -0,0 +1,334 @@
+#include "profiler.h"
+
+#if SGS_PROFILER_ENABLED
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Sogas
+{
+namespace Profiler
+{
+
+struct Event
+{
+    const char* name;
+    uint64_t    start;
+    uint64_t    end;
+};
+
+// Single producer (owning thread), single consumer (EndFrame). The producer never waits,
+// events are dropped when the consumer falls behind.
+struct ThreadBuffer
+{
+    static constexpr uint64_t Capacity = 1 << 14;
+    static constexpr uint64_t Mask     = Capacity - 1;
+
+    Event                 events[Capacity];
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> tail{0};
+    std::atomic<uint64_t> dropped{0};
+
+    uint32_t    id = 0;
+    std::string name;
+};
+
+struct CapturedEvent
+{
+    const char* name;
+    uint64_t    start;
+    uint64_t    end;
+    uint32_t    thread;
+};
+
+static constexpr size_t MaxCapturedEvents = 1 << 20;
+
+static std::mutex                                 registry_mutex;
+static std::vector<std::unique_ptr<ThreadBuffer>> thread_buffers;
+static std::vector<ThreadBuffer*>                 free_buffers; // Left by exited threads, reused by new ones.
+
+static const auto epoch = std::chrono::steady_clock::now();
+
+static std::vector<ZoneStats>                   frame_stats;
+static std::unordered_map<const char*, size_t>  frame_stats_index;
+static std::vector<CapturedEvent>               captured_events;
+static bool                                     capturing       = false;
+static uint64_t                                 last_frame_time = 0;
+static double                                   frame_time_ms   = 0.0;
+
+// Gives the buffer back when its thread exits, short lived threads like async jobs would otherwise keep one each.
+// Events still in it are collected by the next EndFrame.
+struct LocalBuffer
+{
+    ThreadBuffer* buffer = nullptr;
+
+    ~LocalBuffer()
+    {
+        if (buffer)
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            free_buffers.push_back(buffer);
+        }
+    }
+};
+
+static thread_local LocalBuffer local_buffer;
+
+// Tracks are registered with the threads, EndFrame and captures don't tell them apart.
+static std::unordered_map<std::string, ThreadBuffer*> track_buffers;
+
+static uint64_t Now()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+}
+
+static ThreadBuffer* RegisterBuffer(const std::string& InName)
+{
+    thread_buffers.push_back(std::make_unique<ThreadBuffer>());
+    ThreadBuffer* buffer = thread_buffers.back().get();
+    buffer->id           = static_cast<uint32_t>(thread_buffers.size() - 1);
+    buffer->name         = InName;
+    return buffer;
+}
+
+static void PushEvent(ThreadBuffer* InBuffer, const Event& InEvent)
+{
+    const uint64_t head = InBuffer->head.load(std::memory_order_relaxed);
+    if (head - InBuffer->tail.load(std::memory_order_acquire) >= ThreadBuffer::Capacity)
+    {
+        InBuffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    InBuffer->events[head & ThreadBuffer::Mask] = InEvent;
+    InBuffer->head.store(head + 1, std::memory_order_release);
+}
+
+static ThreadBuffer* GetThreadBuffer()
+{
+    if (!local_buffer.buffer)
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        if (free_buffers.empty())
+        {
+            local_buffer.buffer = RegisterBuffer("Thread " + std::to_string(thread_buffers.size()));
+        }
+        else
+        {
+            local_buffer.buffer = free_buffers.back();
+            local_buffer.buffer->name = "Thread " + std::to_string(local_buffer.buffer->id);
+            free_buffers.pop_back();
+        }
+    }
+    return local_buffer.buffer;
+}
+
+ScopedZone::ScopedZone(const char* InName)
+: name(InName)
+, start(Now())
+{
+}
+
+ScopedZone::~ScopedZone()
+{
+    const uint64_t end = Now();
+    PushEvent(GetThreadBuffer(), {name, start, end});
+}
+
+void SetThreadName(const char* InName)
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    buffer->name = InName;
+}
+
+uint64_t GetTime()
+{
+    return Now();
+}
+
+void AddTrackZones(const char* InTrackName, const TrackZone* InZones, uint32_t InCount)
+{
+    ThreadBuffer* buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+
+        auto it = track_buffers.find(InTrackName);
+        if (it == track_buffers.end())
+        {
+            it = track_buffers.emplace(InTrackName, RegisterBuffer(InTrackName)).first;
+        }
+        buffer = it->second;
+    }
+
+    for (uint32_t i = 0; i < InCount; ++i)
+    {
+        PushEvent(buffer, {InZones[i].name, InZones[i].start, InZones[i].end});
+    }
+}
+
+void EndFrame()
+{
+    const uint64_t now = Now();
+    frame_time_ms      = last_frame_time ? static_cast<double>(now - last_frame_time) * 1e-6 : 0.0;
+    last_frame_time    = now;
+
+    frame_stats.clear();
+    frame_stats_index.clear();
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (auto& buffer : thread_buffers)
+    {
+        const uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+        const uint64_t head = buffer->head.load(std::memory_order_acquire);
+
+        for (uint64_t i = tail; i < head; ++i)
+        {
+            const Event& event = buffer->events[i & ThreadBuffer::Mask];
+            const double ms    = static_cast<double>(event.end - event.start) * 1e-6;
+
+            auto it = frame_stats_index.find(event.name);
+            if (it == frame_stats_index.end())
+            {
+                it = frame_stats_index.emplace(event.name, frame_stats.size()).first;
+                frame_stats.push_back({event.name, 0, 0.0, 0.0});
+            }
+
+            ZoneStats& stats = frame_stats[it->second];
+            stats.calls++;
+            stats.total_ms += ms;
+            stats.max_ms = std::max(stats.max_ms, ms);
+
+            if (capturing && captured_events.size() < MaxCapturedEvents)
+            {
+                captured_events.push_back({event.name, event.start, event.end, buffer->id});
+            }
+        }
+
+        buffer->tail.store(head, std::memory_order_release);
+    }
+
+    std::sort(frame_stats.begin(), frame_stats.end(), [](const ZoneStats& a, const ZoneStats& b) { return a.total_ms > b.total_ms; });
+}
+
+const std::vector<ZoneStats>& GetFrameStats()
+{
+    return frame_stats;
+}
+
+double GetFrameTime()
+{
+    return frame_time_ms;
+}
+
+void BeginCapture()
+{
+    captured_events.clear();
+    capturing = true;
+}
+
+static void WriteEscaped(std::ofstream& out, const char* str)
+{
+    for (; *str; ++str)
+    {
+        if (*str == '"' || *str == '\\')
+        {
+            out << '\\';
+        }
+        out << *str;
+    }
+}
+
+bool EndCapture(const char* InFilename)
+{
+    capturing = false;
+
+    std::ofstream out(InFilename);
+    if (!out.is_open())
+    {
+        return false;
+    }
+
+    out << "{\"traceEvents\":[\n";
+
+    bool first = true;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        for (const auto& buffer : thread_buffers)
+        {
+            out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->id << ",\"args\":{\"name\":\"";
+            WriteEscaped(out, buffer->name.c_str());
+            out << "\"}}";
+            first = false;
+        }
+    }
+
+    // Timestamps and durations are expressed in microseconds.
+    out.precision(3);
+    out << std::fixed;
+    for (const auto& event : captured_events)
+    {
+        out << (first ? "" : ",\n") << "{\"name\":\"";
+        WriteEscaped(out, event.name);
+        out << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread << ",\"ts\":" << static_cast<double>(event.start) * 1e-3
+            << ",\"dur\":" << static_cast<double>(event.end - event.start) * 1e-3 << "}";
+        first = false;
+    }
+
+    out << "\n]}\n";
+
+    captured_events.clear();
+    return true;
+}
+
+} // namespace Profiler
+} // namespace Sogas
+
+#else
+
+namespace Sogas
+{
+namespace Profiler
+{
+static const std::vector<ZoneStats> empty_stats;
+
+void SetThreadName(const char*) {}
+uint64_t GetTime() { return 0; }
+void AddTrackZones(const char*, const TrackZone*, uint32_t) {}
+void EndFrame() {}
+const std::vector<ZoneStats>& GetFrameStats() { return empty_stats; }
+double GetFrameTime() { return 0.0; }
+void BeginCapture() {}
+bool EndCapture(const char*) { return false; }
+} // namespace Profiler
+} // namespace Sogas
+
+#endif
+
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+namespace Sogas
+{
+namespace Profiler
+{
+
+const char* InternName(const char* InName)
+{
+    static std::mutex                      names_mutex;
+    static std::unordered_set<std::string> names; // Nodes don't move, the strings stay where they are.
+
+    std::lock_guard<std::mutex> lock(names_mutex);
+    return names.insert(InName).first->c_str();
+}
+
+} // namespace Profiler
+} // namespace Sogas
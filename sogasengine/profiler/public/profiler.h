@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Zones are compiled out in release unless explicitly requested.
+#ifndef SGS_PROFILER_ENABLED
+#ifdef NDEBUG
+#define SGS_PROFILER_ENABLED 0
+#else
+#define SGS_PROFILER_ENABLED 1
+#endif
+#endif
+
+namespace Sogas
+{
+namespace Profiler
+{
+struct ZoneStats
+{
+    const char* name     = nullptr;
+    uint32_t    calls    = 0;
+    double      total_ms = 0.0;
+    double      max_ms   = 0.0;
+};
+
+// Zone measured outside of the profiler, like on the gpu, converted to the profiler clock.
+struct TrackZone
+{
+    const char* name;
+    uint64_t    start; // Nanoseconds, see GetTime.
+    uint64_t    end;
+};
+
+#if SGS_PROFILER_ENABLED
+
+// Zone names must outlive the profiler, use literals or static strings.
+class ScopedZone
+{
+  public:
+    explicit ScopedZone(const char* InName);
+    ~ScopedZone();
+
+  private:
+    const char* name;
+    uint64_t    start;
+};
+
+#endif
+
+// Always declared so tools can call them, they do nothing when zones are compiled out.
+void SetThreadName(const char* InName);
+
+// Nanoseconds since the profiler started, the clock zones are measured with.
+uint64_t GetTime();
+
+// Adds zones measured on another timeline to a track of their own, collected by EndFrame and captured like the zones
+// of a thread. Tracks are created on first use, a track must be written from a single thread.
+void AddTrackZones(const char* InTrackName, const TrackZone* InZones, uint32_t InCount);
+
+// Copy of a name built at runtime, kept until exit so it can name zones. Works when zones are compiled out.
+const char* InternName(const char* InName);
+
+// Collects the zones recorded by every thread since the last call.
+void EndFrame();
+
+// Zones closed during the last frame, sorted by total time.
+const std::vector<ZoneStats>& GetFrameStats();
+double                        GetFrameTime();
+
+void BeginCapture();
+// Writes the captured frames as Chrome trace events (chrome://tracing, Perfetto).
+bool EndCapture(const char* InFilename);
+
+} // namespace Profiler
+} // namespace Sogas
+
+#define SPROFILE_CONCAT_IMPL(a, b) a##b
+#define SPROFILE_CONCAT(a, b)      SPROFILE_CONCAT_IMPL(a, b)
+
+#if SGS_PROFILER_ENABLED
+#define SPROFILE_ZONE(name)   ::Sogas::Profiler::ScopedZone SPROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#define SPROFILE_FUNCTION()   SPROFILE_ZONE(__FUNCTION__)
+#define SPROFILE_THREAD(name) ::Sogas::Profiler::SetThreadName(name)
+#define SPROFILE_END_FRAME()  ::Sogas::Profiler::EndFrame()
+#else
+#define SPROFILE_ZONE(name)
+#define SPROFILE_FUNCTION()
+#define SPROFILE_THREAD(name)
+#define SPROFILE_END_FRAME()
+#endif
@@ -18,6 +18,16 @@ namespace Sogas
         bool bIsRunning;
         bool bQuitting;
 
+        // Headless runs render a fixed number of frames offscreen, for benchmarks and image tests.
+        bool bHeadless = false;
+        bool bNullDevice = false; // Renders through a device without gpu, implies headless.
+        bool bPipelineStatistics = false; // Counts the shader invocations of every render pass.
+        u32 HeadlessFrames = 100;
+        std::string CapturePath; // Last frame written here when not empty.
+        std::vector<std::string> Benchmarks; // Run instead of the frames, imply headless.
+        i32 Width = 640;
+        i32 Height = 480;
+
     public:
 
         CApplication();
@@ -32,7 +42,23 @@ namespace Sogas
 
         GLFWwindow* GetWindow() { return window; }
         bool IsRunning() { return bIsRunning; }
-        void GetWindowSize(i32* width, i32* height) { SASSERT(window); glfwGetWindowSize(window, width, height);}
+        bool IsHeadless() const { return bHeadless; }
+        bool IsNullDevice() const { return bNullDevice; }
+        bool IsPipelineStatisticsEnabled() const { return bPipelineStatistics; }
+        void GetWindowSize(i32* width, i32* height)
+        {
+            if(bHeadless)
+            {
+                *width = Width;
+                *height = Height;
+                return;
+            }
+            SASSERT(window);
+            glfwGetWindowSize(window, width, height);
+        }
+
+        // --headless, --null-device, --pipeline-statistics, --frames <count>, --capture <path.ppm>, --bench <names|culling|log>
+        void ParseCommandLine(int argc, char** argv);
 
         virtual bool Init();
         virtual void Run();
@@ -40,5 +66,7 @@ namespace Sogas
 
     private:
         virtual void InitInstance();
+        void RunHeadless();
+        void RunBenchmarks();
     };
 } // namespace Sogas
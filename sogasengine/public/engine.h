@@ -37,12 +37,23 @@ namespace Sogas
 
         CRenderModule* GetRenderModule() { return RenderModule; }
 
+        void SetFixedTimestep(f32 dt) { SASSERT(dt > 0.0f); FixedDeltaTime = dt; }
+        void SetMaxCatchUpSteps(u32 steps) { SASSERT(steps > 0); MaxCatchUpSteps = steps; }
+        f32 GetFixedTimestep() const { return FixedDeltaTime; }
+        /** Fraction of a fixed step accumulated but not simulated yet, to interpolate when rendering.*/
+        f32 GetInterpolationAlpha() const { return InterpolationAlpha; }
+
     private:
         static CEngine* engine;
         CRenderModule* RenderModule = nullptr;
         CEntityModule* EntityModule = nullptr;
         CModuleManager ModuleManager;
 
+        f32 FixedDeltaTime = 1.0f / 60.0f;
+        u32 MaxCatchUpSteps = 5;
+        f64 Accumulator = 0.0;
+        f32 InterpolationAlpha = 0.0f;
+
         void update(const f32 dt);
     };
 } // Sogas
@@ -4,8 +4,10 @@
 
 namespace Sogas
 {
-    bool GameEntry()
+    bool GameEntry(int argc, char** argv)
     {
+        CApplication::Get()->ParseCommandLine(argc, argv);
+
         if(!CApplication::Get()->Init())
             SFATAL("Failed to initiate application.");
 
@@ -8,4 +8,15 @@ namespace Sogas
     glm::vec3 YawPitchToVector(f32 yaw, f32 pitch);
     /** Return yaw and pitch in radians.*/
     void VectorToYawPitch(glm::vec3 front, f32* yaw, f32* pitch);
+
+    struct AABB
+    {
+        glm::vec3 center = glm::vec3(0.0f);
+        glm::vec3 halfSize = glm::vec3(0.0f);
+
+        static AABB FromMinMax(const glm::vec3& min, const glm::vec3& max);
+        /** Box enclosing this one once transformed, grows when rotated.*/
+        AABB Transformed(const glm::mat4& matrix) const;
+        AABB Merged(const AABB& other) const;
+    };
 }
\ No newline at end of file
@@ -41,6 +41,7 @@ namespace Sogas
         }
 
         friend class CModuleManager;
+        friend class CModuleScheduler;
 
         std::string name;
         bool bIsActive = false;
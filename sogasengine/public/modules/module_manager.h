@@ -1,6 +1,7 @@
 #pragma once
 
 #include "module.h"
+#include "module_scheduler.h"
 
 namespace Sogas
 {
@@ -11,6 +12,7 @@ namespace Sogas
         void Clear();
 
         void Update(f32 dt);
+        void UpdateAhead(f32 dt);
         void Render();
         void RenderUI();
         void RenderInMenu();
@@ -25,6 +27,7 @@ namespace Sogas
         void ChangeToGameState(GameState* newGameState);
 
         IModule* GetModule(const std::string& ModuleName);
+        const ModuleSchedulerStats& GetSchedulerStats() const { return Scheduler.GetStats(); }
 
     private:
         void StartModules(VModules& Modules);
@@ -45,5 +48,7 @@ namespace Sogas
 
         std::map<std::string, IModule*> RegisteredModules;
         std::map<std::string, GameState> RegisteredGameStates;
+
+        CModuleScheduler Scheduler;
     };
 }
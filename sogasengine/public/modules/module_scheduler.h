@@ -0,0 +1,86 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+
+#include "module.h"
+
+namespace Sogas
+{
+    /** Resources a module touches during Update. Each resource name maps to a bit. */
+    struct ModuleAccess
+    {
+        u64 reads = ~0ull;
+        u64 writes = ~0ull;
+        // Modules polling the window or input must stay on the thread owning it.
+        bool bMainThread = true;
+
+        bool ConflictsWith(const ModuleAccess& other) const
+        {
+            return (writes & (other.reads | other.writes)) || (reads & other.writes);
+        }
+    };
+
+    struct ModuleSchedulerStats
+    {
+        f64 wallTime = 0.0;             // ms spent by the main thread in Update.
+        f64 criticalPathTime = 0.0;     // ms of the longest dependency chain.
+        u32 nModulesRunAhead = 0;
+        std::vector<IModule*> criticalPath;
+    };
+
+    /** Builds a dependency graph out of the update modules and runs independent ones in the thread pool.
+     *  The list order from modules.json decides the direction of an edge when two modules conflict. */
+    class CModuleScheduler
+    {
+    public:
+        void ParseDependencies(const json& j, const std::map<std::string, IModule*>& modules);
+
+        /** Builds the graph of the active modules. Modules not conflicting with the render
+         *  modules may run ahead, overlapping the next frame with the current render submission.
+         *  Modules that already ran ahead keep their completion and are skipped by the next Run. */
+        void Build(const VModules& updateModules, const VModules& renderModules);
+
+        void Run(f32 dt);
+        void RunAhead(f32 dt);
+        void Wait();
+
+        const ModuleSchedulerStats& GetStats() const { return Stats; }
+
+    private:
+        struct Node
+        {
+            IModule* module = nullptr;
+            const char* zone_name = nullptr;  // Interned, zone names must outlive the profiler.
+            ModuleAccess access;
+            std::vector<u32> successors;
+            std::vector<u32> predecessors;
+            u32 pending = 0;
+            bool bRunAhead = false;     // Can be launched before render.
+            bool bInRun = false;
+            bool bDone = false;
+            f64 duration = 0.0;
+        };
+
+        u64 GetResourceBit(const std::string& resource);
+        void Launch(f32 dt, bool bAhead);
+        void Dispatch(const std::vector<u32>& ready, f32 dt);
+        void Execute(u32 index, f32 dt);
+        void OnNodeFinished(u32 index, f32 dt);
+        void ComputeCriticalPath();
+
+        std::map<IModule*, ModuleAccess> Accesses;
+        std::map<std::string, u32> ResourceBits;
+
+        std::vector<Node> Nodes;
+        std::vector<u32> MainThreadQueue;
+        u32 nRunning = 0;
+        bool bAheadInFlight = false;
+
+        std::mutex Mutex;
+        std::condition_variable Finished;
+
+        ModuleSchedulerStats Stats;
+    };
+
+} // Sogas
@@ -0,0 +1,38 @@
+#pragma once
+
+namespace Sogas
+{
+    // FNV-1a 64 bits. constexpr so literal names are hashed at compile time.
+    constexpr u64 HashName(const char* str)
+    {
+        u64 hash = 0xcbf29ce484222325ull;
+        while (*str)
+        {
+            hash ^= static_cast<u64>(static_cast<u8>(*str++));
+            hash *= 0x100000001b3ull;
+        }
+        // 0 is reserved for invalid ids.
+        return hash ? hash : 1;
+    }
+
+    /** Interned name identifier. The string is hashed once and only the id is compared afterwards. */
+    struct NameId
+    {
+        static const u64 Invalid = 0;
+
+        u64 id = Invalid;
+
+        constexpr NameId() = default;
+        constexpr explicit NameId(u64 InId) : id(InId) {}
+        explicit NameId(const std::string& InName) : id(HashName(InName.c_str())) {}
+
+        constexpr bool IsValid() const { return id != Invalid; }
+
+        constexpr bool operator==(NameId other) const { return id == other.id; }
+        constexpr bool operator!=(NameId other) const { return id != other.id; }
+    };
+
+    // Forces the hash of a literal to be evaluated at compile time.
+    #define SGS_NAME(literal) ::Sogas::NameId(std::integral_constant<u64, ::Sogas::HashName(literal)>::value)
+
+} // Sogas
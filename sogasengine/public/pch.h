@@ -11,6 +11,7 @@
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <type_traits>
 #include <vector>
 
 // external
@@ -30,6 +31,8 @@ using json = nlohmann::json;
 // application
 #include "defines.h"
 #include "logger/public/logger.h"
+#include "profiler/public/profiler.h"
 #include "engine.h"
 #include "math_utils.h"
+#include "name_id.h"
 #include "read_json.h"
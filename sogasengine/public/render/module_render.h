@@ -23,6 +23,8 @@ class CRenderModule : public IModule
     std::shared_ptr<Renderer::GPU_device> GetGraphicsDevice() const { return renderer; }
 
     void DoFrame();
+    // Writes the last frame rendered headless as a PPM image. Waits for the gpu.
+    bool CaptureFrame(const std::string& InPath);
 
   private:
     std::shared_ptr<Renderer::GPU_device> renderer;
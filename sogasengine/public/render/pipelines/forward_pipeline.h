@@ -3,35 +3,73 @@
 #include "renderer/public/attachment.h"
 #include "renderer/public/render_types.h"
 
+#include <chrono>
+#include <future>
+
 namespace Sogas
 {
 struct Swapchain;
+class CFileWatcher;
 
 namespace Renderer
 {
 class GPU_device;
-}
+class CommandBuffer;
+class RenderGraph;
+} // namespace Renderer
 
 class ForwardPipeline
 {
   public:
     explicit ForwardPipeline(std::shared_ptr<Renderer::GPU_device> InRenderer = nullptr);
-    ~ForwardPipeline(){};
+    ~ForwardPipeline();
 
     void update_constants();
     void render();
     void destroy();
 
   private:
+    struct ShaderSources
+    {
+        std::string vertex;
+        std::string fragment;
+        std::string include_directory; // Directory of the sources.
+        bool        bCompiled = false;
+        bool        bBindless = false; // Compiled with BINDLESS, materials read their textures from the heap.
+    };
+
+    // Reads the GLSL sources and compiles them into the shader cache, runs on a worker when reloading.
+    static ShaderSources LoadShaders(Renderer::GPU_device* InRenderer, const std::string& InVertexPath, const std::string& InFragmentPath);
+    static void          SetShaders(Renderer::ShaderStateDescriptor& OutShaders, const ShaderSources& InSources);
+
+    // Called at the frame boundary, swaps the pipeline once the new shaders are compiled and the pipeline built.
+    void reload_shaders();
+
+    // Records the scene in the forward pass of the frame graph.
+    void render_forward(Renderer::CommandBuffer* cmd, Renderer::RenderPassHandle pass);
+
     std::shared_ptr<Renderer::GPU_device> renderer;
 
-    Renderer::BufferHandle              camera_buffer;
-    Renderer::BufferHandle              mesh_buffer;
-    Renderer::BufferHandle              light_buffer;
+    Renderer::PipelineDescriptor        pipeline_descriptor; // Everything but the shaders, kept to rebuild the pipeline.
     Renderer::PipelineHandle            pipeline;
     Renderer::DescriptorSetHandle       descriptorSet;
     Renderer::DescriptorSetLayoutHandle descriptorLayout;
 
+    std::unique_ptr<Renderer::RenderGraph> graph;
+
+    // Per frame state used by the pass callbacks, written in render before the graph is executed.
+    u32 frame_offsets[2]      = {0, 0}; // Camera and light constants in the dynamic buffer.
+    u32 frame_instance_offset = 0;
+    bool bDrawScene           = false; // The frame data fit in the dynamic buffer.
+
+    // Shader hot reload
+    std::string                           vertex_path;
+    std::string                           fragment_path;
+    std::unique_ptr<CFileWatcher>         shader_watcher;
+    std::future<ShaderSources>            shader_reload;
+    Renderer::PipelineHandle              reloaded_pipeline = Renderer::INVALID_PIPELINE;
+    std::chrono::steady_clock::time_point reload_start;
+
     const u32 nLights = 10;
 };
 } // namespace Sogas
\ No newline at end of file
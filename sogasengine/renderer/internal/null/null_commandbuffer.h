@@ -0,0 +1,126 @@
+#pragma once
+
+#include "commandbuffer.h"
+#include "device_resources.h"
+#include "render_types.h"
+
+namespace Sogas
+{
+namespace Renderer
+{
+namespace Null
+{
+
+class NullDevice;
+
+// Counters of the commands recorded, summed per frame by the device.
+struct NullCommandStats
+{
+    u32 draws                = 0;
+    u32 instances            = 0;
+    u32 pass_binds           = 0;
+    u32 pipeline_binds       = 0;
+    u32 descriptor_set_binds = 0;
+    u32 buffer_binds         = 0; // Vertex and index buffers.
+    u32 barriers             = 0;
+    u64 uploaded_bytes       = 0; // Push constants, buffer and texture data and dynamic allocations.
+    u64 command_bytes        = 0; // Size of the recorded command streams.
+    u32 validation_errors    = 0; // Commands dropped because of invalid handles or state.
+
+    void Add(const NullCommandStats& InOther);
+    void Max(const NullCommandStats& InOther);
+};
+
+enum class NullCommandType : u8
+{
+    BIND_PASS,
+    BIND_PIPELINE,
+    BIND_DESCRIPTOR_SET,
+    BIND_TRANSIENT_DESCRIPTOR_SET,
+    PUSH_CONSTANTS,
+    BIND_VERTEX_BUFFER,
+    BIND_INDEX_BUFFER,
+    BARRIER,
+    BEGIN_ZONE,
+    END_ZONE,
+    SET_VIEWPORT,
+    SET_SCISSORS,
+    DRAW,
+    DRAW_INDEXED,
+    EXECUTE_COMMANDS
+};
+
+// Commands are validated against the device resources and appended to a byte stream, nothing is executed. The
+// stream keeps its capacity between frames so recording doesn't allocate once it has grown.
+class NullCommandBuffer : public CommandBuffer
+{
+  public:
+    void init(u32 buffer_size, u32 submit_size, bool baked) override;
+    void finish() override;
+
+    // interface
+
+    void bind_pass(RenderPassHandle handle, bool use_secondary = false) override;
+    void bind_pipeline(PipelineHandle handle) override;
+    void bind_descriptor_set(DescriptorSetHandle handle, u32* offsets, u32 offsets_count) override;
+    void bind_descriptor_set(const TransientDescriptorSet& set, u32* offsets, u32 offsets_count) override;
+    void push_constants(const void* data, u32 size, u32 offset = 0) override;
+
+    void bind_vertex_buffer(BufferHandle handle, u32 binding, u32 offset) override;
+    void bind_index_buffer(BufferHandle handle, u32 offset) override;
+
+    void barrier(const TextureBarrier* barriers, u32 count) override;
+
+    void begin_zone(const char* name) override;
+    void end_zone() override;
+
+    void set_viewport() override;
+    void set_scissors() override;
+
+    void draw(u32 first_vertex, u32 vertex_count, u32 first_instance, u32 instance_count) override;
+    void draw_indexed(u32 index_count, u32 instance_count, u32 first_index, i32 vertex_offset, u32 first_instance) override;
+
+    void end() override;
+    void execute_commands(CommandBuffer** secondaries, u32 count) override;
+
+    void reset() override;
+
+    // Continues the render pass bound on the primary.
+    void begin_secondary(const NullCommandBuffer* primary);
+
+    NullDevice* device = nullptr;
+
+    std::vector<u8>  commands;
+    NullCommandStats stats;
+
+    RenderPassHandle current_pass         = INVALID_RENDERPASS;
+    PipelineHandle   current_pipeline     = INVALID_PIPELINE;
+    bool             bSecondary           = false;
+    bool             bRecording           = false;
+    bool             bIndexBufferBound    = false;
+    bool             bPassUsesSecondaries = false; // The primary only executes secondaries until the pass ends.
+    u32              open_zones           = 0;
+
+  private:
+    struct CommandHeader
+    {
+        NullCommandType type;
+        u16             size; // Bytes of payload following the header.
+    };
+
+    // Appends a command, the payload it returns is written by the caller.
+    u8* append(NullCommandType InType, u32 InSize);
+
+    template <typename T>
+    void record(NullCommandType InType, const T& InData)
+    {
+        memcpy(append(InType, static_cast<u32>(sizeof(T))), &InData, sizeof(T));
+    }
+
+    // False, and the error counted, when the command can't be recorded.
+    bool validate(bool bCondition, const char* InMessage);
+};
+
+} // namespace Null
+} // namespace Renderer
+} // namespace Sogas
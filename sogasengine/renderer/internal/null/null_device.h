@@ -0,0 +1,222 @@
+#pragma once
+
+#include "null_commandbuffer.h"
+#include "render_device.h"
+
+namespace Sogas
+{
+namespace Renderer
+{
+namespace Null
+{
+
+static const u32 NULL_MAX_FRAMES_IN_FLIGHT          = 3;
+static const u32 NULL_DYNAMIC_BUFFER_PER_FRAME_SIZE = 4 * 1024 * 1024;
+
+// Resources only keep what validation and the queries of the device need, they live in raw pool memory and are
+// filled by the Create functions. bAlive is cleared when destroyed, stale handles are caught by the command buffers.
+struct NullBuffer
+{
+    u8*         data   = nullptr; // Host memory, written by the initial data and mapped by MapBuffer.
+    u32         size   = 0;
+    BufferUsage usage  = BufferUsage::UNDEFINED;
+    bool        bAlive = false;
+};
+
+struct NullTexture
+{
+    u16    width    = 1;
+    u16    height   = 1;
+    u64    size     = 0;
+    Format format   = Format::UNDEFINED;
+    bool   bAliased = false;
+    bool   bAlive   = false;
+};
+
+struct NullShaderState
+{
+    u32  stages_count = 0;
+    bool bAlive       = false;
+};
+
+struct NullSampler
+{
+    bool bAlive = false;
+};
+
+struct NullDescriptorSetLayout
+{
+    u32  set_index      = 0;
+    u32  bindings_count = 0;
+    bool bAlive         = false;
+};
+
+struct NullDescriptorSet
+{
+    DescriptorSetLayoutHandle layout;
+    u32                       resources_count = 0;
+    bool                      bAlive          = false;
+};
+
+struct NullPipeline
+{
+    ShaderStateHandle         shader_state;
+    DescriptorSetLayoutHandle descriptor_set_layouts[MAX_DESCRIPTOR_SET_LAYOUTS];
+    u32                       active_layouts_count = 0;
+    u32                       color_formats_count  = 0; // Must match the render targets of the bound pass.
+    bool                      bAlive               = false;
+};
+
+struct NullRenderPass
+{
+    RenderPassType type                 = RenderPassType::GEOMETRY;
+    u32            render_targets_count = 0;
+    bool           bAlive               = false;
+};
+
+// Device talking to no driver, for profiling the cpu side of the renderer: culling, sorting, constant uploads and
+// command recording. Resources are validated and tracked in the pools like on a real device, buffers are backed by
+// host memory so their contents can be written, and command buffers record into memory. Shaders are not compiled
+// nor reflected, nothing is rendered and textures can't be read back.
+class NullDevice : public GPU_device
+{
+    friend class NullCommandBuffer;
+
+  public:
+    explicit NullDevice(GraphicsAPI apiType);
+    NullDevice(const NullDevice&) = delete;
+    NullDevice(NullDevice&&)      = delete;
+    ~NullDevice() override;
+
+    const NullDevice& operator=(const NullDevice& other) = delete;
+
+    bool Init(const DeviceDescriptor& InDescriptor) override;
+    void shutdown() override;
+
+    // clang-format off
+    BufferHandle              CreateBuffer(const BufferDescriptor& InDescriptor) override;
+    TextureHandle             CreateTexture(const TextureDescriptor& InDescriptor) override;
+    ShaderStateHandle         CreateShaderState(const ShaderStateDescriptor& InDescriptor) override;
+    SamplerHandle             CreateSampler(const SamplerDescriptor& InDescriptor) override;
+    DescriptorSetHandle       CreateDescriptorSet(const DescriptorSetDescriptor& InDescriptor) override;
+    DescriptorSetLayoutHandle CreateDescriptorSetLayout(const DescriptorSetLayoutDescriptor& InDescriptor) override;
+    TransientDescriptorSet    CreateTransientDescriptorSet(const DescriptorSetDescriptor& InDescriptor) override;
+    PipelineHandle            CreatePipeline(const PipelineDescriptor& InDescriptor) override;
+    RenderPassHandle          CreateRenderPass(const RenderPassDescriptor& InDescriptor) override;
+    PipelineHandle            CreatePipelineAsync(const PipelineDescriptor& InDescriptor) override;
+    bool                      IsPipelineReady(PipelineHandle InHandle) override;
+    bool                      IsPipelineFailed(PipelineHandle InHandle) override;
+    bool                      CompileShaders(const ShaderStateDescriptor& InDescriptor) override;
+    DescriptorSetLayoutHandle GetDescriptorSetLayout(PipelineHandle InHandle, u32 InSetIndex) override;
+    u32                       GetBindlessIndex(TextureHandle InHandle) override;
+    u32                       GetBindlessIndex(BufferHandle InHandle) override;
+    TextureMemoryInfo         GetTextureMemoryInfo(TextureHandle InHandle) override;
+    bool                      ReadbackTexture(TextureHandle InHandle, TextureReadback& OutReadback) override;
+
+    void                      DestroyBuffer(BufferHandle InHandle) override;
+    void                      DestroyTexture(TextureHandle InHandle) override;
+    void                      DestroyShaderState(ShaderStateHandle InHandle) override;
+    void                      DestroySampler(SamplerHandle InHandle) override;
+    void                      DestroyDescriptorSet(DescriptorSetHandle InHandle) override;
+    void                      DestroyDescriptorSetLayout(DescriptorSetLayoutHandle InHandle) override;
+    void                      DestroyPipeline(PipelineHandle InPipelineHandle) override;
+    void                      DestroyRenderPass(RenderPassHandle InHandle) override;
+
+    // clang-format on
+    void BeginFrame() override;
+    void Present() override;
+
+    void* MapBuffer(const BufferHandle& InHandle, u32 size, u32 offset = 0) override;
+    void  UnmapBuffer(const BufferHandle& InHandle) override;
+
+    DynamicAllocation AllocateDynamic(u32 size) override;
+    BufferHandle      GetDynamicBuffer() const override;
+
+    std::vector<i8> ReadShaderBinary(std::string InFilename) override;
+    char*           ReadShader(std::string InFilename, u32& OutSize) override;
+    CommandBuffer*  GetCommandBuffer(bool begin) override;
+    CommandBuffer*  GetInstantCommandBuffer() override;
+    void            QueueCommandBuffer(CommandBuffer* cmd) override;
+    CommandBuffer*  GetSecondaryCommandBuffer(u32 thread_index, CommandBuffer* primary) override;
+    u32             GetMaxRecordingThreads() const override;
+
+    GraphicsAPI             getApiType() const override;
+    u32                     GetFrameIndex() const override;
+    u32                     GetFramesInFlight() const override;
+    f32                     GetFrameWaitMs() const override;
+    GPUMemoryStats          GetMemoryStats() const override;
+    u32                     Defragment(u32 InMaxMoves) override;
+    RenderPassHandle        GetSwapchainRenderpass() override;
+    const RenderPassOutput& GetSwapchainOutput() const override;
+    TextureHandle           GetBackbufferTexture() const override;
+
+    // Nothing runs on a gpu, always empty.
+    const std::vector<GPUZoneTiming>& GetGpuTimings() const override;
+
+    // Counters of the last presented frame.
+    const NullCommandStats& GetFrameStats() const { return last_frame_stats; }
+
+    static const u32 MAX_THREADS                  = 8;
+    static const u32 BUFFERS_PER_FRAME            = 4;
+    static const u32 SECONDARY_BUFFERS_PER_THREAD = 4;
+
+  private:
+    void CreateSwapchain(GLFWwindow* window) override;
+
+    // Invalid or destroyed handles give null.
+    NullBuffer*              GetBufferResource(BufferHandle InHandle);
+    NullTexture*             GetTextureResource(TextureHandle InHandle);
+    NullDescriptorSet*       GetDescriptorSetResource(DescriptorSetHandle InHandle);
+    NullDescriptorSetLayout* GetDescriptorSetLayoutResource(DescriptorSetLayoutHandle InHandle);
+    NullPipeline*            GetPipelineResource(PipelineHandle InHandle);
+    NullRenderPass*          GetRenderPassResource(RenderPassHandle InHandle);
+
+    void DestroyBufferInstant(ResourceHandle InHandle) override;
+    void DestroyTextureInstant(ResourceHandle InHandle) override;
+    void DestroyShaderStateInstant(ResourceHandle InHandle) override;
+    void DestroySamplerInstant(ResourceHandle InHandle) override;
+    void DestroyDescriptorSetInstant(ResourceHandle InHandle) override;
+    void DestroyDescriptorSetLayoutInstant(ResourceHandle InHandle) override;
+    void DestroyPipelineInstant(ResourceHandle InHandle) override;
+    void DestroyRenderPassInstant(ResourceHandle InHandle) override;
+
+    void DestroyQueuedResources();
+
+    u32 frame_count      = 0;
+    u32 frames_in_flight = 2;
+
+    // Given to the pipelines created without layouts, the shaders are not reflected.
+    DescriptorSetLayoutHandle default_layout = INVALID_DESCRIPTORSETLAYOUT;
+
+    RenderPassOutput swapchain_output;
+    TextureHandle    backbuffer = INVALID_TEXTURE;
+
+    NullCommandBuffer command_buffers[NULL_MAX_FRAMES_IN_FLIGHT][BUFFERS_PER_FRAME];
+    NullCommandBuffer secondary_command_buffers[NULL_MAX_FRAMES_IN_FLIGHT][MAX_THREADS][SECONDARY_BUFFERS_PER_THREAD];
+    u32               next_command_buffer = 0;
+    u32               next_secondary_command_buffer[MAX_THREADS]{}; // Each recording thread only touches its own.
+
+    // Per frame ring for dynamic data, in host memory.
+    BufferHandle dynamic_buffer             = INVALID_BUFFER;
+    u8*          dynamic_mapped_memory      = nullptr;
+    u32          dynamic_alignment          = 256;
+    u32          dynamic_per_frame_size     = 0;
+    u32          dynamic_allocated_size     = 0;
+    u32          dynamic_frame_start        = 0; // Beginning of the partition allocations are taken from.
+    u32          dynamic_max_per_frame_size = 0;
+
+    u64 transient_set_count = 0; // Gives every transient set a different non zero handle.
+    u64 buffer_bytes        = 0; // Host memory backing the buffers alive.
+
+    // Counted by the device during the frame, the command buffer stats are added at Present.
+    NullCommandStats frame_stats;
+    NullCommandStats last_frame_stats;
+    NullCommandStats total_stats;
+    NullCommandStats peak_stats; // Highest value of each counter over the frames.
+
+    std::vector<GPUZoneTiming> gpu_timings;
+};
+
+} // namespace Null
+} // namespace Renderer
+} // namespace Sogas
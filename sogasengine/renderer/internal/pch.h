@@ -29,4 +29,5 @@
 
 // application
 #include "logger/public/logger.h"
+#include "profiler/public/profiler.h"
 #include "public/sgs_memory.h"
\ No newline at end of file
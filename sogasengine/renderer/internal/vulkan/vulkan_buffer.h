@@ -1,5 +1,6 @@
 #pragma once
 
+#include "vulkan_memory.h"
 #include "vulkan_types.h"
 
 namespace Sogas
@@ -17,21 +18,22 @@ class VulkanBuffer
   public:
     static BufferHandle Create(VulkanDevice* InDevice, const BufferDescriptor& InDescriptor);
 
-    VkBuffer       buffer = VK_NULL_HANDLE;
-    VkDeviceMemory memory = VK_NULL_HANDLE;
-    BufferHandle   handle;
+    VkBuffer         buffer = VK_NULL_HANDLE;
+    VulkanAllocation allocation;
+    BufferHandle     handle;
 
     VkBufferUsageFlags usage_flags   = 0;
     BufferType         usage_type    = BufferType::Static;
     u32                size          = 0;
     u32                global_offset = 0; // Offset into global constant, if dynamic.
+    u8*                mapped_data   = nullptr; // Host visible buffers stay mapped for their whole life.
 
     std::string name;
 
   private:
     void Allocate_buffer_memory(VkMemoryPropertyFlags memoryPropertyFlags);
 
-    const VulkanDevice* device = nullptr;
+    VulkanDevice* device = nullptr;
 };
 } // namespace Vk
 } // namespace Renderer
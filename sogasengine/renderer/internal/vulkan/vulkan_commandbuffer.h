@@ -27,7 +27,7 @@ class VulkanCommandBuffer : public CommandBuffer
 
     // interface
 
-    void bind_pass(RenderPassHandle handle) override;
+    void bind_pass(RenderPassHandle handle, bool use_secondary = false) override;
     void bind_pipeline(PipelineHandle handle) override;
 
     void set_viewport() override;
@@ -36,17 +36,38 @@ class VulkanCommandBuffer : public CommandBuffer
     void bind_vertex_buffer(BufferHandle handle, u32 binding, u32 offset) override;
     void bind_index_buffer(BufferHandle handle, u32 offset) override;
     void bind_descriptor_set(DescriptorSetHandle handle, u32* offsets, u32 offsets_count) override;
+    void bind_descriptor_set(const TransientDescriptorSet& set, u32* offsets, u32 offsets_count) override;
+    void push_constants(const void* data, u32 size, u32 offset = 0) override;
+    void barrier(const TextureBarrier* barriers, u32 count) override;
+
+    void begin_zone(const char* name) override;
+    void end_zone() override;
 
     void draw(u32 first_vertex, u32 vertex_count, u32 first_instance, u32 instance_count) override;
     void draw_indexed(u32 index_count, u32 instance_count, u32 first_index, i32 vertex_offset, u32 first_instance) override;
 
+    void end() override;
+    void execute_commands(CommandBuffer** secondaries, u32 count) override;
+
     void reset() override;
 
+    // Begins a secondary command buffer continuing the render pass bound on the primary.
+    void begin_secondary(const VulkanCommandBuffer* primary);
+
+    // Ends the render pass begun by bind_pass, nothing is bound afterwards.
+    void end_pass();
+
+    // Dynamic rendering path of bind_pass.
+    void begin_rendering(const VulkanRenderPass* renderpass, bool use_secondary);
+
+    VkExtent2D get_pass_extent() const;
+
     VulkanDevice* device = nullptr;
 
     VkCommandBuffer command_buffer;
 
-    VulkanRenderPass* current_renderpass = nullptr;
+    VulkanRenderPass* current_renderpass  = nullptr;
+    VkFramebuffer     current_framebuffer = VK_NULL_HANDLE;
     VulkanPipeline*   current_pipeline   = nullptr;
     VkClearValue      clears[2];
     bool              is_recording;
@@ -57,6 +78,14 @@ class VulkanCommandBuffer : public CommandBuffer
     ResourceHandle resource_handle;
     u32            buffer_size = 0;
     bool           baked       = false;
+
+    static const u32 MAX_OPEN_ZONES = 16;
+
+    // Gpu zones, the render pass one is ended with the pass.
+    u32  pass_zone             = INVALID_ID;
+    bool pass_uses_secondaries = false;
+    u32  open_zones[MAX_OPEN_ZONES];
+    u32  open_zones_count = 0;
 };
 
 class VulkanCommandBufferResources
@@ -69,21 +98,32 @@ class VulkanCommandBufferResources
 
     VulkanCommandBuffer* get_command_buffer(u32 frame, bool begin);
     VulkanCommandBuffer* get_instant_command_buffer(u32 frame);
+    // Each recording thread uses its own pool, a pool must not be recorded from two threads at the same time.
+    VulkanCommandBuffer* get_secondary_command_buffer(u32 frame, u32 thread_index);
 
+    // Primaries are allocated from the first thread pool of each frame.
     static u16 pool_from_index(u32 index)
     {
-        return static_cast<u16>(index) / BUFFER_PER_POOL;
+        return static_cast<u16>((index / BUFFER_PER_POOL) * MAX_THREADS);
+    }
+
+    static u16 pool_from_secondary_index(u32 index)
+    {
+        return static_cast<u16>(index / SECONDARY_BUFFER_PER_POOL);
     }
 
-    static const u16 MAX_THREADS     = 1;
-    static const u16 MAX_POOLS       = MAX_SWAPCHAIN_IMAGES * MAX_THREADS;
-    static const u16 BUFFER_PER_POOL = 4;
-    static const u16 MAX_BUFFERS     = BUFFER_PER_POOL * MAX_POOLS;
+    static const u16 MAX_THREADS               = 8;
+    static const u16 MAX_POOLS                 = MAX_SWAPCHAIN_IMAGES * MAX_THREADS;
+    static const u16 BUFFER_PER_POOL           = 4;
+    static const u16 MAX_BUFFERS               = BUFFER_PER_POOL * MAX_SWAPCHAIN_IMAGES;
+    static const u16 SECONDARY_BUFFER_PER_POOL = 4;
+    static const u16 MAX_SECONDARY_BUFFERS     = SECONDARY_BUFFER_PER_POOL * MAX_POOLS;
 
     VulkanDevice*       device = nullptr;
     VkCommandPool       command_pools[MAX_POOLS];
     VulkanCommandBuffer command_buffers[MAX_BUFFERS];
-    u8                  next_free_per_thread_frame[MAX_POOLS];
+    VulkanCommandBuffer secondary_command_buffers[MAX_SECONDARY_BUFFERS];
+    u8                  next_free_per_thread_frame[MAX_POOLS]{};
 };
 
 } // namespace Vk
@@ -8,6 +8,7 @@ namespace Renderer
 namespace Vk
 {
 class VulkanDevice;
+class VulkanDescriptorWriter;
 
 struct DescriptorBinding
 {
@@ -27,6 +28,7 @@ class VulkanDescriptorSetLayout
     DescriptorBinding*            bindings       = nullptr;
     u16                           bindings_count = 0;
     u16                           set_index      = 0;
+    u64                           hash           = 0; // Of the bindings, layouts with the same hash are compatible.
 
     DescriptorSetLayoutHandle handle;
 };
@@ -42,6 +44,7 @@ class VulkanDescriptorSet
 
     static DescriptorSetHandle       Create(VulkanDevice* InDevice, const DescriptorSetDescriptor& InDescriptor);
     static DescriptorSetLayoutHandle Create(VulkanDevice* InDevice, const DescriptorSetLayoutDescriptor& InDescriptor);
+    static TransientDescriptorSet    CreateTransient(VulkanDevice* InDevice, const DescriptorSetDescriptor& InDescriptor);
 
     void BindDescriptor(VkCommandBuffer cmd) const;
 
@@ -64,17 +67,12 @@ class VulkanDescriptorSet
     const u32                                 setNumber;
 
   private:
-    void FillWriteDescriptorSets(
+    static void WriteResources(
       VulkanDevice*                    InDevice,
       const VulkanDescriptorSetLayout* InDescriptorSetLayout,
       VkDescriptorSet                  InDescriptorSet,
-      VkWriteDescriptorSet*            InWriteDescriptorSet,
-      VkDescriptorBufferInfo*          InBufferInfo,
-      VkDescriptorImageInfo*           InImageInfo,
-      u32&                             OutResourcesCount,
-      const ResourceHandle*            InResources,
-      const SamplerHandle*             InSamplers,
-      const u16*                       InBindings);
+      const DescriptorSetDescriptor&   InDescriptor,
+      VulkanDescriptorWriter&          OutWriter);
 
     const VulkanDevice* device = nullptr;
     VkPipelineBindPoint pipelineBindPoint;
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "vulkan_types.h"
+
+namespace Sogas
+{
+namespace Renderer
+{
+namespace Vk
+{
+
+// Descriptor sets living for a single frame. Each frame slot owns a chain of pools, a new pool is appended when the
+// last one is full and the whole chain is reset with vkResetDescriptorPool once the gpu is done with the slot. Sets
+// are never freed one by one. Not thread safe, sets are allocated from the render thread.
+class VulkanDescriptorAllocator
+{
+  public:
+    void Init(VkDevice InDevice, u32 InFramesInFlight);
+    void Shutdown();
+
+    // The gpu finished the frame that used the slot, every set allocated for it is released. Pools are kept.
+    void Reset(u32 InFrameIndex);
+
+    VkDescriptorSet Allocate(u32 InFrameIndex, VkDescriptorSetLayout InLayout);
+
+  private:
+    struct FramePools
+    {
+        std::vector<VkDescriptorPool> pools;
+        u32                           current = 0; // Pool sets are allocated from, the previous ones are full.
+    };
+
+    VkDescriptorPool CreatePool(u32 InMaxSets);
+
+    static constexpr u32 INITIAL_SETS_PER_POOL = 64;
+    static constexpr u32 MAX_SETS_PER_POOL     = 4096;
+
+    VkDevice   device           = VK_NULL_HANDLE;
+    u32        frames_in_flight = 0;
+    FramePools frames[MAX_FRAMES_IN_FLIGHT];
+
+    // Stats
+    u32 pools_count     = 0;
+    u32 allocated_count = 0; // Sets allocated since the last reset of the slot.
+    u32 peak_count      = 0; // Most sets allocated by a frame.
+};
+
+// Collects descriptor writes and submits them with a single vkUpdateDescriptorSets. The infos are copied, the writes
+// given to Vulkan point into the writer storage.
+class VulkanDescriptorWriter
+{
+  public:
+    void WriteImage(VkDescriptorSet InSet, u32 InBinding, u32 InArrayElement, VkDescriptorType InType, const VkDescriptorImageInfo& InInfo);
+    void WriteBuffer(VkDescriptorSet InSet, u32 InBinding, u32 InArrayElement, VkDescriptorType InType, const VkDescriptorBufferInfo& InInfo);
+
+    void Flush(VkDevice InDevice);
+
+    bool IsEmpty() const
+    {
+        return writes.empty();
+    }
+
+  private:
+    // Pointers are resolved at flush, the vectors may grow while writes are added. Each write takes the next info
+    // of its kind.
+    std::vector<VkWriteDescriptorSet>   writes;
+    std::vector<VkDescriptorImageInfo>  image_infos;
+    std::vector<VkDescriptorBufferInfo> buffer_infos;
+};
+
+} // namespace Vk
+} // namespace Renderer
+} // namespace Sogas
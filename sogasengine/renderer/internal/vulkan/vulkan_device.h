@@ -2,8 +2,17 @@
 
 #include "device_resources.h"
 #include "vulkan_commandbuffer.h"
+#include "vulkan_descriptor_allocator.h"
+#include "vulkan_gpu_profiler.h"
+#include "vulkan_memory.h"
+#include "vulkan_shader_compiler.h"
+#include "vulkan_upload.h"
 #include "vulkan_types.h"
 
+#include <atomic>
+#include <future>
+#include <mutex>
+
 namespace Sogas
 {
 namespace Renderer
@@ -26,12 +35,14 @@ class VulkanDevice : public GPU_device
     friend class VulkanCommandBufferResources;
     friend class VulkanDescriptorSet;
     friend class VulkanDescriptorSetLayout;
+    friend class VulkanGpuProfiler;
     friend class VulkanPipeline;
     friend class VulkanRenderPass;
     friend class VulkanSampler;
     friend class VulkanShader;
     friend class VulkanSwapchain;
     friend class VulkanTexture;
+    friend class VulkanUploadManager;
 
   public:
     explicit VulkanDevice(GraphicsAPI              apiType,
@@ -54,8 +65,18 @@ class VulkanDevice : public GPU_device
     SamplerHandle             CreateSampler(const SamplerDescriptor& InDescriptor) override;
     DescriptorSetHandle       CreateDescriptorSet(const DescriptorSetDescriptor& InDescriptor) override;
     DescriptorSetLayoutHandle CreateDescriptorSetLayout(const DescriptorSetLayoutDescriptor& InDescriptor) override;
+    TransientDescriptorSet    CreateTransientDescriptorSet(const DescriptorSetDescriptor& InDescriptor) override;
     PipelineHandle            CreatePipeline(const PipelineDescriptor& InDescriptor) override;
     RenderPassHandle          CreateRenderPass(const RenderPassDescriptor& InDescriptor) override;
+    PipelineHandle            CreatePipelineAsync(const PipelineDescriptor& InDescriptor) override;
+    bool                      IsPipelineReady(PipelineHandle InHandle) override;
+    bool                      IsPipelineFailed(PipelineHandle InHandle) override;
+    bool                      CompileShaders(const ShaderStateDescriptor& InDescriptor) override;
+    DescriptorSetLayoutHandle GetDescriptorSetLayout(PipelineHandle InHandle, u32 InSetIndex) override;
+    u32                       GetBindlessIndex(TextureHandle InHandle) override;
+    u32                       GetBindlessIndex(BufferHandle InHandle) override;
+    TextureMemoryInfo         GetTextureMemoryInfo(TextureHandle InHandle) override;
+    bool                      ReadbackTexture(TextureHandle InHandle, TextureReadback& OutReadback) override;
 
     void                      DestroyBuffer(BufferHandle InHandle) override;
     void                      DestroyTexture(TextureHandle InHandle) override;
@@ -73,23 +94,35 @@ class VulkanDevice : public GPU_device
     void* MapBuffer(const BufferHandle& InHandle, u32 size, u32 offset = 0) override;
     void UnmapBuffer(const BufferHandle& InHandle) override;
 
+    DynamicAllocation AllocateDynamic(u32 size) override;
+    BufferHandle      GetDynamicBuffer() const override;
+
     std::vector<i8> ReadShaderBinary(std::string InFilename) override;
     char* ReadShader(std::string InFilename, u32& OutSize) override;
     CommandBuffer*  GetCommandBuffer(bool begin) override;
     CommandBuffer*  GetInstantCommandBuffer() override;
     void            QueueCommandBuffer(CommandBuffer* cmd) override;
+    CommandBuffer*  GetSecondaryCommandBuffer(u32 thread_index, CommandBuffer* primary) override;
+    u32             GetMaxRecordingThreads() const override;
 
     GraphicsAPI             getApiType() const;
     const VkPhysicalDevice& GetGPU() const;
     const u32               GetFamilyQueueIndex();
     const u32               GetFrameCount() const;
-    const u32               GetFrameIndex() const;
+    u32                     GetFrameIndex() const override;
+    u32                     GetFramesInFlight() const override;
+    f32                     GetFrameWaitMs() const override;
+    GPUMemoryStats          GetMemoryStats() const override;
+    u32                     Defragment(u32 InMaxMoves) override;
     RenderPassHandle        GetSwapchainRenderpass() override;
     const RenderPassOutput& GetSwapchainOutput() const override;
+    TextureHandle           GetBackbufferTexture() const override;
     VkRenderPass            GetVulkanRenderPass(const RenderPassOutput& InOutput, std::string InName);
     const VkQueue           GetGraphicsQueue();
     VulkanSampler*          GetDefaultSampler();
 
+    const std::vector<GPUZoneTiming>& GetGpuTimings() const override;
+
   private:
     bool CreateInstance();
     void PickPhysicalDevice();
@@ -97,8 +130,35 @@ class VulkanDevice : public GPU_device
     void SetupDebugMessenger();
     bool CheckValidationLayersSupport();
 
-    u32  FindMemoryType(u32 typeFilter, VkMemoryPropertyFlags propertyFlags) const;
     void CreateSwapchain(GLFWwindow* window) override;
+    // The window changed size or the surface is out of date. False while minimized, frames are skipped until then.
+    bool RecreateSwapchain();
+    // Ends the frame, submitted or skipped, and destroys the resources no frame in flight can use anymore.
+    void AdvanceFrame();
+
+    void LoadPipelineCache(const char* InPath);
+    void SavePipelineCache();
+
+    // The heap has one element per texture and buffer in the pools, the index of a resource is its handle index.
+    void CreateBindlessHeap();
+    void WriteBindlessDescriptor(ResourceType InType, ResourceHandle InHandle);
+
+    // Descriptor writes are batched, flushed before binding a set and before the frame submit.
+    void FlushDescriptorWrites();
+
+    // Framebuffer of an offscreen pass, shared with the passes rendering to the same views.
+    VkFramebuffer GetFramebuffer(const VulkanRenderPass* InRenderPass);
+    // The view is about to be destroyed, the framebuffers using it are too.
+    void EvictFramebuffers(VkImageView InView);
+
+    // Layouts shared by every pipeline declaring the same bindings, alive until shutdown.
+    DescriptorSetLayoutHandle GetCachedDescriptorSetLayout(const DescriptorSetLayoutDescriptor& InDescriptor);
+    VkPipelineLayout          GetCachedPipelineLayout(const VulkanDescriptorSetLayout* const* InLayouts, u32 InLayoutsCount, const VkPushConstantRange& InPushConstants);
+
+    void QueuePipelineCompile(PipelineHandle InHandle, std::future<VkPipeline> InResult);
+    // Publishes the async pipelines that finished compiling, bWait blocks until all of them are done.
+    void ResolvePipelines(bool bWait);
+    void WaitForPipeline(PipelineHandle InHandle);
 
     VulkanBuffer*              GetBufferResource(BufferHandle handle);
     VulkanShaderState*         GetShaderResource(ShaderStateHandle handle);
@@ -130,6 +190,56 @@ class VulkanDevice : public GPU_device
 
     VkDescriptorPool descriptor_pool;
 
+    // Bindless
+    VkDescriptorPool          bindless_pool   = VK_NULL_HANDLE;
+    DescriptorSetLayoutHandle bindless_layout = INVALID_DESCRIPTORSETLAYOUT;
+    VkDescriptorSet           bindless_set    = VK_NULL_HANDLE; // Null when bindless is not supported.
+
+    VulkanDescriptorAllocator descriptor_allocator; // Transient sets, reset per frame slot.
+    VulkanDescriptorWriter    descriptor_writer;
+    std::mutex                descriptor_writes_mutex; // Secondaries flush from the recording threads.
+
+    VulkanMemoryAllocator memory_allocator;
+    VulkanUploadManager   upload_manager;
+    VulkanShaderCompiler  shader_compiler;
+    VulkanGpuProfiler     gpu_profiler;
+
+    // Query features, enabled when supported.
+    bool bPipelineStatisticsSupported = false;
+    bool bInheritedQueriesSupported   = false; // Queries stay active while executing secondaries.
+
+    struct PendingPipeline
+    {
+        PipelineHandle          handle;
+        std::future<VkPipeline> result;
+    };
+
+    // Pipelines
+    VkPipelineCache              pipeline_cache = VK_NULL_HANDLE;
+    std::string                  pipeline_cache_path;
+    bool                         bPipelineCacheLoaded = false;
+    std::vector<PendingPipeline> pending_pipelines;
+    std::mutex                   pending_pipelines_mutex;
+    std::atomic<u64>             pipeline_compile_us{0};
+    std::atomic<u32>             pipeline_compile_count{0};
+
+    // Render passes begin with vkCmdBeginRendering, no VkRenderPass or VkFramebuffer is created for them. Pipelines
+    // only depend on the attachment formats.
+    bool bDynamicRendering = false;
+
+    struct CachedFramebuffer
+    {
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        VkImageView   views[MAX_IMAGE_OUTPUTS + 1];
+        u32           views_count = 0;
+    };
+
+    // Without dynamic rendering, keyed by render pass, attachment views and size.
+    std::unordered_map<u64, CachedFramebuffer> framebuffer_cache;
+
+    std::unordered_map<u64, DescriptorSetLayoutHandle> descriptor_set_layout_cache;
+    std::unordered_map<u64, VkPipelineLayout>          pipeline_layout_cache;
+
     // Queues
     std::vector<VkQueueFamilyProperties> queueFamilyProperties;
     std::vector<u32>                     queueFamilies;
@@ -141,7 +251,23 @@ class VulkanDevice : public GPU_device
     VkQueue                              TransferQueue  = VK_NULL_HANDLE;
     u32                                  FrameCount     = 0; // Number of frames since the beginning of the application.
 
+    u32     frames_in_flight = MAX_FRAMES_IN_FLIGHT;
     VkFence fence[MAX_FRAMES_IN_FLIGHT];
+    bool    bImageAcquired = false; // False when the swapchain is out of date, the frame is skipped.
+
+    // Cpu time waiting in BeginFrame.
+    f32 frame_wait_ms       = 0.0f;
+    f32 frame_wait_max_ms   = 0.0f;
+    f64 frame_wait_total_ms = 0.0;
+
+    // Per frame ring for dynamic data.
+    BufferHandle dynamic_buffer             = INVALID_BUFFER;
+    u8*          dynamic_mapped_memory      = nullptr;
+    u32          dynamic_alignment          = 256;
+    u32          dynamic_per_frame_size     = 0;
+    u32          dynamic_allocated_size     = 0;
+    u32          dynamic_frame_start        = 0; // Beginning of the partition allocations are taken from.
+    u32          dynamic_max_per_frame_size = 0;
 
     VkSemaphore beginSemaphore = VK_NULL_HANDLE;
     VkSemaphore endSemaphore   = VK_NULL_HANDLE;
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "render_device.h"
+#include "vulkan_types.h"
+
+namespace Sogas
+{
+namespace Renderer
+{
+namespace Vk
+{
+class VulkanDevice;
+
+// Gpu time of the render passes and of the zones begun on the frame command buffer, measured with a pair of
+// timestamps each. Every frame slot owns its query pools, reset when the command buffer of the frame begins. Results
+// are read when BeginFrame reuses the slot: its fence was waited for, they are available and reading never stalls.
+// Pipeline statistics are counted per render pass when enabled and supported. Resolved zones are also given to the
+// cpu profiler, converted to its clock, so both show in one capture.
+// Not thread safe, zones are recorded from the render thread.
+class VulkanGpuProfiler
+{
+  public:
+    void Init(VulkanDevice* InDevice, u32 InFramesInFlight, bool bInTimestamps, bool bInStatistics);
+    void Shutdown();
+
+    // The frame command buffer was begun, the queries of the slot are reset in it. Zones recorded before are dropped
+    // with the commands.
+    void BeginCommandBuffer(VkCommandBuffer InCommandBuffer, u32 InFrameIndex);
+    // The frame was submitted, its results are read once the slot comes back.
+    void Submit(u32 InFrameIndex);
+    // The gpu finished the frame that used the slot.
+    void Resolve(u32 InFrameIndex);
+
+    // Index of the zone to end, INVALID_ID when it is not timed. Statistics queries are outside of any render pass,
+    // the pass begins after the zone and ends before it.
+    u32  BeginZone(VkCommandBuffer InCommandBuffer, const char* InName, bool bInStatistics);
+    void EndZone(VkCommandBuffer InCommandBuffer, u32 InZone);
+
+    // Secondaries executed while statistics are counted must be begun with these, zero when they can't be.
+    VkQueryPipelineStatisticFlags GetInheritedStatistics() const;
+
+    const std::vector<GPUZoneTiming>& GetTimings() const
+    {
+        return timings;
+    }
+
+  private:
+    struct Zone
+    {
+        const char* name;
+        u32         depth;
+        u32         statistics_query; // INVALID_ID without statistics.
+    };
+
+    // Timestamps of zone i are the queries 2 * i and 2 * i + 1.
+    struct FrameQueries
+    {
+        VkQueryPool       timestamps = VK_NULL_HANDLE;
+        VkQueryPool       statistics = VK_NULL_HANDLE;
+        std::vector<Zone> zones;
+        u32               statistics_count = 0;
+        u32               open_zones       = 0;
+        bool              bReset           = false; // Queries can be written, the reset is recorded.
+        bool              bSubmitted       = false;
+    };
+
+    // Offset from the gpu timestamps to the cpu profiler clock, measured once at Init. The clocks drift slowly apart,
+    // the zones are placed approximately in the capture.
+    void Calibrate();
+
+    static constexpr u32 MAX_ZONES_PER_FRAME = 256;
+    static constexpr u32 MAX_STATISTICS      = 64; // Render passes counted per frame.
+
+    VulkanDevice* device           = nullptr;
+    u32           frames_in_flight = 0;
+    u32           current_frame    = 0;
+    FrameQueries  frames[MAX_FRAMES_IN_FLIGHT];
+
+    bool bStatistics          = false;
+    bool bInheritedStatistics = false; // Device supports queries active while executing secondaries.
+    f64  timestamp_period     = 1.0;   // Nanoseconds per tick.
+    u64  timestamp_mask       = 0;     // Valid bits of the timestamps, zero when not supported.
+    i64  cpu_offset_ns        = 0;
+
+    std::vector<GPUZoneTiming>       timings;
+    std::vector<u64>                 query_results; // Scratch, kept to avoid allocating every frame.
+    std::vector<Profiler::TrackZone> track_zones;
+
+    // Stats
+    u32 resolved_frames = 0;
+    u32 dropped_zones   = 0; // Not timed, or not counted, because the pools of the frame were full.
+    f64 frame_total_ms  = 0.0;
+    f64 frame_max_ms    = 0.0;
+};
+
+} // namespace Vk
+} // namespace Renderer
+} // namespace Sogas
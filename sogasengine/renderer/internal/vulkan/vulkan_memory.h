@@ -0,0 +1,91 @@
+#pragma once
+
+#include "vulkan_types.h"
+#include <functional>
+#include <mutex>
+
+namespace Sogas
+{
+namespace Renderer
+{
+namespace Vk
+{
+struct VulkanMemoryBlock;
+struct VulkanMemoryNode;
+struct VulkanMemoryPool;
+
+// Range of device memory owned by a resource. Either a sub allocation of a block or a dedicated allocation.
+struct VulkanAllocation
+{
+    VkDeviceMemory    memory      = VK_NULL_HANDLE;
+    VkDeviceSize      offset      = 0;
+    VkDeviceSize      size        = 0;
+    u8*               mapped      = nullptr; // Host visible memory stays mapped while the allocation is alive.
+    u32               memory_type = 0;
+    VulkanMemoryNode* node        = nullptr; // Null for dedicated allocations.
+    bool              aliasable   = false;   // Not tied to the resource, other resources can be bound to the range.
+
+    bool IsValid() const { return memory != VK_NULL_HANDLE; }
+};
+
+// Device memory allocator. Large blocks are allocated per memory type and split with a two level segregated
+// fit (TLSF) allocator, so allocation and free are O(1) and neighbour free ranges are merged.
+// Buffers and optimal tiling images live in separate blocks, no bufferImageGranularity padding is needed.
+class VulkanMemoryAllocator
+{
+  public:
+    // Called for each allocation moved while defragmenting. The resource must be recreated and bound at the
+    // new allocation and its contents copied, return false to keep it where it is. Called without the allocator
+    // lock, it may allocate and free other allocations but not the two it is given.
+    using MoveCallback = std::function<bool(void* user_data, const VulkanAllocation& from, const VulkanAllocation& to)>;
+
+    void Init(VkDevice InDevice, VkPhysicalDevice InPhysicalDevice);
+    void Shutdown();
+
+    // Allocates and binds memory for the resource. User data is given back when defragmenting.
+    VulkanAllocation AllocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties, void* user_data = nullptr);
+    // Aliasable images never get memory dedicated to them, unless the driver requires it.
+    VulkanAllocation AllocateImage(VkImage image, VkMemoryPropertyFlags properties, bool bDedicated, bool bAliasable, void* user_data = nullptr);
+
+    void Free(VulkanAllocation& allocation);
+
+    // Empties the least used blocks of each pool moving up to max_moves allocations, empty blocks are released.
+    // The caller must make sure the gpu doesn't use the moved resources. Returns the number of allocations moved.
+    u32 Defragment(u32 max_moves, const MoveCallback& move);
+
+    GPUMemoryStats GetStats() const;
+
+    VkMemoryPropertyFlags GetMemoryProperties(u32 memory_type) const { return memory_properties.memoryTypes[memory_type].propertyFlags; }
+    // Device local memory the cpu can write to, big enough for more than the 256 MB BAR (resizable BAR, integrated gpus).
+    bool HasMappableDeviceLocalHeap() const { return bMappableDeviceLocalHeap; }
+
+  private:
+    VulkanAllocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, u32 pool_kind, bool bDedicated, VkBuffer buffer, VkImage image, void* user_data);
+    VulkanAllocation AllocateFromPool(VulkanMemoryPool& pool, VkDeviceSize size, VkDeviceSize alignment, const VulkanMemoryBlock* excluded, void* user_data);
+    VulkanAllocation AllocateDedicated(VkDeviceSize size, u32 memory_type, VkBuffer buffer, VkImage image);
+
+    VulkanMemoryBlock* CreateBlock(VulkanMemoryPool& pool, VkDeviceSize min_size);
+    void               DestroyBlock(VulkanMemoryBlock* block);
+    void               FreeNode(VulkanMemoryNode* node);
+
+    VulkanMemoryNode* NewNode();
+
+    u32 FindMemoryType(u32 type_bits, VkMemoryPropertyFlags properties) const;
+
+    VkDevice                         device = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties memory_properties{};
+    VkDeviceSize                     block_size[VK_MAX_MEMORY_TYPES]{};
+    bool                             bMappableDeviceLocalHeap = false;
+
+    std::vector<VulkanMemoryPool*> pools; // One per memory type and pool kind.
+    std::vector<VulkanMemoryNode*> free_nodes;
+
+    u32          dedicated_count = 0;
+    VkDeviceSize dedicated_bytes[VK_MAX_MEMORY_TYPES]{};
+
+    mutable std::mutex mutex;
+};
+
+} // namespace Vk
+} // namespace Renderer
+} // namespace Sogas
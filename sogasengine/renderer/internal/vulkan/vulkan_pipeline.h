@@ -11,6 +11,7 @@ namespace Vk
 {
 class VulkanDevice;
 class VulkanDescriptorSetLayout;
+struct VulkanShaderState;
 class VulkanPipeline
 {
   public:
@@ -20,25 +21,31 @@ class VulkanPipeline
     const VulkanPipeline& operator=(const VulkanPipeline& other) = delete;
     ~VulkanPipeline();
 
-    static PipelineHandle Create(VulkanDevice* InDevice, const PipelineDescriptor& InDescriptor);
+    // Async pipelines are compiled on a worker thread, their VkPipeline stays null until the device resolves them.
+    static PipelineHandle Create(VulkanDevice* InDevice, const PipelineDescriptor& InDescriptor, bool bAsync = false);
 
     void Destroy();
 
     // TODO rethink this, probably make them private ...
     VkPipeline          pipeline       = VK_NULL_HANDLE;
-    VkPipelineLayout    pipelineLayout = VK_NULL_HANDLE;
+    VkPipelineLayout    pipelineLayout = VK_NULL_HANDLE; // Owned by the device layout cache.
     VkPipelineBindPoint bind_point;
+    VkPushConstantRange push_constants = {};
 
     ShaderStateHandle shader_state;
 
     const VulkanDescriptorSetLayout* descriptor_set_layout[MAX_DESCRIPTOR_SET_LAYOUTS];
     DescriptorSetLayoutHandle        descriptor_set_layout_handle[MAX_DESCRIPTOR_SET_LAYOUTS];
     u32                              active_layout_count = 0;
+    bool                             bindless            = false; // Binds the device bindless set with the pipeline.
 
     PipelineHandle handle;
     bool           graphics_pipeline = true;
+    bool           bFailed           = false; // The async compile failed, the pipeline can't be bound.
 
   private:
+    static VkPipeline Compile(VulkanDevice* InDevice, const PipelineDescriptor& InDescriptor, const VulkanShaderState& InShaderState, VkPipelineLayout InLayout, VkRenderPass InRenderPass);
+
     VulkanDevice* device = nullptr;
 };
 
@@ -24,8 +24,9 @@ class VulkanRenderPass
 
     void Destroy();
 
-    VkRenderPass     renderpass  = VK_NULL_HANDLE;
-    VkFramebuffer    framebuffer = VK_NULL_HANDLE;
+    // Null for offscreen passes with dynamic rendering. Their framebuffers come from the device cache, swapchain
+    // passes use the swapchain framebuffers.
+    VkRenderPass     renderpass = VK_NULL_HANDLE;
     RenderPassType   type;
     RenderPassOutput output;
 
@@ -44,6 +45,7 @@ class VulkanRenderPass
     u8 render_targets_count = 0;
 
     std::string name;
+    const char* profile_name = nullptr; // Interned name, the gpu zone of the pass outlives it.
 
     VkRenderPassBeginInfo beginInfo = {};
     VkClearValue          clearColor[8]; // Maximum of 8 attachments at the moment.
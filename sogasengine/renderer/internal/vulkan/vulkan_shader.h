@@ -11,6 +11,16 @@ namespace Vk
 {
 class VulkanDevice;
 
+// Descriptor found by reflection, merged across the stages of a shader state.
+// A count of 0 is a runtime sized array, only valid in the bindless set.
+struct VulkanShaderBinding
+{
+    DescriptorType type  = DescriptorType::COUNT;
+    u16            set   = 0;
+    u16            start = 0;
+    u16            count = 0;
+};
+
 struct VulkanShaderState
 {
     VkPipelineShaderStageCreateInfo ShaderStageInfo[MAX_SHADER_STAGES];
@@ -18,6 +28,14 @@ struct VulkanShaderState
     std::string Name;
     u8          ActiveShaders{0};
     bool        bIsGraphicsPipeline{false};
+
+    // Reflected from the SPIR-V of the stages, pipelines without explicit layouts or vertex attributes use them.
+    VulkanShaderBinding Bindings[MAX_DESCRIPTOR_SET_LAYOUTS * MAX_DESCRIPTOR_PER_SET]; // Sorted by set and binding.
+    u32                 BindingsCount{0};
+    u32                 SetsCount{0}; // Highest set used plus one.
+    VkPushConstantRange PushConstants{};
+    VertexAttribute     VertexInputs[MAX_VERTEX_ATTRIBUTE]; // Location and format only, sorted by location.
+    u32                 VertexInputsCount{0};
 };
 
 class VulkanShader
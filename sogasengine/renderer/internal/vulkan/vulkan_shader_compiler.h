@@ -0,0 +1,51 @@
+#pragma once
+
+#include "vulkan_types.h"
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace Sogas
+{
+namespace Renderer
+{
+namespace Vk
+{
+
+// Compiles GLSL to SPIR-V in process with shaderc. Results are cached in memory and on disk, keyed by a hash of the
+// source, the files it includes, the defines and the stage, so unchanged shaders are only compiled once. #include is resolved
+// against the including file, then the include directory of the shader. Thread safe, variants can be compiled from
+// worker threads.
+class VulkanShaderCompiler
+{
+  public:
+    using Defines = std::vector<std::pair<std::string, std::string>>;
+
+    // An empty cache directory disables the disk cache.
+    void Init(const std::string& InCacheDirectory);
+    void Shutdown();
+
+    bool Compile(const char* code, u32 size, ShaderStageType stage, const std::string& name, const Defines& defines, const std::string& include_directory, std::vector<u32>& OutSpirv);
+
+  private:
+    u64  ComputeKey(const char* code, u32 size, ShaderStageType stage, const std::string& name, const Defines& defines, const std::string& include_directory) const;
+    bool LoadCached(u64 key, std::vector<u32>& OutSpirv) const;
+    void StoreCached(u64 key, const std::vector<u32>& spirv) const;
+
+    std::string cache_directory;
+
+    // Every shader compiled or loaded this run. Variants compiled ahead on workers are found here when the shader
+    // state is created, even without a disk cache.
+    std::unordered_map<u64, std::vector<u32>> memory_cache;
+    std::mutex                                memory_cache_mutex;
+
+    // Stats
+    std::atomic<u32> cache_hits{0};
+    std::atomic<u32> cache_misses{0};
+    std::atomic<u64> compile_us{0};
+    std::atomic<u64> load_us{0};
+};
+
+} // namespace Vk
+} // namespace Renderer
+} // namespace Sogas
@@ -19,8 +19,12 @@ class VulkanSwapchain
     ~VulkanSwapchain();
 
     static bool Create(VulkanDevice* device, std::shared_ptr<VulkanSwapchain> swapchain);
+    // Without a surface, a single render target texture stands for the images and nothing is presented.
+    static bool CreateHeadless(VulkanDevice* device, std::shared_ptr<VulkanSwapchain> swapchain, u16 InWidth, u16 InHeight);
 
     void           CreateRenderPass(VulkanRenderPass* render_pass);
+    // Framebuffers and views of the images, recreated with the swapchain.
+    void           DestroyTargets();
     void           Destroy();
 
     VkSwapchainKHR     swapchain = VK_NULL_HANDLE;
@@ -37,8 +41,17 @@ class VulkanSwapchain
     std::vector<VkImageView>   imageViews;
     std::vector<VkFramebuffer> framebuffers;
 
-    VkSemaphore presentCompleteSemaphore = VK_NULL_HANDLE;
-    VkSemaphore renderCompleteSemaphore  = VK_NULL_HANDLE;
+    // Layout the images are left in at the end of the frame, ready to be read back when headless.
+    VkImageLayout present_layout  = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    TextureHandle headless_target = INVALID_TEXTURE;
+
+    // Signaled when the acquired image can be rendered, one per frame in flight.
+    VkSemaphore imageAcquiredSemaphores[MAX_FRAMES_IN_FLIGHT]{};
+    // Waited by the presentation engine, one per image as the semaphore is only known to be free once its image is
+    // acquired again.
+    std::vector<VkSemaphore> renderCompleteSemaphores;
+    // Fence of the last frame rendering to each image, null until the image is first used.
+    std::vector<VkFence> imageFences;
 
   private:
     VulkanDevice* device = nullptr;
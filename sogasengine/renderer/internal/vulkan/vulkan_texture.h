@@ -1,6 +1,7 @@
 #pragma once
 
 #include "texture.h"
+#include "vulkan_memory.h"
 #include "vulkan_types.h"
 
 namespace Sogas
@@ -66,17 +67,20 @@ class VulkanTexture
 
     VkDescriptorImageInfo descriptorImageInfo;
 
-    VkImage        texture    = VK_NULL_HANDLE;
-    VkImageView    image_view = VK_NULL_HANDLE;
-    VkDeviceMemory memory     = VK_NULL_HANDLE;
-    VkImageLayout  image_layout;
+    VkImage          texture    = VK_NULL_HANDLE;
+    VkImageView      image_view = VK_NULL_HANDLE;
+    VulkanAllocation allocation;
+    VkImageLayout    image_layout;
 
     VulkanTextureDescriptor descriptor;
     TextureHandle           handle;
+    TextureHandle           alias   = INVALID_TEXTURE; // Owner of the memory the texture is bound to, it doesn't free it.
     VulkanSampler*          sampler = nullptr;
     void*                   mapdata = nullptr;
 
-    void Allocate_and_bind_texture_memory(VkMemoryPropertyFlags memory_properties);
+    void Allocate_and_bind_texture_memory(VkMemoryPropertyFlags memory_properties, bool bDedicated, bool bAliasable);
+    // Binds the image at the allocation of the alias, false when the image doesn't fit in it.
+    bool Bind_aliased_memory(TextureHandle InAlias);
 
   private:
     VulkanDevice* device = nullptr;
@@ -6,6 +6,8 @@
 #include <vulkan/vulkan.h>
 
 static const u32 MAX_FRAMES_IN_FLIGHT = 3;
+static const u32 DYNAMIC_BUFFER_PER_FRAME_SIZE = 4 * 1024 * 1024;
+static const u32 UPLOAD_RING_SIZE = 32 * 1024 * 1024;
 
 namespace Sogas
 {
@@ -76,100 +78,6 @@ constexpr VkImageType GetImageType(TextureDescriptor::TextureType type)
     }
 }
 
-constexpr u32 GetFormatStride(Format format)
-{
-    switch (format)
-    {
-        case Format::R32G32B32A32_SFLOAT:
-        case Format::R32G32B32A32_UINT:
-        case Format::R32G32B32A32_SINT:
-            return 16u;
-        case Format::R32G32B32_SFLOAT:
-        case Format::R32G32B32_UINT:
-        case Format::R32G32B32_SINT:
-            return 12u;
-        case Format::R64_UINT:
-        case Format::R64_SINT:
-        case Format::R64_SFLOAT:
-        case Format::R32G32_SFLOAT:
-        case Format::R32G32_UINT:
-        case Format::R32G32_SINT:
-        case Format::R16G16B16A16_SFLOAT:
-        case Format::R16G16B16A16_SNORM:
-        case Format::R16G16B16A16_UNORM:
-        case Format::R16G16B16A16_SINT:
-        case Format::R16G16B16A16_UINT:
-            return 8u;
-        case Format::R16G16B16_SFLOAT:
-        case Format::R16G16B16_SNORM:
-        case Format::R16G16B16_UNORM:
-        case Format::R16G16B16_SINT:
-        case Format::R16G16B16_UINT:
-            return 6u;
-        case Format::R32_SFLOAT:
-        case Format::R32_UINT:
-        case Format::R32_SINT:
-        case Format::R16G16_SFLOAT:
-        case Format::R16G16_SNORM:
-        case Format::R16G16_UNORM:
-        case Format::R16G16_SINT:
-        case Format::R16G16_UINT:
-        case Format::R8G8B8A8_SRGB:
-        case Format::R8G8B8A8_SSCALED:
-        case Format::R8G8B8A8_USCALED:
-        case Format::R8G8B8A8_SNORM:
-        case Format::R8G8B8A8_UNORM:
-        case Format::R8G8B8A8_SINT:
-        case Format::R8G8B8A8_UINT:
-        case Format::B8G8R8A8_SRGB:
-        case Format::B8G8R8A8_SSCALED:
-        case Format::B8G8R8A8_USCALED:
-        case Format::B8G8R8A8_SNORM:
-        case Format::B8G8R8A8_UNORM:
-        case Format::B8G8R8A8_SINT:
-        case Format::B8G8R8A8_UINT:
-            return 4u;
-        case Format::R8G8B8_SRGB:
-        case Format::R8G8B8_SSCALED:
-        case Format::R8G8B8_USCALED:
-        case Format::R8G8B8_SNORM:
-        case Format::R8G8B8_UNORM:
-        case Format::R8G8B8_SINT:
-        case Format::R8G8B8_UINT:
-        case Format::B8G8R8_SRGB:
-        case Format::B8G8R8_SSCALED:
-        case Format::B8G8R8_USCALED:
-        case Format::B8G8R8_SNORM:
-        case Format::B8G8R8_UNORM:
-        case Format::B8G8R8_SINT:
-        case Format::B8G8R8_UINT:
-            return 3u;
-        case Format::R16_SFLOAT:
-        case Format::R16_SNORM:
-        case Format::R16_UNORM:
-        case Format::R16_SINT:
-        case Format::R16_UINT:
-        case Format::R8G8_SRGB:
-        case Format::R8G8_SSCALED:
-        case Format::R8G8_USCALED:
-        case Format::R8G8_SNORM:
-        case Format::R8G8_UNORM:
-        case Format::R8G8_SINT:
-        case Format::R8G8_UINT:
-            return 2u;
-        case Format::R8_SRGB:
-        case Format::R8_SSCALED:
-        case Format::R8_USCALED:
-        case Format::R8_SNORM:
-        case Format::R8_UNORM:
-        case Format::R8_SINT:
-        case Format::R8_UINT:
-            return 1u;
-        default:
-            return 0;
-    }
-}
-
 constexpr VkFormat ConvertFormat(Format format)
 {
     switch (format)
@@ -578,6 +486,37 @@ constexpr VkFormat ConvertVertexFormat(VertexFormat InFormat)
     }
 }
 
+// Size in bytes of one attribute of the format, matches ConvertVertexFormat.
+constexpr u32 GetVertexFormatSize(VertexFormat InFormat)
+{
+    switch (InFormat)
+    {
+        case VertexFormat::BYTE:
+        case VertexFormat::UBYTE:
+            return 1;
+        case VertexFormat::FLOAT:
+        case VertexFormat::BYTE4N:
+        case VertexFormat::UBYTE4N:
+        case VertexFormat::SHORT2:
+        case VertexFormat::SHORT2N:
+        case VertexFormat::UINT:
+            return 4;
+        case VertexFormat::FLOAT2:
+        case VertexFormat::SHORT4:
+        case VertexFormat::SHORT4N:
+        case VertexFormat::UINT2:
+            return 8;
+        case VertexFormat::FLOAT3:
+            return 12;
+        case VertexFormat::FLOAT4:
+        case VertexFormat::MAT4:
+        case VertexFormat::UINT4:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
 constexpr VkCompareOp ConvertCompareOperation(CompareOperation operation)
 {
     switch (operation)
@@ -610,6 +549,8 @@ constexpr VkShaderStageFlagBits ConvertShaderStage(ShaderStageType stage)
             return VK_SHADER_STAGE_FRAGMENT_BIT;
         case ShaderStageType::VERTEX:
             return VK_SHADER_STAGE_VERTEX_BIT;
+        case ShaderStageType::COMPUTE:
+            return VK_SHADER_STAGE_COMPUTE_BIT;
         case ShaderStageType::UNDEFINED:
         default:
             return VK_SHADER_STAGE_ALL;
@@ -644,6 +585,19 @@ constexpr VkImageLayout ConvertImageLayout(BindPoint InLayout)
     }
 }
 
+constexpr VkAttachmentLoadOp ConvertLoadOperation(RenderPassOperation InOperation)
+{
+    switch (InOperation)
+    {
+        case RenderPassOperation::LOAD:
+            return VK_ATTACHMENT_LOAD_OP_LOAD;
+        case RenderPassOperation::CLEAR:
+            return VK_ATTACHMENT_LOAD_OP_CLEAR;
+        default:
+            return VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    }
+}
+
 } // namespace Vk
 } // namespace Renderer
 } // namespace Sogas
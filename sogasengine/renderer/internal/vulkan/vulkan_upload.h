@@ -0,0 +1,105 @@
+#pragma once
+
+#include "vulkan_memory.h"
+#include "vulkan_types.h"
+
+namespace Sogas
+{
+namespace Renderer
+{
+namespace Vk
+{
+class VulkanDevice;
+
+// Streams buffer and texture contents through a persistent staging ring, copies are batched and executed on the
+// transfer queue. Batches signal a timeline semaphore the next frame waits on, the cpu never waits for an upload
+// unless the ring is full. When the transfer queue belongs to another family, ownership is released after the copy
+// and acquired by the graphics queue at the beginning of the frame.
+// Destinations are expected to be new resources, ownership is not released from the graphics queue before copying.
+// Not thread safe, uploads are recorded from the render thread.
+class VulkanUploadManager
+{
+  public:
+    void Init(VulkanDevice* InDevice);
+    void Shutdown();
+
+    // Data is copied into the staging ring, the copy is submitted with the next frame or when the ring is full.
+    void UploadBuffer(VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size);
+    // Leaves the image in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+    void UploadTexture(VkImage image, VkExtent3D extent, VkImageAspectFlags aspect, const void* data, VkDeviceSize size);
+
+    // Submits the copies recorded so far to the transfer queue.
+    void Flush();
+
+    // Flushes and gives the semaphore, value and ownership acquire commands the frame submit must wait on.
+    // Returns false when there is nothing to wait for.
+    bool PrepareFrameSubmit(u32 frame_index, VkSemaphore& OutSemaphore, u64& OutValue, VkCommandBuffer& OutAcquire);
+
+    // Releases staging space of the batches the gpu finished.
+    void Update();
+
+    void WaitIdle();
+
+    // The graphics queue has not acquired the buffer from the transfer queue yet, it must not be replaced.
+    bool HasPendingAcquire(VkBuffer buffer) const;
+
+  private:
+    struct TemporaryStaging
+    {
+        VkBuffer         buffer = VK_NULL_HANDLE;
+        VulkanAllocation allocation;
+    };
+
+    struct Batch
+    {
+        VkCommandBuffer               command_buffer = VK_NULL_HANDLE;
+        u64                           value          = 0; // Timeline value signaled when the copies are done.
+        VkDeviceSize                  ring_end       = 0;
+        std::vector<TemporaryStaging> temporaries; // Uploads bigger than the ring.
+    };
+
+    // Returns the staging buffer and offset the data was written to. The recording batch is started, the copy must be
+    // recorded into it before anything else flushes.
+    bool   Stage(const void* data, VkDeviceSize size, VkDeviceSize alignment, VkBuffer& OutBuffer, VkDeviceSize& OutOffset);
+    bool   Reserve(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& OutOffset);
+    Batch& GetRecordingBatch();
+    void   RetireBatches(bool bWait);
+
+    static const u32 MAX_BATCHES = 8;
+
+    VulkanDevice* device = nullptr;
+
+    VkCommandPool transfer_pool = VK_NULL_HANDLE;
+    VkCommandPool acquire_pool  = VK_NULL_HANDLE;
+    VkSemaphore   timeline      = VK_NULL_HANDLE;
+
+    Batch           batches[MAX_BATCHES];
+    u32             first_batch     = 0; // Oldest batch in flight.
+    u32             in_flight_count = 0;
+    bool            bRecording      = false;
+    u64             submitted_value = 0;
+    u64             waited_value    = 0; // Last value a frame waited on.
+    VkCommandBuffer acquire_command_buffers[MAX_FRAMES_IN_FLIGHT]{};
+
+    // Recorded when the transfer and graphics families differ.
+    std::vector<VkBufferMemoryBarrier> pending_buffer_acquires;
+    std::vector<VkImageMemoryBarrier>  pending_image_acquires;
+    std::vector<VkBufferMemoryBarrier> recording_buffer_acquires;
+    std::vector<VkImageMemoryBarrier>  recording_image_acquires;
+
+    // Staging ring, [tail, head) is in use by the batches in flight and the one being recorded.
+    VkBuffer         ring_buffer = VK_NULL_HANDLE;
+    VulkanAllocation ring_allocation;
+    VkDeviceSize     ring_size = 0;
+    VkDeviceSize     ring_head = 0;
+    VkDeviceSize     ring_tail = 0;
+
+    // Stats
+    u64 uploaded_bytes  = 0;
+    u32 submitted_count = 0;
+    u32 stall_count     = 0;
+};
+
+} // namespace Vk
+} // namespace Renderer
+} // namespace Sogas
@@ -0,0 +1,341 @@
+#include "null/null_commandbuffer.h"
+#include "null/null_device.h"
+
+namespace Sogas
+{
+namespace Renderer
+{
+namespace Null
+{
+
+void NullCommandStats::Add(const NullCommandStats& InOther)
+{
+    draws                += InOther.draws;
+    instances            += InOther.instances;
+    pass_binds           += InOther.pass_binds;
+    pipeline_binds       += InOther.pipeline_binds;
+    descriptor_set_binds += InOther.descriptor_set_binds;
+    buffer_binds         += InOther.buffer_binds;
+    barriers             += InOther.barriers;
+    uploaded_bytes       += InOther.uploaded_bytes;
+    command_bytes        += InOther.command_bytes;
+    validation_errors    += InOther.validation_errors;
+}
+
+void NullCommandStats::Max(const NullCommandStats& InOther)
+{
+    draws                = std::max(draws, InOther.draws);
+    instances            = std::max(instances, InOther.instances);
+    pass_binds           = std::max(pass_binds, InOther.pass_binds);
+    pipeline_binds       = std::max(pipeline_binds, InOther.pipeline_binds);
+    descriptor_set_binds = std::max(descriptor_set_binds, InOther.descriptor_set_binds);
+    buffer_binds         = std::max(buffer_binds, InOther.buffer_binds);
+    barriers             = std::max(barriers, InOther.barriers);
+    uploaded_bytes       = std::max(uploaded_bytes, InOther.uploaded_bytes);
+    command_bytes        = std::max(command_bytes, InOther.command_bytes);
+    validation_errors    = std::max(validation_errors, InOther.validation_errors);
+}
+
+void NullCommandBuffer::init(u32 buffer_size, u32 /*submit_size*/, bool /*baked*/)
+{
+    commands.reserve(buffer_size);
+    reset();
+}
+
+void NullCommandBuffer::finish()
+{
+    bRecording = false;
+}
+
+// interface
+
+void NullCommandBuffer::bind_pass(RenderPassHandle handle, bool use_secondary)
+{
+    bRecording = true;
+
+    if (!validate(device->GetRenderPassResource(handle) != nullptr, "Binding an invalid render pass."))
+    {
+        return;
+    }
+
+    if (handle.index == current_pass.index && use_secondary == bPassUsesSecondaries)
+    {
+        return;
+    }
+
+    current_pass         = handle;
+    current_pipeline     = INVALID_PIPELINE;
+    bPassUsesSecondaries = use_secondary;
+    ++stats.pass_binds;
+
+    record(NullCommandType::BIND_PASS, handle);
+}
+
+void NullCommandBuffer::bind_pipeline(PipelineHandle handle)
+{
+    const NullPipeline*   pipeline = device->GetPipelineResource(handle);
+    const NullRenderPass* pass     = device->GetRenderPassResource(current_pass);
+    if (!validate(pipeline != nullptr, "Binding an invalid pipeline.") || !validate(pass != nullptr, "Binding a pipeline outside of a render pass.") ||
+        !validate(pipeline->color_formats_count == pass->render_targets_count, "Pipeline attachments don't match the bound render pass."))
+    {
+        return;
+    }
+
+    current_pipeline = handle;
+    ++stats.pipeline_binds;
+
+    record(NullCommandType::BIND_PIPELINE, handle);
+}
+
+void NullCommandBuffer::bind_descriptor_set(DescriptorSetHandle handle, u32* /*offsets*/, u32 offsets_count)
+{
+    const NullDescriptorSet* descriptor_set = device->GetDescriptorSetResource(handle);
+    if (!validate(descriptor_set != nullptr, "Binding an invalid descriptor set.") || !validate(device->GetPipelineResource(current_pipeline) != nullptr, "Binding a descriptor set without a pipeline.") ||
+        !validate(device->GetDescriptorSetLayoutResource(descriptor_set->layout) != nullptr, "Descriptor set layout was destroyed."))
+    {
+        return;
+    }
+
+    ++stats.descriptor_set_binds;
+
+    struct
+    {
+        DescriptorSetHandle handle;
+        u32                 offsets_count;
+    } command = {handle, offsets_count};
+    record(NullCommandType::BIND_DESCRIPTOR_SET, command);
+}
+
+void NullCommandBuffer::bind_descriptor_set(const TransientDescriptorSet& set, u32* /*offsets*/, u32 /*offsets_count*/)
+{
+    if (!validate(set.set != 0, "Binding a transient descriptor set that failed to allocate.") || !validate(device->GetPipelineResource(current_pipeline) != nullptr, "Binding a descriptor set without a pipeline."))
+    {
+        return;
+    }
+
+    ++stats.descriptor_set_binds;
+    record(NullCommandType::BIND_TRANSIENT_DESCRIPTOR_SET, set);
+}
+
+void NullCommandBuffer::push_constants(const void* data, u32 size, u32 offset)
+{
+    // The push constant range is not reflected, only the bound pipeline is checked.
+    if (!validate(device->GetPipelineResource(current_pipeline) != nullptr, "Pushing constants without a pipeline."))
+    {
+        return;
+    }
+
+    stats.uploaded_bytes += size;
+
+    u8* payload = append(NullCommandType::PUSH_CONSTANTS, static_cast<u32>(sizeof(u32)) + size);
+    memcpy(payload, &offset, sizeof(u32));
+    memcpy(payload + sizeof(u32), data, size);
+}
+
+void NullCommandBuffer::bind_vertex_buffer(BufferHandle handle, u32 binding, u32 offset)
+{
+    const NullBuffer* buffer = device->GetBufferResource(handle);
+    if (!validate(buffer != nullptr, "Binding an invalid vertex buffer.") || !validate(offset <= buffer->size, "Vertex buffer offset out of range."))
+    {
+        return;
+    }
+
+    ++stats.buffer_binds;
+
+    struct
+    {
+        BufferHandle handle;
+        u32          binding;
+        u32          offset;
+    } command = {handle, binding, offset};
+    record(NullCommandType::BIND_VERTEX_BUFFER, command);
+}
+
+void NullCommandBuffer::bind_index_buffer(BufferHandle handle, u32 offset)
+{
+    const NullBuffer* buffer = device->GetBufferResource(handle);
+    if (!validate(buffer != nullptr, "Binding an invalid index buffer.") || !validate(offset <= buffer->size, "Index buffer offset out of range."))
+    {
+        return;
+    }
+
+    bIndexBufferBound = true;
+    ++stats.buffer_binds;
+
+    struct
+    {
+        BufferHandle handle;
+        u32          offset;
+    } command = {handle, offset};
+    record(NullCommandType::BIND_INDEX_BUFFER, command);
+}
+
+void NullCommandBuffer::barrier(const TextureBarrier* barriers, u32 count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        if (!validate(device->GetTextureResource(barriers[i].texture) != nullptr, "Barrier on an invalid texture."))
+        {
+            return;
+        }
+    }
+
+    // Ends the render pass like on the other devices.
+    current_pass         = INVALID_RENDERPASS;
+    current_pipeline     = INVALID_PIPELINE;
+    bPassUsesSecondaries = false;
+    stats.barriers += count;
+
+    const u32 size = static_cast<u32>(sizeof(TextureBarrier)) * count;
+    memcpy(append(NullCommandType::BARRIER, size), barriers, size);
+}
+
+void NullCommandBuffer::begin_zone(const char* name)
+{
+    if (!validate(!bSecondary && !bPassUsesSecondaries, "Gpu zones are recorded on primaries, outside of passes executing secondaries."))
+    {
+        return;
+    }
+
+    ++open_zones;
+    record(NullCommandType::BEGIN_ZONE, name);
+}
+
+void NullCommandBuffer::end_zone()
+{
+    if (!validate(open_zones > 0, "Ending a gpu zone that was not begun."))
+    {
+        return;
+    }
+
+    --open_zones;
+    append(NullCommandType::END_ZONE, 0);
+}
+
+void NullCommandBuffer::set_viewport()
+{
+    append(NullCommandType::SET_VIEWPORT, 0);
+}
+
+void NullCommandBuffer::set_scissors()
+{
+    append(NullCommandType::SET_SCISSORS, 0);
+}
+
+void NullCommandBuffer::draw(u32 first_vertex, u32 vertex_count, u32 first_instance, u32 instance_count)
+{
+    if (!validate(device->GetPipelineResource(current_pipeline) != nullptr, "Drawing without a pipeline.") || !validate(!bPassUsesSecondaries, "Drawing in a pass recorded in secondary command buffers."))
+    {
+        return;
+    }
+
+    ++stats.draws;
+    stats.instances += instance_count;
+
+    const u32 command[] = {first_vertex, vertex_count, first_instance, instance_count};
+    record(NullCommandType::DRAW, command);
+}
+
+void NullCommandBuffer::draw_indexed(u32 index_count, u32 instance_count, u32 first_index, i32 vertex_offset, u32 first_instance)
+{
+    if (!validate(device->GetPipelineResource(current_pipeline) != nullptr, "Drawing without a pipeline.") || !validate(bIndexBufferBound, "Indexed draw without an index buffer.") ||
+        !validate(!bPassUsesSecondaries, "Drawing in a pass recorded in secondary command buffers."))
+    {
+        return;
+    }
+
+    ++stats.draws;
+    stats.instances += instance_count;
+
+    struct
+    {
+        u32 index_count;
+        u32 instance_count;
+        u32 first_index;
+        i32 vertex_offset;
+        u32 first_instance;
+    } command = {index_count, instance_count, first_index, vertex_offset, first_instance};
+    record(NullCommandType::DRAW_INDEXED, command);
+}
+
+void NullCommandBuffer::end()
+{
+    SASSERT_MSG(bSecondary, "Primary command buffers are ended when the frame is submitted.");
+    bRecording = false;
+}
+
+void NullCommandBuffer::execute_commands(CommandBuffer** secondaries, u32 count)
+{
+    if (!validate(bPassUsesSecondaries, "Executing secondaries in a pass not bound for them."))
+    {
+        return;
+    }
+
+    // The work recorded by the secondaries is counted in the frame through the primary executing it.
+    for (u32 i = 0; i < count; ++i)
+    {
+        const NullCommandBuffer* secondary = static_cast<NullCommandBuffer*>(secondaries[i]);
+        validate(!secondary->bRecording, "Executing a secondary command buffer that was not ended.");
+        stats.Add(secondary->stats);
+    }
+
+    record(NullCommandType::EXECUTE_COMMANDS, count);
+}
+
+void NullCommandBuffer::reset()
+{
+    commands.clear();
+    stats = {};
+
+    current_pass         = INVALID_RENDERPASS;
+    current_pipeline     = INVALID_PIPELINE;
+    bRecording           = false;
+    bIndexBufferBound    = false;
+    bPassUsesSecondaries = false;
+    open_zones           = 0;
+}
+
+void NullCommandBuffer::begin_secondary(const NullCommandBuffer* primary)
+{
+    SASSERT_MSG(primary->current_pass.index != INVALID_ID, "Secondary command buffers continue the render pass of the primary.");
+
+    reset();
+
+    bSecondary   = true;
+    bRecording   = true;
+    current_pass = primary->current_pass;
+}
+
+u8* NullCommandBuffer::append(NullCommandType InType, u32 InSize)
+{
+    SASSERT(InSize <= std::numeric_limits<u16>::max());
+
+    const CommandHeader header = {InType, static_cast<u16>(InSize)};
+    const size_t        offset = commands.size();
+
+    commands.resize(offset + sizeof(CommandHeader) + InSize);
+    memcpy(commands.data() + offset, &header, sizeof(CommandHeader));
+
+    stats.command_bytes += sizeof(CommandHeader) + InSize;
+    return commands.data() + offset + sizeof(CommandHeader);
+}
+
+bool NullCommandBuffer::validate(bool bCondition, const char* InMessage)
+{
+    if (!bCondition)
+    {
+        SERROR("Null device: %s", InMessage);
+        ++stats.validation_errors;
+    }
+
+    return bCondition;
+}
+
+} // namespace Null
+} // namespace Renderer
+} // namespace Sogas
@@ -0,0 +1,932 @@
+#include "null/null_device.h"
+
+#include "public/sgs_memory.h"
+
+#include <cstdlib>
+
+namespace Sogas
+{
+namespace Renderer
+{
+namespace Null
+{
+
+NullDevice::NullDevice(GraphicsAPI apiType)
+{
+    api_type = apiType;
+}
+
+NullDevice::~NullDevice()
+{
+    shutdown();
+}
+
+bool NullDevice::Init(const DeviceDescriptor& InDescriptor)
+{
+    STRACE("Initializing null renderer ... ");
+
+    allocator        = InDescriptor.allocator;
+    frames_in_flight = std::clamp<u32>(InDescriptor.frames_in_flight, 2, NULL_MAX_FRAMES_IN_FLIGHT);
+
+    // There is no window to present to, the swapchain pass renders to a texture like a headless device.
+    bIsHeadless = true;
+
+    buffers.Init(allocator, 512, sizeof(NullBuffer));
+    textures.Init(allocator, 512, sizeof(NullTexture));
+    renderpasses.Init(allocator, 256, sizeof(NullRenderPass));
+    pipelines.Init(allocator, 128, sizeof(NullPipeline));
+    shaders.Init(allocator, 128, sizeof(NullShaderState));
+    descriptorSets.Init(allocator, 128, sizeof(NullDescriptorSet));
+    descriptorSetLayouts.Init(allocator, 128, sizeof(NullDescriptorSetLayout));
+    samplers.Init(allocator, 32, sizeof(NullSampler));
+
+    for (u32 i = 0; i < NULL_MAX_FRAMES_IN_FLIGHT; ++i)
+    {
+        for (NullCommandBuffer& cmd : command_buffers[i])
+        {
+            cmd.device = this;
+            cmd.init(64 * 1024, 0, false);
+        }
+
+        for (u32 t = 0; t < MAX_THREADS; ++t)
+        {
+            for (NullCommandBuffer& cmd : secondary_command_buffers[i][t])
+            {
+                cmd.device = this;
+                cmd.init(16 * 1024, 0, false);
+            }
+        }
+    }
+
+    const u16 width  = InDescriptor.width > 0 ? InDescriptor.width : 1;
+    const u16 height = InDescriptor.height > 0 ? InDescriptor.height : 1;
+
+    swapchain_output.Reset();
+    swapchain_output.AddColor(Format::R8G8B8A8_SRGB);
+    swapchain_output.SetDepth(Format::D32_SFLOAT);
+
+    TextureDescriptor backbuffer_descriptor;
+    backbuffer_descriptor.SetSize(width, height, 1)
+      .SetFlags(1, TextureFlagsMask::RENDER_TARGET)
+      .SetFormatType(Format::R8G8B8A8_SRGB, TextureDescriptor::TextureType::TEXTURE_TYPE_2D)
+      .SetName("NullBackbuffer");
+    backbuffer = CreateTexture(backbuffer_descriptor);
+
+    DescriptorSetLayoutDescriptor default_layout_descriptor;
+    default_layout_descriptor.Reset().SetName("NullDefaultLayout");
+    default_layout = CreateDescriptorSetLayout(default_layout_descriptor);
+
+    SamplerDescriptor sampler_descriptor{};
+    sampler_descriptor.SetName("Default Sampler");
+    default_sampler = CreateSampler(sampler_descriptor);
+
+    TextureDescriptor depth_texture_descriptor = {nullptr, width, height, 1, 1, 0, Format::D32_SFLOAT, TextureDescriptor::TextureType::TEXTURE_TYPE_2D, "DepthTexture"};
+    depth_texture                              = CreateTexture(depth_texture_descriptor);
+
+    RenderPassDescriptor swapchain_renderpass_descriptor;
+    swapchain_renderpass_descriptor
+      .SetType(RenderPassType::SWAPCHAIN)
+      .SetName("Swapchain")
+      .SetOperations(RenderPassOperation::CLEAR, RenderPassOperation::CLEAR, RenderPassOperation::CLEAR);
+    swapchain_renderpass = CreateRenderPass(swapchain_renderpass_descriptor);
+
+    dynamic_per_frame_size = NULL_DYNAMIC_BUFFER_PER_FRAME_SIZE;
+
+    BufferDescriptor dynamic_buffer_descriptor;
+    dynamic_buffer_descriptor.reset()
+      .set(BufferUsage::UNIFORM, BufferType::Dynamic, BufferBindingPoint::Uniform, dynamic_per_frame_size * frames_in_flight)
+      .setName("Dynamic_Persistent_Buffer");
+    dynamic_buffer = CreateBuffer(dynamic_buffer_descriptor);
+
+    dynamic_mapped_memory  = GetBufferResource(dynamic_buffer)->data;
+    dynamic_allocated_size = 0;
+
+    // Counted from the first frame, the resources above are not part of it.
+    frame_stats = {};
+
+    STRACE("Finished Initializing null device.\n");
+
+    return true;
+}
+
+void NullDevice::shutdown()
+{
+    // Called again by the destructor.
+    if (allocator == nullptr)
+    {
+        return;
+    }
+
+    STRACE("Shutting down null renderer ...");
+    SINFO("\tDynamic buffer peak usage: %d of %d bytes per frame.", dynamic_max_per_frame_size, dynamic_per_frame_size);
+
+    if (frame_count > 0)
+    {
+        const f64 frames = static_cast<f64>(frame_count);
+        STRACE("\tPer frame over %d frames, average and peak:", frame_count);
+        STRACE("\t\tDraws: %.1f, %d (%.1f, %d instances)", total_stats.draws / frames, peak_stats.draws, total_stats.instances / frames, peak_stats.instances);
+        STRACE("\t\tPass binds: %.1f, %d", total_stats.pass_binds / frames, peak_stats.pass_binds);
+        STRACE("\t\tPipeline binds: %.1f, %d", total_stats.pipeline_binds / frames, peak_stats.pipeline_binds);
+        STRACE("\t\tDescriptor set binds: %.1f, %d", total_stats.descriptor_set_binds / frames, peak_stats.descriptor_set_binds);
+        STRACE("\t\tVertex and index buffer binds: %.1f, %d", total_stats.buffer_binds / frames, peak_stats.buffer_binds);
+        STRACE("\t\tBarriers: %.1f, %d", total_stats.barriers / frames, peak_stats.barriers);
+        STRACE("\t\tUploaded: %.1f, %.1f KB", static_cast<f64>(total_stats.uploaded_bytes) / frames / 1024.0, static_cast<f64>(peak_stats.uploaded_bytes) / 1024.0);
+        STRACE("\t\tRecorded commands: %.1f, %.1f KB", static_cast<f64>(total_stats.command_bytes) / frames / 1024.0, static_cast<f64>(peak_stats.command_bytes) / 1024.0);
+    }
+
+    if (total_stats.validation_errors > 0)
+    {
+        SERROR("\t%d commands failed validation.", total_stats.validation_errors);
+    }
+
+    DestroyTexture(backbuffer);
+    DestroyTexture(depth_texture);
+    DestroyRenderPass(swapchain_renderpass);
+    DestroySampler(default_sampler);
+    DestroyBuffer(dynamic_buffer);
+    DestroyDescriptorSetLayout(default_layout);
+
+    DestroyQueuedResources();
+
+    samplers.Shutdown();
+    descriptorSetLayouts.Shutdown();
+    descriptorSets.Shutdown();
+    shaders.Shutdown();
+    pipelines.Shutdown();
+    renderpasses.Shutdown();
+    textures.Shutdown();
+    buffers.Shutdown();
+
+    allocator = nullptr;
+
+    STRACE("Null renderer has shut down.\n");
+}
+
+BufferHandle NullDevice::CreateBuffer(const BufferDescriptor& InDescriptor)
+{
+    BufferHandle handle = {buffers.ObtainResource()};
+
+    if (handle.index == INVALID_ID)
+    {
+        return handle;
+    }
+
+    NullBuffer* buffer = static_cast<NullBuffer*>(buffers.AccessResource(handle.index));
+    buffer->size       = InDescriptor.size;
+    buffer->usage      = InDescriptor.usage;
+    buffer->data       = static_cast<u8*>(std::malloc(InDescriptor.size > 0 ? InDescriptor.size : 1));
+    buffer->bAlive     = true;
+
+    if (InDescriptor.data)
+    {
+        memcpy(buffer->data, InDescriptor.data, InDescriptor.size);
+        frame_stats.uploaded_bytes += InDescriptor.size;
+    }
+
+    buffer_bytes += InDescriptor.size;
+    return handle;
+}
+
+TextureHandle NullDevice::CreateTexture(const TextureDescriptor& InDescriptor)
+{
+    TextureHandle handle = {textures.ObtainResource()};
+
+    if (handle.index == INVALID_ID)
+    {
+        return handle;
+    }
+
+    // Depth formats have no stride, they are counted as 4 bytes.
+    const u32 stride = HasDepthOrStencil(InDescriptor.format) ? 4u : GetFormatStride(InDescriptor.format);
+
+    NullTexture* texture = static_cast<NullTexture*>(textures.AccessResource(handle.index));
+    texture->width       = InDescriptor.width;
+    texture->height      = InDescriptor.height;
+    texture->format      = InDescriptor.format;
+    texture->size        = static_cast<u64>(InDescriptor.width) * InDescriptor.height * InDescriptor.depth * stride;
+    texture->bAliased    = InDescriptor.alias.index != INVALID_ID && GetTextureResource(InDescriptor.alias) != nullptr;
+    texture->bAlive      = true;
+
+    // Only the first mip is uploaded, the others are generated.
+    if (InDescriptor.data)
+    {
+        frame_stats.uploaded_bytes += texture->size;
+    }
+
+    return handle;
+}
+
+ShaderStateHandle NullDevice::CreateShaderState(const ShaderStateDescriptor& InDescriptor)
+{
+    ShaderStateHandle handle = {shaders.ObtainResource()};
+
+    if (handle.index == INVALID_ID)
+    {
+        return handle;
+    }
+
+    NullShaderState* shader = static_cast<NullShaderState*>(shaders.AccessResource(handle.index));
+    shader->stages_count    = InDescriptor.stages_count;
+    shader->bAlive          = true;
+
+    return handle;
+}
+
+SamplerHandle NullDevice::CreateSampler(const SamplerDescriptor& /*InDescriptor*/)
+{
+    SamplerHandle handle = {samplers.ObtainResource()};
+
+    if (handle.index == INVALID_ID)
+    {
+        return handle;
+    }
+
+    static_cast<NullSampler*>(samplers.AccessResource(handle.index))->bAlive = true;
+    return handle;
+}
+
+DescriptorSetHandle NullDevice::CreateDescriptorSet(const DescriptorSetDescriptor& InDescriptor)
+{
+    if (GetDescriptorSetLayoutResource(InDescriptor.layout) == nullptr)
+    {
+        SERROR("Creating a descriptor set with an invalid layout.");
+        return INVALID_DESCRIPTORSET;
+    }
+
+    DescriptorSetHandle handle = {descriptorSets.ObtainResource()};
+
+    if (handle.index == INVALID_ID)
+    {
+        return handle;
+    }
+
+    NullDescriptorSet* descriptor_set = static_cast<NullDescriptorSet*>(descriptorSets.AccessResource(handle.index));
+    descriptor_set->layout            = InDescriptor.layout;
+    descriptor_set->resources_count   = InDescriptor.resources_count;
+    descriptor_set->bAlive            = true;
+
+    return handle;
+}
+
+DescriptorSetLayoutHandle NullDevice::CreateDescriptorSetLayout(const DescriptorSetLayoutDescriptor& InDescriptor)
+{
+    DescriptorSetLayoutHandle handle = {descriptorSetLayouts.ObtainResource()};
+
+    if (handle.index == INVALID_ID)
+    {
+        return handle;
+    }
+
+    NullDescriptorSetLayout* layout = static_cast<NullDescriptorSetLayout*>(descriptorSetLayouts.AccessResource(handle.index));
+    layout->set_index               = InDescriptor.set_index;
+    layout->bindings_count          = InDescriptor.bindings_count;
+    layout->bAlive                  = true;
+
+    return handle;
+}
+
+TransientDescriptorSet NullDevice::CreateTransientDescriptorSet(const DescriptorSetDescriptor& InDescriptor)
+{
+    TransientDescriptorSet set;
+
+    const NullDescriptorSetLayout* layout = GetDescriptorSetLayoutResource(InDescriptor.layout);
+    if (layout == nullptr)
+    {
+        SERROR("Creating a transient descriptor set with an invalid layout.");
+        return set;
+    }
+
+    set.set       = ++transient_set_count;
+    set.set_index = layout->set_index;
+    return set;
+}
+
+PipelineHandle NullDevice::CreatePipeline(const PipelineDescriptor& InDescriptor)
+{
+    PipelineHandle handle = {pipelines.ObtainResource()};
+
+    if (handle.index == INVALID_ID)
+    {
+        return handle;
+    }
+
+    NullPipeline* pipeline        = static_cast<NullPipeline*>(pipelines.AccessResource(handle.index));
+    pipeline->shader_state        = CreateShaderState(InDescriptor.shaders);
+    pipeline->color_formats_count = InDescriptor.render_pass.ColorFormatCounts;
+    pipeline->bAlive              = true;
+
+    // Without reflection the pipelines relying on it get a single empty set.
+    if (InDescriptor.active_layouts_count == 0)
+    {
+        pipeline->descriptor_set_layouts[0] = default_layout;
+        pipeline->active_layouts_count      = 1;
+    }
+    else
+    {
+        for (u32 i = 0; i < InDescriptor.active_layouts_count; ++i)
+        {
+            pipeline->descriptor_set_layouts[i] = InDescriptor.descriptor_set_layout[i];
+        }
+        pipeline->active_layouts_count = InDescriptor.active_layouts_count;
+    }
+
+    return handle;
+}
+
+RenderPassHandle NullDevice::CreateRenderPass(const RenderPassDescriptor& InDescriptor)
+{
+    RenderPassHandle handle = {renderpasses.ObtainResource()};
+
+    if (handle.index == INVALID_ID)
+    {
+        return handle;
+    }
+
+    NullRenderPass* render_pass       = static_cast<NullRenderPass*>(renderpasses.AccessResource(handle.index));
+    render_pass->type                 = InDescriptor.Type;
+    render_pass->render_targets_count = InDescriptor.Type == RenderPassType::SWAPCHAIN ? swapchain_output.ColorFormatCounts : InDescriptor.RenderTargetsCount;
+    render_pass->bAlive               = true;
+
+    for (u32 i = 0; i < InDescriptor.RenderTargetsCount; ++i)
+    {
+        if (GetTextureResource(InDescriptor.OutputTextures[i]) == nullptr)
+        {
+            SERROR("Render pass %s has an invalid render target.", InDescriptor.Name.c_str());
+        }
+    }
+
+    return handle;
+}
+
+PipelineHandle NullDevice::CreatePipelineAsync(const PipelineDescriptor& InDescriptor)
+{
+    // Nothing to compile, the pipeline is ready right away.
+    return CreatePipeline(InDescriptor);
+}
+
+bool NullDevice::IsPipelineReady(PipelineHandle InHandle)
+{
+    return GetPipelineResource(InHandle) != nullptr;
+}
+
+bool NullDevice::IsPipelineFailed(PipelineHandle /*InHandle*/)
+{
+    return false;
+}
+
+bool NullDevice::CompileShaders(const ShaderStateDescriptor& /*InDescriptor*/)
+{
+    return true;
+}
+
+DescriptorSetLayoutHandle NullDevice::GetDescriptorSetLayout(PipelineHandle InHandle, u32 InSetIndex)
+{
+    const NullPipeline* pipeline = GetPipelineResource(InHandle);
+    if (pipeline == nullptr || InSetIndex >= pipeline->active_layouts_count)
+    {
+        return INVALID_DESCRIPTORSETLAYOUT;
+    }
+
+    return pipeline->descriptor_set_layouts[InSetIndex];
+}
+
+u32 NullDevice::GetBindlessIndex(TextureHandle /*InHandle*/)
+{
+    // Bindless is not supported, resources go through descriptor sets.
+    return INVALID_ID;
+}
+
+u32 NullDevice::GetBindlessIndex(BufferHandle /*InHandle*/)
+{
+    return INVALID_ID;
+}
+
+TextureMemoryInfo NullDevice::GetTextureMemoryInfo(TextureHandle InHandle)
+{
+    TextureMemoryInfo info;
+
+    const NullTexture* texture = GetTextureResource(InHandle);
+    if (texture)
+    {
+        info.size    = texture->size;
+        info.aliased = texture->bAliased;
+    }
+
+    return info;
+}
+
+bool NullDevice::ReadbackTexture(TextureHandle /*InHandle*/, TextureReadback& /*OutReadback*/)
+{
+    SERROR("The null device renders nothing, textures can't be read back.");
+    return false;
+}
+
+void NullDevice::DestroyBuffer(BufferHandle InHandle)
+{
+    if (InHandle.index < buffers.pool_size)
+    {
+        resource_deletion_queue.push_back({ResourceType::BUFFER, InHandle.index, frame_count});
+    }
+    else
+    {
+        SERROR("Trying to delete an invalid buffer.");
+    }
+}
+
+void NullDevice::DestroyTexture(TextureHandle InHandle)
+{
+    if (InHandle.index < textures.pool_size)
+    {
+        resource_deletion_queue.push_back({ResourceType::TEXTURE, InHandle.index, frame_count});
+    }
+    else
+    {
+        SERROR("Trying to delete an invalid texture.");
+    }
+}
+
+void NullDevice::DestroyShaderState(ShaderStateHandle InHandle)
+{
+    if (InHandle.index < shaders.pool_size)
+    {
+        resource_deletion_queue.push_back({ResourceType::SHADER, InHandle.index, frame_count});
+    }
+    else
+    {
+        SERROR("Trying to delete an invalid shader.");
+    }
+}
+
+void NullDevice::DestroySampler(SamplerHandle InHandle)
+{
+    if (InHandle.index < samplers.pool_size)
+    {
+        resource_deletion_queue.push_back({ResourceType::SAMPLER, InHandle.index, frame_count});
+    }
+    else
+    {
+        SERROR("Trying to delete an invalid sampler.");
+    }
+}
+
+void NullDevice::DestroyDescriptorSet(DescriptorSetHandle InHandle)
+{
+    if (InHandle.index < descriptorSets.pool_size)
+    {
+        resource_deletion_queue.push_back({ResourceType::DESCRIPTOR_SET, InHandle.index, frame_count});
+    }
+    else
+    {
+        SERROR("Trying to delete an invalid descriptor set.");
+    }
+}
+
+void NullDevice::DestroyDescriptorSetLayout(DescriptorSetLayoutHandle InHandle)
+{
+    if (InHandle.index < descriptorSetLayouts.pool_size)
+    {
+        resource_deletion_queue.push_back({ResourceType::DESCRIPTOR_SET_LAYOUT, InHandle.index, frame_count});
+    }
+    else
+    {
+        SERROR("Trying to delete an invalid descriptor set layout.");
+    }
+}
+
+void NullDevice::DestroyPipeline(PipelineHandle InHandle)
+{
+    if (InHandle.index < pipelines.pool_size)
+    {
+        resource_deletion_queue.push_back({ResourceType::PIPELINE, InHandle.index, frame_count});
+
+        if (const NullPipeline* pipeline = GetPipelineResource(InHandle))
+        {
+            DestroyShaderState(pipeline->shader_state);
+        }
+    }
+    else
+    {
+        SERROR("Trying to delete an invalid pipeline.");
+    }
+}
+
+void NullDevice::DestroyRenderPass(RenderPassHandle InHandle)
+{
+    if (InHandle.index < renderpasses.pool_size)
+    {
+        resource_deletion_queue.push_back({ResourceType::RENDERPASS, InHandle.index, frame_count});
+    }
+    else
+    {
+        SERROR("Trying to delete an invalid renderpass.");
+    }
+}
+
+void NullDevice::BeginFrame()
+{
+    SPROFILE_FUNCTION();
+
+    const u32 frame_index = GetFrameIndex();
+
+    for (NullCommandBuffer& cmd : command_buffers[frame_index])
+    {
+        cmd.reset();
+    }
+    next_command_buffer = 0;
+
+    for (u32 t = 0; t < MAX_THREADS; ++t)
+    {
+        next_secondary_command_buffer[t] = 0;
+    }
+
+    // Same partitioning of the ring as a real device, the partition written is measured before starting over.
+    dynamic_max_per_frame_size = std::max(dynamic_max_per_frame_size, dynamic_allocated_size - dynamic_frame_start);
+    dynamic_frame_start        = dynamic_per_frame_size * frame_index;
+    dynamic_allocated_size     = dynamic_frame_start;
+}
+
+void NullDevice::Present()
+{
+    SPROFILE_FUNCTION();
+
+    for (CommandBuffer* cmd : queued_command_buffers)
+    {
+        NullCommandBuffer* null_cmd = static_cast<NullCommandBuffer*>(cmd);
+        null_cmd->finish();
+        frame_stats.Add(null_cmd->stats);
+    }
+    queued_command_buffers.clear();
+
+    last_frame_stats = frame_stats;
+    total_stats.Add(frame_stats);
+    peak_stats.Max(frame_stats);
+    frame_stats = {};
+
+    ++frame_count;
+
+    // Nothing runs after the frame is submitted, queued resources are released right away.
+    DestroyQueuedResources();
+}
+
+void* NullDevice::MapBuffer(const BufferHandle& InHandle, u32 size, u32 offset)
+{
+    NullBuffer* buffer = GetBufferResource(InHandle);
+    if (buffer == nullptr)
+    {
+        SERROR("Mapping an invalid buffer.");
+        return nullptr;
+    }
+
+    SASSERT(offset + size <= buffer->size);
+
+    // Written by the caller.
+    frame_stats.uploaded_bytes += size;
+    return buffer->data + offset;
+}
+
+void NullDevice::UnmapBuffer(const BufferHandle& /*InHandle*/)
+{
+}
+
+DynamicAllocation NullDevice::AllocateDynamic(u32 size)
+{
+    DynamicAllocation allocation;
+
+    const u32 aligned_size = (size + dynamic_alignment - 1) & ~(dynamic_alignment - 1);
+    const u32 frame_end    = dynamic_per_frame_size * (GetFrameIndex() + 1);
+    if (dynamic_allocated_size + aligned_size > frame_end)
+    {
+        SERROR("Dynamic buffer out of memory, %d bytes requested.", size);
+        return allocation;
+    }
+
+    allocation.data   = dynamic_mapped_memory + dynamic_allocated_size;
+    allocation.offset = dynamic_allocated_size;
+    dynamic_allocated_size += aligned_size;
+
+    frame_stats.uploaded_bytes += size;
+    return allocation;
+}
+
+BufferHandle NullDevice::GetDynamicBuffer() const
+{
+    return dynamic_buffer;
+}
+
+std::vector<i8> NullDevice::ReadShaderBinary(std::string /*InFilename*/)
+{
+    return {};
+}
+
+char* NullDevice::ReadShader(std::string /*InFilename*/, u32& OutSize)
+{
+    OutSize = 0;
+    return nullptr;
+}
+
+CommandBuffer* NullDevice::GetCommandBuffer(bool begin)
+{
+    SASSERT_MSG(next_command_buffer < BUFFERS_PER_FRAME, "No more command buffers left this frame.");
+
+    NullCommandBuffer* cmd = &command_buffers[GetFrameIndex()][next_command_buffer++];
+    cmd->reset();
+    cmd->bSecondary = false;
+    cmd->bRecording = begin;
+    return cmd;
+}
+
+CommandBuffer* NullDevice::GetInstantCommandBuffer()
+{
+    return GetCommandBuffer(true);
+}
+
+void NullDevice::QueueCommandBuffer(CommandBuffer* cmd)
+{
+    queued_command_buffers.push_back(cmd);
+}
+
+CommandBuffer* NullDevice::GetSecondaryCommandBuffer(u32 thread_index, CommandBuffer* primary)
+{
+    if (thread_index >= MAX_THREADS || next_secondary_command_buffer[thread_index] >= SECONDARY_BUFFERS_PER_THREAD)
+    {
+        return nullptr;
+    }
+
+    NullCommandBuffer* secondary = &secondary_command_buffers[GetFrameIndex()][thread_index][next_secondary_command_buffer[thread_index]++];
+    secondary->begin_secondary(static_cast<NullCommandBuffer*>(primary));
+    return secondary;
+}
+
+u32 NullDevice::GetMaxRecordingThreads() const
+{
+    return MAX_THREADS;
+}
+
+GraphicsAPI NullDevice::getApiType() const
+{
+    return api_type;
+}
+
+u32 NullDevice::GetFrameIndex() const
+{
+    return frame_count % frames_in_flight;
+}
+
+u32 NullDevice::GetFramesInFlight() const
+{
+    return frames_in_flight;
+}
+
+f32 NullDevice::GetFrameWaitMs() const
+{
+    // Never waits for a gpu.
+    return 0.0f;
+}
+
+GPUMemoryStats NullDevice::GetMemoryStats() const
+{
+    GPUMemoryStats stats;
+    stats.reserved_bytes     = buffer_bytes;
+    stats.used_bytes         = buffer_bytes;
+    stats.host_visible_bytes = buffer_bytes;
+    stats.allocation_count   = buffers.used_indices;
+    return stats;
+}
+
+u32 NullDevice::Defragment(u32 /*InMaxMoves*/)
+{
+    // Buffers are plain host allocations, there are no blocks to empty.
+    return 0;
+}
+
+const std::vector<GPUZoneTiming>& NullDevice::GetGpuTimings() const
+{
+    return gpu_timings;
+}
+
+RenderPassHandle NullDevice::GetSwapchainRenderpass()
+{
+    return swapchain_renderpass;
+}
+
+const RenderPassOutput& NullDevice::GetSwapchainOutput() const
+{
+    return swapchain_output;
+}
+
+TextureHandle NullDevice::GetBackbufferTexture() const
+{
+    return backbuffer;
+}
+
+void NullDevice::CreateSwapchain(GLFWwindow* /*window*/)
+{
+    // Never presents, the backbuffer is a texture created at Init.
+}
+
+NullBuffer* NullDevice::GetBufferResource(BufferHandle InHandle)
+{
+    if (InHandle.index >= buffers.pool_size)
+    {
+        return nullptr;
+    }
+
+    NullBuffer* buffer = static_cast<NullBuffer*>(buffers.AccessResource(InHandle.index));
+    return buffer->bAlive ? buffer : nullptr;
+}
+
+NullTexture* NullDevice::GetTextureResource(TextureHandle InHandle)
+{
+    if (InHandle.index >= textures.pool_size)
+    {
+        return nullptr;
+    }
+
+    NullTexture* texture = static_cast<NullTexture*>(textures.AccessResource(InHandle.index));
+    return texture->bAlive ? texture : nullptr;
+}
+
+NullDescriptorSet* NullDevice::GetDescriptorSetResource(DescriptorSetHandle InHandle)
+{
+    if (InHandle.index >= descriptorSets.pool_size)
+    {
+        return nullptr;
+    }
+
+    NullDescriptorSet* descriptor_set = static_cast<NullDescriptorSet*>(descriptorSets.AccessResource(InHandle.index));
+    return descriptor_set->bAlive ? descriptor_set : nullptr;
+}
+
+NullDescriptorSetLayout* NullDevice::GetDescriptorSetLayoutResource(DescriptorSetLayoutHandle InHandle)
+{
+    if (InHandle.index >= descriptorSetLayouts.pool_size)
+    {
+        return nullptr;
+    }
+
+    NullDescriptorSetLayout* layout = static_cast<NullDescriptorSetLayout*>(descriptorSetLayouts.AccessResource(InHandle.index));
+    return layout->bAlive ? layout : nullptr;
+}
+
+NullPipeline* NullDevice::GetPipelineResource(PipelineHandle InHandle)
+{
+    if (InHandle.index >= pipelines.pool_size)
+    {
+        return nullptr;
+    }
+
+    NullPipeline* pipeline = static_cast<NullPipeline*>(pipelines.AccessResource(InHandle.index));
+    return pipeline->bAlive ? pipeline : nullptr;
+}
+
+NullRenderPass* NullDevice::GetRenderPassResource(RenderPassHandle InHandle)
+{
+    if (InHandle.index >= renderpasses.pool_size)
+    {
+        return nullptr;
+    }
+
+    NullRenderPass* render_pass = static_cast<NullRenderPass*>(renderpasses.AccessResource(InHandle.index));
+    return render_pass->bAlive ? render_pass : nullptr;
+}
+
+void NullDevice::DestroyBufferInstant(ResourceHandle InHandle)
+{
+    NullBuffer* buffer = static_cast<NullBuffer*>(buffers.AccessResource(InHandle));
+
+    if (buffer && buffer->bAlive)
+    {
+        buffer_bytes -= buffer->size;
+        std::free(buffer->data);
+        buffer->data   = nullptr;
+        buffer->bAlive = false;
+    }
+
+    buffers.ReleaseResource(InHandle);
+}
+
+void NullDevice::DestroyTextureInstant(ResourceHandle InHandle)
+{
+    NullTexture* texture = static_cast<NullTexture*>(textures.AccessResource(InHandle));
+
+    if (texture)
+    {
+        texture->bAlive = false;
+    }
+
+    textures.ReleaseResource(InHandle);
+}
+
+void NullDevice::DestroyShaderStateInstant(ResourceHandle InHandle)
+{
+    NullShaderState* shader = static_cast<NullShaderState*>(shaders.AccessResource(InHandle));
+
+    if (shader)
+    {
+        shader->bAlive = false;
+    }
+
+    shaders.ReleaseResource(InHandle);
+}
+
+void NullDevice::DestroySamplerInstant(ResourceHandle InHandle)
+{
+    NullSampler* sampler = static_cast<NullSampler*>(samplers.AccessResource(InHandle));
+
+    if (sampler)
+    {
+        sampler->bAlive = false;
+    }
+
+    samplers.ReleaseResource(InHandle);
+}
+
+void NullDevice::DestroyDescriptorSetInstant(ResourceHandle InHandle)
+{
+    NullDescriptorSet* descriptor_set = static_cast<NullDescriptorSet*>(descriptorSets.AccessResource(InHandle));
+
+    if (descriptor_set)
+    {
+        descriptor_set->bAlive = false;
+    }
+
+    descriptorSets.ReleaseResource(InHandle);
+}
+
+void NullDevice::DestroyDescriptorSetLayoutInstant(ResourceHandle InHandle)
+{
+    NullDescriptorSetLayout* layout = static_cast<NullDescriptorSetLayout*>(descriptorSetLayouts.AccessResource(InHandle));
+
+    if (layout)
+    {
+        layout->bAlive = false;
+    }
+
+    descriptorSetLayouts.ReleaseResource(InHandle);
+}
+
+void NullDevice::DestroyPipelineInstant(ResourceHandle InHandle)
+{
+    NullPipeline* pipeline = static_cast<NullPipeline*>(pipelines.AccessResource(InHandle));
+
+    if (pipeline)
+    {
+        pipeline->bAlive = false;
+    }
+
+    pipelines.ReleaseResource(InHandle);
+}
+
+void NullDevice::DestroyRenderPassInstant(ResourceHandle InHandle)
+{
+    NullRenderPass* render_pass = static_cast<NullRenderPass*>(renderpasses.AccessResource(InHandle));
+
+    if (render_pass)
+    {
+        render_pass->bAlive = false;
+    }
+
+    renderpasses.ReleaseResource(InHandle);
+}
+
+void NullDevice::DestroyQueuedResources()
+{
+    for (const ResourceUpdate& resource : resource_deletion_queue)
+    {
+        switch (resource.type)
+        {
+            case ResourceType::BUFFER:
+                DestroyBufferInstant(resource.handle);
+                break;
+            case ResourceType::TEXTURE:
+                DestroyTextureInstant(resource.handle);
+                break;
+            case ResourceType::SHADER:
+                DestroyShaderStateInstant(resource.handle);
+                break;
+            case ResourceType::SAMPLER:
+                DestroySamplerInstant(resource.handle);
+                break;
+            case ResourceType::DESCRIPTOR_SET:
+                DestroyDescriptorSetInstant(resource.handle);
+                break;
+            case ResourceType::DESCRIPTOR_SET_LAYOUT:
+                DestroyDescriptorSetLayoutInstant(resource.handle);
+                break;
+            case ResourceType::PIPELINE:
+                DestroyPipelineInstant(resource.handle);
+                break;
+            case ResourceType::RENDERPASS:
+                DestroyRenderPassInstant(resource.handle);
+                break;
+            default:
+                break;
+        }
+    }
+
+    resource_deletion_queue.clear();
+}
+
+} // namespace Null
+} // namespace Renderer
+} // namespace Sogas
@@ -1,4 +1,5 @@
 #include "render_device.h"
+#include "null/null_device.h"
 #include "public/sgs_memory.h"
 #include "vulkan/vulkan_device.h"
 
@@ -21,6 +22,46 @@ DeviceDescriptor& DeviceDescriptor::SetAllocator(Memory::Allocator* InAllocator)
     return *this;
 }
 
+DeviceDescriptor& DeviceDescriptor::SetFramesInFlight(u8 InFramesInFlight)
+{
+    frames_in_flight = InFramesInFlight;
+    return *this;
+}
+
+DeviceDescriptor& DeviceDescriptor::SetPipelineCachePath(const char* InPath)
+{
+    pipeline_cache_path = InPath;
+    return *this;
+}
+
+DeviceDescriptor& DeviceDescriptor::SetShaderCachePath(const char* InPath)
+{
+    shader_cache_path = InPath;
+    return *this;
+}
+
+DeviceDescriptor& DeviceDescriptor::SetDynamicRendering(bool bEnabled)
+{
+    dynamic_rendering = bEnabled;
+    return *this;
+}
+
+DeviceDescriptor& DeviceDescriptor::SetHeadless(u16 InWidth, u16 InHeight)
+{
+    headless = true;
+    window   = nullptr;
+    width    = InWidth;
+    height   = InHeight;
+    return *this;
+}
+
+DeviceDescriptor& DeviceDescriptor::SetGpuProfiling(bool bTimestamps, bool bPipelineStatistics)
+{
+    gpu_timestamps      = bTimestamps;
+    pipeline_statistics = bPipelineStatistics;
+    return *this;
+}
+
 std::shared_ptr<GPU_device>
 createVulkanDevice(std::vector<const char*> glfwExtensions)
 {
@@ -32,6 +73,11 @@ std::shared_ptr<GPU_device> createOpenGLDevice(void* /*device*/)
     return nullptr;
 }
 
+std::shared_ptr<GPU_device> createNullDevice()
+{
+    return std::make_shared<Null::NullDevice>(GraphicsAPI::Null);
+}
+
 std::shared_ptr<GPU_device> GPU_device::create(GraphicsAPI api, std::vector<const char*> extensions)
 {
     switch (api)
@@ -45,6 +91,9 @@ std::shared_ptr<GPU_device> GPU_device::create(GraphicsAPI api, std::vector<cons
         case GraphicsAPI::OpenGL:
             return createOpenGLDevice(nullptr);
             break;
+        case GraphicsAPI::Null:
+            return createNullDevice();
+            break;
         default:
             SFATAL("No valid api provided.");
             return nullptr;
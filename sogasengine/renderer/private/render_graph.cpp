@@ -0,0 +1,587 @@
+#include "render_graph.h"
+
+namespace Sogas
+{
+namespace Renderer
+{
+
+static bool IsWriteState(ResourceState InState)
+{
+    return InState == ResourceState::RENDER_TARGET || InState == ResourceState::DEPTH_WRITE || InState == ResourceState::STORAGE;
+}
+
+RenderGraphPassDescriptor& RenderGraphPassDescriptor::Reset()
+{
+    InputsCount         = 0;
+    RenderTargetsCount  = 0;
+    DepthStencilTexture = {};
+    Execute             = nullptr;
+    return *this;
+}
+
+RenderGraphPassDescriptor& RenderGraphPassDescriptor::SetName(std::string InName)
+{
+    Name = InName;
+    return *this;
+}
+
+RenderGraphPassDescriptor& RenderGraphPassDescriptor::SetType(RenderPassType InType)
+{
+    Type = InType;
+    return *this;
+}
+
+RenderGraphPassDescriptor& RenderGraphPassDescriptor::AddInput(RenderGraphResource InResource, ResourceState InState)
+{
+    SASSERT(InputsCount < MAX_PASS_INPUTS);
+    InputTextures[InputsCount++] = {InResource, InState};
+    return *this;
+}
+
+RenderGraphPassDescriptor& RenderGraphPassDescriptor::AddRenderTexture(RenderGraphResource InResource)
+{
+    SASSERT(RenderTargetsCount < MAX_IMAGE_OUTPUTS);
+    OutputTextures[RenderTargetsCount++] = InResource;
+    return *this;
+}
+
+RenderGraphPassDescriptor& RenderGraphPassDescriptor::SetDepthStencilTexture(RenderGraphResource InResource)
+{
+    DepthStencilTexture = InResource;
+    return *this;
+}
+
+RenderGraphPassDescriptor& RenderGraphPassDescriptor::SetOperations(RenderPassOperation InColor, RenderPassOperation InDepth)
+{
+    ColorOperation = InColor;
+    DepthOperation = InDepth;
+    return *this;
+}
+
+RenderGraphPassDescriptor& RenderGraphPassDescriptor::SetExecute(RenderGraphExecute InExecute)
+{
+    Execute = std::move(InExecute);
+    return *this;
+}
+
+void RenderGraph::Init(GPU_device* InDevice)
+{
+    SASSERT(InDevice != nullptr);
+    device = InDevice;
+}
+
+void RenderGraph::Shutdown()
+{
+    ReleaseResources();
+    Reset();
+    device = nullptr;
+}
+
+void RenderGraph::Reset()
+{
+    textures.clear();
+    passes.clear();
+    final_barriers.clear();
+    stats = {};
+}
+
+RenderGraphResource RenderGraph::CreateTexture(const TextureDescriptor& InDescriptor)
+{
+    Texture texture;
+    texture.descriptor = InDescriptor;
+    texture.descriptor.flags = static_cast<u8>(texture.descriptor.flags | TextureFlagsMask::TRANSIENT);
+
+    textures.push_back(texture);
+    return {static_cast<u32>(textures.size() - 1)};
+}
+
+RenderGraphResource RenderGraph::ImportTexture(TextureHandle InHandle, Format InFormat, ResourceState InState)
+{
+    Texture texture;
+    texture.descriptor.format = InFormat;
+    texture.handle            = InHandle;
+    texture.initial_state     = InState;
+    texture.bImported         = true;
+
+    textures.push_back(texture);
+    return {static_cast<u32>(textures.size() - 1)};
+}
+
+RenderGraphPass RenderGraph::AddPass(const RenderGraphPassDescriptor& InDescriptor)
+{
+    Pass pass;
+    pass.descriptor = InDescriptor;
+
+    passes.push_back(pass);
+    return {static_cast<u32>(passes.size() - 1)};
+}
+
+bool RenderGraph::Compile()
+{
+    SASSERT(device != nullptr);
+
+    ReleaseResources();
+
+    stats              = {};
+    stats.passes_count = static_cast<u32>(passes.size());
+
+    // Each read depends on the last pass declared before that wrote the texture.
+    std::vector<u32> last_writer(textures.size(), INVALID_ID);
+    for (u32 i = 0; i < passes.size(); ++i)
+    {
+        Pass&                            pass       = passes[i];
+        const RenderGraphPassDescriptor& descriptor = pass.descriptor;
+
+        pass.dependencies.clear();
+        pass.barriers.clear();
+        pass.render_pass = INVALID_RENDERPASS;
+        pass.bCulled     = false;
+
+        if (descriptor.Type == RenderPassType::GEOMETRY && descriptor.RenderTargetsCount == 0 && descriptor.DepthStencilTexture.index == INVALID_ID)
+        {
+            SERROR("Render graph pass %s has no attachment.", descriptor.Name.c_str());
+            return false;
+        }
+
+        for (u32 j = 0; j < descriptor.InputsCount; ++j)
+        {
+            const u32 index = descriptor.InputTextures[j].Resource.index;
+            if (last_writer[index] == INVALID_ID && !textures[index].bImported)
+            {
+                SERROR("Render graph pass %s reads %s before any pass writes it.", descriptor.Name.c_str(), textures[index].descriptor.name.c_str());
+                return false;
+            }
+
+            if (last_writer[index] != INVALID_ID)
+            {
+                pass.dependencies.push_back(last_writer[index]);
+            }
+        }
+
+        auto write = [&](RenderGraphResource InResource, RenderPassOperation InOperation)
+        {
+            if (InOperation == RenderPassOperation::LOAD && last_writer[InResource.index] != INVALID_ID)
+            {
+                pass.dependencies.push_back(last_writer[InResource.index]);
+            }
+            last_writer[InResource.index] = i;
+        };
+
+        for (u32 j = 0; j < descriptor.RenderTargetsCount; ++j)
+        {
+            write(descriptor.OutputTextures[j], descriptor.ColorOperation);
+        }
+
+        if (descriptor.DepthStencilTexture.index != INVALID_ID)
+        {
+            write(descriptor.DepthStencilTexture, descriptor.DepthOperation);
+        }
+    }
+
+    CullPasses();
+    AllocateTextures();
+
+    for (Pass& pass : passes)
+    {
+        if (pass.bCulled)
+        {
+            continue;
+        }
+
+        const RenderGraphPassDescriptor& descriptor = pass.descriptor;
+        if (descriptor.Type == RenderPassType::SWAPCHAIN)
+        {
+            pass.render_pass = device->GetSwapchainRenderpass();
+            continue;
+        }
+
+        RenderPassDescriptor render_pass_descriptor;
+        render_pass_descriptor.Reset().SetName(descriptor.Name).SetType(descriptor.Type);
+        render_pass_descriptor.SetOperations(descriptor.ColorOperation, descriptor.DepthOperation, RenderPassOperation::DONTCARE);
+
+        for (u32 i = 0; i < descriptor.RenderTargetsCount; ++i)
+        {
+            render_pass_descriptor.AddRenderTexture(textures[descriptor.OutputTextures[i].index].handle);
+        }
+
+        if (descriptor.DepthStencilTexture.index != INVALID_ID)
+        {
+            render_pass_descriptor.SetDepthStencilTexture(textures[descriptor.DepthStencilTexture.index].handle);
+        }
+
+        pass.render_pass = device->CreateRenderPass(render_pass_descriptor);
+        created_passes.push_back(pass.render_pass);
+    }
+
+    PlanBarriers();
+
+    STRACE("Render graph: %d passes, %d culled, %d barriers. %d transient textures, %d aliased, %.2f MB in %.2f MB.", stats.passes_count,
+           stats.culled_passes_count, stats.barriers_count, stats.textures_count, stats.aliased_textures_count,
+           static_cast<f64>(stats.transient_bytes) / (1024.0 * 1024.0), static_cast<f64>(stats.allocated_bytes) / (1024.0 * 1024.0));
+
+    return true;
+}
+
+void RenderGraph::CullPasses()
+{
+    // Roots are the passes with effects outside the graph: presenting, writing imported textures, or declaring no
+    // outputs at all, their effects are unknown.
+    std::vector<u32> stack;
+    std::vector<u8>  used(passes.size(), 0);
+    for (u32 i = 0; i < passes.size(); ++i)
+    {
+        const RenderGraphPassDescriptor& descriptor = passes[i].descriptor;
+
+        bool bRoot = descriptor.Type == RenderPassType::SWAPCHAIN || (descriptor.RenderTargetsCount == 0 && descriptor.DepthStencilTexture.index == INVALID_ID);
+        for (u32 j = 0; j < descriptor.RenderTargetsCount; ++j)
+        {
+            bRoot |= textures[descriptor.OutputTextures[j].index].bImported;
+        }
+        if (descriptor.DepthStencilTexture.index != INVALID_ID)
+        {
+            bRoot |= textures[descriptor.DepthStencilTexture.index].bImported;
+        }
+
+        if (bRoot)
+        {
+            used[i] = 1;
+            stack.push_back(i);
+        }
+    }
+
+    while (!stack.empty())
+    {
+        const u32 index = stack.back();
+        stack.pop_back();
+
+        for (u32 dependency : passes[index].dependencies)
+        {
+            if (!used[dependency])
+            {
+                used[dependency] = 1;
+                stack.push_back(dependency);
+            }
+        }
+    }
+
+    for (u32 i = 0; i < passes.size(); ++i)
+    {
+        passes[i].bCulled = !used[i];
+        stats.culled_passes_count += passes[i].bCulled ? 1 : 0;
+    }
+}
+
+void RenderGraph::AllocateTextures()
+{
+    for (Texture& texture : textures)
+    {
+        texture.first_pass = INVALID_ID;
+        texture.last_pass  = INVALID_ID;
+        texture.last_state = ResourceState::UNDEFINED;
+        texture.previous   = INVALID_ID;
+        if (!texture.bImported)
+        {
+            texture.handle = INVALID_TEXTURE;
+        }
+    }
+
+    // Lifetimes over the passes left, textures only used by culled passes are not created.
+    for (u32 i = 0; i < passes.size(); ++i)
+    {
+        if (passes[i].bCulled)
+        {
+            continue;
+        }
+
+        auto use = [&](RenderGraphResource InResource, ResourceState InState)
+        {
+            Texture& texture = textures[InResource.index];
+            if (texture.first_pass == INVALID_ID)
+            {
+                texture.first_pass = i;
+            }
+            texture.last_pass  = i;
+            texture.last_state = InState;
+
+            if (InState == ResourceState::STORAGE)
+            {
+                texture.descriptor.flags = static_cast<u8>(texture.descriptor.flags | TextureFlagsMask::COMPUTE);
+            }
+        };
+
+        const RenderGraphPassDescriptor& descriptor = passes[i].descriptor;
+        for (u32 j = 0; j < descriptor.InputsCount; ++j)
+        {
+            use(descriptor.InputTextures[j].Resource, descriptor.InputTextures[j].State);
+        }
+        for (u32 j = 0; j < descriptor.RenderTargetsCount; ++j)
+        {
+            use(descriptor.OutputTextures[j], ResourceState::RENDER_TARGET);
+        }
+        if (descriptor.DepthStencilTexture.index != INVALID_ID)
+        {
+            use(descriptor.DepthStencilTexture, ResourceState::DEPTH_WRITE);
+        }
+    }
+
+    // Memory given back by the textures whose lifetime ended, with the last texture that used it.
+    struct Region
+    {
+        u32 owner;
+        u32 occupant;
+        u64 size;
+    };
+    std::vector<Region> busy;
+    std::vector<Region> available;
+    std::vector<u32>    last_occupant(textures.size(), INVALID_ID);
+
+    for (u32 i = 0; i < passes.size(); ++i)
+    {
+        if (passes[i].bCulled)
+        {
+            continue;
+        }
+
+        for (size_t j = 0; j < busy.size();)
+        {
+            if (textures[busy[j].occupant].last_pass < i)
+            {
+                available.push_back(busy[j]);
+                busy[j] = busy.back();
+                busy.pop_back();
+            }
+            else
+            {
+                ++j;
+            }
+        }
+
+        for (u32 j = 0; j < textures.size(); ++j)
+        {
+            Texture& texture = textures[j];
+            if (texture.bImported || texture.first_pass != i)
+            {
+                continue;
+            }
+
+            // The biggest free range is tried, the device keeps the texture on its own memory when it doesn't fit.
+            auto candidate = std::max_element(available.begin(), available.end(), [](const Region& a, const Region& b) { return a.size < b.size; });
+
+            TextureDescriptor descriptor = texture.descriptor;
+            descriptor.alias             = candidate != available.end() ? textures[candidate->owner].handle : INVALID_TEXTURE;
+
+            texture.handle = device->CreateTexture(descriptor);
+            if (texture.handle.index == INVALID_ID)
+            {
+                SERROR("Render graph could not create texture %s.", descriptor.name.c_str());
+                continue;
+            }
+            created_textures.push_back(texture.handle);
+
+            const TextureMemoryInfo memory = device->GetTextureMemoryInfo(texture.handle);
+            stats.transient_bytes += memory.size;
+            ++stats.textures_count;
+
+            if (memory.aliased)
+            {
+                texture.previous = candidate->occupant;
+                busy.push_back({candidate->owner, j, candidate->size});
+                available.erase(candidate);
+                ++stats.aliased_textures_count;
+            }
+            else
+            {
+                busy.push_back({j, j, memory.size});
+                stats.allocated_bytes += memory.size;
+            }
+        }
+    }
+
+    // The first texture of each range waits for the last one, it used the memory in the previous frame.
+    for (const std::vector<Region>* regions : {&busy, &available})
+    {
+        for (const Region& region : *regions)
+        {
+            last_occupant[region.owner] = region.occupant;
+        }
+    }
+
+    for (u32 i = 0; i < textures.size(); ++i)
+    {
+        if (last_occupant[i] != INVALID_ID)
+        {
+            textures[i].previous = last_occupant[i];
+        }
+    }
+}
+
+void RenderGraph::PlanBarriers()
+{
+    std::vector<ResourceState> states(textures.size(), ResourceState::UNDEFINED);
+    std::vector<u8>            written(textures.size(), 0);
+    for (u32 i = 0; i < textures.size(); ++i)
+    {
+        states[i] = textures[i].initial_state;
+    }
+
+    for (u32 i = 0; i < passes.size(); ++i)
+    {
+        Pass& pass = passes[i];
+        if (pass.bCulled)
+        {
+            continue;
+        }
+
+        auto transition = [&](RenderGraphResource InResource, ResourceState InState)
+        {
+            const Texture& texture = textures[InResource.index];
+            if (texture.handle.index == INVALID_ID)
+            {
+                return;
+            }
+
+            ResourceState& state = states[InResource.index];
+            if (!texture.bImported && texture.first_pass == i && !written[InResource.index])
+            {
+                // Nothing to keep, only the previous user of the memory must be done with it.
+                pass.barriers.push_back({texture.handle, textures[texture.previous].last_state, InState, true});
+            }
+            else if (state != InState || IsWriteState(InState))
+            {
+                // Reads in the same state share the layout, writes are ordered after what was done before.
+                pass.barriers.push_back({texture.handle, state, InState, false});
+            }
+
+            state = InState;
+            if (IsWriteState(InState))
+            {
+                written[InResource.index] = 1;
+            }
+        };
+
+        const RenderGraphPassDescriptor& descriptor = pass.descriptor;
+        for (u32 j = 0; j < descriptor.InputsCount; ++j)
+        {
+            transition(descriptor.InputTextures[j].Resource, descriptor.InputTextures[j].State);
+        }
+        for (u32 j = 0; j < descriptor.RenderTargetsCount; ++j)
+        {
+            transition(descriptor.OutputTextures[j], ResourceState::RENDER_TARGET);
+        }
+        if (descriptor.DepthStencilTexture.index != INVALID_ID)
+        {
+            transition(descriptor.DepthStencilTexture, ResourceState::DEPTH_WRITE);
+        }
+
+        stats.barriers_count += static_cast<u32>(pass.barriers.size());
+        stats.barrier_batches_count += pass.barriers.empty() ? 0 : 1;
+    }
+
+    for (u32 i = 0; i < textures.size(); ++i)
+    {
+        if (textures[i].bImported && states[i] != textures[i].initial_state)
+        {
+            final_barriers.push_back({textures[i].handle, states[i], textures[i].initial_state, false});
+        }
+    }
+
+    stats.barriers_count += static_cast<u32>(final_barriers.size());
+    stats.barrier_batches_count += final_barriers.empty() ? 0 : 1;
+}
+
+void RenderGraph::Execute(CommandBuffer* cmd)
+{
+    SPROFILE_FUNCTION();
+
+    stats.barriers_count        = 0;
+    stats.barrier_batches_count = 0;
+
+    for (const Pass& pass : passes)
+    {
+        if (pass.bCulled)
+        {
+            continue;
+        }
+
+        if (!pass.barriers.empty())
+        {
+            cmd->barrier(pass.barriers.data(), static_cast<u32>(pass.barriers.size()));
+            stats.barriers_count += static_cast<u32>(pass.barriers.size());
+            ++stats.barrier_batches_count;
+        }
+
+        if (pass.descriptor.Execute)
+        {
+            pass.descriptor.Execute(cmd, pass.render_pass);
+        }
+    }
+
+    if (!final_barriers.empty())
+    {
+        cmd->barrier(final_barriers.data(), static_cast<u32>(final_barriers.size()));
+        stats.barriers_count += static_cast<u32>(final_barriers.size());
+        ++stats.barrier_batches_count;
+    }
+}
+
+TextureHandle RenderGraph::GetTexture(RenderGraphResource InResource) const
+{
+    return textures[InResource.index].handle;
+}
+
+RenderPassHandle RenderGraph::GetRenderPass(RenderGraphPass InPass) const
+{
+    return passes[InPass.index].render_pass;
+}
+
+RenderPassOutput RenderGraph::GetPassOutput(RenderGraphPass InPass) const
+{
+    const RenderGraphPassDescriptor& descriptor = passes[InPass.index].descriptor;
+    if (descriptor.Type == RenderPassType::SWAPCHAIN)
+    {
+        return device->GetSwapchainOutput();
+    }
+
+    RenderPassOutput output;
+    output.Reset();
+
+    for (u32 i = 0; i < descriptor.RenderTargetsCount; ++i)
+    {
+        output.AddColor(textures[descriptor.OutputTextures[i].index].descriptor.format);
+    }
+
+    if (descriptor.DepthStencilTexture.index != INVALID_ID)
+    {
+        output.SetDepth(textures[descriptor.DepthStencilTexture.index].descriptor.format);
+    }
+
+    output.SetOperations(descriptor.ColorOperation, descriptor.DepthOperation, RenderPassOperation::DONTCARE);
+    return output;
+}
+
+bool RenderGraph::IsCulled(RenderGraphPass InPass) const
+{
+    return passes[InPass.index].bCulled;
+}
+
+void RenderGraph::ReleaseResources()
+{
+    // Through the deletion queue, frames in flight may still use them.
+    for (RenderPassHandle handle : created_passes)
+    {
+        device->DestroyRenderPass(handle);
+    }
+
+    // Aliases first, the textures owning the memory are created before them.
+    for (auto it = created_textures.rbegin(); it != created_textures.rend(); ++it)
+    {
+        device->DestroyTexture(*it);
+    }
+
+    created_passes.clear();
+    created_textures.clear();
+    final_barriers.clear();
+}
+
+} // namespace Renderer
+} // namespace Sogas
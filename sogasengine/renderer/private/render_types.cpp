@@ -1,4 +1,5 @@
 #include "render_types.h"
+#include "texture.h"
 
 namespace Sogas
 {
@@ -29,6 +30,8 @@ BlendState& BlendStateDescriptor::AddBlendState()
 ShaderStateDescriptor& ShaderStateDescriptor::Reset()
 {
     stages_count = 0;
+    defines.clear();
+    include_directory.clear();
     return *this;
 }
 
@@ -48,6 +51,18 @@ ShaderStateDescriptor& ShaderStateDescriptor::AddStage(const char* InCode, u32 I
     return *this;
 }
 
+ShaderStateDescriptor& ShaderStateDescriptor::AddDefine(const std::string& InName, const std::string& InValue)
+{
+    defines.emplace_back(InName, InValue);
+    return *this;
+}
+
+ShaderStateDescriptor& ShaderStateDescriptor::SetIncludeDirectory(const std::string& InDirectory)
+{
+    include_directory = InDirectory;
+    return *this;
+}
+
 ShaderStateDescriptor& ShaderStateDescriptor::SetSpvInput(bool InValue)
 {
     spv_input = InValue;
@@ -56,7 +71,13 @@ ShaderStateDescriptor& ShaderStateDescriptor::SetSpvInput(bool InValue)
 
 RenderPassOutput& RenderPassOutput::Reset()
 {
-    ColorFormatCounts = 0;
+    // Outputs are hashed to find their render pass, unused formats must not hold garbage.
+    for (Format& format : ColorFormats)
+    {
+        format = Format::UNDEFINED;
+    }
+    DepthStencilFormat = Format::UNDEFINED;
+    ColorFormatCounts  = 0;
     return *this;
 }
 
@@ -168,15 +189,17 @@ DescriptorSetDescriptor& DescriptorSetDescriptor::Texture(TextureHandle InTextur
 {
     samplers[resources_count]  = INVALID_SAMPLER;
     bindings[resources_count]  = InBinding;
+    ranges[resources_count]    = 0;
     resources[resources_count] = InTexture.index;
     ++resources_count;
     return *this;
 }
 
-DescriptorSetDescriptor& DescriptorSetDescriptor::Buffer(BufferHandle InBuffer, u16 InBinding)
+DescriptorSetDescriptor& DescriptorSetDescriptor::Buffer(BufferHandle InBuffer, u16 InBinding, u32 InRange)
 {
     samplers[resources_count]  = INVALID_SAMPLER;
     bindings[resources_count]  = InBinding;
+    ranges[resources_count]    = InRange;
     resources[resources_count] = InBuffer.index;
     ++resources_count;
     return *this;
@@ -186,6 +209,7 @@ DescriptorSetDescriptor& DescriptorSetDescriptor::TextureSampler(TextureHandle I
 {
     samplers[resources_count]  = InSampler;
     bindings[resources_count]  = InBinding;
+    ranges[resources_count]    = 0;
     resources[resources_count] = InTexture.index;
     ++resources_count;
     return *this;
@@ -223,5 +247,11 @@ DescriptorSetLayoutDescriptor& DescriptorSetLayoutDescriptor::SetSetIndex(u32 In
     return *this;
 }
 
+DescriptorSetLayoutDescriptor& DescriptorSetLayoutDescriptor::SetBindless(bool InValue)
+{
+    bindless = InValue;
+    return *this;
+}
+
 } // namespace Renderer
 } // namespace Sogas
\ No newline at end of file
@@ -8,7 +8,8 @@ namespace Renderer
 
 RenderPassDescriptor& RenderPassDescriptor::Reset()
 {
-    RenderTargetsCount = 0;
+    RenderTargetsCount  = 0;
+    DepthStencilTexture = INVALID_TEXTURE;
     return *this;
 }
 
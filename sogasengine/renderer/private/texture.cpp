@@ -36,6 +36,11 @@ TextureDescriptor& TextureDescriptor::SetData(void* InData)
     data = InData;
     return *this;
 }
+TextureDescriptor& TextureDescriptor::SetAlias(TextureHandle InHandle)
+{
+    alias = InHandle;
+    return *this;
+}
 
 } // namespace Renderer
 } // namespace Sogas
\ No newline at end of file
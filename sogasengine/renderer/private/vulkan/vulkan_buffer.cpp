@@ -24,6 +24,9 @@ static VkBufferUsageFlags ConvertUsage(BufferUsage InUsage)
         case BufferUsage::UNIFORM:
             return VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
             break;
+        case BufferUsage::STORAGE:
+            return VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+            break;
         case BufferUsage::TRANSFER_DST:
             return VK_BUFFER_USAGE_TRANSFER_DST_BIT;
             break;
@@ -54,26 +57,55 @@ BufferHandle VulkanBuffer::Create(VulkanDevice* InDevice, const BufferDescriptor
     buffer->global_offset = 0;
     buffer->usage_type    = InDescriptor.type;
     buffer->handle        = handle;
+    buffer->mapped_data   = nullptr;
+
+    // Dynamic buffers hold any per frame data, constants, instances or indices.
+    if (InDescriptor.type == BufferType::Dynamic)
+    {
+        buffer->usage_flags |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    }
 
     VkBufferCreateInfo buffer_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
-    buffer_info.usage              = VK_BUFFER_USAGE_TRANSFER_DST_BIT | buffer->usage_flags;
+    // Transfer source so defragmentation can copy the contents to a new place.
+    buffer_info.usage              = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | buffer->usage_flags;
     buffer_info.size               = InDescriptor.size > 0 ? InDescriptor.size : 1;
 
     SASSERT(vkCreateBuffer(InDevice->Handle, &buffer_info, nullptr, &buffer->buffer) == VK_SUCCESS);
 
-    VkMemoryPropertyFlags memory_property_flags =
-      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    // Static buffers are read by the gpu only, they live in device local memory and are filled with a staging copy.
+    // Dynamic and stream buffers are written by the cpu, host visible and also device local when the whole device
+    // memory can be mapped.
+    VkMemoryPropertyFlags memory_property_flags = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    if (InDescriptor.type == BufferType::Static)
+    {
+        memory_property_flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    }
+    else if (InDevice->memory_allocator.HasMappableDeviceLocalHeap())
+    {
+        memory_property_flags |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    }
 
     buffer->Allocate_buffer_memory(memory_property_flags);
 
-    vkBindBufferMemory(InDevice->Handle, buffer->buffer, buffer->memory, 0);
+    // Device local memory can be host visible too on integrated gpus and software drivers, no copy is needed then.
+    const VkMemoryPropertyFlags placement = InDevice->memory_allocator.GetMemoryProperties(buffer->allocation.memory_type);
+    if (buffer->mapped_data != nullptr && !(placement & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+    {
+        buffer->mapped_data = nullptr;
+    }
+
+    if (InDescriptor.data != nullptr && buffer->mapped_data != nullptr)
+    {
+        memcpy(buffer->mapped_data, InDescriptor.data, InDescriptor.size);
+    }
+    else if (InDescriptor.data != nullptr && buffer->allocation.IsValid())
+    {
+        InDevice->upload_manager.UploadBuffer(buffer->buffer, 0, InDescriptor.data, InDescriptor.size);
+    }
 
-    if (InDescriptor.data != nullptr)
+    if (buffer->usage_flags & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
     {
-        void* data;
-        vkMapMemory(InDevice->Handle, buffer->memory, 0, InDescriptor.size, 0, &data);
-        memcpy(data, InDescriptor.data, InDescriptor.size);
-        vkUnmapMemory(InDevice->Handle, buffer->memory);
+        InDevice->WriteBindlessDescriptor(ResourceType::BUFFER, handle.index);
     }
 
     return handle;
@@ -81,17 +113,15 @@ BufferHandle VulkanBuffer::Create(VulkanDevice* InDevice, const BufferDescriptor
 
 void VulkanBuffer::Allocate_buffer_memory(VkMemoryPropertyFlags memoryPropertyFlags)
 {
-    VkMemoryRequirements memoryRequirements;
-    vkGetBufferMemoryRequirements(device->Handle, buffer, &memoryRequirements);
+    // Memory comes bound, host visible memory already mapped.
+    allocation = device->memory_allocator.AllocateBuffer(buffer, memoryPropertyFlags, this);
 
-    VkMemoryAllocateInfo allocateInfo = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
-    allocateInfo.allocationSize       = memoryRequirements.size;
-    allocateInfo.memoryTypeIndex      = device->FindMemoryType(memoryRequirements.memoryTypeBits, memoryPropertyFlags);
-
-    if (vkAllocateMemory(device->Handle, &allocateInfo, nullptr, &memory))
+    if (!allocation.IsValid())
     {
         SERROR("Failed to allocate buffer memory.");
     }
+
+    mapped_data = allocation.mapped;
 }
 
 } // namespace Vk
@@ -6,6 +6,7 @@
 #include "vulkan/vulkan_pipeline.h"
 #include "vulkan/vulkan_renderpass.h"
 #include "vulkan/vulkan_swapchain.h"
+#include "vulkan/vulkan_texture.h"
 
 namespace Sogas
 {
@@ -14,6 +15,28 @@ namespace Renderer
 namespace Vk
 {
 
+struct VulkanResourceState
+{
+    VkImageLayout        layout;
+    VkAccessFlags        access;
+    VkPipelineStageFlags stages;
+};
+
+// Indexed by ResourceState.
+// clang-format off
+static const VulkanResourceState resource_states[] =
+  {
+    {VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT},
+    {VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT},
+    {VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT},
+    {VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT},
+    {VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT},
+    {VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT}
+};
+// clang-format on
+
+static_assert(std::size(resource_states) == static_cast<size_t>(ResourceState::COUNT), "Missing resource state.");
+
 void VulkanCommandBufferResources::init(VulkanDevice* device)
 {
     this->device = device;
@@ -42,6 +65,22 @@ void VulkanCommandBufferResources::init(VulkanDevice* device)
         command_buffers[i].handle = i;
         command_buffers[i].reset();
     }
+
+    for (u32 i = 0; i < MAX_SECONDARY_BUFFERS; ++i)
+    {
+        const u32 pool_index = pool_from_secondary_index(i);
+
+        VkCommandBufferAllocateInfo allocate_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+        allocate_info.commandPool                 = command_pools[pool_index];
+        allocate_info.level                       = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocate_info.commandBufferCount          = 1;
+
+        vkcheck(vkAllocateCommandBuffers(device->Handle, &allocate_info, &secondary_command_buffers[i].command_buffer));
+
+        secondary_command_buffers[i].device = device;
+        secondary_command_buffers[i].handle = i;
+        secondary_command_buffers[i].reset();
+    }
 }
 
 void VulkanCommandBufferResources::shutdown()
@@ -57,6 +96,7 @@ void VulkanCommandBufferResources::reset_pools(u32 frame_index)
     for (u32 i = 0; i < MAX_THREADS; ++i)
     {
         vkResetCommandPool(device->Handle, command_pools[frame_index * MAX_THREADS + i], 0);
+        next_free_per_thread_frame[frame_index * MAX_THREADS + i] = 0;
     }
 }
 
@@ -81,6 +121,21 @@ VulkanCommandBuffer* VulkanCommandBufferResources::get_instant_command_buffer(u3
     return &command_buffers[frame * BUFFER_PER_POOL + 1];
 }
 
+VulkanCommandBuffer* VulkanCommandBufferResources::get_secondary_command_buffer(u32 frame, u32 thread_index)
+{
+    SASSERT(thread_index < MAX_THREADS);
+
+    const u32 pool_index = frame * MAX_THREADS + thread_index;
+    u8&       next_free  = next_free_per_thread_frame[pool_index];
+    if (next_free >= SECONDARY_BUFFER_PER_POOL)
+    {
+        SERROR("Out of secondary command buffers for thread %d.", thread_index);
+        return nullptr;
+    }
+
+    return &secondary_command_buffers[pool_index * SECONDARY_BUFFER_PER_POOL + next_free++];
+}
+
 void VulkanCommandBuffer::init(u32 buffer_size, u32 submit_size, bool baked)
 {
     buffer_size = buffer_size;
@@ -96,52 +151,355 @@ void VulkanCommandBuffer::finish()
 
 // interface
 
-void VulkanCommandBuffer::bind_pass(RenderPassHandle handle)
+void VulkanCommandBuffer::bind_pass(RenderPassHandle handle, bool use_secondary)
 {
     is_recording = true;
 
     VulkanRenderPass* renderpass = device->GetRenderPassResource(handle);
 
-    if (current_renderpass && (current_renderpass->type != RenderPassType::COMPUTE) && (current_renderpass != renderpass))
+    if (renderpass == current_renderpass)
     {
-        vkCmdEndRenderPass(command_buffer);
+        return;
     }
 
-    if (renderpass != current_renderpass && (renderpass->type != RenderPassType::COMPUTE))
+    end_pass();
+
+    // Timed around the whole pass, statistics queries can't begin inside it. The contents recorded in secondaries are
+    // only counted when they can inherit the query.
+    const bool statistics = !use_secondary || device->gpu_profiler.GetInheritedStatistics() != 0;
+    pass_zone             = device->gpu_profiler.BeginZone(command_buffer, renderpass->profile_name, statistics);
+    pass_uses_secondaries = use_secondary;
+
+    if (renderpass->type != RenderPassType::COMPUTE && device->bDynamicRendering)
+    {
+        begin_rendering(renderpass, use_secondary);
+    }
+    else if (renderpass->type != RenderPassType::COMPUTE)
     {
         auto swapchain = device->swapchain;
 
         VkRenderPassBeginInfo renderpass_begin_info = {VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
-        renderpass_begin_info.framebuffer           = renderpass->type == RenderPassType::SWAPCHAIN ? swapchain->framebuffers.at(device->GetFrameIndex()) : renderpass->framebuffer;
+        current_framebuffer                         = renderpass->type == RenderPassType::SWAPCHAIN ? swapchain->framebuffers.at(swapchain->imageIndex) : device->GetFramebuffer(renderpass);
+        renderpass_begin_info.framebuffer           = current_framebuffer;
         renderpass_begin_info.renderPass            = renderpass->renderpass;
 
+        // One clear value per attachment, colors take the first clear and depth the second.
+        VkClearValue clear_values[MAX_IMAGE_OUTPUTS + 1];
+        u32          clears_count = 0;
+
         renderpass_begin_info.renderArea.offset = {0, 0};
-        renderpass_begin_info.renderArea.extent = {swapchain->width, swapchain->height};
+        if (renderpass->type == RenderPassType::SWAPCHAIN)
+        {
+            renderpass_begin_info.renderArea.extent = {swapchain->width, swapchain->height};
+
+            clear_values[clears_count++] = clears[0];
+            clear_values[clears_count++] = clears[1];
+        }
+        else
+        {
+            renderpass_begin_info.renderArea.extent = {renderpass->width, renderpass->heigh};
+
+            for (u32 i = 0; i < renderpass->render_targets_count; ++i)
+            {
+                clear_values[clears_count++] = clears[0];
+            }
+            if (renderpass->depth_texture.index != INVALID_ID)
+            {
+                clear_values[clears_count++] = clears[1];
+            }
+        }
+
+        renderpass_begin_info.clearValueCount = clears_count;
+        renderpass_begin_info.pClearValues    = clear_values;
+
+        vkCmdBeginRenderPass(command_buffer, &renderpass_begin_info, use_secondary ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+    }
+
+    current_renderpass = renderpass;
+}
+
+void VulkanCommandBuffer::begin_rendering(const VulkanRenderPass* renderpass, bool use_secondary)
+{
+    VkRenderingAttachmentInfo color_attachments[MAX_IMAGE_OUTPUTS];
+    VkRenderingAttachmentInfo depth_attachment   = {VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO};
+    VkRenderingAttachmentInfo stencil_attachment = {VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO};
+    VkAttachmentLoadOp        stencil_op         = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    u32                       colors_count       = 0;
+    const VulkanTexture*      depth              = nullptr;
+
+    VkRenderingInfo rendering_info   = {VK_STRUCTURE_TYPE_RENDERING_INFO};
+    rendering_info.flags             = use_secondary ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+    rendering_info.renderArea.offset = {0, 0};
+    rendering_info.layerCount        = 1;
+
+    if (renderpass->type == RenderPassType::SWAPCHAIN)
+    {
+        auto swapchain = device->swapchain;
 
-        renderpass_begin_info.clearValueCount = 2;
-        renderpass_begin_info.pClearValues    = clears;
+        VulkanTexture* depth_texture = device->GetTextureResource(device->depth_texture);
+        depth                        = depth_texture;
+
+        // Both attachments are cleared, their previous contents are discarded as the swapchain render pass does with
+        // its initial layouts. The color image comes back from the presentation engine, or from the previous frame
+        // when headless.
+        VkImageMemoryBarrier image_barriers[2];
+        image_barriers[0]                             = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+        image_barriers[0].image                       = swapchain->images[swapchain->imageIndex];
+        image_barriers[0].oldLayout                   = VK_IMAGE_LAYOUT_UNDEFINED;
+        image_barriers[0].newLayout                   = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        image_barriers[0].srcAccessMask               = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        image_barriers[0].dstAccessMask               = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        image_barriers[0].srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+        image_barriers[0].dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+        image_barriers[0].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        image_barriers[0].subresourceRange.levelCount = 1;
+        image_barriers[0].subresourceRange.layerCount = 1;
+
+        // The previous frame may still be testing against it.
+        image_barriers[1]                             = image_barriers[0];
+        image_barriers[1].image                       = depth_texture->texture;
+        image_barriers[1].newLayout                   = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        image_barriers[1].srcAccessMask               = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        image_barriers[1].dstAccessMask               = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        image_barriers[1].subresourceRange.aspectMask = depth_texture->descriptor.aspect;
+
+        const VkPipelineStageFlags stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        vkCmdPipelineBarrier(command_buffer, stages, stages, 0, 0, nullptr, 0, nullptr, 2, image_barriers);
+
+        depth_texture->image_layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkRenderingAttachmentInfo& color_attachment = color_attachments[colors_count++];
+        color_attachment                            = {VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO};
+        color_attachment.imageView                  = swapchain->imageViews[swapchain->imageIndex];
+        color_attachment.loadOp                     = VK_ATTACHMENT_LOAD_OP_CLEAR;
+
+        depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+
+        rendering_info.renderArea.extent = {swapchain->width, swapchain->height};
+    }
+    else
+    {
+        // Attachments are expected in their attachment layouts, the render graph transitions them.
+        for (u32 i = 0; i < renderpass->render_targets_count; ++i)
+        {
+            VkRenderingAttachmentInfo& color_attachment = color_attachments[colors_count++];
+            color_attachment                            = {VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO};
+            color_attachment.imageView                  = device->GetTextureResource(renderpass->output_texture[i])->image_view;
+            color_attachment.loadOp                     = ConvertLoadOperation(renderpass->output.ColorOperation);
+        }
+
+        if (renderpass->depth_texture.index != INVALID_ID)
+        {
+            depth                   = device->GetTextureResource(renderpass->depth_texture);
+            depth_attachment.loadOp = ConvertLoadOperation(renderpass->output.DepthOperation);
+            stencil_op              = ConvertLoadOperation(renderpass->output.StencilOperation);
+        }
+
+        rendering_info.renderArea.extent = {renderpass->width, renderpass->heigh};
+    }
 
-        vkCmdBeginRenderPass(command_buffer, &renderpass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+    for (u32 i = 0; i < colors_count; ++i)
+    {
+        color_attachments[i].imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        color_attachments[i].storeOp     = VK_ATTACHMENT_STORE_OP_STORE;
+        color_attachments[i].clearValue  = clears[0];
     }
 
-    current_renderpass = renderpass;
+    rendering_info.colorAttachmentCount = colors_count;
+    rendering_info.pColorAttachments    = color_attachments;
+
+    if (depth)
+    {
+        depth_attachment.imageView   = depth->image_view;
+        depth_attachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        depth_attachment.storeOp     = VK_ATTACHMENT_STORE_OP_STORE;
+        depth_attachment.clearValue  = clears[1];
+
+        if (HasDepth(depth->descriptor.generic_format))
+        {
+            rendering_info.pDepthAttachment = &depth_attachment;
+        }
+
+        if (!IsDepthOnly(depth->descriptor.generic_format))
+        {
+            stencil_attachment         = depth_attachment;
+            stencil_attachment.loadOp  = stencil_op;
+            stencil_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+            rendering_info.pStencilAttachment = &stencil_attachment;
+        }
+    }
+
+    vkCmdBeginRendering(command_buffer, &rendering_info);
+
+    current_framebuffer = VK_NULL_HANDLE;
+}
+
+void VulkanCommandBuffer::end_pass()
+{
+    if (current_renderpass && current_renderpass->type != RenderPassType::COMPUTE)
+    {
+        if (!device->bDynamicRendering)
+        {
+            vkCmdEndRenderPass(command_buffer);
+        }
+        else
+        {
+            vkCmdEndRendering(command_buffer);
+
+            if (current_renderpass->type == RenderPassType::SWAPCHAIN)
+            {
+                // The final layout of the swapchain render pass otherwise.
+                VkImageMemoryBarrier present_barrier        = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+                present_barrier.image                       = device->swapchain->images[device->swapchain->imageIndex];
+                present_barrier.oldLayout                   = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                present_barrier.newLayout                   = device->swapchain->present_layout;
+                present_barrier.srcAccessMask               = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+                present_barrier.dstAccessMask               = 0;
+                present_barrier.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+                present_barrier.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+                present_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                present_barrier.subresourceRange.levelCount = 1;
+                present_barrier.subresourceRange.layerCount = 1;
+
+                vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &present_barrier);
+            }
+        }
+    }
+
+    device->gpu_profiler.EndZone(command_buffer, pass_zone);
+
+    current_renderpass    = nullptr;
+    current_framebuffer   = VK_NULL_HANDLE;
+    pass_zone             = INVALID_ID;
+    pass_uses_secondaries = false;
 }
 
 void VulkanCommandBuffer::bind_pipeline(PipelineHandle handle)
 {
     VulkanPipeline* pipeline = device->GetPipelineResource(handle);
+    if (pipeline->pipeline == VK_NULL_HANDLE)
+    {
+        // Created async and still compiling.
+        device->WaitForPipeline(handle);
+    }
+
     vkCmdBindPipeline(command_buffer, pipeline->bind_point, pipeline->pipeline);
 
+    // Resources are selected by index in the shaders, the heap is the only set bound for them.
+    if (pipeline->bindless)
+    {
+        vkCmdBindDescriptorSets(command_buffer, pipeline->bind_point, pipeline->pipelineLayout, BINDLESS_SET_INDEX, 1, &device->bindless_set, 0, nullptr);
+    }
+
     current_pipeline = pipeline;
 }
 
+static u32 CountDynamicDescriptors(const VulkanDescriptorSetLayout* InLayout)
+{
+    u32 count = 0;
+    for (u32 i = 0; i < InLayout->bindings_count; ++i)
+    {
+        const VkDescriptorSetLayoutBinding& binding = InLayout->binding[i];
+        if (binding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC || binding.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC)
+        {
+            count += binding.descriptorCount;
+        }
+    }
+    return count;
+}
+
 void VulkanCommandBuffer::bind_descriptor_set(DescriptorSetHandle handle, u32* offsets, u32 offsets_count)
 {
+    // The set may have been created since the last flush.
+    device->FlushDescriptorWrites();
+
     auto descriptor_set = device->GetDescriptorSetResource(handle);
 
     auto descriptor_set_layout = descriptor_set->layout;
 
-    vkCmdBindDescriptorSets(command_buffer, current_pipeline->bind_point, current_pipeline->pipelineLayout, 0, 1, &descriptor_set->descriptorSet, 0, nullptr);
+    // One offset per dynamic descriptor, in binding order.
+    SASSERT_MSG(offsets_count == CountDynamicDescriptors(descriptor_set_layout), "Descriptor set bound with %d dynamic offsets, its layout has %d dynamic descriptors.", offsets_count, CountDynamicDescriptors(descriptor_set_layout));
+    vkCmdBindDescriptorSets(command_buffer, current_pipeline->bind_point, current_pipeline->pipelineLayout, descriptor_set_layout->set_index, 1, &descriptor_set->descriptorSet, offsets_count, offsets);
+}
+
+void VulkanCommandBuffer::bind_descriptor_set(const TransientDescriptorSet& set, u32* offsets, u32 offsets_count)
+{
+    device->FlushDescriptorWrites();
+
+    const VkDescriptorSet descriptor_set = reinterpret_cast<VkDescriptorSet>(set.set);
+    vkCmdBindDescriptorSets(command_buffer, current_pipeline->bind_point, current_pipeline->pipelineLayout, set.set_index, 1, &descriptor_set, offsets_count, offsets);
+}
+
+void VulkanCommandBuffer::push_constants(const void* data, u32 size, u32 offset)
+{
+    SASSERT(current_pipeline && offset + size <= current_pipeline->push_constants.size);
+    vkCmdPushConstants(command_buffer, current_pipeline->pipelineLayout, current_pipeline->push_constants.stageFlags, offset, size, data);
+}
+
+void VulkanCommandBuffer::barrier(const TextureBarrier* barriers, u32 count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    // Barriers inside a render pass need a self dependency, the graph records them between passes.
+    end_pass();
+
+    constexpr u32        MAX_BARRIERS = 32;
+    VkImageMemoryBarrier image_barriers[MAX_BARRIERS];
+    VkPipelineStageFlags src_stages = 0;
+    VkPipelineStageFlags dst_stages = 0;
+
+    SASSERT(count <= MAX_BARRIERS);
+    for (u32 i = 0; i < count; ++i)
+    {
+        const VulkanResourceState& before  = resource_states[static_cast<u32>(barriers[i].before)];
+        const VulkanResourceState& after   = resource_states[static_cast<u32>(barriers[i].after)];
+        VulkanTexture*             texture = device->GetTextureResource(barriers[i].texture);
+
+        VkImageMemoryBarrier& image_barrier = image_barriers[i];
+        image_barrier                       = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+        image_barrier.image                 = texture->texture;
+        image_barrier.oldLayout             = barriers[i].discard ? VK_IMAGE_LAYOUT_UNDEFINED : before.layout;
+        image_barrier.newLayout             = after.layout;
+        image_barrier.srcAccessMask         = before.access;
+        image_barrier.dstAccessMask         = after.access;
+        image_barrier.srcQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+        image_barrier.dstQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+
+        image_barrier.subresourceRange.aspectMask = texture->descriptor.aspect;
+        if (HasDepthOrStencil(texture->descriptor.generic_format) && !IsDepthOnly(texture->descriptor.generic_format))
+        {
+            // Without separate depth stencil layouts both aspects change layout together.
+            image_barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+        }
+        image_barrier.subresourceRange.levelCount = texture->descriptor.mipmaps;
+        image_barrier.subresourceRange.layerCount = 1;
+
+        src_stages |= before.stages;
+        dst_stages |= after.stages;
+
+        texture->image_layout = after.layout;
+    }
+
+    vkCmdPipelineBarrier(command_buffer, src_stages, dst_stages, 0, 0, nullptr, 0, nullptr, count, image_barriers);
+}
+
+void VulkanCommandBuffer::begin_zone(const char* name)
+{
+    SASSERT_MSG(!pass_uses_secondaries, "Gpu zones can't be recorded in a pass executing secondary command buffers.");
+    SASSERT(open_zones_count < MAX_OPEN_ZONES);
+
+    open_zones[open_zones_count++] = device->gpu_profiler.BeginZone(command_buffer, name, false);
+}
+
+void VulkanCommandBuffer::end_zone()
+{
+    SASSERT_MSG(open_zones_count > 0, "Ending a gpu zone that was not begun.");
+
+    device->gpu_profiler.EndZone(command_buffer, open_zones[--open_zones_count]);
 }
 
 void VulkanCommandBuffer::bind_vertex_buffer(BufferHandle handle, u32 binding, u32 offset)
@@ -162,13 +520,25 @@ void VulkanCommandBuffer::bind_index_buffer(BufferHandle handle, u32 offset)
     vkCmdBindIndexBuffer(command_buffer, buffer->buffer, offsets, VK_INDEX_TYPE_UINT32);
 }
 
+VkExtent2D VulkanCommandBuffer::get_pass_extent() const
+{
+    // Offscreen passes cover their attachments, the others the swapchain.
+    if (current_renderpass && current_renderpass->type == RenderPassType::GEOMETRY)
+    {
+        return {current_renderpass->width, current_renderpass->heigh};
+    }
+    return {device->swapchain->width, device->swapchain->height};
+}
+
 void VulkanCommandBuffer::set_viewport()
 {
+    const VkExtent2D extent = get_pass_extent();
+
     VkViewport viewport;
     viewport.x        = 0;
     viewport.y        = 0;
-    viewport.width    = device->swapchain->width;
-    viewport.height   = device->swapchain->height;
+    viewport.width    = static_cast<f32>(extent.width);
+    viewport.height   = static_cast<f32>(extent.height);
     viewport.minDepth = 0.0f;
     viewport.maxDepth = 1.0f;
 
@@ -179,7 +549,7 @@ void VulkanCommandBuffer::set_scissors()
 {
     VkRect2D scissors;
     scissors.offset = {0, 0};
-    scissors.extent = {device->swapchain->width, device->swapchain->height};
+    scissors.extent = get_pass_extent();
     vkCmdSetScissor(command_buffer, 0, 1, &scissors);
 }
 
@@ -193,12 +563,81 @@ void VulkanCommandBuffer::draw_indexed(u32 index_count, u32 instance_count, u32
     vkCmdDrawIndexed(command_buffer, index_count, instance_count, first_index, vertex_offset, first_instance);
 }
 
+void VulkanCommandBuffer::end()
+{
+    vkEndCommandBuffer(command_buffer);
+    is_recording = false;
+}
+
+void VulkanCommandBuffer::execute_commands(CommandBuffer** secondaries, u32 count)
+{
+    SASSERT(count <= VulkanCommandBufferResources::MAX_THREADS);
+
+    VkCommandBuffer command_buffers[VulkanCommandBufferResources::MAX_THREADS];
+    for (u32 i = 0; i < count; ++i)
+    {
+        command_buffers[i] = static_cast<VulkanCommandBuffer*>(secondaries[i])->command_buffer;
+    }
+
+    if (count > 0)
+    {
+        vkCmdExecuteCommands(command_buffer, count, command_buffers);
+    }
+}
+
 void VulkanCommandBuffer::reset()
 {
-    is_recording       = false;
-    current_renderpass = nullptr;
-    current_pipeline   = nullptr;
-    current_command    = 0;
+    is_recording          = false;
+    current_renderpass    = nullptr;
+    current_framebuffer   = VK_NULL_HANDLE;
+    current_pipeline      = nullptr;
+    current_command       = 0;
+    pass_zone             = INVALID_ID;
+    pass_uses_secondaries = false;
+    open_zones_count      = 0;
+}
+
+void VulkanCommandBuffer::begin_secondary(const VulkanCommandBuffer* primary)
+{
+    SASSERT_MSG(primary->current_renderpass, "Secondary command buffers continue the render pass of the primary.");
+
+    reset();
+
+    VkCommandBufferInheritanceInfo inheritance = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
+    inheritance.renderPass                     = primary->current_renderpass->renderpass;
+    inheritance.subpass                        = 0;
+    inheritance.framebuffer                    = primary->current_framebuffer;
+    inheritance.pipelineStatistics             = device->gpu_profiler.GetInheritedStatistics();
+
+    // Without a render pass object the secondary is given the attachment formats.
+    VkFormat                                color_formats[MAX_IMAGE_OUTPUTS];
+    VkCommandBufferInheritanceRenderingInfo inheritance_rendering = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO};
+    if (device->bDynamicRendering)
+    {
+        const RenderPassOutput& output = primary->current_renderpass->type == RenderPassType::SWAPCHAIN ? device->swapchain->output : primary->current_renderpass->output;
+        for (u32 i = 0; i < output.ColorFormatCounts; ++i)
+        {
+            color_formats[i] = ConvertFormat(output.ColorFormats[i]);
+        }
+
+        inheritance_rendering.colorAttachmentCount    = output.ColorFormatCounts;
+        inheritance_rendering.pColorAttachmentFormats = color_formats;
+        inheritance_rendering.depthAttachmentFormat   = HasDepth(output.DepthStencilFormat) ? ConvertFormat(output.DepthStencilFormat) : VK_FORMAT_UNDEFINED;
+        inheritance_rendering.stencilAttachmentFormat = HasDepthOrStencil(output.DepthStencilFormat) && !IsDepthOnly(output.DepthStencilFormat) ? ConvertFormat(output.DepthStencilFormat) : VK_FORMAT_UNDEFINED;
+        inheritance_rendering.rasterizationSamples    = VK_SAMPLE_COUNT_1_BIT;
+
+        inheritance.pNext      = &inheritance_rendering;
+        inheritance.renderPass = VK_NULL_HANDLE;
+    }
+
+    VkCommandBufferBeginInfo begin_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    begin_info.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    begin_info.pInheritanceInfo         = &inheritance;
+    vkBeginCommandBuffer(command_buffer, &begin_info);
+
+    is_recording        = true;
+    current_renderpass  = primary->current_renderpass;
+    current_framebuffer = primary->current_framebuffer;
 }
 
 } // namespace Vk
@@ -42,107 +42,92 @@ constexpr static VkDescriptorType ConvertDescriptorType(DescriptorType InType)
     }
 }
 
-void VulkanDescriptorSet::FillWriteDescriptorSets(
+void VulkanDescriptorSet::WriteResources(
   VulkanDevice*                    InDevice,
   const VulkanDescriptorSetLayout* InDescriptorSetLayout,
   VkDescriptorSet                  InDescriptorSet,
-  VkWriteDescriptorSet*            InWriteDescriptorSet,
-  VkDescriptorBufferInfo*          InBufferInfo,
-  VkDescriptorImageInfo*           InImageInfo,
-  u32&                             OutResourcesCount,
-  const ResourceHandle*            InResources,
-  const SamplerHandle*             InSamplers,
-  const u16*                       InBindings)
+  const DescriptorSetDescriptor&   InDescriptor,
+  VulkanDescriptorWriter&          OutWriter)
 {
     auto default_sampler = InDevice->GetDefaultSampler();
 
-    u32 resources_used = 0;
-    for (u32 i = 0; i < OutResourcesCount; ++i)
+    for (u32 i = 0; i < InDescriptor.resources_count; ++i)
     {
-        u32 layout_binding_index = InBindings[i];
+        // Bindings are given by binding number, which may not match their index in the layout.
+        u32 layout_binding_index = 0;
+        while (layout_binding_index < InDescriptorSetLayout->bindings_count && InDescriptorSetLayout->bindings[layout_binding_index].start != InDescriptor.bindings[i])
+        {
+            ++layout_binding_index;
+        }
+        SASSERT_MSG(layout_binding_index < InDescriptorSetLayout->bindings_count, "Binding not found in the descriptor set layout.");
 
         const DescriptorBinding& binding = InDescriptorSetLayout->bindings[layout_binding_index];
 
-        InWriteDescriptorSet[resources_used]                 = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-        InWriteDescriptorSet[resources_used].dstSet          = InDescriptorSet;
-        InWriteDescriptorSet[resources_used].dstBinding      = binding.start;
-        InWriteDescriptorSet[resources_used].dstArrayElement = 0;
-        InWriteDescriptorSet[resources_used].descriptorCount = 1;
-
         switch (binding.type)
         {
             case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
             {
-                InWriteDescriptorSet[resources_used].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-
-                TextureHandle  texture_handle = {InResources[i]};
+                TextureHandle  texture_handle = {InDescriptor.resources[i]};
                 VulkanTexture* texture        = InDevice->GetTextureResource(texture_handle);
 
-                InImageInfo[resources_used].sampler = default_sampler->sampler;
+                VkDescriptorImageInfo image_info = {};
+                image_info.sampler               = default_sampler->sampler;
+                image_info.imageView             = texture->image_view;
+                image_info.imageLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
                 if (texture->sampler)
                 {
-                    InImageInfo[resources_used].sampler = texture->sampler->sampler;
+                    image_info.sampler = texture->sampler->sampler;
                 }
 
-                if (InSamplers[i].index != INVALID_ID)
+                if (InDescriptor.samplers[i].index != INVALID_ID)
                 {
-                    VulkanSampler* sampler              = InDevice->GetSamplerResource(InSamplers[i]);
-                    InImageInfo[resources_used].sampler = sampler->sampler;
+                    VulkanSampler* sampler = InDevice->GetSamplerResource(InDescriptor.samplers[i]);
+                    image_info.sampler     = sampler->sampler;
                 }
 
-                InWriteDescriptorSet[resources_used].pImageInfo = &InImageInfo[resources_used];
-
+                OutWriter.WriteImage(InDescriptorSet, binding.start, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, image_info);
                 break;
             }
             case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
             {
-                InWriteDescriptorSet[resources_used].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-
-                TextureHandle  texture_handle = {InResources[i]};
+                TextureHandle  texture_handle = {InDescriptor.resources[i]};
                 VulkanTexture* texture        = InDevice->GetTextureResource(texture_handle);
 
-                InImageInfo[resources_used].sampler     = nullptr;
-                InImageInfo[resources_used].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-                InImageInfo[resources_used].imageView   = texture->image_view;
-
-                InWriteDescriptorSet[resources_used].pImageInfo = &InImageInfo[resources_used];
+                VkDescriptorImageInfo image_info = {};
+                image_info.sampler               = nullptr;
+                image_info.imageLayout           = VK_IMAGE_LAYOUT_GENERAL;
+                image_info.imageView             = texture->image_view;
 
+                OutWriter.WriteImage(InDescriptorSet, binding.start, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, image_info);
                 break;
             }
             case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
             {
-                InWriteDescriptorSet[resources_used].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-
-                BufferHandle  buffer_handle = {InResources[i]};
+                BufferHandle  buffer_handle = {InDescriptor.resources[i]};
                 VulkanBuffer* buffer        = InDevice->GetBufferResource(buffer_handle);
 
-                InWriteDescriptorSet[resources_used].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-                InWriteDescriptorSet[resources_used].descriptorType = buffer->usage_type == BufferType::Dynamic ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-
-                InBufferInfo[resources_used].buffer = buffer->buffer;
-                InBufferInfo[resources_used].offset = 0;
-                InBufferInfo[resources_used].range  = buffer->size;
-
-                InWriteDescriptorSet[resources_used].pBufferInfo = &InBufferInfo[resources_used];
+                VkDescriptorBufferInfo buffer_info = {};
+                buffer_info.buffer                 = buffer->buffer;
+                buffer_info.offset                 = 0;
+                buffer_info.range                  = InDescriptor.ranges[i] > 0 ? InDescriptor.ranges[i] : buffer->size;
 
+                // Must match the layout, dynamic descriptors get their offset when bound.
+                OutWriter.WriteBuffer(InDescriptorSet, binding.start, 0, binding.type, buffer_info);
                 break;
             }
             case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
             {
-                InWriteDescriptorSet[resources_used].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-
-                BufferHandle  buffer_handle = {InResources[i]};
+                BufferHandle  buffer_handle = {InDescriptor.resources[i]};
                 VulkanBuffer* buffer        = InDevice->GetBufferResource(buffer_handle);
 
-                //InWriteDescriptorSet[resources_used].descriptorType = buffer->
-
-                InBufferInfo[resources_used].buffer = buffer->buffer;
-                InBufferInfo[resources_used].offset = 0;
-                InBufferInfo[resources_used].range  = buffer->size;
-
-                InWriteDescriptorSet[resources_used].pBufferInfo = &InBufferInfo[resources_used];
+                VkDescriptorBufferInfo buffer_info = {};
+                buffer_info.buffer                 = buffer->buffer;
+                buffer_info.offset                 = 0;
+                buffer_info.range                  = buffer->size;
 
+                OutWriter.WriteBuffer(InDescriptorSet, binding.start, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, buffer_info);
                 break;
             }
             default:
@@ -151,11 +136,7 @@ void VulkanDescriptorSet::FillWriteDescriptorSets(
                 break;
             }
         }
-
-        ++resources_used;
     }
-
-    OutResourcesCount = resources_used;
 }
 
 VulkanDescriptorSet::~VulkanDescriptorSet()
@@ -192,26 +173,6 @@ DescriptorSetHandle VulkanDescriptorSet::Create(VulkanDevice* InDevice, const De
     descriptor_set->resources_count = InDescriptor.resources_count;
     descriptor_set->layout          = descriptor_set_layout;
 
-    // Update
-    VkWriteDescriptorSet   descriptor_write[8];
-    VkDescriptorBufferInfo buffer_info[8];
-    VkDescriptorImageInfo  image_info[8];
-
-    VulkanSampler* default_sampler = InDevice->GetDefaultSampler();
-
-    u32 resources_count = InDescriptor.resources_count;
-    descriptor_set->FillWriteDescriptorSets(
-      InDevice,
-      descriptor_set_layout,
-      descriptor_set->descriptorSet,
-      descriptor_write,
-      buffer_info,
-      image_info,
-      resources_count,
-      InDescriptor.resources,
-      InDescriptor.samplers,
-      InDescriptor.bindings);
-
     for (u32 i = 0; i < InDescriptor.resources_count; ++i)
     {
         descriptor_set->resources[i] = InDescriptor.resources[i];
@@ -219,11 +180,37 @@ DescriptorSetHandle VulkanDescriptorSet::Create(VulkanDevice* InDevice, const De
         descriptor_set->bindings[i]  = InDescriptor.bindings[i];
     }
 
-    vkUpdateDescriptorSets(InDevice->Handle, resources_count, descriptor_write, 0, nullptr);
+    // Batched with the writes of the other sets, submitted before the set is bound.
+    {
+        std::lock_guard<std::mutex> lock(InDevice->descriptor_writes_mutex);
+        WriteResources(InDevice, descriptor_set_layout, descriptor_set->descriptorSet, InDescriptor, InDevice->descriptor_writer);
+    }
 
     return handle;
 }
 
+TransientDescriptorSet VulkanDescriptorSet::CreateTransient(VulkanDevice* InDevice, const DescriptorSetDescriptor& InDescriptor)
+{
+    const VulkanDescriptorSetLayout* descriptor_set_layout = InDevice->GetDescriptorSetLayoutResource(InDescriptor.layout);
+
+    TransientDescriptorSet transient;
+    transient.set_index = descriptor_set_layout->set_index;
+
+    VkDescriptorSet descriptor_set = InDevice->descriptor_allocator.Allocate(InDevice->GetFrameIndex(), descriptor_set_layout->descriptor_set_layout);
+    if (descriptor_set == VK_NULL_HANDLE)
+    {
+        return transient;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(InDevice->descriptor_writes_mutex);
+        WriteResources(InDevice, descriptor_set_layout, descriptor_set, InDescriptor, InDevice->descriptor_writer);
+    }
+
+    transient.set = reinterpret_cast<u64>(descriptor_set);
+    return transient;
+}
+
 DescriptorSetLayoutHandle VulkanDescriptorSet::Create(VulkanDevice* InDevice, const DescriptorSetLayoutDescriptor& InDescriptor)
 {
     DescriptorSetLayoutHandle handle = {InDevice->descriptorSetLayouts.ObtainResource()};
@@ -248,7 +235,7 @@ DescriptorSetLayoutHandle VulkanDescriptorSet::Create(VulkanDevice* InDevice, co
         DescriptorBinding&                            binding       = descriptor_set_layout->bindings[i];
         const DescriptorSetLayoutDescriptor::Binding& input_binding = InDescriptor.bindings[i];
         binding.start                                               = input_binding.start == UINT16_MAX ? static_cast<u16>(i) : input_binding.start;
-        binding.count                                               = 1;
+        binding.count                                               = std::max<u16>(input_binding.count, 1);
         binding.type                                                = ConvertDescriptorType(input_binding.type);
         binding.name                                                = input_binding.name.c_str();
 
@@ -258,7 +245,7 @@ DescriptorSetLayoutHandle VulkanDescriptorSet::Create(VulkanDevice* InDevice, co
         vulkan_binding.binding         = binding.start;
         vulkan_binding.descriptorType  = binding.type;
         vulkan_binding.descriptorType  = input_binding.type == DescriptorType::UNIFOR_BUFFER_DYNAMIC ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : vulkan_binding.descriptorType;
-        vulkan_binding.descriptorCount = 1;
+        vulkan_binding.descriptorCount = binding.count;
 
         vulkan_binding.stageFlags         = VK_SHADER_STAGE_ALL;
         vulkan_binding.pImmutableSamplers = nullptr;
@@ -268,8 +255,27 @@ DescriptorSetLayoutHandle VulkanDescriptorSet::Create(VulkanDevice* InDevice, co
     info.bindingCount                    = used_bindings;
     info.pBindings                       = descriptor_set_layout->binding;
 
+    // Bindless arrays are written while the set is bound, only the elements the shaders read must be valid.
+    VkDescriptorBindingFlags                    binding_flags[MAX_DESCRIPTOR_PER_SET];
+    VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO};
+    if (InDescriptor.bindless)
+    {
+        for (u32 i = 0; i < used_bindings; ++i)
+        {
+            binding_flags[i] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+        }
+
+        binding_flags_info.bindingCount  = used_bindings;
+        binding_flags_info.pBindingFlags = binding_flags;
+
+        info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+        info.pNext = &binding_flags_info;
+    }
+
     vkcheck(vkCreateDescriptorSetLayout(InDevice->Handle, &info, nullptr, &descriptor_set_layout->descriptor_set_layout));
 
+    descriptor_set_layout->hash = wyhash(descriptor_set_layout->binding, sizeof(VkDescriptorSetLayoutBinding) * used_bindings, InDescriptor.bindless ? 1 : 0, _wyp);
+
     return handle;
 }
 
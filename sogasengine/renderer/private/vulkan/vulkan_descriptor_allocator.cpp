@@ -0,0 +1,189 @@
+#include "vulkan/vulkan_descriptor_allocator.h"
+#include "vulkan/vulkan_device.h"
+
+namespace Sogas
+{
+namespace Renderer
+{
+namespace Vk
+{
+
+// Descriptors per set of each type, a pool holds this many times its sets.
+// clang-format off
+static const std::pair<VkDescriptorType, u32> pool_ratios[] =
+  {
+    {VK_DESCRIPTOR_TYPE_SAMPLER, 1},
+    {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4},
+    {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 4},
+    {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 1},
+    {VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 1},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2},
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 2},
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1},
+    {VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1}
+};
+// clang-format on
+
+void VulkanDescriptorAllocator::Init(VkDevice InDevice, u32 InFramesInFlight)
+{
+    device           = InDevice;
+    frames_in_flight = InFramesInFlight;
+}
+
+void VulkanDescriptorAllocator::Shutdown()
+{
+    SINFO("\tTransient descriptor sets: %d pools, %d sets peak per frame.", pools_count, peak_count);
+
+    for (u32 i = 0; i < frames_in_flight; ++i)
+    {
+        for (VkDescriptorPool pool : frames[i].pools)
+        {
+            vkDestroyDescriptorPool(device, pool, nullptr);
+        }
+
+        frames[i].pools.clear();
+        frames[i].current = 0;
+    }
+
+    pools_count = 0;
+}
+
+void VulkanDescriptorAllocator::Reset(u32 InFrameIndex)
+{
+    FramePools& frame = frames[InFrameIndex];
+
+    // Only the pools the frame used have sets to release.
+    for (u32 i = 0; i <= frame.current && i < frame.pools.size(); ++i)
+    {
+        vkResetDescriptorPool(device, frame.pools[i], 0);
+    }
+
+    frame.current   = 0;
+    peak_count      = std::max(peak_count, allocated_count);
+    allocated_count = 0;
+}
+
+VkDescriptorSet VulkanDescriptorAllocator::Allocate(u32 InFrameIndex, VkDescriptorSetLayout InLayout)
+{
+    FramePools& frame = frames[InFrameIndex];
+
+    VkDescriptorSetAllocateInfo allocate_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    allocate_info.descriptorSetCount          = 1;
+    allocate_info.pSetLayouts                 = &InLayout;
+
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    while (true)
+    {
+        if (frame.current == frame.pools.size())
+        {
+            // Each new pool of the chain is twice as big, a frame needing many sets settles on a few pools.
+            const u32 max_sets = std::min(INITIAL_SETS_PER_POOL << std::min<u32>(frame.current, 6), MAX_SETS_PER_POOL);
+            frame.pools.push_back(CreatePool(max_sets));
+        }
+
+        allocate_info.descriptorPool = frame.pools[frame.current];
+
+        const VkResult result = vkAllocateDescriptorSets(device, &allocate_info, &set);
+        if (result == VK_SUCCESS)
+        {
+            break;
+        }
+
+        if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL)
+        {
+            SERROR("Failed to allocate a transient descriptor set.");
+            return VK_NULL_HANDLE;
+        }
+
+        // Full, the next pool of the chain is tried.
+        ++frame.current;
+    }
+
+    ++allocated_count;
+    return set;
+}
+
+VkDescriptorPool VulkanDescriptorAllocator::CreatePool(u32 InMaxSets)
+{
+    VkDescriptorPoolSize pool_sizes[std::size(pool_ratios)];
+    for (size_t i = 0; i < std::size(pool_ratios); ++i)
+    {
+        pool_sizes[i] = {pool_ratios[i].first, pool_ratios[i].second * InMaxSets};
+    }
+
+    // No FREE_DESCRIPTOR_SET_BIT, sets are only released by resetting the pool.
+    VkDescriptorPoolCreateInfo pool_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    pool_info.maxSets                    = InMaxSets;
+    pool_info.poolSizeCount              = static_cast<u32>(std::size(pool_sizes));
+    pool_info.pPoolSizes                 = pool_sizes;
+
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    vkcheck(vkCreateDescriptorPool(device, &pool_info, nullptr, &pool));
+
+    ++pools_count;
+    return pool;
+}
+
+void VulkanDescriptorWriter::WriteImage(VkDescriptorSet InSet, u32 InBinding, u32 InArrayElement, VkDescriptorType InType, const VkDescriptorImageInfo& InInfo)
+{
+    VkWriteDescriptorSet write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+    write.dstSet               = InSet;
+    write.dstBinding           = InBinding;
+    write.dstArrayElement      = InArrayElement;
+    write.descriptorCount      = 1;
+    write.descriptorType       = InType;
+
+    writes.push_back(write);
+    image_infos.push_back(InInfo);
+}
+
+void VulkanDescriptorWriter::WriteBuffer(VkDescriptorSet InSet, u32 InBinding, u32 InArrayElement, VkDescriptorType InType, const VkDescriptorBufferInfo& InInfo)
+{
+    VkWriteDescriptorSet write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+    write.dstSet               = InSet;
+    write.dstBinding           = InBinding;
+    write.dstArrayElement      = InArrayElement;
+    write.descriptorCount      = 1;
+    write.descriptorType       = InType;
+
+    writes.push_back(write);
+    buffer_infos.push_back(InInfo);
+}
+
+void VulkanDescriptorWriter::Flush(VkDevice InDevice)
+{
+    if (writes.empty())
+    {
+        return;
+    }
+
+    size_t image_index  = 0;
+    size_t buffer_index = 0;
+    for (VkWriteDescriptorSet& write : writes)
+    {
+        switch (write.descriptorType)
+        {
+            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+                write.pBufferInfo = &buffer_infos[buffer_index++];
+                break;
+            default:
+                write.pImageInfo = &image_infos[image_index++];
+                break;
+        }
+    }
+
+    vkUpdateDescriptorSets(InDevice, static_cast<u32>(writes.size()), writes.data(), 0, nullptr);
+
+    writes.clear();
+    image_infos.clear();
+    buffer_infos.clear();
+}
+
+} // namespace Vk
+} // namespace Renderer
+} // namespace Sogas
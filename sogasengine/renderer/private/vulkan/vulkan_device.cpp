@@ -17,6 +17,8 @@
 
 #include "public/sgs_memory.h"
 
+#include <chrono>
+
 namespace Sogas
 {
 namespace Renderer
@@ -28,6 +30,20 @@ static std::unordered_map<u64, VkRenderPass> render_pass_cache;
 static VulkanCommandBufferResources          commandbuffer_resources;
 
 const std::vector<const char*> validationLayers         = {"VK_LAYER_KHRONOS_validation"};
+
+// Written in front of the driver data, the cache is discarded when the gpu or the driver changed.
+struct PipelineCacheFileHeader
+{
+    u32 magic;
+    u32 vendor_id;
+    u32 device_id;
+    u32 driver_version;
+    u8  uuid[VK_UUID_SIZE];
+    u64 data_size;
+    u64 data_hash;
+};
+
+static const u32 PIPELINE_CACHE_MAGIC = 0x43505053; // SPPC
 const std::vector<const char*> requiredDeviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 
 #ifdef NDEBUG
@@ -91,7 +107,12 @@ bool VulkanDevice::Init(const DeviceDescriptor& InDescriptor)
 {
     STRACE("Initializing Vulkan renderer ... ");
 
-    allocator = InDescriptor.allocator;
+    allocator        = InDescriptor.allocator;
+    frames_in_flight = std::clamp<u32>(InDescriptor.frames_in_flight, 2, MAX_FRAMES_IN_FLIGHT);
+
+    // Kept only if the device supports it.
+    bDynamicRendering = InDescriptor.dynamic_rendering;
+    bIsHeadless       = InDescriptor.headless;
 
     if (!CreateInstance())
     {
@@ -105,6 +126,12 @@ bool VulkanDevice::Init(const DeviceDescriptor& InDescriptor)
         return false;
     }
 
+    memory_allocator.Init(Handle, Physical_device);
+    upload_manager.Init(this);
+
+    LoadPipelineCache(InDescriptor.pipeline_cache_path);
+    shader_compiler.Init(InDescriptor.shader_cache_path ? InDescriptor.shader_cache_path : "");
+
     buffers.Init(allocator, 512, sizeof(VulkanBuffer));
     textures.Init(allocator, 512, sizeof(VulkanTexture));
     renderpasses.Init(allocator, 256, sizeof(VulkanRenderPass));
@@ -126,10 +153,23 @@ bool VulkanDevice::Init(const DeviceDescriptor& InDescriptor)
         }
     }
 
-    GLFWwindow* window = reinterpret_cast<GLFWwindow*>(InDescriptor.window);
-    CreateSwapchain(window);
+    if (bIsHeadless)
+    {
+        swapchain = std::make_shared<VulkanSwapchain>(this);
+        if (!VulkanSwapchain::CreateHeadless(this, swapchain, InDescriptor.width, InDescriptor.height))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        GLFWwindow* window = reinterpret_cast<GLFWwindow*>(InDescriptor.window);
+        CreateSwapchain(window);
+    }
 
     commandbuffer_resources.init(this);
+    descriptor_allocator.Init(Handle, frames_in_flight);
+    gpu_profiler.Init(this, frames_in_flight, InDescriptor.gpu_timestamps, InDescriptor.pipeline_statistics);
 
     static const u32 global_pool_elements = 128;
 
@@ -157,6 +197,11 @@ bool VulkanDevice::Init(const DeviceDescriptor& InDescriptor)
     pool_info.pPoolSizes                 = pool_sizes.data();
     vkcheck(vkCreateDescriptorPool(Handle, &pool_info, nullptr, &descriptor_pool));
 
+    if (bIsBindlessSupported)
+    {
+        CreateBindlessHeap();
+    }
+
     SamplerDescriptor sampler_descriptor{};
     sampler_descriptor
       .SetAddressModeUVW(SamplerDescriptor::SamplerAddressMode::REPEAT, SamplerDescriptor::SamplerAddressMode::REPEAT, SamplerDescriptor::SamplerAddressMode::REPEAT)
@@ -177,6 +222,19 @@ bool VulkanDevice::Init(const DeviceDescriptor& InDescriptor)
 
     swapchain_renderpass = CreateRenderPass(swapchain_renderpass_descriptor);
 
+    // Per frame ring, one partition per frame in flight.
+    dynamic_alignment      = static_cast<u32>(Physical_device_properties.limits.minUniformBufferOffsetAlignment);
+    dynamic_per_frame_size = DYNAMIC_BUFFER_PER_FRAME_SIZE;
+
+    BufferDescriptor dynamic_buffer_descriptor;
+    dynamic_buffer_descriptor.reset()
+      .set(BufferUsage::UNIFORM, BufferType::Dynamic, BufferBindingPoint::Uniform, dynamic_per_frame_size * frames_in_flight)
+      .setName("Dynamic_Persistent_Buffer");
+    dynamic_buffer = CreateBuffer(dynamic_buffer_descriptor);
+
+    dynamic_mapped_memory  = GetBufferResource(dynamic_buffer)->mapped_data;
+    dynamic_allocated_size = 0;
+
     STRACE("Finished Initializing Vulkan device.\n");
 
     return true;
@@ -185,10 +243,23 @@ bool VulkanDevice::Init(const DeviceDescriptor& InDescriptor)
 void VulkanDevice::shutdown()
 {
     STRACE("Shutting down Vulkan renderer ...");
+    SINFO("\tDynamic buffer peak usage: %d of %d bytes per frame.", dynamic_max_per_frame_size, dynamic_per_frame_size);
+    SINFO("\tFrame wait with %d frames in flight: %.3f ms average, %.3f ms peak.", frames_in_flight, FrameCount > 0 ? frame_wait_total_ms / FrameCount : 0.0, frame_wait_max_ms);
+
+    const GPUMemoryStats memory_stats = memory_allocator.GetStats();
+    SINFO("\tDevice memory: %d blocks, %d dedicated allocations, %d KB reserved.", memory_stats.block_count, memory_stats.dedicated_count, static_cast<u32>(memory_stats.reserved_bytes / 1024));
+    SINFO("\tResources placed in %d KB of device local and %d KB of host visible memory.", static_cast<u32>(memory_stats.device_local_bytes / 1024), static_cast<u32>(memory_stats.host_visible_bytes / 1024));
 
     vkDeviceWaitIdle(Handle);
 
+    ResolvePipelines(true);
+    shader_compiler.Shutdown();
+    SINFO("\t%d pipelines compiled in %.3f ms with a %s cache.", pipeline_compile_count.load(), static_cast<f64>(pipeline_compile_us.load()) / 1000.0, bPipelineCacheLoaded ? "warm" : "cold");
+    SavePipelineCache();
+
+    gpu_profiler.Shutdown();
     commandbuffer_resources.shutdown();
+    upload_manager.Shutdown();
 
     for (u32 i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
     {
@@ -198,11 +269,26 @@ void VulkanDevice::shutdown()
     vkDestroySemaphore(Handle, beginSemaphore, nullptr);
     vkDestroySemaphore(Handle, endSemaphore, nullptr);
 
+    FlushDescriptorWrites();
+    descriptor_allocator.Shutdown();
     vkDestroyDescriptorPool(Handle, descriptor_pool, nullptr);
+    vkDestroyDescriptorPool(Handle, bindless_pool, nullptr);
+    bindless_set = VK_NULL_HANDLE;
+
+    if (bindless_layout.index != INVALID_ID)
+    {
+        DestroyDescriptorSetLayoutInstant(bindless_layout.index);
+        bindless_layout = INVALID_DESCRIPTORSETLAYOUT;
+    }
 
     DestroyTexture(depth_texture);
+    if (swapchain->headless_target.index != INVALID_ID)
+    {
+        DestroyTexture(swapchain->headless_target);
+    }
     DestroyRenderPass(swapchain_renderpass);
     DestroySampler(default_sampler);
+    DestroyBuffer(dynamic_buffer);
 
     for (auto& resource : resource_deletion_queue)
     {
@@ -235,6 +321,24 @@ void VulkanDevice::shutdown()
         }
     }
 
+    for (const auto& cached : pipeline_layout_cache)
+    {
+        vkDestroyPipelineLayout(Handle, cached.second, nullptr);
+    }
+    pipeline_layout_cache.clear();
+
+    for (const auto& cached : descriptor_set_layout_cache)
+    {
+        DestroyDescriptorSetLayoutInstant(cached.second.index);
+    }
+    descriptor_set_layout_cache.clear();
+
+    for (const auto& cached : framebuffer_cache)
+    {
+        vkDestroyFramebuffer(Handle, cached.second.framebuffer, nullptr);
+    }
+    framebuffer_cache.clear();
+
     auto it = render_pass_cache.begin();
     while (it != render_pass_cache.end())
     {
@@ -259,6 +363,10 @@ void VulkanDevice::shutdown()
     textures.Shutdown();
     buffers.Shutdown();
 
+    memory_allocator.Shutdown();
+
+    vkDestroyPipelineCache(Handle, pipeline_cache, nullptr);
+
     STRACE("\tDestroying Vulkan logical device ...");
     vkDestroyDevice(Handle, nullptr);
 
@@ -297,6 +405,11 @@ DescriptorSetHandle VulkanDevice::CreateDescriptorSet(const DescriptorSetDescrip
     return VulkanDescriptorSet::Create(this, InDescriptor);
 }
 
+TransientDescriptorSet VulkanDevice::CreateTransientDescriptorSet(const DescriptorSetDescriptor& InDescriptor)
+{
+    return VulkanDescriptorSet::CreateTransient(this, InDescriptor);
+}
+
 DescriptorSetLayoutHandle VulkanDevice::CreateDescriptorSetLayout(const DescriptorSetLayoutDescriptor& InDescriptor)
 {
     return VulkanDescriptorSet::Create(this, InDescriptor);
@@ -312,6 +425,207 @@ RenderPassHandle VulkanDevice::CreateRenderPass(const RenderPassDescriptor& InDe
     return VulkanRenderPass::Create(this, InDescriptor);
 }
 
+PipelineHandle VulkanDevice::CreatePipelineAsync(const PipelineDescriptor& InDescriptor)
+{
+    return VulkanPipeline::Create(this, InDescriptor, true);
+}
+
+bool VulkanDevice::CompileShaders(const ShaderStateDescriptor& InDescriptor)
+{
+    if (InDescriptor.spv_input)
+    {
+        return true;
+    }
+
+    std::vector<u32> spirv;
+    for (u32 i = 0; i < InDescriptor.stages_count; ++i)
+    {
+        const ShaderStage& stage = InDescriptor.stages[i];
+        if (!shader_compiler.Compile(stage.code, stage.size, stage.type, InDescriptor.name, InDescriptor.defines, InDescriptor.include_directory, spirv))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+DescriptorSetLayoutHandle VulkanDevice::GetDescriptorSetLayout(PipelineHandle InHandle, u32 InSetIndex)
+{
+    VulkanPipeline* pipeline = GetPipelineResource(InHandle);
+    if (pipeline == nullptr || InSetIndex >= pipeline->active_layout_count)
+    {
+        return INVALID_DESCRIPTORSETLAYOUT;
+    }
+
+    return pipeline->descriptor_set_layout_handle[InSetIndex];
+}
+
+u32 VulkanDevice::GetBindlessIndex(TextureHandle InHandle)
+{
+    if (bindless_set == VK_NULL_HANDLE || InHandle.index >= textures.pool_size)
+    {
+        return INVALID_ID;
+    }
+
+    return InHandle.index;
+}
+
+u32 VulkanDevice::GetBindlessIndex(BufferHandle InHandle)
+{
+    if (bindless_set == VK_NULL_HANDLE || InHandle.index >= buffers.pool_size)
+    {
+        return INVALID_ID;
+    }
+
+    const VulkanBuffer* buffer = GetBufferResource(InHandle);
+    return (buffer->usage_flags & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) ? InHandle.index : INVALID_ID;
+}
+
+TextureMemoryInfo VulkanDevice::GetTextureMemoryInfo(TextureHandle InHandle)
+{
+    const VulkanTexture* texture = GetTextureResource(InHandle);
+
+    TextureMemoryInfo info;
+    info.size    = texture->allocation.size;
+    info.aliased = texture->alias.index != INVALID_ID;
+    return info;
+}
+
+bool VulkanDevice::ReadbackTexture(TextureHandle InHandle, TextureReadback& OutReadback)
+{
+    SPROFILE_FUNCTION();
+
+    VulkanTexture* texture = GetTextureResource(InHandle);
+    if (texture == nullptr || texture->descriptor.aspect != VK_IMAGE_ASPECT_COLOR_BIT)
+    {
+        SERROR("Only color render targets can be read back.");
+        return false;
+    }
+
+    // Frames still in flight may be writing the texture.
+    vkDeviceWaitIdle(Handle);
+
+    const u16    width  = texture->descriptor.width;
+    const u16    height = texture->descriptor.height;
+    const size_t size   = static_cast<size_t>(width) * height * texture->descriptor.format_stride;
+
+    VkBufferCreateInfo buffer_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    buffer_info.size               = static_cast<VkDeviceSize>(size);
+    buffer_info.usage              = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    buffer_info.sharingMode        = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkBuffer staging_buffer = VK_NULL_HANDLE;
+    vkcheck(vkCreateBuffer(Handle, &buffer_info, nullptr, &staging_buffer));
+
+    VulkanAllocation staging_allocation =
+      memory_allocator.AllocateBuffer(staging_buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    if (!staging_allocation.IsValid())
+    {
+        SERROR("Failed to allocate the readback buffer.");
+        vkDestroyBuffer(Handle, staging_buffer, nullptr);
+        return false;
+    }
+
+    VkCommandBufferBeginInfo begin_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    begin_info.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    VulkanCommandBuffer* cmd = static_cast<VulkanCommandBuffer*>(GetInstantCommandBuffer());
+    vkBeginCommandBuffer(cmd->command_buffer, &begin_info);
+
+    const VkImageLayout original_layout = texture->image_layout;
+
+    VkImageMemoryBarrier image_barrier            = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    image_barrier.srcAccessMask                   = VK_ACCESS_MEMORY_WRITE_BIT;
+    image_barrier.dstAccessMask                   = VK_ACCESS_TRANSFER_READ_BIT;
+    image_barrier.oldLayout                       = original_layout;
+    image_barrier.newLayout                       = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    image_barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    image_barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    image_barrier.image                           = texture->texture;
+    image_barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    image_barrier.subresourceRange.baseMipLevel   = 0;
+    image_barrier.subresourceRange.levelCount     = 1;
+    image_barrier.subresourceRange.baseArrayLayer = 0;
+    image_barrier.subresourceRange.layerCount     = 1;
+
+    vkCmdPipelineBarrier(cmd->command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &image_barrier);
+
+    // Tightly packed rows, the first mip only.
+    VkBufferImageCopy region               = {};
+    region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel       = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount     = 1;
+    region.imageExtent                     = {width, height, 1};
+
+    vkCmdCopyImageToBuffer(cmd->command_buffer, texture->texture, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, staging_buffer, 1, &region);
+
+    // Back to the layout the next frame expects, undefined contents are left readable.
+    if (original_layout != VK_IMAGE_LAYOUT_UNDEFINED)
+    {
+        image_barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        image_barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+        image_barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        image_barrier.newLayout     = original_layout;
+
+        vkCmdPipelineBarrier(cmd->command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &image_barrier);
+    }
+    else
+    {
+        texture->image_layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    }
+
+    VkBufferMemoryBarrier buffer_barrier = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+    buffer_barrier.srcAccessMask         = VK_ACCESS_TRANSFER_WRITE_BIT;
+    buffer_barrier.dstAccessMask         = VK_ACCESS_HOST_READ_BIT;
+    buffer_barrier.srcQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+    buffer_barrier.dstQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+    buffer_barrier.buffer                = staging_buffer;
+    buffer_barrier.offset                = 0;
+    buffer_barrier.size                  = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(cmd->command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &buffer_barrier, 0, nullptr);
+
+    vkEndCommandBuffer(cmd->command_buffer);
+
+    VkSubmitInfo submit_info       = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers    = &cmd->command_buffer;
+
+    vkQueueSubmit(GraphicsQueue, 1, &submit_info, VK_NULL_HANDLE);
+    vkQueueWaitIdle(GraphicsQueue);
+
+    vkResetCommandBuffer(cmd->command_buffer, VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT);
+
+    OutReadback.data.resize(size);
+    memcpy(OutReadback.data.data(), staging_allocation.mapped, size);
+    OutReadback.width  = width;
+    OutReadback.height = height;
+    OutReadback.format = texture->descriptor.generic_format;
+
+    vkDestroyBuffer(Handle, staging_buffer, nullptr);
+    memory_allocator.Free(staging_allocation);
+
+    return true;
+}
+
+bool VulkanDevice::IsPipelineReady(PipelineHandle InHandle)
+{
+    ResolvePipelines(false);
+
+    VulkanPipeline* pipeline = GetPipelineResource(InHandle);
+    return pipeline && pipeline->pipeline != VK_NULL_HANDLE;
+}
+
+bool VulkanDevice::IsPipelineFailed(PipelineHandle InHandle)
+{
+    ResolvePipelines(false);
+
+    VulkanPipeline* pipeline = GetPipelineResource(InHandle);
+    return pipeline && pipeline->bFailed;
+}
+
 void VulkanDevice::DestroyBuffer(BufferHandle InHandle)
 {
     if (InHandle.index < buffers.pool_size)
@@ -415,28 +729,83 @@ void VulkanDevice::DestroyRenderPass(RenderPassHandle InHandle)
 
 void VulkanDevice::BeginFrame()
 {
+    SPROFILE_FUNCTION();
+
     const u32& frame_index = GetFrameIndex();
+    const auto wait_start  = std::chrono::high_resolution_clock::now();
+
+    // Only the frame that used this slot frames_in_flight frames ago is waited for, newer frames keep running.
     if (vkGetFenceStatus(Handle, fence[frame_index]) != VK_SUCCESS)
     {
         vkWaitForFences(Handle, 1, &fence[frame_index], VK_TRUE, UINT64_MAX);
     }
 
-    vkResetFences(Handle, 1, &fence[frame_index]);
+    if (bIsHeadless)
+    {
+        // The single target is always available, frames rendering to it are ordered on the graphics queue.
+        swapchain->imageIndex = 0;
+        bImageAcquired        = true;
+    }
+    else
+    {
+        // Acquired before recording so the submit only waits for the image at the color output stage.
+        VkResult result = vkAcquireNextImageKHR(Handle, swapchain->swapchain, UINT64_MAX, swapchain->imageAcquiredSemaphores[frame_index], VK_NULL_HANDLE, &swapchain->imageIndex);
+        bImageAcquired  = result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR;
+    }
+
+    if (bImageAcquired)
+    {
+        // Images can be returned out of order, a frame from another slot may still be rendering to this one.
+        if (!bIsHeadless)
+        {
+            VkFence& image_fence = swapchain->imageFences[swapchain->imageIndex];
+            if (image_fence != VK_NULL_HANDLE && image_fence != fence[frame_index])
+            {
+                vkWaitForFences(Handle, 1, &image_fence, VK_TRUE, UINT64_MAX);
+            }
+            image_fence = fence[frame_index];
+        }
+
+        // Left signaled when the frame is skipped, the next use of the slot must not wait forever.
+        vkResetFences(Handle, 1, &fence[frame_index]);
+    }
+
+    frame_wait_ms       = std::chrono::duration<f32, std::milli>(std::chrono::high_resolution_clock::now() - wait_start).count();
+    frame_wait_max_ms   = std::max(frame_wait_max_ms, frame_wait_ms);
+    frame_wait_total_ms += frame_wait_ms;
 
     commandbuffer_resources.reset_pools(frame_index);
+    descriptor_allocator.Reset(frame_index);
+    gpu_profiler.Resolve(frame_index);
+
+    upload_manager.Update();
+    ResolvePipelines(false);
+
+    // The gpu is done with this frame partition, allocations restart at its beginning. Usage is measured on the
+    // partition written since the last reset.
+    dynamic_max_per_frame_size = std::max(dynamic_max_per_frame_size, dynamic_allocated_size - dynamic_frame_start);
+    dynamic_frame_start        = dynamic_per_frame_size * frame_index;
+    dynamic_allocated_size     = dynamic_frame_start;
 }
 
 void VulkanDevice::Present()
 {
-    VkResult ok = vkAcquireNextImageKHR(Handle, swapchain->swapchain, UINT64_MAX, swapchain->presentCompleteSemaphore, VK_NULL_HANDLE, &swapchain->imageIndex);
+    SPROFILE_FUNCTION();
 
-    if (ok == VK_ERROR_OUT_OF_DATE_KHR)
+    FlushDescriptorWrites();
+
+    if (!bImageAcquired)
     {
-        // TODO resize
-        ++FrameCount;
+        // The recorded command buffers are dropped when their pools are reset.
+        queued_command_buffers.clear();
+        RecreateSwapchain();
+        AdvanceFrame();
         return;
     }
 
+    const u32   frame_index     = GetFrameIndex();
+    VkSemaphore render_complete = bIsHeadless ? VK_NULL_HANDLE : swapchain->renderCompleteSemaphores[swapchain->imageIndex];
+
     std::vector<VkCommandBuffer> enqueued_command_buffers;
     enqueued_command_buffers.reserve(4);
     for (auto cmd : queued_command_buffers)
@@ -444,111 +813,163 @@ void VulkanDevice::Present()
         VulkanCommandBuffer* vulkan_cmd = static_cast<VulkanCommandBuffer*>(cmd);
         enqueued_command_buffers.push_back(vulkan_cmd->command_buffer);
 
-        if (vulkan_cmd->is_recording && vulkan_cmd->current_renderpass && (vulkan_cmd->current_renderpass->type != RenderPassType::COMPUTE))
+        if (vulkan_cmd->is_recording)
         {
-            vkCmdEndRenderPass(vulkan_cmd->command_buffer);
+            vulkan_cmd->end_pass();
         }
 
         vkEndCommandBuffer(vulkan_cmd->command_buffer);
     }
 
-    VkPipelineStageFlags wait_stages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+    VkSemaphore          wait_semaphores[] = {swapchain->imageAcquiredSemaphores[frame_index], VK_NULL_HANDLE};
+    u64                  wait_values[]     = {0, 0};
+    VkPipelineStageFlags wait_stages[]     = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT};
+    u32                  wait_count        = 1;
+
+    // Uploads recorded this frame go to the transfer queue, the frame waits for them and acquires their ownership first.
+    VkCommandBuffer acquire_command_buffer = VK_NULL_HANDLE;
+    if (upload_manager.PrepareFrameSubmit(frame_index, wait_semaphores[1], wait_values[1], acquire_command_buffer))
+    {
+        wait_count = 2;
+        if (acquire_command_buffer != VK_NULL_HANDLE)
+        {
+            enqueued_command_buffers.insert(enqueued_command_buffers.begin(), acquire_command_buffer);
+        }
+    }
+
+    // Headless frames have no image to wait for nor to present, only the uploads are waited.
+    const u32 first_wait = bIsHeadless ? 1 : 0;
 
-    VkSubmitInfo submit         = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
-    submit.waitSemaphoreCount   = 1;
-    submit.pWaitSemaphores      = &swapchain->presentCompleteSemaphore;
-    submit.signalSemaphoreCount = 1;
-    submit.pSignalSemaphores    = &swapchain->renderCompleteSemaphore;
+    VkTimelineSemaphoreSubmitInfo timeline_submit = {VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+    timeline_submit.waitSemaphoreValueCount       = wait_count - first_wait;
+    timeline_submit.pWaitSemaphoreValues          = wait_values + first_wait;
+
+    VkSubmitInfo submit         = {VK_STRUCTURE_TYPE_SUBMIT_INFO, &timeline_submit};
+    submit.waitSemaphoreCount   = wait_count - first_wait;
+    submit.pWaitSemaphores      = wait_semaphores + first_wait;
+    submit.signalSemaphoreCount = bIsHeadless ? 0 : 1;
+    submit.pSignalSemaphores    = &render_complete;
     submit.commandBufferCount   = static_cast<u32>(enqueued_command_buffers.size());
     submit.pCommandBuffers      = enqueued_command_buffers.data();
-    submit.pWaitDstStageMask    = wait_stages;
-
-    vkQueueSubmit(GraphicsQueue, 1, &submit, fence[GetFrameIndex()]);
+    submit.pWaitDstStageMask    = wait_stages + first_wait;
 
-    VkPresentInfoKHR present_info   = {VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
-    present_info.swapchainCount     = 1;
-    present_info.pSwapchains        = &swapchain->swapchain;
-    present_info.waitSemaphoreCount = 1;
-    present_info.pWaitSemaphores    = &swapchain->renderCompleteSemaphore;
-    present_info.pImageIndices      = &swapchain->imageIndex;
+    vkQueueSubmit(GraphicsQueue, 1, &submit, fence[frame_index]);
+    gpu_profiler.Submit(frame_index);
 
-    ok = vkQueuePresentKHR(GraphicsQueue, &present_info);
+    VkResult ok = VK_SUCCESS;
+    if (!bIsHeadless)
+    {
+        VkPresentInfoKHR present_info   = {VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
+        present_info.swapchainCount     = 1;
+        present_info.pSwapchains        = &swapchain->swapchain;
+        present_info.waitSemaphoreCount = 1;
+        present_info.pWaitSemaphores    = &render_complete;
+        present_info.pImageIndices      = &swapchain->imageIndex;
+
+        ok = vkQueuePresentKHR(GraphicsQueue, &present_info);
+    }
 
     queued_command_buffers.clear();
 
     if (ok == VK_ERROR_OUT_OF_DATE_KHR || ok == VK_SUBOPTIMAL_KHR || resized)
     {
-        resized = false;
-
-        // TODO resized swapchain.
-        ++FrameCount;
-        return;
+        RecreateSwapchain();
     }
 
+    AdvanceFrame();
+}
+
+void VulkanDevice::AdvanceFrame()
+{
     ++FrameCount;
 
-    // Resource deletion here ...
-    if (!resource_deletion_queue.empty())
+    // Resources are destroyed once every frame that could use them has finished on the gpu. BeginFrame waited for
+    // the frame frames_in_flight frames before the one just submitted. The order is kept, a pipeline must go before
+    // its shader state.
+    size_t kept = 0;
+    for (size_t i = 0; i < resource_deletion_queue.size(); ++i)
     {
-        for (auto& resource : resource_deletion_queue)
+        const ResourceUpdate resource = resource_deletion_queue[i];
+        if (resource.current_frame + frames_in_flight >= GetFrameCount())
         {
-            if (resource.current_frame == GetFrameCount())
-            {
-                switch (resource.type)
-                {
-                    case ResourceType::BUFFER:
-                        DestroyBufferInstant(resource.handle);
-                        break;
-                    case ResourceType::TEXTURE:
-                        DestroyTextureInstant(resource.handle);
-                        break;
-                    case ResourceType::SHADER:
-                        DestroyShaderStateInstant(resource.handle);
-                        break;
-                    case ResourceType::SAMPLER:
-                        DestroySamplerInstant(resource.handle);
-                        break;
-                    case ResourceType::DESCRIPTOR_SET:
-                        DestroyDescriptorSetInstant(resource.handle);
-                        break;
-                    case ResourceType::DESCRIPTOR_SET_LAYOUT:
-                        DestroyDescriptorSetLayoutInstant(resource.handle);
-                        break;
-                    case ResourceType::PIPELINE:
-                        DestroyPipelineInstant(resource.handle);
-                        break;
-                    case ResourceType::RENDERPASS:
-                        DestroyRenderPassInstant(resource.handle);
-                        break;
-                }
-            }
+            resource_deletion_queue[kept++] = resource;
+            continue;
         }
 
-        resource_deletion_queue.clear();
+        switch (resource.type)
+        {
+            case ResourceType::BUFFER:
+                DestroyBufferInstant(resource.handle);
+                break;
+            case ResourceType::TEXTURE:
+                DestroyTextureInstant(resource.handle);
+                break;
+            case ResourceType::SHADER:
+                DestroyShaderStateInstant(resource.handle);
+                break;
+            case ResourceType::SAMPLER:
+                DestroySamplerInstant(resource.handle);
+                break;
+            case ResourceType::DESCRIPTOR_SET:
+                DestroyDescriptorSetInstant(resource.handle);
+                break;
+            case ResourceType::DESCRIPTOR_SET_LAYOUT:
+                DestroyDescriptorSetLayoutInstant(resource.handle);
+                break;
+            case ResourceType::PIPELINE:
+                DestroyPipelineInstant(resource.handle);
+                break;
+            case ResourceType::RENDERPASS:
+                DestroyRenderPassInstant(resource.handle);
+                break;
+        }
     }
+
+    resource_deletion_queue.resize(kept);
 }
 
-void* VulkanDevice::MapBuffer(const BufferHandle& InHandle, u32 size, u32 offset)
+DynamicAllocation VulkanDevice::AllocateDynamic(u32 size)
 {
-    auto buffer = GetBufferResource(InHandle);
+    DynamicAllocation allocation;
 
-    void* data = nullptr;
-    if (buffer != nullptr)
+    const u32 aligned_size = (size + dynamic_alignment - 1) & ~(dynamic_alignment - 1);
+    const u32 frame_end    = dynamic_per_frame_size * (GetFrameIndex() + 1);
+    if (dynamic_allocated_size + aligned_size > frame_end)
     {
-        vkMapMemory(Handle, buffer->memory, offset, size, 0, &data);
+        SERROR("Dynamic buffer out of memory, %d bytes requested.", size);
+        return allocation;
     }
 
-    return data;
+    allocation.data   = dynamic_mapped_memory + dynamic_allocated_size;
+    allocation.offset = dynamic_allocated_size;
+    dynamic_allocated_size += aligned_size;
+
+    return allocation;
 }
 
-void VulkanDevice::UnmapBuffer(const BufferHandle& InHandle)
+BufferHandle VulkanDevice::GetDynamicBuffer() const
+{
+    return dynamic_buffer;
+}
+
+void* VulkanDevice::MapBuffer(const BufferHandle& InHandle, u32 size, u32 offset)
 {
     auto buffer = GetBufferResource(InHandle);
 
-    if (buffer)
+    // Memory blocks are shared between buffers and can't be mapped twice, host visible blocks are mapped once at creation.
+    if (buffer == nullptr || buffer->mapped_data == nullptr)
     {
-        vkUnmapMemory(Handle, buffer->memory);
+        SERROR("Buffer memory is not host visible.");
+        return nullptr;
     }
+
+    SASSERT(offset + size <= buffer->size);
+    return buffer->mapped_data + offset;
+}
+
+void VulkanDevice::UnmapBuffer(const BufferHandle& /*InHandle*/)
+{
+    // Buffers stay mapped until destroyed.
 }
 
 std::vector<i8> VulkanDevice::ReadShaderBinary(std::string InFilename)
@@ -563,7 +984,13 @@ char* VulkanDevice::ReadShader(std::string InFilename, u32& OutSize)
 
 CommandBuffer* VulkanDevice::GetCommandBuffer(bool begin)
 {
-    return commandbuffer_resources.get_command_buffer(GetFrameIndex(), begin);
+    VulkanCommandBuffer* cmd = commandbuffer_resources.get_command_buffer(GetFrameIndex(), begin);
+    if (begin)
+    {
+        gpu_profiler.BeginCommandBuffer(cmd->command_buffer, GetFrameIndex());
+    }
+
+    return cmd;
 }
 
 CommandBuffer* VulkanDevice::GetInstantCommandBuffer()
@@ -576,6 +1003,22 @@ void VulkanDevice::QueueCommandBuffer(CommandBuffer* cmd)
     queued_command_buffers.push_back(cmd);
 }
 
+CommandBuffer* VulkanDevice::GetSecondaryCommandBuffer(u32 thread_index, CommandBuffer* primary)
+{
+    VulkanCommandBuffer* secondary = commandbuffer_resources.get_secondary_command_buffer(GetFrameIndex(), thread_index);
+    if (secondary)
+    {
+        secondary->begin_secondary(static_cast<VulkanCommandBuffer*>(primary));
+    }
+
+    return secondary;
+}
+
+u32 VulkanDevice::GetMaxRecordingThreads() const
+{
+    return VulkanCommandBufferResources::MAX_THREADS;
+}
+
 GraphicsAPI VulkanDevice::getApiType() const
 {
     return api_type;
@@ -596,9 +1039,112 @@ const u32 VulkanDevice::GetFrameCount() const
     return FrameCount;
 }
 
-const u32 VulkanDevice::GetFrameIndex() const
+u32 VulkanDevice::GetFrameIndex() const
+{
+    return GetFrameCount() % frames_in_flight;
+}
+
+u32 VulkanDevice::GetFramesInFlight() const
+{
+    return frames_in_flight;
+}
+
+f32 VulkanDevice::GetFrameWaitMs() const
+{
+    return frame_wait_ms;
+}
+
+GPUMemoryStats VulkanDevice::GetMemoryStats() const
+{
+    return memory_allocator.GetStats();
+}
+
+u32 VulkanDevice::Defragment(u32 InMaxMoves)
+{
+    SPROFILE_FUNCTION();
+
+    // Nothing may use the moved buffers, uploads to them included.
+    upload_manager.WaitIdle();
+    vkDeviceWaitIdle(Handle);
+
+    VkCommandBufferBeginInfo begin_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    begin_info.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    // Allocations are tagged with the buffer or texture owning them. Only vertex and index buffers are moved, they
+    // are looked up by handle when bound. Descriptors would keep pointing to the old VkBuffer, and textures have views
+    // and layouts to rebuild.
+    const u8* buffers_begin = buffers.memory;
+    const u8* buffers_end   = buffers.memory + static_cast<size_t>(buffers.pool_size) * buffers.resource_size;
+    auto      move          = [&](void* user_data, const VulkanAllocation& from, const VulkanAllocation& to)
+    {
+        const u8* owner = static_cast<const u8*>(user_data);
+        if (owner < buffers_begin || owner >= buffers_end)
+        {
+            return false;
+        }
+
+        VulkanBuffer* buffer = static_cast<VulkanBuffer*>(user_data);
+        if ((buffer->usage_flags & ~(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT)) != 0 || upload_manager.HasPendingAcquire(buffer->buffer))
+        {
+            return false;
+        }
+
+        VkBufferCreateInfo buffer_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+        buffer_info.usage              = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | buffer->usage_flags;
+        buffer_info.size               = buffer->size > 0 ? buffer->size : 1;
+
+        VkBuffer moved = VK_NULL_HANDLE;
+        if (vkCreateBuffer(Handle, &buffer_info, nullptr, &moved) != VK_SUCCESS)
+        {
+            return false;
+        }
+        if (vkBindBufferMemory(Handle, moved, to.memory, to.offset) != VK_SUCCESS)
+        {
+            vkDestroyBuffer(Handle, moved, nullptr);
+            return false;
+        }
+
+        // The old block may be released as soon as this returns, the copy is waited for.
+        if (from.mapped && to.mapped)
+        {
+            memcpy(to.mapped, from.mapped, buffer_info.size);
+        }
+        else
+        {
+            VulkanCommandBuffer* cmd = static_cast<VulkanCommandBuffer*>(GetInstantCommandBuffer());
+            vkBeginCommandBuffer(cmd->command_buffer, &begin_info);
+
+            const VkBufferCopy region = {0, 0, buffer_info.size};
+            vkCmdCopyBuffer(cmd->command_buffer, buffer->buffer, moved, 1, &region);
+
+            vkEndCommandBuffer(cmd->command_buffer);
+
+            VkSubmitInfo submit_info       = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+            submit_info.commandBufferCount = 1;
+            submit_info.pCommandBuffers    = &cmd->command_buffer;
+
+            vkQueueSubmit(GraphicsQueue, 1, &submit_info, VK_NULL_HANDLE);
+            vkQueueWaitIdle(GraphicsQueue);
+
+            vkResetCommandBuffer(cmd->command_buffer, VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT);
+        }
+
+        vkDestroyBuffer(Handle, buffer->buffer, nullptr);
+        buffer->buffer     = moved;
+        buffer->allocation = to;
+
+        // Same rule as creation, only coherent memory is written through the mapping.
+        const VkMemoryPropertyFlags placement = memory_allocator.GetMemoryProperties(to.memory_type);
+        buffer->mapped_data                   = (placement & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) ? to.mapped : nullptr;
+        return true;
+    };
+
+    return memory_allocator.Defragment(InMaxMoves, move);
+}
+
+const std::vector<GPUZoneTiming>& VulkanDevice::GetGpuTimings() const
 {
-    return GetFrameCount() % MAX_FRAMES_IN_FLIGHT;
+    return gpu_profiler.GetTimings();
 }
 
 RenderPassHandle VulkanDevice::GetSwapchainRenderpass()
@@ -611,9 +1157,24 @@ const RenderPassOutput& VulkanDevice::GetSwapchainOutput() const
     return swapchain->output;
 }
 
+TextureHandle VulkanDevice::GetBackbufferTexture() const
+{
+    return swapchain->headless_target;
+}
+
+// Only the formats in use and the operations, the rest of the struct may be uninitialized.
+static u64 HashRenderPassOutput(const RenderPassOutput& InOutput)
+{
+    u64 hashed = wyhash(InOutput.ColorFormats, sizeof(Format) * InOutput.ColorFormatCounts, InOutput.ColorFormatCounts, _wyp);
+    hashed     = wyhash(&InOutput.DepthStencilFormat, sizeof(Format), hashed, _wyp);
+
+    const RenderPassOperation operations[] = {InOutput.ColorOperation, InOutput.DepthOperation, InOutput.StencilOperation};
+    return wyhash(operations, sizeof(operations), hashed, _wyp);
+}
+
 VkRenderPass VulkanDevice::GetVulkanRenderPass(const RenderPassOutput& InOutput, std::string InName)
 {
-    u64          hashed      = wyhash((void*)&InOutput, sizeof(RenderPassOutput), 0, _wyp);
+    u64          hashed      = HashRenderPassOutput(InOutput);
     VkRenderPass render_pass = render_pass_cache.find(hashed) != render_pass_cache.end() ? render_pass_cache.at(hashed) : nullptr;
     if (render_pass)
     {
@@ -626,6 +1187,123 @@ VkRenderPass VulkanDevice::GetVulkanRenderPass(const RenderPassOutput& InOutput,
     return render_pass;
 }
 
+VkFramebuffer VulkanDevice::GetFramebuffer(const VulkanRenderPass* InRenderPass)
+{
+    CachedFramebuffer entry;
+    for (u32 i = 0; i < InRenderPass->render_targets_count; ++i)
+    {
+        entry.views[entry.views_count++] = GetTextureResource(InRenderPass->output_texture[i])->image_view;
+    }
+
+    if (InRenderPass->depth_texture.index != INVALID_ID)
+    {
+        entry.views[entry.views_count++] = GetTextureResource(InRenderPass->depth_texture)->image_view;
+    }
+
+    const u32 size[] = {InRenderPass->width, InRenderPass->heigh};
+
+    u64 hashed = wyhash(&InRenderPass->renderpass, sizeof(VkRenderPass), entry.views_count, _wyp);
+    hashed     = wyhash(entry.views, sizeof(VkImageView) * entry.views_count, hashed, _wyp);
+    hashed     = wyhash(size, sizeof(size), hashed, _wyp);
+
+    auto it = framebuffer_cache.find(hashed);
+    if (it != framebuffer_cache.end())
+    {
+        return it->second.framebuffer;
+    }
+
+    VkFramebufferCreateInfo framebuffer_info = {VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
+    framebuffer_info.renderPass              = InRenderPass->renderpass;
+    framebuffer_info.attachmentCount         = entry.views_count;
+    framebuffer_info.pAttachments            = entry.views;
+    framebuffer_info.width                   = InRenderPass->width;
+    framebuffer_info.height                  = InRenderPass->heigh;
+    framebuffer_info.layers                  = 1;
+
+    vkcheck(vkCreateFramebuffer(Handle, &framebuffer_info, nullptr, &entry.framebuffer));
+
+    framebuffer_cache.insert({hashed, entry});
+    return entry.framebuffer;
+}
+
+void VulkanDevice::EvictFramebuffers(VkImageView InView)
+{
+    auto it = framebuffer_cache.begin();
+    while (it != framebuffer_cache.end())
+    {
+        const CachedFramebuffer& entry = it->second;
+        if (std::find(entry.views, entry.views + entry.views_count, InView) != entry.views + entry.views_count)
+        {
+            // Destroyed with the texture, after the gpu finished the frames using it.
+            vkDestroyFramebuffer(Handle, entry.framebuffer, nullptr);
+            it = framebuffer_cache.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+DescriptorSetLayoutHandle VulkanDevice::GetCachedDescriptorSetLayout(const DescriptorSetLayoutDescriptor& InDescriptor)
+{
+    u64 hashed = wyhash(&InDescriptor.set_index, sizeof(InDescriptor.set_index), InDescriptor.bindings_count, _wyp);
+    for (u32 i = 0; i < InDescriptor.bindings_count; ++i)
+    {
+        const DescriptorSetLayoutDescriptor::Binding& binding = InDescriptor.bindings[i];
+        const u32                                     packed[] = {static_cast<u32>(binding.type), binding.start, binding.count};
+        hashed = wyhash(packed, sizeof(packed), hashed, _wyp);
+    }
+
+    auto cached = descriptor_set_layout_cache.find(hashed);
+    if (cached != descriptor_set_layout_cache.end())
+    {
+        return cached->second;
+    }
+
+    DescriptorSetLayoutHandle handle = CreateDescriptorSetLayout(InDescriptor);
+    if (handle.index != INVALID_ID)
+    {
+        descriptor_set_layout_cache.emplace(hashed, handle);
+    }
+
+    return handle;
+}
+
+VkPipelineLayout VulkanDevice::GetCachedPipelineLayout(const VulkanDescriptorSetLayout* const* InLayouts, u32 InLayoutsCount, const VkPushConstantRange& InPushConstants)
+{
+    // Keyed by the layout contents rather than their handles, identically defined set layouts are compatible.
+    u64 hashed = wyhash(&InPushConstants, sizeof(VkPushConstantRange), InLayoutsCount, _wyp);
+    for (u32 i = 0; i < InLayoutsCount; ++i)
+    {
+        hashed = wyhash(&InLayouts[i]->hash, sizeof(u64), hashed, _wyp);
+    }
+
+    auto cached = pipeline_layout_cache.find(hashed);
+    if (cached != pipeline_layout_cache.end())
+    {
+        return cached->second;
+    }
+
+    VkDescriptorSetLayout layouts[MAX_DESCRIPTOR_SET_LAYOUTS];
+    for (u32 i = 0; i < InLayoutsCount; ++i)
+    {
+        layouts[i] = InLayouts[i]->descriptor_set_layout;
+    }
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info = {VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    pipeline_layout_info.pSetLayouts                = layouts;
+    pipeline_layout_info.setLayoutCount             = InLayoutsCount;
+    pipeline_layout_info.pPushConstantRanges        = &InPushConstants;
+    pipeline_layout_info.pushConstantRangeCount     = InPushConstants.size > 0 ? 1 : 0;
+
+    VkPipelineLayout pipeline_layout;
+    vkcheck(vkCreatePipelineLayout(Handle, &pipeline_layout_info, nullptr, &pipeline_layout));
+
+    pipeline_layout_cache.emplace(hashed, pipeline_layout);
+    return pipeline_layout;
+}
+
 const VkQueue VulkanDevice::GetGraphicsQueue()
 {
     return GraphicsQueue;
@@ -640,6 +1318,269 @@ VulkanSampler* VulkanDevice::GetDefaultSampler()
 // | PRIVATE |
 // +---------+
 
+void VulkanDevice::LoadPipelineCache(const char* InPath)
+{
+    std::vector<u8> file_data;
+
+    FILE* file = nullptr;
+    if (InPath)
+    {
+        pipeline_cache_path = InPath;
+        fopen_s(&file, InPath, "rb");
+    }
+
+    if (file)
+    {
+        fseek(file, 0, SEEK_END);
+        const size_t file_size = ftell(file);
+        rewind(file);
+
+        file_data.resize(file_size);
+        if (fread(file_data.data(), 1, file_size, file) != file_size)
+        {
+            file_data.clear();
+        }
+
+        fclose(file);
+    }
+
+    const void* initial_data      = nullptr;
+    size_t      initial_data_size = 0;
+
+    if (file_data.size() > sizeof(PipelineCacheFileHeader))
+    {
+        PipelineCacheFileHeader header;
+        memcpy(&header, file_data.data(), sizeof(header));
+
+        const u8*    data      = file_data.data() + sizeof(header);
+        const size_t data_size = file_data.size() - sizeof(header);
+
+        const bool bSameDevice = header.magic == PIPELINE_CACHE_MAGIC && header.vendor_id == Physical_device_properties.vendorID && header.device_id == Physical_device_properties.deviceID &&
+                                 header.driver_version == Physical_device_properties.driverVersion && memcmp(header.uuid, Physical_device_properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+        const bool bIntact = header.data_size == data_size && header.data_hash == wyhash(data, data_size, 0, _wyp);
+
+        if (bSameDevice && bIntact)
+        {
+            initial_data      = data;
+            initial_data_size = data_size;
+        }
+        else
+        {
+            STRACE("\tPipeline cache '%s' discarded, %s.", InPath, bSameDevice ? "data is corrupted" : "gpu or driver changed");
+        }
+    }
+
+    VkPipelineCacheCreateInfo cache_info = {VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+    cache_info.initialDataSize           = initial_data_size;
+    cache_info.pInitialData              = initial_data;
+
+    // Drivers may still reject data written by another version, start empty then.
+    if (vkCreatePipelineCache(Handle, &cache_info, nullptr, &pipeline_cache) != VK_SUCCESS && initial_data)
+    {
+        cache_info.initialDataSize = 0;
+        cache_info.pInitialData    = nullptr;
+        initial_data               = nullptr;
+        vkcheck(vkCreatePipelineCache(Handle, &cache_info, nullptr, &pipeline_cache));
+    }
+
+    bPipelineCacheLoaded = initial_data != nullptr;
+    if (bPipelineCacheLoaded)
+    {
+        STRACE("\tPipeline cache loaded, %d KB.", static_cast<u32>(initial_data_size / 1024));
+    }
+}
+
+void VulkanDevice::SavePipelineCache()
+{
+    if (pipeline_cache == VK_NULL_HANDLE || pipeline_cache_path.empty())
+    {
+        return;
+    }
+
+    size_t data_size = 0;
+    if (vkGetPipelineCacheData(Handle, pipeline_cache, &data_size, nullptr) != VK_SUCCESS || data_size == 0)
+    {
+        return;
+    }
+
+    std::vector<u8> file_data(sizeof(PipelineCacheFileHeader) + data_size);
+    u8*             data = file_data.data() + sizeof(PipelineCacheFileHeader);
+    if (vkGetPipelineCacheData(Handle, pipeline_cache, &data_size, data) != VK_SUCCESS)
+    {
+        return;
+    }
+
+    PipelineCacheFileHeader header = {};
+    header.magic                   = PIPELINE_CACHE_MAGIC;
+    header.vendor_id               = Physical_device_properties.vendorID;
+    header.device_id               = Physical_device_properties.deviceID;
+    header.driver_version          = Physical_device_properties.driverVersion;
+    header.data_size               = data_size;
+    header.data_hash               = wyhash(data, data_size, 0, _wyp);
+    memcpy(header.uuid, Physical_device_properties.pipelineCacheUUID, VK_UUID_SIZE);
+    memcpy(file_data.data(), &header, sizeof(header));
+
+    // Written aside and renamed, a crash while saving never leaves a truncated cache behind.
+    const std::string temp_path = pipeline_cache_path + ".tmp";
+
+    FILE* file = nullptr;
+    fopen_s(&file, temp_path.c_str(), "wb");
+    if (!file)
+    {
+        SWARNING("Could not write pipeline cache '%s'.", temp_path.c_str());
+        return;
+    }
+
+    const bool bWritten = fwrite(file_data.data(), 1, file_data.size(), file) == file_data.size();
+    const bool bClosed  = fclose(file) == 0;
+    if (!bWritten || !bClosed)
+    {
+        SWARNING("Could not write pipeline cache '%s'.", temp_path.c_str());
+        std::remove(temp_path.c_str());
+        return;
+    }
+
+    // Renaming over an existing file fails on Windows, the previous cache is kept aside until the new one is in place.
+    const std::string previous_path = pipeline_cache_path + ".old";
+    std::remove(previous_path.c_str());
+    const bool bHadPrevious = std::rename(pipeline_cache_path.c_str(), previous_path.c_str()) == 0;
+
+    if (std::rename(temp_path.c_str(), pipeline_cache_path.c_str()) != 0)
+    {
+        SWARNING("Could not write pipeline cache '%s'.", pipeline_cache_path.c_str());
+        std::remove(temp_path.c_str());
+        if (bHadPrevious)
+        {
+            std::rename(previous_path.c_str(), pipeline_cache_path.c_str());
+        }
+        return;
+    }
+
+    std::remove(previous_path.c_str());
+
+    STRACE("\tPipeline cache saved, %d KB.", static_cast<u32>(data_size / 1024));
+}
+
+void VulkanDevice::CreateBindlessHeap()
+{
+    VkPhysicalDeviceDescriptorIndexingProperties indexing_properties = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES};
+    VkPhysicalDeviceProperties2                  properties          = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, &indexing_properties};
+    vkGetPhysicalDeviceProperties2(Physical_device, &properties);
+
+    const u32 texture_count = textures.pool_size;
+    const u32 buffer_count  = buffers.pool_size;
+
+    if (texture_count > indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages ||
+        texture_count > indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers ||
+        buffer_count > indexing_properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers)
+    {
+        SWARNING("\tThe bindless heap exceeds the device limits, resources are bound with descriptor sets.");
+        bIsBindlessSupported = false;
+        return;
+    }
+
+    VkDescriptorPoolSize pool_sizes[] = {
+      {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, texture_count},
+      {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, buffer_count}};
+
+    VkDescriptorPoolCreateInfo pool_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    pool_info.flags                      = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    pool_info.maxSets                    = 1;
+    pool_info.poolSizeCount              = 2;
+    pool_info.pPoolSizes                 = pool_sizes;
+    vkcheck(vkCreateDescriptorPool(Handle, &pool_info, nullptr, &bindless_pool));
+
+    DescriptorSetLayoutDescriptor layout_descriptor;
+    layout_descriptor.SetSetIndex(BINDLESS_SET_INDEX).SetBindless(true).SetName("Bindless");
+    layout_descriptor.AddBinding({DescriptorType::COMBINED_IMAGE_SAMPLER, BINDLESS_TEXTURE_BINDING, static_cast<u16>(texture_count), "Textures"});
+    layout_descriptor.AddBinding({DescriptorType::STORAGE_BUFFER, BINDLESS_BUFFER_BINDING, static_cast<u16>(buffer_count), "Buffers"});
+    bindless_layout = CreateDescriptorSetLayout(layout_descriptor);
+
+    VkDescriptorSetAllocateInfo allocate_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    allocate_info.descriptorPool              = bindless_pool;
+    allocate_info.descriptorSetCount          = 1;
+    allocate_info.pSetLayouts                 = &GetDescriptorSetLayoutResource(bindless_layout)->descriptor_set_layout;
+    vkcheck(vkAllocateDescriptorSets(Handle, &allocate_info, &bindless_set));
+
+    STRACE("\tBindless heap with %d textures and %d storage buffers.", texture_count, buffer_count);
+}
+
+void VulkanDevice::WriteBindlessDescriptor(ResourceType InType, ResourceHandle InHandle)
+{
+    if (bindless_set == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    // Written with the next flush, at the latest before the frame is submitted.
+    std::lock_guard<std::mutex> lock(descriptor_writes_mutex);
+    if (InType == ResourceType::TEXTURE)
+    {
+        const VulkanTexture* texture = GetTextureResource({InHandle});
+
+        VkDescriptorImageInfo info = {};
+        info.sampler               = texture->sampler ? texture->sampler->sampler : GetDefaultSampler()->sampler;
+        info.imageView             = texture->image_view;
+        info.imageLayout           = HasDepthOrStencil(texture->descriptor.generic_format) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+        descriptor_writer.WriteImage(bindless_set, BINDLESS_TEXTURE_BINDING, InHandle, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, info);
+    }
+    else
+    {
+        const VkDescriptorBufferInfo info = {GetBufferResource({InHandle})->buffer, 0, VK_WHOLE_SIZE};
+        descriptor_writer.WriteBuffer(bindless_set, BINDLESS_BUFFER_BINDING, InHandle, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, info);
+    }
+}
+
+void VulkanDevice::FlushDescriptorWrites()
+{
+    std::lock_guard<std::mutex> lock(descriptor_writes_mutex);
+    descriptor_writer.Flush(Handle);
+}
+
+void VulkanDevice::QueuePipelineCompile(PipelineHandle InHandle, std::future<VkPipeline> InResult)
+{
+    std::lock_guard<std::mutex> lock(pending_pipelines_mutex);
+    pending_pipelines.push_back({InHandle, std::move(InResult)});
+}
+
+void VulkanDevice::ResolvePipelines(bool bWait)
+{
+    std::lock_guard<std::mutex> lock(pending_pipelines_mutex);
+
+    for (auto it = pending_pipelines.begin(); it != pending_pipelines.end();)
+    {
+        if (bWait || it->result.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            VulkanPipeline* pipeline = GetPipelineResource(it->handle);
+            pipeline->pipeline       = it->result.get();
+            pipeline->bFailed        = pipeline->pipeline == VK_NULL_HANDLE;
+            it                       = pending_pipelines.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void VulkanDevice::WaitForPipeline(PipelineHandle InHandle)
+{
+    std::lock_guard<std::mutex> lock(pending_pipelines_mutex);
+
+    for (auto it = pending_pipelines.begin(); it != pending_pipelines.end(); ++it)
+    {
+        if (it->handle.index == InHandle.index)
+        {
+            VulkanPipeline* pipeline = GetPipelineResource(it->handle);
+            pipeline->pipeline       = it->result.get();
+            pipeline->bFailed        = pipeline->pipeline == VK_NULL_HANDLE;
+            pending_pipelines.erase(it);
+            return;
+        }
+    }
+}
+
 bool VulkanDevice::CreateInstance()
 {
     STRACE("\tCreating the Vulkan Instance ...");
@@ -670,7 +1611,8 @@ bool VulkanDevice::CreateInstance()
     }
     std::cout << "\t-- \t -- \t -- \n";
 
-    SASSERT(glfwExtensions.empty() == false);
+    // Headless devices need no surface extensions.
+    SASSERT(bIsHeadless || glfwExtensions.empty() == false);
     if (validationLayersEnabled)
     {
         glfwExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -763,8 +1705,22 @@ bool VulkanDevice::CreateDevice()
         ++i;
     }
 
+    // A transfer only family runs uploads in parallel with rendering, otherwise they go to the graphics queue.
+    TransferFamily = GraphicsFamily;
+    i              = 0;
+    for (const auto& queueFamily : queueFamilyProperties)
+    {
+        if (queueFamily.queueCount > 0 && (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+            !(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+        {
+            TransferFamily = i;
+            break;
+        }
+        ++i;
+    }
+
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-    std::set<u32>                        uniqueQueueFamilies = {GraphicsFamily};
+    std::set<u32>                        uniqueQueueFamilies = {GraphicsFamily, TransferFamily};
 
     f32 queuePriority = 1.0f;
     for (u32 queueFamily : uniqueQueueFamilies)
@@ -777,27 +1733,81 @@ bool VulkanDevice::CreateDevice()
         queueFamilies.push_back(queueFamily);
     }
 
+    VkPhysicalDeviceDynamicRenderingFeatures dynamic_rendering_features{
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES,
+      nullptr};
+
+    // Core in Vulkan 1.3, older devices are not queried for it.
+    const bool bIsVulkan13 = Physical_device_properties.apiVersion >= VK_API_VERSION_1_3;
+
+    VkPhysicalDeviceTimelineSemaphoreFeatures timeline_features{
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES,
+      bIsVulkan13 ? &dynamic_rendering_features : nullptr};
+
     VkPhysicalDeviceDescriptorIndexingFeatures indexing_features{
       VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES,
-      nullptr};
+      &timeline_features};
 
     VkPhysicalDeviceFeatures2 physical_features2 = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &indexing_features};
     vkGetPhysicalDeviceFeatures2(Physical_device, &physical_features2);
 
+    // The heap is written while bound, textures and storage buffers need update after bind. Shaders index it with
+    // push constant values, which needs dynamic indexing of sampled image arrays.
     bIsBindlessSupported =
-      indexing_features.descriptorBindingPartiallyBound && indexing_features.runtimeDescriptorArray;
+      indexing_features.descriptorBindingPartiallyBound && indexing_features.runtimeDescriptorArray &&
+      indexing_features.descriptorBindingSampledImageUpdateAfterBind && indexing_features.descriptorBindingStorageBufferUpdateAfterBind &&
+      indexing_features.descriptorBindingUpdateUnusedWhilePending && physical_features2.features.shaderSampledImageArrayDynamicIndexing;
+
+    bDynamicRendering = bDynamicRendering && bIsVulkan13 && dynamic_rendering_features.dynamicRendering;
+    if (!bDynamicRendering)
+    {
+        timeline_features.pNext = nullptr;
+    }
+    STRACE("\tRendering with %s.", bDynamicRendering ? "dynamic rendering" : "render pass objects");
 
     VkDeviceCreateInfo deviceCreateInfo      = {VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
     deviceCreateInfo.queueCreateInfoCount    = static_cast<u32>(queueCreateInfos.size());
     deviceCreateInfo.pQueueCreateInfos       = queueCreateInfos.data();
-    deviceCreateInfo.enabledExtensionCount   = static_cast<u32>(requiredDeviceExtensions.size());
+    deviceCreateInfo.enabledExtensionCount   = bIsHeadless ? 0 : static_cast<u32>(requiredDeviceExtensions.size());
     deviceCreateInfo.ppEnabledExtensionNames = requiredDeviceExtensions.data();
 
+    // Uploads signal a timeline semaphore, mandatory since Vulkan 1.2.
+    SASSERT_MSG(timeline_features.timelineSemaphore, "Timeline semaphores are not supported.");
+
+    // Used by the gpu profiler.
+    bPipelineStatisticsSupported = physical_features2.features.pipelineStatisticsQuery == VK_TRUE;
+    bInheritedQueriesSupported   = physical_features2.features.inheritedQueries == VK_TRUE;
+
+    VkPhysicalDeviceFeatures enabled_features = {};
+    enabled_features.pipelineStatisticsQuery  = physical_features2.features.pipelineStatisticsQuery;
+    enabled_features.inheritedQueries         = physical_features2.features.inheritedQueries;
+
     if (bIsBindlessSupported)
     {
-        deviceCreateInfo.pNext = &physical_features2;
+        enabled_features.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
     }
 
+    // Only what the bindless heap needs, the queried structs would enable every supported feature. The timeline and
+    // dynamic rendering structs hold a single feature each and are chained as queried.
+    VkPhysicalDeviceDescriptorIndexingFeatures enabled_indexing_features{
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES,
+      &timeline_features};
+    enabled_indexing_features.descriptorBindingPartiallyBound               = VK_TRUE;
+    enabled_indexing_features.runtimeDescriptorArray                        = VK_TRUE;
+    enabled_indexing_features.descriptorBindingSampledImageUpdateAfterBind  = VK_TRUE;
+    enabled_indexing_features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+    enabled_indexing_features.descriptorBindingUpdateUnusedWhilePending     = VK_TRUE;
+
+    if (bIsBindlessSupported)
+    {
+        deviceCreateInfo.pNext = &enabled_indexing_features;
+    }
+    else
+    {
+        deviceCreateInfo.pNext = &timeline_features;
+    }
+    deviceCreateInfo.pEnabledFeatures = &enabled_features;
+
     if (validationLayersEnabled)
     {
         deviceCreateInfo.enabledLayerCount   = static_cast<u32>(validationLayers.size());
@@ -814,6 +1824,7 @@ bool VulkanDevice::CreateDevice()
 
     STRACE("\tRetrieving queue handles ...");
     vkGetDeviceQueue(Handle, GraphicsFamily, 0, &GraphicsQueue);
+    vkGetDeviceQueue(Handle, TransferFamily, 0, &TransferQueue);
 
     STRACE("\tLogical device created!");
 
@@ -871,22 +1882,56 @@ bool VulkanDevice::CheckValidationLayersSupport()
     return true;
 }
 
-u32 VulkanDevice::FindMemoryType(u32 typeFilter, VkMemoryPropertyFlags propertyFlags) const
+bool VulkanDevice::RecreateSwapchain()
 {
-    VkPhysicalDeviceMemoryProperties memoryProperties;
-    vkGetPhysicalDeviceMemoryProperties(Physical_device, &memoryProperties);
+    SPROFILE_FUNCTION();
 
-    for (u32 i = 0; i < memoryProperties.memoryTypeCount; ++i)
+    if (bIsHeadless)
     {
-        if ((typeFilter & (1 << i)) &&
-            ((memoryProperties.memoryTypes[i].propertyFlags & propertyFlags) == propertyFlags))
-        {
-            return i;
-        }
+        resized = false;
+        return true;
+    }
+
+    // Minimized windows have no extent, resized stays set so it is tried again next frame.
+    VkSurfaceCapabilitiesKHR capabilities;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(Physical_device, swapchain->surface, &capabilities);
+    if (capabilities.currentExtent.width == 0 || capabilities.currentExtent.height == 0)
+    {
+        resized = true;
+        return false;
+    }
+
+    resized = false;
+
+    vkDeviceWaitIdle(Handle);
+
+    // The old swapchain is retired by the new one, its images, semaphores and depth buffer are replaced.
+    swapchain->DestroyTargets();
+    for (auto& semaphore : swapchain->renderCompleteSemaphores)
+    {
+        vkDestroySemaphore(Handle, semaphore, nullptr);
+    }
+    swapchain->renderCompleteSemaphores.clear();
+
+    if (!VulkanSwapchain::Create(this, swapchain))
+    {
+        SERROR("Failed to recreate the vulkan swapchain.");
+        return false;
     }
 
-    SASSERT_MSG(false, "Failed to find suitable memory type.");
-    return 0;
+    DestroyTexture(depth_texture);
+    TextureDescriptor depth_texture_descriptor = {nullptr, swapchain->width, swapchain->height, 1, 1, 0, Format::D32_SFLOAT, TextureDescriptor::TextureType::TEXTURE_TYPE_2D, "DepthTexture"};
+    depth_texture                              = CreateTexture(depth_texture_descriptor);
+
+    swapchain->output.SetDepth(Format::D32_SFLOAT);
+
+    // Same formats, the pipelines created with the previous render pass stay compatible with the new one.
+    VulkanRenderPass* render_pass = GetRenderPassResource(swapchain_renderpass);
+    vkDestroyRenderPass(Handle, render_pass->renderpass, nullptr);
+    swapchain->CreateRenderPass(render_pass);
+
+    STRACE("Swapchain recreated at %dx%d.", swapchain->width, swapchain->height);
+    return true;
 }
 
 void VulkanDevice::CreateSwapchain(GLFWwindow* window)
@@ -975,7 +2020,8 @@ void VulkanDevice::DestroyBufferInstant(ResourceHandle InHandle)
     if (buffer)
     {
         vkDestroyBuffer(Handle, buffer->buffer, nullptr);
-        vkFreeMemory(Handle, buffer->memory, nullptr);
+        memory_allocator.Free(buffer->allocation);
+        buffer->mapped_data = nullptr;
     }
 
     buffers.ReleaseResource(InHandle);
@@ -987,9 +2033,13 @@ void VulkanDevice::DestroyTextureInstant(ResourceHandle InHandle)
 
     if (texture)
     {
-        vkFreeMemory(Handle, texture->memory, nullptr);
+        EvictFramebuffers(texture->image_view);
         vkDestroyImageView(Handle, texture->image_view, nullptr);
         vkDestroyImage(Handle, texture->texture, nullptr);
+        if (texture->alias.index == INVALID_ID)
+        {
+            memory_allocator.Free(texture->allocation);
+        }
     }
 
     textures.ReleaseResource(InHandle);
@@ -1050,12 +2100,14 @@ void VulkanDevice::DestroyDescriptorSetLayoutInstant(ResourceHandle InHandle)
 
 void VulkanDevice::DestroyPipelineInstant(ResourceHandle InHandle)
 {
+    // The compile job owns the pipeline until it finishes.
+    WaitForPipeline({InHandle});
+
     auto pipeline = static_cast<VulkanPipeline*>(pipelines.AccessResource(InHandle));
 
     if (pipeline)
     {
         vkDestroyPipeline(Handle, pipeline->pipeline, nullptr);
-        vkDestroyPipelineLayout(Handle, pipeline->pipelineLayout, nullptr);
     }
 
     pipelines.ReleaseResource(InHandle);
@@ -1063,18 +2115,7 @@ void VulkanDevice::DestroyPipelineInstant(ResourceHandle InHandle)
 
 void VulkanDevice::DestroyRenderPassInstant(ResourceHandle InHandle)
 {
-    auto render_pass = static_cast<VulkanRenderPass*>(renderpasses.AccessResource(InHandle));
-
-    if (render_pass)
-    {
-        if (render_pass->render_targets_count > 0)
-        {
-            vkDestroyFramebuffer(Handle, render_pass->framebuffer, nullptr);
-        }
-
-        // This should be destroyed with the renderpass static map ... avoid duplicate destruction calls.
-    }
-
+    // The VkRenderPass is owned by the render pass cache and the framebuffers by the framebuffer cache.
     renderpasses.ReleaseResource(InHandle);
 }
 
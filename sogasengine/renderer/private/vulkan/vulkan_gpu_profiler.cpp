@@ -0,0 +1,309 @@
+#include "vulkan/vulkan_gpu_profiler.h"
+#include "vulkan/vulkan_commandbuffer.h"
+#include "vulkan/vulkan_device.h"
+
+namespace Sogas
+{
+namespace Renderer
+{
+namespace Vk
+{
+
+// Results are written in bit order, the order of PipelineStatistic.
+static const VkQueryPipelineStatisticFlags statistic_flags =
+  VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT | VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+  VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+  VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT | VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+static const u32 statistics_count = static_cast<u32>(PipelineStatistic::COUNT);
+
+void VulkanGpuProfiler::Init(VulkanDevice* InDevice, u32 InFramesInFlight, bool bInTimestamps, bool bInStatistics)
+{
+    device           = InDevice;
+    frames_in_flight = InFramesInFlight;
+
+    const u32 valid_bits = device->queueFamilyProperties[device->GraphicsFamily].timestampValidBits;
+    if (!bInTimestamps || valid_bits == 0)
+    {
+        STRACE("\tGpu timestamps %s.", bInTimestamps ? "not supported by the graphics queue" : "disabled");
+        return;
+    }
+
+    timestamp_mask       = valid_bits >= 64 ? ~0ull : (1ull << valid_bits) - 1;
+    timestamp_period     = static_cast<f64>(device->Physical_device_properties.limits.timestampPeriod);
+    bStatistics          = bInStatistics && device->bPipelineStatisticsSupported;
+    bInheritedStatistics = bStatistics && device->bInheritedQueriesSupported;
+
+    if (bInStatistics && !bStatistics)
+    {
+        SWARNING("\tPipeline statistics queries are not supported.");
+    }
+
+    for (u32 i = 0; i < frames_in_flight; ++i)
+    {
+        VkQueryPoolCreateInfo timestamps_info = {VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+        timestamps_info.queryType             = VK_QUERY_TYPE_TIMESTAMP;
+        timestamps_info.queryCount            = MAX_ZONES_PER_FRAME * 2;
+        vkcheck(vkCreateQueryPool(device->Handle, &timestamps_info, nullptr, &frames[i].timestamps));
+
+        if (bStatistics)
+        {
+            VkQueryPoolCreateInfo statistics_info = {VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+            statistics_info.queryType             = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+            statistics_info.queryCount            = MAX_STATISTICS;
+            statistics_info.pipelineStatistics    = statistic_flags;
+            vkcheck(vkCreateQueryPool(device->Handle, &statistics_info, nullptr, &frames[i].statistics));
+        }
+
+        frames[i].zones.reserve(MAX_ZONES_PER_FRAME);
+    }
+
+    Calibrate();
+
+    STRACE("\tGpu timestamps enabled%s.", bStatistics ? " with pipeline statistics" : "");
+}
+
+void VulkanGpuProfiler::Shutdown()
+{
+    if (resolved_frames > 0)
+    {
+        SINFO("\tGpu frame time over %d frames: %.3f ms average, %.3f ms peak.", resolved_frames, frame_total_ms / resolved_frames, frame_max_ms);
+    }
+
+    if (dropped_zones > 0)
+    {
+        SWARNING("\t%d gpu zones were dropped, the query pools were full.", dropped_zones);
+    }
+
+    for (u32 i = 0; i < frames_in_flight; ++i)
+    {
+        vkDestroyQueryPool(device->Handle, frames[i].timestamps, nullptr);
+        vkDestroyQueryPool(device->Handle, frames[i].statistics, nullptr);
+
+        frames[i].timestamps = VK_NULL_HANDLE;
+        frames[i].statistics = VK_NULL_HANDLE;
+    }
+
+    timestamp_mask = 0;
+}
+
+void VulkanGpuProfiler::BeginCommandBuffer(VkCommandBuffer InCommandBuffer, u32 InFrameIndex)
+{
+    if (timestamp_mask == 0)
+    {
+        return;
+    }
+
+    FrameQueries& frame = frames[InFrameIndex];
+
+    // Resets must be outside of render passes, the command buffer has none yet.
+    vkCmdResetQueryPool(InCommandBuffer, frame.timestamps, 0, MAX_ZONES_PER_FRAME * 2);
+    if (frame.statistics != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(InCommandBuffer, frame.statistics, 0, MAX_STATISTICS);
+    }
+
+    frame.zones.clear();
+    frame.statistics_count = 0;
+    frame.open_zones       = 0;
+    frame.bReset           = true;
+    frame.bSubmitted       = false;
+
+    current_frame = InFrameIndex;
+}
+
+void VulkanGpuProfiler::Submit(u32 InFrameIndex)
+{
+    FrameQueries& frame = frames[InFrameIndex];
+
+    // The results of the whole pool are read at once, a timestamp never written would never be available.
+    if (frame.open_zones > 0)
+    {
+        SERROR("%d gpu zones were not ended, the frame is not timed.", frame.open_zones);
+        frame.bReset = false;
+        return;
+    }
+
+    frame.bSubmitted = frame.bReset;
+}
+
+void VulkanGpuProfiler::Resolve(u32 InFrameIndex)
+{
+    SPROFILE_FUNCTION();
+
+    FrameQueries& frame = frames[InFrameIndex];
+
+    const bool bReady = frame.bSubmitted && !frame.zones.empty();
+    frame.bSubmitted  = false;
+    frame.bReset      = false;
+
+    if (!bReady)
+    {
+        return;
+    }
+
+    const u32 zones_count = static_cast<u32>(frame.zones.size());
+    query_results.resize(zones_count * 2);
+
+    // The fence of the frame was waited for, the results are available.
+    VkResult result = vkGetQueryPoolResults(device->Handle, frame.timestamps, 0, zones_count * 2, query_results.size() * sizeof(u64), query_results.data(), sizeof(u64), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS)
+    {
+        SWARNING("Gpu timestamps of frame slot %d are not available.", InFrameIndex);
+        return;
+    }
+
+    timings.resize(zones_count);
+    track_zones.resize(zones_count);
+
+    const u64 first_timestamp = query_results[0] & timestamp_mask;
+    f64       frame_ms        = 0.0;
+
+    for (u32 i = 0; i < zones_count; ++i)
+    {
+        const u64 start = query_results[i * 2] & timestamp_mask;
+        const u64 end   = std::max(start, query_results[i * 2 + 1] & timestamp_mask);
+
+        // Zones beginning at the top of the pipe may start before the first one finished its previous work.
+        const f64 start_ns    = start > first_timestamp ? static_cast<f64>(start - first_timestamp) * timestamp_period : 0.0;
+        const f64 duration_ns = static_cast<f64>(end - start) * timestamp_period;
+
+        GPUZoneTiming& timing = timings[i];
+        timing.name           = frame.zones[i].name;
+        timing.start_ms       = start_ns * 1e-6;
+        timing.duration_ms    = duration_ns * 1e-6;
+        timing.depth          = frame.zones[i].depth;
+        timing.bStatistics    = false;
+
+        frame_ms = std::max(frame_ms, timing.start_ms + timing.duration_ms);
+
+        // On the cpu profiler clock.
+        const u64 cpu_start = static_cast<u64>(std::max<i64>(static_cast<i64>(static_cast<f64>(start) * timestamp_period) + cpu_offset_ns, 0));
+        track_zones[i]      = {timing.name, cpu_start, cpu_start + static_cast<u64>(duration_ns)};
+    }
+
+    if (frame.statistics_count > 0)
+    {
+        query_results.resize(frame.statistics_count * statistics_count);
+
+        const u32 stride = statistics_count * static_cast<u32>(sizeof(u64));
+        result           = vkGetQueryPoolResults(device->Handle, frame.statistics, 0, frame.statistics_count, query_results.size() * sizeof(u64), query_results.data(), stride, VK_QUERY_RESULT_64_BIT);
+        if (result == VK_SUCCESS)
+        {
+            for (u32 i = 0; i < zones_count; ++i)
+            {
+                const u32 query = frame.zones[i].statistics_query;
+                if (query == INVALID_ID)
+                {
+                    continue;
+                }
+
+                timings[i].bStatistics = true;
+                memcpy(timings[i].statistics, &query_results[query * statistics_count], stride);
+            }
+        }
+    }
+
+    ++resolved_frames;
+    frame_total_ms += frame_ms;
+    frame_max_ms = std::max(frame_max_ms, frame_ms);
+
+    Profiler::AddTrackZones("GPU", track_zones.data(), zones_count);
+}
+
+u32 VulkanGpuProfiler::BeginZone(VkCommandBuffer InCommandBuffer, const char* InName, bool bInStatistics)
+{
+    FrameQueries& frame = frames[current_frame];
+    if (!frame.bReset)
+    {
+        return INVALID_ID;
+    }
+
+    if (frame.zones.size() >= MAX_ZONES_PER_FRAME)
+    {
+        ++dropped_zones;
+        return INVALID_ID;
+    }
+
+    const u32 zone_index = static_cast<u32>(frame.zones.size());
+    Zone      zone       = {InName, frame.open_zones++, INVALID_ID};
+
+    vkCmdWriteTimestamp(InCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.timestamps, zone_index * 2);
+
+    if (bInStatistics && bStatistics)
+    {
+        if (frame.statistics_count < MAX_STATISTICS)
+        {
+            zone.statistics_query = frame.statistics_count++;
+            vkCmdBeginQuery(InCommandBuffer, frame.statistics, zone.statistics_query, 0);
+        }
+        else
+        {
+            ++dropped_zones;
+        }
+    }
+
+    frame.zones.push_back(zone);
+    return zone_index;
+}
+
+void VulkanGpuProfiler::EndZone(VkCommandBuffer InCommandBuffer, u32 InZone)
+{
+    if (InZone == INVALID_ID)
+    {
+        return;
+    }
+
+    FrameQueries& frame = frames[current_frame];
+    const Zone&   zone  = frame.zones[InZone];
+
+    if (zone.statistics_query != INVALID_ID)
+    {
+        vkCmdEndQuery(InCommandBuffer, frame.statistics, zone.statistics_query);
+    }
+
+    vkCmdWriteTimestamp(InCommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestamps, InZone * 2 + 1);
+    --frame.open_zones;
+}
+
+VkQueryPipelineStatisticFlags VulkanGpuProfiler::GetInheritedStatistics() const
+{
+    return bInheritedStatistics ? statistic_flags : 0;
+}
+
+void VulkanGpuProfiler::Calibrate()
+{
+    VkCommandBufferBeginInfo begin_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    begin_info.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    VulkanCommandBuffer* cmd = static_cast<VulkanCommandBuffer*>(device->GetInstantCommandBuffer());
+    vkBeginCommandBuffer(cmd->command_buffer, &begin_info);
+
+    // Reset again by the first frame using the pool.
+    vkCmdResetQueryPool(cmd->command_buffer, frames[0].timestamps, 0, 1);
+    vkCmdWriteTimestamp(cmd->command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frames[0].timestamps, 0);
+
+    vkEndCommandBuffer(cmd->command_buffer);
+
+    VkSubmitInfo submit_info       = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers    = &cmd->command_buffer;
+
+    // The timestamp is written between the submit and the end of the wait, its middle is the best guess.
+    const u64 submit_time = Profiler::GetTime();
+    vkQueueSubmit(device->GraphicsQueue, 1, &submit_info, VK_NULL_HANDLE);
+    vkQueueWaitIdle(device->GraphicsQueue);
+    const u64 done_time = Profiler::GetTime();
+
+    vkResetCommandBuffer(cmd->command_buffer, VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT);
+
+    u64 timestamp = 0;
+    vkGetQueryPoolResults(device->Handle, frames[0].timestamps, 0, 1, sizeof(u64), &timestamp, sizeof(u64), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+
+    const f64 gpu_ns = static_cast<f64>(timestamp & timestamp_mask) * timestamp_period;
+    cpu_offset_ns    = static_cast<i64>(submit_time + (done_time - submit_time) / 2) - static_cast<i64>(gpu_ns);
+}
+
+} // namespace Vk
+} // namespace Renderer
+} // namespace Sogas
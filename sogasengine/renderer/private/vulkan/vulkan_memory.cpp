@@ -0,0 +1,759 @@
+#include "vulkan/vulkan_memory.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Sogas
+{
+namespace Renderer
+{
+namespace Vk
+{
+
+// TLSF parameters. Sizes below SMALL_SIZE share the first level, split in SL_COUNT lists of 8 bytes.
+static const u32          SL_LOG2    = 5;
+static const u32          SL_COUNT   = 1 << SL_LOG2;
+static const u32          FL_SHIFT   = 8;
+static const u32          FL_COUNT   = 48;
+static const VkDeviceSize SMALL_SIZE = VkDeviceSize(1) << FL_SHIFT;
+
+static const VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+static const VkDeviceSize SMALL_HEAP_SIZE    = 1024ull * 1024 * 1024;
+static const VkDeviceSize BAR_SIZE           = 256ull * 1024 * 1024;
+
+enum PoolKind : u32
+{
+    POOL_LINEAR = 0, // Buffers.
+    POOL_OPTIMAL,    // Optimal tiling images.
+    POOL_COUNT
+};
+
+struct VulkanMemoryNode
+{
+    VkDeviceSize offset    = 0;
+    VkDeviceSize size      = 0;
+    VkDeviceSize alignment = 1;
+
+    VulkanMemoryNode* prev_physical = nullptr;
+    VulkanMemoryNode* next_physical = nullptr;
+    VulkanMemoryNode* prev_free     = nullptr;
+    VulkanMemoryNode* next_free     = nullptr;
+
+    VulkanMemoryBlock* block     = nullptr;
+    void*              user_data = nullptr;
+    bool               bFree     = true;
+};
+
+struct VulkanMemoryBlock
+{
+    VulkanMemoryPool* pool   = nullptr;
+    VkDeviceMemory    memory = VK_NULL_HANDLE;
+    VkDeviceSize      size   = 0;
+    VkDeviceSize      used   = 0;
+    u8*               mapped = nullptr;
+    u32               count  = 0; // Allocations alive.
+
+    VulkanMemoryNode* first = nullptr; // Nodes in address order.
+
+    u64               fl_bitmap = 0;
+    u32               sl_bitmap[FL_COUNT]{};
+    VulkanMemoryNode* free_lists[FL_COUNT][SL_COUNT]{};
+};
+
+struct VulkanMemoryPool
+{
+    u32                             memory_type = 0;
+    u32                             kind        = POOL_LINEAR;
+    std::vector<VulkanMemoryBlock*> blocks;
+};
+
+static u32 FindLastSet(u64 value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<u32>(index);
+#else
+    return 63u - static_cast<u32>(__builtin_clzll(value));
+#endif
+}
+
+static u32 FindFirstSet(u64 value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<u32>(index);
+#else
+    return static_cast<u32>(__builtin_ctzll(value));
+#endif
+}
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static void MappingInsert(VkDeviceSize size, u32& fl, u32& sl)
+{
+    if (size < SMALL_SIZE)
+    {
+        fl = 0;
+        sl = static_cast<u32>(size / (SMALL_SIZE / SL_COUNT));
+    }
+    else
+    {
+        const u32 msb = FindLastSet(size);
+        sl            = static_cast<u32>(size >> (msb - SL_LOG2)) ^ SL_COUNT;
+        fl            = std::min(msb - FL_SHIFT + 1, FL_COUNT - 1);
+    }
+}
+
+// Rounds the size up to the next list, so any node found there is big enough.
+static void MappingSearch(VkDeviceSize size, u32& fl, u32& sl)
+{
+    if (size < SMALL_SIZE)
+    {
+        size = AlignUp(size, SMALL_SIZE / SL_COUNT);
+    }
+    else
+    {
+        size += (VkDeviceSize(1) << (FindLastSet(size) - SL_LOG2)) - 1;
+    }
+    MappingInsert(size, fl, sl);
+}
+
+static void InsertFree(VulkanMemoryBlock* block, VulkanMemoryNode* node)
+{
+    u32 fl, sl;
+    MappingInsert(node->size, fl, sl);
+
+    VulkanMemoryNode*& head = block->free_lists[fl][sl];
+    node->bFree             = true;
+    node->prev_free         = nullptr;
+    node->next_free         = head;
+    if (head)
+    {
+        head->prev_free = node;
+    }
+    head = node;
+
+    block->fl_bitmap |= u64(1) << fl;
+    block->sl_bitmap[fl] |= 1u << sl;
+}
+
+static void RemoveFree(VulkanMemoryBlock* block, VulkanMemoryNode* node)
+{
+    u32 fl, sl;
+    MappingInsert(node->size, fl, sl);
+
+    if (node->prev_free)
+    {
+        node->prev_free->next_free = node->next_free;
+    }
+    else
+    {
+        block->free_lists[fl][sl] = node->next_free;
+    }
+
+    if (node->next_free)
+    {
+        node->next_free->prev_free = node->prev_free;
+    }
+
+    if (block->free_lists[fl][sl] == nullptr)
+    {
+        block->sl_bitmap[fl] &= ~(1u << sl);
+        if (block->sl_bitmap[fl] == 0)
+        {
+            block->fl_bitmap &= ~(u64(1) << fl);
+        }
+    }
+
+    node->prev_free = nullptr;
+    node->next_free = nullptr;
+    node->bFree     = false;
+}
+
+static VulkanMemoryNode* FindFree(const VulkanMemoryBlock* block, VkDeviceSize size)
+{
+    u32 fl, sl;
+    MappingSearch(size, fl, sl);
+    if (fl >= FL_COUNT)
+    {
+        return nullptr;
+    }
+
+    u32 sl_map = block->sl_bitmap[fl] & (~0u << sl);
+    if (sl_map == 0)
+    {
+        const u64 fl_map = fl + 1 < FL_COUNT ? block->fl_bitmap & (~u64(0) << (fl + 1)) : 0;
+        if (fl_map == 0)
+        {
+            return nullptr;
+        }
+
+        fl     = FindFirstSet(fl_map);
+        sl_map = block->sl_bitmap[fl];
+    }
+
+    sl = FindFirstSet(sl_map);
+    return block->free_lists[fl][sl];
+}
+
+static void LinkAfter(VulkanMemoryNode* node, VulkanMemoryNode* next)
+{
+    next->prev_physical = node;
+    next->next_physical = node->next_physical;
+    if (node->next_physical)
+    {
+        node->next_physical->prev_physical = next;
+    }
+    node->next_physical = next;
+}
+
+static void Unlink(VulkanMemoryBlock* block, VulkanMemoryNode* node)
+{
+    if (node->prev_physical)
+    {
+        node->prev_physical->next_physical = node->next_physical;
+    }
+    else
+    {
+        block->first = node->next_physical;
+    }
+
+    if (node->next_physical)
+    {
+        node->next_physical->prev_physical = node->prev_physical;
+    }
+}
+
+static VulkanAllocation MakeAllocation(VulkanMemoryNode* node)
+{
+    const VulkanMemoryBlock* block = node->block;
+
+    VulkanAllocation allocation;
+    allocation.memory      = block->memory;
+    allocation.offset      = node->offset;
+    allocation.size        = node->size;
+    allocation.mapped      = block->mapped ? block->mapped + node->offset : nullptr;
+    allocation.memory_type = block->pool->memory_type;
+    allocation.node        = node;
+    allocation.aliasable   = true;
+    return allocation;
+}
+
+void VulkanMemoryAllocator::Init(VkDevice InDevice, VkPhysicalDevice InPhysicalDevice)
+{
+    device = InDevice;
+    vkGetPhysicalDeviceMemoryProperties(InPhysicalDevice, &memory_properties);
+
+    // Small heaps, like the host visible device local one, get smaller blocks so they are not exhausted.
+    for (u32 i = 0; i < memory_properties.memoryTypeCount; ++i)
+    {
+        const VkDeviceSize heap_size = memory_properties.memoryHeaps[memory_properties.memoryTypes[i].heapIndex].size;
+        block_size[i]                = heap_size <= SMALL_HEAP_SIZE ? AlignUp(heap_size / 8, 4096) : DEFAULT_BLOCK_SIZE;
+
+        const VkMemoryPropertyFlags mappable_device_local = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        if ((memory_properties.memoryTypes[i].propertyFlags & mappable_device_local) == mappable_device_local && heap_size > BAR_SIZE)
+        {
+            bMappableDeviceLocalHeap = true;
+        }
+    }
+
+    pools.resize(memory_properties.memoryTypeCount * POOL_COUNT);
+    for (u32 i = 0; i < static_cast<u32>(pools.size()); ++i)
+    {
+        pools[i]              = new VulkanMemoryPool;
+        pools[i]->memory_type = i / POOL_COUNT;
+        pools[i]->kind        = i % POOL_COUNT;
+    }
+}
+
+void VulkanMemoryAllocator::Shutdown()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (VulkanMemoryPool* pool : pools)
+    {
+        while (!pool->blocks.empty())
+        {
+            VulkanMemoryBlock* block = pool->blocks.back();
+            if (block->count > 0)
+            {
+                SWARNING("\t%d allocations still alive in memory type %d.", block->count, pool->memory_type);
+            }
+            DestroyBlock(block);
+        }
+        delete pool;
+    }
+    pools.clear();
+
+    for (VulkanMemoryNode* node : free_nodes)
+    {
+        delete node;
+    }
+    free_nodes.clear();
+
+    if (dedicated_count > 0)
+    {
+        SWARNING("\t%d dedicated allocations still alive.", dedicated_count);
+    }
+}
+
+VulkanAllocation VulkanMemoryAllocator::AllocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties, void* user_data)
+{
+    VkBufferMemoryRequirementsInfo2 info = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2};
+    info.buffer                          = buffer;
+
+    VkMemoryDedicatedRequirements dedicated    = {VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS};
+    VkMemoryRequirements2         requirements = {VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2, &dedicated};
+    vkGetBufferMemoryRequirements2(device, &info, &requirements);
+
+    const bool bDedicated = dedicated.prefersDedicatedAllocation || dedicated.requiresDedicatedAllocation;
+
+    VulkanAllocation allocation = Allocate(requirements.memoryRequirements, properties, POOL_LINEAR, bDedicated, buffer, VK_NULL_HANDLE, user_data);
+    if (allocation.IsValid())
+    {
+        vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset);
+    }
+    return allocation;
+}
+
+VulkanAllocation VulkanMemoryAllocator::AllocateImage(VkImage image, VkMemoryPropertyFlags properties, bool bDedicated, bool bAliasable, void* user_data)
+{
+    VkImageMemoryRequirementsInfo2 info = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2};
+    info.image                          = image;
+
+    VkMemoryDedicatedRequirements dedicated    = {VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS};
+    VkMemoryRequirements2         requirements = {VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2, &dedicated};
+    vkGetImageMemoryRequirements2(device, &info, &requirements);
+
+    // Big aliasable images still get their own allocation, without naming the image so others can be bound to it.
+    bAliasable = bAliasable && !dedicated.requiresDedicatedAllocation;
+    if (bAliasable)
+    {
+        bDedicated = false;
+    }
+    else
+    {
+        bDedicated |= dedicated.prefersDedicatedAllocation || dedicated.requiresDedicatedAllocation;
+    }
+
+    VulkanAllocation allocation = Allocate(requirements.memoryRequirements, properties, POOL_OPTIMAL, bDedicated, VK_NULL_HANDLE, bAliasable ? VK_NULL_HANDLE : image, user_data);
+    if (allocation.IsValid())
+    {
+        vkBindImageMemory(device, image, allocation.memory, allocation.offset);
+    }
+    return allocation;
+}
+
+VulkanAllocation VulkanMemoryAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, u32 pool_kind, bool bDedicated, VkBuffer buffer, VkImage image, void* user_data)
+{
+    const u32 memory_type = FindMemoryType(requirements.memoryTypeBits, properties);
+    if (memory_type == INVALID_ID)
+    {
+        SERROR("No memory type matches properties %d.", properties);
+        return {};
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Resources bigger than half a block would waste most of it.
+    if (bDedicated || requirements.size > block_size[memory_type] / 2)
+    {
+        return AllocateDedicated(requirements.size, memory_type, buffer, image);
+    }
+
+    VulkanMemoryPool& pool = *pools[memory_type * POOL_COUNT + pool_kind];
+    return AllocateFromPool(pool, requirements.size, requirements.alignment, nullptr, user_data);
+}
+
+VulkanAllocation VulkanMemoryAllocator::AllocateFromPool(VulkanMemoryPool& pool, VkDeviceSize size, VkDeviceSize alignment, const VulkanMemoryBlock* excluded, void* user_data)
+{
+    alignment = std::max(alignment, VkDeviceSize(1));
+
+    // Worst case padding is searched for, so the first node of the list found always fits.
+    const VkDeviceSize search_size = size + alignment - 1;
+
+    VulkanMemoryBlock* block = nullptr;
+    VulkanMemoryNode*  node  = nullptr;
+    for (VulkanMemoryBlock* candidate : pool.blocks)
+    {
+        if (candidate != excluded && (node = FindFree(candidate, search_size)) != nullptr)
+        {
+            block = candidate;
+            break;
+        }
+    }
+
+    // Defragmentation only moves allocations into existing blocks.
+    if (node == nullptr && excluded == nullptr)
+    {
+        block = CreateBlock(pool, search_size);
+        node  = block ? FindFree(block, search_size) : nullptr;
+    }
+
+    if (node == nullptr)
+    {
+        return {};
+    }
+
+    RemoveFree(block, node);
+
+    const VkDeviceSize padding = AlignUp(node->offset, alignment) - node->offset;
+    if (padding > 0)
+    {
+        // The previous node is in use, otherwise it would have been merged with this one.
+        VulkanMemoryNode* front = NewNode();
+        front->block            = block;
+        front->offset           = node->offset;
+        front->size             = padding;
+
+        front->prev_physical = node->prev_physical;
+        front->next_physical = node;
+        if (node->prev_physical)
+        {
+            node->prev_physical->next_physical = front;
+        }
+        else
+        {
+            block->first = front;
+        }
+        node->prev_physical = front;
+
+        node->offset += padding;
+        node->size -= padding;
+        InsertFree(block, front);
+    }
+
+    if (node->size > size)
+    {
+        VulkanMemoryNode* back = NewNode();
+        back->block            = block;
+        back->offset           = node->offset + size;
+        back->size             = node->size - size;
+        LinkAfter(node, back);
+
+        node->size = size;
+        InsertFree(block, back);
+    }
+
+    node->alignment = alignment;
+    node->user_data = user_data;
+
+    block->used += node->size;
+    ++block->count;
+
+    return MakeAllocation(node);
+}
+
+VulkanAllocation VulkanMemoryAllocator::AllocateDedicated(VkDeviceSize size, u32 memory_type, VkBuffer buffer, VkImage image)
+{
+    VkMemoryDedicatedAllocateInfo dedicated_info = {VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO};
+    dedicated_info.buffer                        = buffer;
+    dedicated_info.image                         = image;
+
+    VkMemoryAllocateInfo info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, &dedicated_info};
+    info.allocationSize       = size;
+    info.memoryTypeIndex      = memory_type;
+
+    VulkanAllocation allocation;
+    if (vkAllocateMemory(device, &info, nullptr, &allocation.memory) != VK_SUCCESS)
+    {
+        SERROR("Failed to allocate %d bytes of dedicated memory.", static_cast<u32>(size));
+        return {};
+    }
+
+    if (memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        void* data = nullptr;
+        vkMapMemory(device, allocation.memory, 0, VK_WHOLE_SIZE, 0, &data);
+        allocation.mapped = static_cast<u8*>(data);
+    }
+
+    allocation.size        = size;
+    allocation.memory_type = memory_type;
+    allocation.aliasable   = buffer == VK_NULL_HANDLE && image == VK_NULL_HANDLE;
+
+    ++dedicated_count;
+    dedicated_bytes[memory_type] += size;
+
+    return allocation;
+}
+
+void VulkanMemoryAllocator::Free(VulkanAllocation& allocation)
+{
+    if (!allocation.IsValid())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (allocation.node == nullptr)
+    {
+        if (allocation.mapped)
+        {
+            vkUnmapMemory(device, allocation.memory);
+        }
+        vkFreeMemory(device, allocation.memory, nullptr);
+
+        --dedicated_count;
+        dedicated_bytes[allocation.memory_type] -= allocation.size;
+    }
+    else
+    {
+        FreeNode(allocation.node);
+    }
+
+    allocation = {};
+}
+
+void VulkanMemoryAllocator::FreeNode(VulkanMemoryNode* node)
+{
+    VulkanMemoryBlock* block = node->block;
+
+    block->used -= node->size;
+    --block->count;
+    node->user_data = nullptr;
+
+    VulkanMemoryNode* prev = node->prev_physical;
+    if (prev && prev->bFree)
+    {
+        RemoveFree(block, prev);
+        prev->size += node->size;
+        Unlink(block, node);
+        free_nodes.push_back(node);
+        node = prev;
+    }
+
+    VulkanMemoryNode* next = node->next_physical;
+    if (next && next->bFree)
+    {
+        RemoveFree(block, next);
+        node->size += next->size;
+        Unlink(block, next);
+        free_nodes.push_back(next);
+    }
+
+    InsertFree(block, node);
+
+    // The last block of a pool is kept, so a resource created and destroyed every frame doesn't hit the driver.
+    VulkanMemoryPool* pool = block->pool;
+    if (block->count == 0 && pool->blocks.size() > 1)
+    {
+        DestroyBlock(block);
+    }
+}
+
+VulkanMemoryBlock* VulkanMemoryAllocator::CreateBlock(VulkanMemoryPool& pool, VkDeviceSize min_size)
+{
+    VkDeviceSize size = std::max(block_size[pool.memory_type], AlignUp(min_size, 4096));
+
+    VkMemoryAllocateInfo info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    info.memoryTypeIndex      = pool.memory_type;
+
+    // Retry with smaller blocks when the heap is almost full.
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    while (true)
+    {
+        info.allocationSize = size;
+        if (vkAllocateMemory(device, &info, nullptr, &memory) == VK_SUCCESS)
+        {
+            break;
+        }
+
+        if (size / 2 < min_size)
+        {
+            SERROR("Failed to allocate a memory block of %d bytes.", static_cast<u32>(size));
+            return nullptr;
+        }
+        size /= 2;
+    }
+
+    VulkanMemoryBlock* block = new VulkanMemoryBlock;
+    block->pool              = &pool;
+    block->memory            = memory;
+    block->size              = size;
+
+    if (memory_properties.memoryTypes[pool.memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        void* data = nullptr;
+        vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &data);
+        block->mapped = static_cast<u8*>(data);
+    }
+
+    VulkanMemoryNode* node = NewNode();
+    node->block            = block;
+    node->size             = size;
+    block->first           = node;
+    InsertFree(block, node);
+
+    pool.blocks.push_back(block);
+
+    STRACE("\tAllocated memory block of %d KB for memory type %d.", static_cast<u32>(size / 1024), pool.memory_type);
+
+    return block;
+}
+
+void VulkanMemoryAllocator::DestroyBlock(VulkanMemoryBlock* block)
+{
+    VulkanMemoryPool* pool = block->pool;
+    pool->blocks.erase(std::find(pool->blocks.begin(), pool->blocks.end(), block));
+
+    VulkanMemoryNode* node = block->first;
+    while (node)
+    {
+        VulkanMemoryNode* next = node->next_physical;
+        free_nodes.push_back(node);
+        node = next;
+    }
+
+    if (block->mapped)
+    {
+        vkUnmapMemory(device, block->memory);
+    }
+    vkFreeMemory(device, block->memory, nullptr);
+
+    delete block;
+}
+
+VulkanMemoryNode* VulkanMemoryAllocator::NewNode()
+{
+    if (free_nodes.empty())
+    {
+        return new VulkanMemoryNode;
+    }
+
+    VulkanMemoryNode* node = free_nodes.back();
+    free_nodes.pop_back();
+    *node = VulkanMemoryNode{};
+    return node;
+}
+
+u32 VulkanMemoryAllocator::Defragment(u32 max_moves, const MoveCallback& move)
+{
+    struct Move
+    {
+        VulkanMemoryNode* from;
+        VulkanAllocation  to;
+        bool              bDone;
+    };
+
+    // Destinations are reserved under the lock, the callbacks run without it so they can allocate and free.
+    std::vector<Move> planned;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (VulkanMemoryPool* pool : pools)
+        {
+            if (planned.size() >= max_moves || pool->blocks.size() < 2)
+            {
+                continue;
+            }
+
+            // The least used block is the cheapest to empty.
+            VulkanMemoryBlock* source = *std::min_element(pool->blocks.begin(), pool->blocks.end(),
+                                                          [](const VulkanMemoryBlock* a, const VulkanMemoryBlock* b) { return a->used < b->used; });
+
+            for (VulkanMemoryNode* node = source->first; node && planned.size() < max_moves; node = node->next_physical)
+            {
+                if (node->bFree)
+                {
+                    continue;
+                }
+
+                VulkanAllocation to = AllocateFromPool(*pool, node->size, node->alignment, source, node->user_data);
+                if (!to.IsValid())
+                {
+                    break;
+                }
+                planned.push_back({node, to, false});
+            }
+        }
+    }
+
+    u32 moves = 0;
+    for (Move& planned_move : planned)
+    {
+        planned_move.bDone = move(planned_move.from->user_data, MakeAllocation(planned_move.from), planned_move.to);
+        moves += planned_move.bDone ? 1 : 0;
+    }
+
+    // Sources of the moves done are released, destinations of the refused ones too. Emptied blocks go with them.
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const Move& planned_move : planned)
+    {
+        FreeNode(planned_move.bDone ? planned_move.from : planned_move.to.node);
+    }
+
+    return moves;
+}
+
+GPUMemoryStats VulkanMemoryAllocator::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    VkDeviceSize used_per_type[VK_MAX_MEMORY_TYPES]{};
+
+    GPUMemoryStats stats;
+    for (const VulkanMemoryPool* pool : pools)
+    {
+        for (const VulkanMemoryBlock* block : pool->blocks)
+        {
+            stats.reserved_bytes += block->size;
+            stats.used_bytes += block->used;
+            stats.allocation_count += block->count;
+            ++stats.block_count;
+            used_per_type[pool->memory_type] += block->used;
+
+            for (const VulkanMemoryNode* node = block->first; node; node = node->next_physical)
+            {
+                if (node->bFree)
+                {
+                    stats.largest_free_range = std::max(stats.largest_free_range, static_cast<u64>(node->size));
+                }
+            }
+        }
+    }
+
+    for (u32 i = 0; i < memory_properties.memoryTypeCount; ++i)
+    {
+        stats.reserved_bytes += dedicated_bytes[i];
+        stats.used_bytes += dedicated_bytes[i];
+        used_per_type[i] += dedicated_bytes[i];
+
+        // Memory both device local and host visible counts for both.
+        const VkMemoryPropertyFlags flags = memory_properties.memoryTypes[i].propertyFlags;
+        if (flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+        {
+            stats.device_local_bytes += used_per_type[i];
+        }
+        if (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            stats.host_visible_bytes += used_per_type[i];
+        }
+    }
+    stats.dedicated_count = dedicated_count;
+
+    return stats;
+}
+
+u32 VulkanMemoryAllocator::FindMemoryType(u32 type_bits, VkMemoryPropertyFlags properties) const
+{
+    for (u32 i = 0; i < memory_properties.memoryTypeCount; ++i)
+    {
+        if ((type_bits & (1u << i)) && (memory_properties.memoryTypes[i].propertyFlags & properties) == properties)
+        {
+            return i;
+        }
+    }
+    return INVALID_ID;
+}
+
+} // namespace Vk
+} // namespace Renderer
+} // namespace Sogas
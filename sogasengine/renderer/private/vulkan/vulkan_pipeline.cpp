@@ -5,6 +5,9 @@
 #include "vulkan/vulkan_renderpass.h"
 #include "vulkan/vulkan_shader.h"
 
+#include <chrono>
+#include <future>
+
 namespace Sogas
 {
 namespace Renderer
@@ -60,12 +63,53 @@ constexpr static VkFrontFace ConvertFrontFace(FrontFace InFrontFace)
     return VK_FRONT_FACE_COUNTER_CLOCKWISE;
 }
 
+// Places the reflected vertex inputs, in location order, one after the other in the declared streams. A stream is
+// full once the inputs reach its stride. Without streams every input goes to a per vertex stream at binding 0.
+static bool ReflectVertexInput(const VulkanShaderState& InShaderState, const std::string& InName, VertexInputDescriptor& OutVertexInput)
+{
+    if (OutVertexInput.vertex_streams_count == 0)
+    {
+        u32 stride = 0;
+        for (u32 i = 0; i < InShaderState.VertexInputsCount; ++i)
+        {
+            stride += GetVertexFormatSize(InShaderState.VertexInputs[i].format);
+        }
+        OutVertexInput.AddVertexStream({0, static_cast<u16>(stride), VertexInputRate::PER_VERTEX});
+    }
+
+    u32 stream = 0;
+    u32 offset = 0;
+    for (u32 i = 0; i < InShaderState.VertexInputsCount; ++i)
+    {
+        if (offset == OutVertexInput.vertex_stream[stream].stride && stream + 1 < OutVertexInput.vertex_streams_count)
+        {
+            ++stream;
+            offset = 0;
+        }
+
+        VertexAttribute attribute = InShaderState.VertexInputs[i];
+        attribute.binding         = OutVertexInput.vertex_stream[stream].binding;
+        attribute.offset          = offset;
+        OutVertexInput.AddVertexAttribute(attribute);
+
+        offset += GetVertexFormatSize(attribute.format);
+    }
+
+    if (stream + 1 != OutVertexInput.vertex_streams_count || offset != OutVertexInput.vertex_stream[stream].stride)
+    {
+        SERROR("Vertex inputs of pipeline %s don't match the strides of its vertex streams.", InName.c_str());
+        return false;
+    }
+
+    return true;
+}
+
 VulkanPipeline::~VulkanPipeline()
 {
     Destroy();
 }
 
-PipelineHandle VulkanPipeline::Create(VulkanDevice* InDevice, const PipelineDescriptor& InDescriptor)
+PipelineHandle VulkanPipeline::Create(VulkanDevice* InDevice, const PipelineDescriptor& InDescriptor, bool bAsync)
 {
     PipelineHandle handle = {InDevice->pipelines.ObtainResource()};
 
@@ -86,40 +130,118 @@ PipelineHandle VulkanPipeline::Create(VulkanDevice* InDevice, const PipelineDesc
     VulkanPipeline*    pipeline     = InDevice->GetPipelineResource(handle);
     VulkanShaderState* shader_state = InDevice->GetShaderResource(shader_state_handle);
 
-    pipeline->shader_state = shader_state_handle;
+    // Vertex attributes not given by the descriptor come from the vertex shader inputs.
+    PipelineDescriptor descriptor = InDescriptor;
+    if (shader_state->bIsGraphicsPipeline && descriptor.vertexInputState.vertex_attributes_count == 0 && shader_state->VertexInputsCount > 0)
+    {
+        if (!ReflectVertexInput(*shader_state, descriptor.name, descriptor.vertexInputState))
+        {
+            InDevice->DestroyShaderStateInstant(shader_state_handle.index);
+            InDevice->pipelines.ReleaseResource(handle.index);
+            handle.index = INVALID_ID;
+            return handle;
+        }
+    }
 
-    VkDescriptorSetLayout layouts[MAX_DESCRIPTOR_SET_LAYOUTS];
+    pipeline->shader_state = shader_state_handle;
 
-    for (u32 i = 0; i < InDescriptor.active_layouts_count; ++i)
+    // Same for the set layouts, reflected layouts are shared with every pipeline declaring the same bindings.
+    if (descriptor.active_layouts_count == 0)
     {
-        pipeline->descriptor_set_layout[i]        = InDevice->GetDescriptorSetLayoutResource(InDescriptor.descriptor_set_layout[i]);
-        pipeline->descriptor_set_layout_handle[i] = InDescriptor.descriptor_set_layout[i];
+        for (u32 set = 0; set < shader_state->SetsCount; ++set)
+        {
+            // The heap layout is shared by every pipeline, the shaders declare only the arrays they read.
+            if (set == BINDLESS_SET_INDEX && InDevice->bindless_set != VK_NULL_HANDLE)
+            {
+                descriptor.AddDescriptorSetLayout(InDevice->bindless_layout);
+                continue;
+            }
+
+            DescriptorSetLayoutDescriptor layout_descriptor;
+            layout_descriptor.SetSetIndex(set).SetName(descriptor.name);
+
+            for (u32 i = 0; i < shader_state->BindingsCount; ++i)
+            {
+                const VulkanShaderBinding& binding = shader_state->Bindings[i];
+                if (binding.set != set)
+                {
+                    continue;
+                }
 
-        layouts[i] = pipeline->descriptor_set_layout[i]->descriptor_set_layout;
+                // Without the heap layout an unsized array would silently become a single descriptor.
+                if (binding.count == 0)
+                {
+                    SERROR("Pipeline %s reads an unsized array at set %d binding %d, but bindless isn't supported. Give it an explicit layout.",
+                           descriptor.name.c_str(),
+                           set,
+                           binding.start);
+                    InDevice->DestroyShaderStateInstant(shader_state_handle.index);
+                    InDevice->pipelines.ReleaseResource(handle.index);
+                    handle.index = INVALID_ID;
+                    return handle;
+                }
+
+                layout_descriptor.AddBinding({binding.type, binding.start, binding.count, ""});
+            }
+
+            descriptor.AddDescriptorSetLayout(InDevice->GetCachedDescriptorSetLayout(layout_descriptor));
+        }
     }
 
-    VkPipelineLayoutCreateInfo pipeline_layout_info = {VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
-    pipeline_layout_info.pSetLayouts                = layouts;
-    pipeline_layout_info.setLayoutCount             = InDescriptor.active_layouts_count;
+    for (u32 i = 0; i < descriptor.active_layouts_count; ++i)
+    {
+        pipeline->descriptor_set_layout[i]        = InDevice->GetDescriptorSetLayoutResource(descriptor.descriptor_set_layout[i]);
+        pipeline->descriptor_set_layout_handle[i] = descriptor.descriptor_set_layout[i];
+    }
 
-    VkPipelineLayout pipeline_layout;
-    vkcheck(vkCreatePipelineLayout(InDevice->Handle, &pipeline_layout_info, nullptr, &pipeline_layout));
+    // Owned by the device, pipelines with compatible layouts share it.
+    VkPipelineLayout pipeline_layout = InDevice->GetCachedPipelineLayout(pipeline->descriptor_set_layout, descriptor.active_layouts_count, shader_state->PushConstants);
 
     pipeline->pipelineLayout      = pipeline_layout;
-    pipeline->active_layout_count = InDescriptor.active_layouts_count;
+    pipeline->push_constants      = shader_state->PushConstants;
+    pipeline->active_layout_count = descriptor.active_layouts_count;
+    pipeline->bindless            = InDevice->bindless_set != VK_NULL_HANDLE && descriptor.active_layouts_count > BINDLESS_SET_INDEX && descriptor.descriptor_set_layout[BINDLESS_SET_INDEX].index == InDevice->bindless_layout.index;
+
+    // Resolved on the calling thread, the render pass cache and resource pools are not thread safe. With dynamic
+    // rendering the pipeline is created from the attachment formats instead.
+    VkRenderPass render_pass = shader_state->bIsGraphicsPipeline && !InDevice->bDynamicRendering ? InDevice->GetVulkanRenderPass(descriptor.render_pass, descriptor.name) : VK_NULL_HANDLE;
+    pipeline->bind_point     = shader_state->bIsGraphicsPipeline ? VK_PIPELINE_BIND_POINT_GRAPHICS : VK_PIPELINE_BIND_POINT_COMPUTE;
+    pipeline->bFailed        = false;
 
-    if (shader_state->bIsGraphicsPipeline)
+    if (bAsync)
+    {
+        // The job works on copies, the descriptor and shader state may change before it runs.
+        pipeline->pipeline = VK_NULL_HANDLE;
+        InDevice->QueuePipelineCompile(handle, std::async(std::launch::async, [InDevice, descriptor = std::move(descriptor), stages = *shader_state, pipeline_layout, render_pass]()
+                                                          { return Compile(InDevice, descriptor, stages, pipeline_layout, render_pass); }));
+    }
+    else
+    {
+        pipeline->pipeline = Compile(InDevice, descriptor, *shader_state, pipeline_layout, render_pass);
+    }
+
+    return handle;
+}
+
+VkPipeline VulkanPipeline::Compile(VulkanDevice* InDevice, const PipelineDescriptor& InDescriptor, const VulkanShaderState& InShaderState, VkPipelineLayout InLayout, VkRenderPass InRenderPass)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    VkPipeline result = VK_NULL_HANDLE;
+    VkResult   status = VK_SUCCESS;
+
+    if (InShaderState.bIsGraphicsPipeline)
     {
         VkGraphicsPipelineCreateInfo pipeline_info = {VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
 
-        pipeline_info.pStages    = shader_state->ShaderStageInfo;
-        pipeline_info.stageCount = shader_state->ActiveShaders;
+        pipeline_info.pStages    = InShaderState.ShaderStageInfo;
+        pipeline_info.stageCount = InShaderState.ActiveShaders;
 
-        pipeline_info.layout = pipeline_layout;
+        pipeline_info.layout = InLayout;
 
         VkPipelineVertexInputStateCreateInfo vertex_input_info = {VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
 
-        VkVertexInputAttributeDescription vertex_attributes[8];
+        VkVertexInputAttributeDescription vertex_attributes[MAX_VERTEX_ATTRIBUTE];
         if (InDescriptor.vertexInputState.vertex_attributes_count)
         {
             for (u32 i = 0; i < InDescriptor.vertexInputState.vertex_attributes_count; ++i)
@@ -137,7 +259,7 @@ PipelineHandle VulkanPipeline::Create(VulkanDevice* InDevice, const PipelineDesc
             vertex_input_info.pVertexAttributeDescriptions    = nullptr;
         }
 
-        VkVertexInputBindingDescription vertex_bindings[8];
+        VkVertexInputBindingDescription vertex_bindings[MAX_VERTEX_STREAMS];
         if (InDescriptor.vertexInputState.vertex_streams_count)
         {
             for (u32 i = 0; i < InDescriptor.vertexInputState.vertex_streams_count; ++i)
@@ -199,7 +321,7 @@ PipelineHandle VulkanPipeline::Create(VulkanDevice* InDevice, const PipelineDesc
         }
 
         VkPipelineColorBlendStateCreateInfo blend_state_info{VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO};
-        blend_state_info.logicOpEnable     = VK_TRUE;
+        blend_state_info.logicOpEnable     = VK_FALSE; // The logicOp feature is not enabled, a logic op would also disable blending.
         blend_state_info.logicOp           = VK_LOGIC_OP_COPY;
         blend_state_info.attachmentCount   = InDescriptor.blendState.ActiveStates ? InDescriptor.blendState.ActiveStates : 1;
         blend_state_info.pAttachments      = color_blend_attachments;
@@ -267,7 +389,25 @@ PipelineHandle VulkanPipeline::Create(VulkanDevice* InDevice, const PipelineDesc
 
         pipeline_info.pViewportState = &viewport_info;
 
-        pipeline_info.renderPass = InDevice->GetVulkanRenderPass(InDescriptor.render_pass, InDescriptor.name);
+        pipeline_info.renderPass = InRenderPass;
+
+        VkFormat                      color_formats[MAX_IMAGE_OUTPUTS];
+        VkPipelineRenderingCreateInfo rendering_info = {VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO};
+        if (InRenderPass == VK_NULL_HANDLE)
+        {
+            const RenderPassOutput& output = InDescriptor.render_pass;
+            for (u32 i = 0; i < output.ColorFormatCounts; ++i)
+            {
+                color_formats[i] = ConvertFormat(output.ColorFormats[i]);
+            }
+
+            rendering_info.colorAttachmentCount    = output.ColorFormatCounts;
+            rendering_info.pColorAttachmentFormats = color_formats;
+            rendering_info.depthAttachmentFormat   = HasDepth(output.DepthStencilFormat) ? ConvertFormat(output.DepthStencilFormat) : VK_FORMAT_UNDEFINED;
+            rendering_info.stencilAttachmentFormat = HasDepthOrStencil(output.DepthStencilFormat) && !IsDepthOnly(output.DepthStencilFormat) ? ConvertFormat(output.DepthStencilFormat) : VK_FORMAT_UNDEFINED;
+
+            pipeline_info.pNext = &rendering_info;
+        }
 
         VkDynamicState                   dynamic_state[2] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
         VkPipelineDynamicStateCreateInfo dynamic_state_info{VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
@@ -276,21 +416,29 @@ PipelineHandle VulkanPipeline::Create(VulkanDevice* InDevice, const PipelineDesc
 
         pipeline_info.pDynamicState = &dynamic_state_info;
 
-        vkCreateGraphicsPipelines(InDevice->Handle, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline->pipeline);
-        pipeline->bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        status = vkCreateGraphicsPipelines(InDevice->Handle, InDevice->pipeline_cache, 1, &pipeline_info, nullptr, &result);
     }
     else
     {
         VkComputePipelineCreateInfo pipeline_info{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
 
-        pipeline_info.stage  = shader_state->ShaderStageInfo[0];
-        pipeline_info.layout = pipeline_layout;
+        pipeline_info.stage  = InShaderState.ShaderStageInfo[0];
+        pipeline_info.layout = InLayout;
 
-        vkCreateComputePipelines(InDevice->Handle, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline->pipeline);
-        pipeline->bind_point = VK_PIPELINE_BIND_POINT_COMPUTE;
+        status = vkCreateComputePipelines(InDevice->Handle, InDevice->pipeline_cache, 1, &pipeline_info, nullptr, &result);
     }
 
-    return handle;
+    if (status != VK_SUCCESS)
+    {
+        SERROR("Failed to compile pipeline %s (VkResult %d).", InDescriptor.name.c_str(), static_cast<i32>(status));
+        result = VK_NULL_HANDLE;
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+    InDevice->pipeline_compile_us += static_cast<u64>(elapsed.count());
+    ++InDevice->pipeline_compile_count;
+
+    return result;
 }
 
 void VulkanPipeline::Destroy()
@@ -56,11 +56,13 @@ RenderPassHandle VulkanRenderPass::Create(VulkanDevice* InDevice, const RenderPa
 
     VulkanRenderPass* render_pass     = static_cast<VulkanRenderPass*>(InDevice->renderpasses.AccessResource(handle.index));
     render_pass->type                 = InDescriptor.Type;
+    render_pass->renderpass           = VK_NULL_HANDLE;
     render_pass->render_targets_count = static_cast<u8>(InDescriptor.RenderTargetsCount);
     render_pass->dispatch_x           = 0;
     render_pass->dispatch_y           = 0;
     render_pass->dispatch_z           = 0;
     render_pass->name                 = InDescriptor.Name;
+    render_pass->profile_name         = Profiler::InternName(InDescriptor.Name.c_str());
     render_pass->scale_x              = InDescriptor.ScaleX;
     render_pass->scale_y              = InDescriptor.ScaleY;
     render_pass->resize               = InDescriptor.Resize;
@@ -76,6 +78,13 @@ RenderPassHandle VulkanRenderPass::Create(VulkanDevice* InDevice, const RenderPa
     }
 
     render_pass->depth_texture = InDescriptor.DepthStencilTexture;
+    if (InDescriptor.Type == RenderPassType::GEOMETRY && InDescriptor.RenderTargetsCount == 0)
+    {
+        const VulkanTexture* texture = InDevice->GetTextureResource(InDescriptor.DepthStencilTexture);
+
+        render_pass->width = texture->descriptor.width;
+        render_pass->heigh = texture->descriptor.height;
+    }
 
     switch (InDescriptor.Type)
     {
@@ -90,8 +99,11 @@ RenderPassHandle VulkanRenderPass::Create(VulkanDevice* InDevice, const RenderPa
         }
         case RenderPassType::GEOMETRY:
         {
-            render_pass->output     = FillRenderPassOutput(InDevice, InDescriptor);
-            render_pass->renderpass = InDevice->GetVulkanRenderPass(render_pass->output, InDescriptor.Name);
+            render_pass->output = FillRenderPassOutput(InDevice, InDescriptor);
+            if (!InDevice->bDynamicRendering)
+            {
+                render_pass->renderpass = InDevice->GetVulkanRenderPass(render_pass->output, InDescriptor.Name);
+            }
             break;
         }
     }
@@ -191,14 +203,12 @@ VkRenderPass VulkanRenderPass::CreateRenderPass(const VulkanDevice* InDevice, co
     subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 
     VkAttachmentDescription attachments[MAX_IMAGE_OUTPUTS + 1]{};
-    u32                     active_attachments = 0;
-    for (; active_attachments < InOutput.ColorFormatCounts; ++active_attachments)
+    for (u32 active_attachments = 0; active_attachments < InOutput.ColorFormatCounts; ++active_attachments)
     {
         attachments[active_attachments] = color_attachments[active_attachments];
-        ++active_attachments;
     }
 
-    subpass.colorAttachmentCount = active_attachments ? active_attachments - 1 : 0;
+    subpass.colorAttachmentCount = InOutput.ColorFormatCounts;
     subpass.pColorAttachments    = color_attachment_refs;
 
     subpass.pDepthStencilAttachment = nullptr;
@@ -211,7 +221,7 @@ VkRenderPass VulkanRenderPass::CreateRenderPass(const VulkanDevice* InDevice, co
     }
 
     VkRenderPassCreateInfo render_pass_info = {VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO};
-    render_pass_info.attachmentCount        = (active_attachments ? active_attachments - 1 : 0) + depth_stencil_count;
+    render_pass_info.attachmentCount        = subpass.colorAttachmentCount + depth_stencil_count;
     render_pass_info.pAttachments           = attachments;
     render_pass_info.subpassCount           = 1;
     render_pass_info.pSubpasses             = &subpass;
@@ -225,13 +235,11 @@ VkRenderPass VulkanRenderPass::CreateRenderPass(const VulkanDevice* InDevice, co
 void VulkanRenderPass::Destroy()
 {
     SASSERT(device != nullptr);
-    vkDestroyFramebuffer(device->Handle, framebuffer, nullptr);
     vkDestroyRenderPass(device->Handle, renderpass, nullptr);
 
-    device      = nullptr;
-    renderpass  = VK_NULL_HANDLE;
-    framebuffer = VK_NULL_HANDLE;
-    beginInfo   = {};
+    device     = nullptr;
+    renderpass = VK_NULL_HANDLE;
+    beginInfo  = {};
 }
 
 } // namespace Vk
@@ -59,44 +59,193 @@ char* VulkanShader::ReadShaderFile(const std::string& InFilename, u32& OutSize)
     return nullptr;
 }
 
-static std::string add_shader_extension(VkShaderStageFlagBits stage)
+static VertexFormat ReflectVertexFormat(const spirv_cross::SPIRType& InType)
 {
-    switch (stage)
+    if (InType.basetype == spirv_cross::SPIRType::Float)
     {
-    case VK_SHADER_STAGE_VERTEX_BIT:
-        return ".vert";
-    case VK_SHADER_STAGE_FRAGMENT_BIT:
-        return ".frag";
-    case VK_SHADER_STAGE_COMPUTE_BIT:
-        return ".comp";
-    default:
-        return "";
+        switch (InType.vecsize)
+        {
+            case 1:
+                return VertexFormat::FLOAT;
+            case 2:
+                return VertexFormat::FLOAT2;
+            case 3:
+                return VertexFormat::FLOAT3;
+            case 4:
+                return VertexFormat::FLOAT4;
+        }
     }
+    else if (InType.basetype == spirv_cross::SPIRType::UInt)
+    {
+        switch (InType.vecsize)
+        {
+            case 1:
+                return VertexFormat::UINT;
+            case 2:
+                return VertexFormat::UINT2;
+            case 4:
+                return VertexFormat::UINT4;
+        }
+    }
+
+    return VertexFormat::COUNT;
 }
 
-VkShaderModuleCreateInfo CompileShader(const char* code, u32 size, VkShaderStageFlagBits stage, std::string name)
+static bool ReflectBinding(const spirv_cross::Compiler& InCompiler, const spirv_cross::Resource& InResource, DescriptorType InType, const std::string& InName, VulkanShaderState* OutState)
 {
-    VkShaderModuleCreateInfo ShaderCreateInfo{VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+    const spirv_cross::SPIRType& type          = InCompiler.get_type(InResource.type_id);
+    const u32                    set           = InCompiler.get_decoration(InResource.id, spv::DecorationDescriptorSet);
+    const u32                    start         = InCompiler.get_decoration(InResource.id, spv::DecorationBinding);
+    const bool                   bRuntimeArray = !type.array.empty() && type.array_size_literal[0] && type.array[0] == 0;
+    const u32                    count         = type.array.empty() ? 1 : type.array[0];
+
+    // Texel buffers are images with a buffer dimension.
+    if (type.basetype == spirv_cross::SPIRType::Image && type.image.dim == spv::DimBuffer)
+    {
+        InType = InType == DescriptorType::STORAGE_IMAGE ? DescriptorType::STORAGE_TEXEL_BUFFER : DescriptorType::UNIFORM_TEXEL_BUFFER;
+    }
 
-    // Create dummy file
-    std::string temporal_shader_name = "temporal" + add_shader_extension(stage);
-    FILE* temporal_shader_file = fopen(temporal_shader_name.c_str(), "w");
-    fwrite( code, size, 1, temporal_shader_file);
-    fclose(temporal_shader_file);
+    if (set >= MAX_DESCRIPTOR_SET_LAYOUTS)
+    {
+        SERROR("Shader %s uses set %d, only %d sets are supported.", InName.c_str(), set, MAX_DESCRIPTOR_SET_LAYOUTS);
+        return false;
+    }
 
-    std::string output_name = temporal_shader_name + ".spv";
-    std::string command = std::string("glslc.exe ") + temporal_shader_name + " -o " + output_name;
+    // Unsized arrays are sized by the device heap layout, a reflected layout can't know how many descriptors they need.
+    if (bRuntimeArray && set != BINDLESS_SET_INDEX)
+    {
+        SERROR("Shader %s declares an unsized array at set %d binding %d, give the pipeline an explicit layout.", InName.c_str(), set, start);
+        return false;
+    }
 
-    system(command.c_str());
+    // Array sizes from specialization constants aren't known here either.
+    if (!type.array.empty() && !type.array_size_literal[0])
+    {
+        SERROR("Shader %s sizes the array at set %d binding %d with a constant, give the pipeline an explicit layout.", InName.c_str(), set, start);
+        return false;
+    }
 
-    auto binary_data = VulkanShader::ReadBinaryShaderFile(output_name);
+    // Stages share descriptors, each one is added once.
+    u32 set_bindings = 0;
+    for (u32 i = 0; i < OutState->BindingsCount; ++i)
+    {
+        const VulkanShaderBinding& binding = OutState->Bindings[i];
+        if (binding.set != set)
+        {
+            continue;
+        }
 
-    ShaderCreateInfo.codeSize = static_cast<u32>(binary_data.size());
-    ShaderCreateInfo.pCode = reinterpret_cast<u32*>(binary_data.data());
+        if (binding.start == start)
+        {
+            if (binding.type != InType || binding.count != count)
+            {
+                SERROR("Shader %s declares set %d binding %d differently in two stages.", InName.c_str(), set, start);
+                return false;
+            }
+            return true;
+        }
 
-    i32 result = remove(temporal_shader_name.c_str());
+        ++set_bindings;
+    }
 
-    return ShaderCreateInfo;
+    if (set_bindings == MAX_DESCRIPTOR_PER_SET)
+    {
+        SERROR("Shader %s uses more than %d bindings in set %d.", InName.c_str(), MAX_DESCRIPTOR_PER_SET, set);
+        return false;
+    }
+
+    VulkanShaderBinding& binding = OutState->Bindings[OutState->BindingsCount++];
+    binding.type                 = InType;
+    binding.set                  = static_cast<u16>(set);
+    binding.start                = static_cast<u16>(start);
+    binding.count                = static_cast<u16>(count);
+
+    OutState->SetsCount = std::max(OutState->SetsCount, set + 1);
+    return true;
+}
+
+// Adds the descriptors, push constants and vertex inputs used by the stage to the shader state.
+static bool Reflect(const u32* InCode, size_t InWordCount, ShaderStageType InStage, const std::string& InName, VulkanShaderState* OutState)
+{
+    try
+    {
+        spirv_cross::Compiler              compiler(InCode, InWordCount);
+        const spirv_cross::ShaderResources resources = compiler.get_shader_resources();
+
+        const std::pair<const spirv_cross::SmallVector<spirv_cross::Resource>*, DescriptorType> descriptors[] = {
+            // Constants live in the per frame dynamic buffer, uniform buffers are bound with a dynamic offset.
+            {&resources.uniform_buffers, DescriptorType::UNIFOR_BUFFER_DYNAMIC},
+            {&resources.storage_buffers, DescriptorType::STORAGE_BUFFER},
+            {&resources.sampled_images, DescriptorType::COMBINED_IMAGE_SAMPLER},
+            {&resources.separate_images, DescriptorType::SAMPLED_IMAGE},
+            {&resources.separate_samplers, DescriptorType::SAMPLER},
+            {&resources.storage_images, DescriptorType::STORAGE_IMAGE},
+        };
+
+        for (const auto& descriptor : descriptors)
+        {
+            for (const spirv_cross::Resource& resource : *descriptor.first)
+            {
+                if (!ReflectBinding(compiler, resource, descriptor.second, InName, OutState))
+                {
+                    return false;
+                }
+            }
+        }
+
+        std::sort(OutState->Bindings, OutState->Bindings + OutState->BindingsCount, [](const VulkanShaderBinding& a, const VulkanShaderBinding& b)
+                  { return a.set != b.set ? a.set < b.set : a.start < b.start; });
+
+        // One range from offset 0 shared by every stage using push constants.
+        for (const spirv_cross::Resource& resource : resources.push_constant_buffers)
+        {
+            const u32 size                     = static_cast<u32>(compiler.get_declared_struct_size(compiler.get_type(resource.base_type_id)));
+            OutState->PushConstants.size       = std::max(OutState->PushConstants.size, size);
+            OutState->PushConstants.stageFlags |= ConvertShaderStage(InStage);
+        }
+
+        if (InStage != ShaderStageType::VERTEX)
+        {
+            return true;
+        }
+
+        for (const spirv_cross::Resource& resource : resources.stage_inputs)
+        {
+            const spirv_cross::SPIRType& type     = compiler.get_type(resource.type_id);
+            const u32                    location = compiler.get_decoration(resource.id, spv::DecorationLocation);
+            const VertexFormat           format   = ReflectVertexFormat(type);
+
+            if (format == VertexFormat::COUNT)
+            {
+                SERROR("Vertex input %s of shader %s has an unsupported type.", resource.name.c_str(), InName.c_str());
+                return false;
+            }
+
+            // Matrices take one location per column.
+            for (u32 column = 0; column < type.columns; ++column)
+            {
+                if (OutState->VertexInputsCount == MAX_VERTEX_ATTRIBUTE)
+                {
+                    SERROR("Shader %s has more than %d vertex inputs.", InName.c_str(), MAX_VERTEX_ATTRIBUTE);
+                    return false;
+                }
+
+                VertexAttribute& attribute = OutState->VertexInputs[OutState->VertexInputsCount++];
+                attribute.location         = static_cast<u16>(location + column);
+                attribute.format           = format;
+            }
+        }
+
+        std::sort(OutState->VertexInputs, OutState->VertexInputs + OutState->VertexInputsCount, [](const VertexAttribute& a, const VertexAttribute& b)
+                  { return a.location < b.location; });
+    }
+    catch (const spirv_cross::CompilerError& error)
+    {
+        SERROR("Failed to reflect shader %s: %s", InName.c_str(), error.what());
+        return false;
+    }
+
+    return true;
 }
 
 ShaderStateHandle VulkanShader::Create(VulkanDevice* InDevice, const ShaderStateDescriptor& InDescriptor)
@@ -119,6 +268,10 @@ ShaderStateHandle VulkanShader::Create(VulkanDevice* InDevice, const ShaderState
     VulkanShaderState* ShaderState   = static_cast<VulkanShaderState*>(InDevice->shaders.AccessResource(handle.index));
     ShaderState->bIsGraphicsPipeline = true;
     ShaderState->ActiveShaders       = 0;
+    ShaderState->BindingsCount       = 0;
+    ShaderState->SetsCount           = 0;
+    ShaderState->PushConstants       = {};
+    ShaderState->VertexInputsCount   = 0;
     u32 CompiledShaders              = 0;
 
     for (CompiledShaders; CompiledShaders < InDescriptor.stages_count; ++CompiledShaders)
@@ -131,6 +284,7 @@ ShaderStateHandle VulkanShader::Create(VulkanDevice* InDevice, const ShaderState
         }
 
         VkShaderModuleCreateInfo ShaderModuleInfo = {VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+        std::vector<u32>         spirv; // Must outlive vkCreateShaderModule.
 
         if (InDescriptor.spv_input)
         {
@@ -139,7 +293,18 @@ ShaderStateHandle VulkanShader::Create(VulkanDevice* InDevice, const ShaderState
         }
         else
         {
-            ShaderModuleInfo = CompileShader(stage.code, stage.size, ConvertShaderStage(stage.type), InDescriptor.name);
+            if (!InDevice->shader_compiler.Compile(stage.code, stage.size, stage.type, InDescriptor.name, InDescriptor.defines, InDescriptor.include_directory, spirv))
+            {
+                break;
+            }
+
+            ShaderModuleInfo.codeSize = spirv.size() * sizeof(u32);
+            ShaderModuleInfo.pCode    = spirv.data();
+        }
+
+        if (!Reflect(ShaderModuleInfo.pCode, ShaderModuleInfo.codeSize / sizeof(u32), stage.type, InDescriptor.name, ShaderState))
+        {
+            break;
         }
 
         VkPipelineShaderStageCreateInfo& ShaderStageInfo = ShaderState->ShaderStageInfo[CompiledShaders];
@@ -149,7 +314,10 @@ ShaderStateHandle VulkanShader::Create(VulkanDevice* InDevice, const ShaderState
         ShaderStageInfo.stage = ConvertShaderStage(stage.type);
 
         VkShaderModule module;
-        auto ok = vkCreateShaderModule(InDevice->Handle, &ShaderModuleInfo, nullptr, &module);
+        if (vkCreateShaderModule(InDevice->Handle, &ShaderModuleInfo, nullptr, &module) != VK_SUCCESS)
+        {
+            break;
+        }
 
         ShaderState->ShaderStageInfo[CompiledShaders].module = module;
         // TODO Set resource name.
@@ -164,12 +332,15 @@ ShaderStateHandle VulkanShader::Create(VulkanDevice* InDevice, const ShaderState
     }
     else
     {
-        for (u32 i = 0; i < ShaderState->ActiveShaders; ++i)
+        for (u32 i = 0; i < CompiledShaders; ++i)
         {
             vkDestroyShaderModule(InDevice->Handle, ShaderState->ShaderStageInfo[i].module, nullptr);
         }
 
-        SERROR("Failed to create shader %s.\n", InDescriptor.name);
+        SERROR("Failed to create shader %s.\n", InDescriptor.name.c_str());
+
+        InDevice->shaders.ReleaseResource(handle.index);
+        handle.index = INVALID_ID;
     }
 
     return handle;
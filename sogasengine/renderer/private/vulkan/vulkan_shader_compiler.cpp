@@ -0,0 +1,393 @@
+#include "vulkan/vulkan_shader_compiler.h"
+
+#include <chrono>
+#include <filesystem>
+#include <set>
+#include <shaderc/shaderc.hpp>
+#include <thread>
+
+namespace Sogas
+{
+namespace Renderer
+{
+namespace Vk
+{
+
+// Bump when the compile options change, older cache entries stop matching.
+static const u32 SHADER_CACHE_VERSION = 1;
+static const u32 SHADER_CACHE_MAGIC   = 0x56505353; // SSPV
+
+struct ShaderCacheFileHeader
+{
+    u32 magic;
+    u32 version;
+    u64 key;
+    u64 spirv_hash;
+    u64 word_count;
+};
+
+using ShaderClock = std::chrono::high_resolution_clock;
+
+static u64 ElapsedUs(ShaderClock::time_point start)
+{
+    return static_cast<u64>(std::chrono::duration_cast<std::chrono::microseconds>(ShaderClock::now() - start).count());
+}
+
+static shaderc_shader_kind ConvertShaderKind(ShaderStageType stage)
+{
+    switch (stage)
+    {
+        case ShaderStageType::FRAGMENT:
+            return shaderc_glsl_fragment_shader;
+        case ShaderStageType::VERTEX:
+            return shaderc_glsl_vertex_shader;
+        case ShaderStageType::COMPUTE:
+            return shaderc_glsl_compute_shader;
+        case ShaderStageType::UNDEFINED:
+        default:
+            return shaderc_glsl_infer_from_source;
+    }
+}
+
+// Path of an included file, empty when it is not found. Quoted includes are looked for next to the including file
+// first, the top level source is named after the shader and has no directory.
+static std::string ResolveInclude(const std::string& InDirectory, const std::string& InRequested, const std::string& InRequesting, bool bRelative)
+{
+    std::error_code error;
+
+    const std::filesystem::path requesting_directory = std::filesystem::path(InRequesting).parent_path();
+    if (bRelative && !requesting_directory.empty())
+    {
+        const std::filesystem::path path = requesting_directory / InRequested;
+        if (std::filesystem::is_regular_file(path, error))
+        {
+            return path.string();
+        }
+    }
+
+    if (!InDirectory.empty())
+    {
+        const std::filesystem::path path = std::filesystem::path(InDirectory) / InRequested;
+        if (std::filesystem::is_regular_file(path, error))
+        {
+            return path.string();
+        }
+    }
+
+    return {};
+}
+
+static bool ReadInclude(const std::string& InPath, std::string& OutContent)
+{
+    std::ifstream file(InPath, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    OutContent.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Calls InFunction with the name and quoting of every #include line. Includes disabled by the preprocessor are listed
+// too, they only make the cache key stricter.
+template <typename Function>
+static void ForEachInclude(const std::string& InSource, Function InFunction)
+{
+    size_t line_start = 0;
+    while (line_start < InSource.size())
+    {
+        size_t line_end = InSource.find('\n', line_start);
+        if (line_end == std::string::npos)
+        {
+            line_end = InSource.size();
+        }
+
+        size_t i = InSource.find_first_not_of(" \t", line_start);
+        if (i < line_end && InSource[i] == '#')
+        {
+            i = InSource.find_first_not_of(" \t", i + 1);
+            if (i < line_end && InSource.compare(i, 7, "include") == 0)
+            {
+                const size_t open = InSource.find_first_of("\"<", i + 7);
+                if (open < line_end)
+                {
+                    const bool   bRelative = InSource[open] == '"';
+                    const size_t close     = InSource.find(bRelative ? '"' : '>', open + 1);
+                    if (close < line_end)
+                    {
+                        InFunction(InSource.substr(open + 1, close - open - 1), bRelative);
+                    }
+                }
+            }
+        }
+
+        line_start = line_end + 1;
+    }
+}
+
+// Hashes the files included by InSource, recursively, in the order they appear.
+static u64 HashIncludes(const std::string& InSource, const std::string& InSourcePath, const std::string& InDirectory, u64 InKey, std::set<std::string>& InOutVisited)
+{
+    ForEachInclude(InSource,
+                   [&](const std::string& requested, bool bRelative)
+                   {
+                       const std::string path = ResolveInclude(InDirectory, requested, InSourcePath, bRelative);
+
+                       // Missing includes fail the compile, nothing is cached for them.
+                       std::string content;
+                       if (path.empty() || !InOutVisited.insert(path).second || !ReadInclude(path, content))
+                       {
+                           return;
+                       }
+
+                       InKey = wyhash(content.data(), content.size(), InKey ^ content.size(), _wyp);
+                       InKey = HashIncludes(content, path, InDirectory, InKey, InOutVisited);
+                   });
+
+    return InKey;
+}
+
+// Gives shaderc the files included by the sources, read from disk on each request.
+class ShaderIncluder : public shaderc::CompileOptions::IncluderInterface
+{
+  public:
+    explicit ShaderIncluder(const std::string& InDirectory)
+    : directory(InDirectory)
+    {
+    }
+
+    shaderc_include_result* GetInclude(const char* requested_source, shaderc_include_type type, const char* requesting_source, size_t /*include_depth*/) override
+    {
+        Include* include = new Include;
+        include->name    = ResolveInclude(directory, requested_source, requesting_source, type == shaderc_include_type_relative);
+        if (include->name.empty() || !ReadInclude(include->name, include->content))
+        {
+            // An empty name reports the content as the error.
+            include->name.clear();
+            include->content = std::string("Could not find include ") + requested_source + ".";
+        }
+
+        include->result.source_name        = include->name.c_str();
+        include->result.source_name_length = include->name.size();
+        include->result.content            = include->content.c_str();
+        include->result.content_length     = include->content.size();
+        include->result.user_data          = include;
+        return &include->result;
+    }
+
+    void ReleaseInclude(shaderc_include_result* data) override
+    {
+        delete static_cast<Include*>(data->user_data);
+    }
+
+  private:
+    struct Include
+    {
+        std::string            name;
+        std::string            content;
+        shaderc_include_result result;
+    };
+
+    std::string directory;
+};
+
+void VulkanShaderCompiler::Init(const std::string& InCacheDirectory)
+{
+    cache_directory = InCacheDirectory;
+
+    if (!cache_directory.empty())
+    {
+        std::error_code error;
+        std::filesystem::create_directories(cache_directory, error);
+        if (error)
+        {
+            SWARNING("Could not create shader cache directory '%s', shaders are compiled every run.", cache_directory.c_str());
+            cache_directory.clear();
+        }
+    }
+}
+
+void VulkanShaderCompiler::Shutdown()
+{
+    SINFO("\tShaders: %d compiled in %.3f ms, %d loaded from cache in %.3f ms.",
+          cache_misses.load(),
+          static_cast<f64>(compile_us.load()) / 1000.0,
+          cache_hits.load(),
+          static_cast<f64>(load_us.load()) / 1000.0);
+
+    std::lock_guard<std::mutex> lock(memory_cache_mutex);
+    memory_cache.clear();
+}
+
+bool VulkanShaderCompiler::Compile(const char* code, u32 size, ShaderStageType stage, const std::string& name, const Defines& defines, const std::string& include_directory, std::vector<u32>& OutSpirv)
+{
+    const auto start = ShaderClock::now();
+
+    const u64 key = ComputeKey(code, size, stage, name, defines, include_directory);
+    {
+        std::lock_guard<std::mutex> lock(memory_cache_mutex);
+        auto                        it = memory_cache.find(key);
+        if (it != memory_cache.end())
+        {
+            OutSpirv = it->second;
+            load_us += ElapsedUs(start);
+            ++cache_hits;
+            return true;
+        }
+    }
+
+    if (LoadCached(key, OutSpirv))
+    {
+        std::lock_guard<std::mutex> lock(memory_cache_mutex);
+        memory_cache[key] = OutSpirv;
+
+        load_us += ElapsedUs(start);
+        ++cache_hits;
+        return true;
+    }
+
+    shaderc::CompileOptions options;
+    options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
+    options.SetOptimizationLevel(shaderc_optimization_level_performance);
+    for (const auto& define : defines)
+    {
+        options.AddMacroDefinition(define.first, define.second);
+    }
+    options.SetIncluder(std::make_unique<ShaderIncluder>(include_directory));
+
+    // The compiler is cheap to create, one per call keeps concurrent compiles independent.
+    shaderc::Compiler                   compiler;
+    const shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(code, size, ConvertShaderKind(stage), name.c_str(), options);
+
+    if (result.GetCompilationStatus() != shaderc_compilation_status_success)
+    {
+        SERROR("Failed to compile shader %s: %s", name.c_str(), result.GetErrorMessage().c_str());
+        return false;
+    }
+
+    OutSpirv.assign(result.cbegin(), result.cend());
+    StoreCached(key, OutSpirv);
+    {
+        std::lock_guard<std::mutex> lock(memory_cache_mutex);
+        memory_cache[key] = OutSpirv;
+    }
+
+    compile_us += ElapsedUs(start);
+    ++cache_misses;
+    return true;
+}
+
+u64 VulkanShaderCompiler::ComputeKey(const char* code, u32 size, ShaderStageType stage, const std::string& name, const Defines& defines, const std::string& include_directory) const
+{
+    u64 key = wyhash(code, size, (static_cast<u64>(SHADER_CACHE_VERSION) << 32) | static_cast<u64>(stage), _wyp);
+    for (const auto& define : defines)
+    {
+        // Lengths are hashed too, "A" "BC" and "AB" "C" give different keys.
+        key = wyhash(define.first.data(), define.first.size(), key ^ define.first.size(), _wyp);
+        key = wyhash(define.second.data(), define.second.size(), key ^ define.second.size(), _wyp);
+    }
+
+    // Included files are read again on every compile, an edited header gives a new key.
+    std::set<std::string> visited;
+    return HashIncludes(std::string(code, size), name, include_directory, key, visited);
+}
+
+bool VulkanShaderCompiler::LoadCached(u64 key, std::vector<u32>& OutSpirv) const
+{
+    if (cache_directory.empty())
+    {
+        return false;
+    }
+
+    char filename[32];
+    snprintf(filename, sizeof(filename), "%016llx.spv", static_cast<unsigned long long>(key));
+
+    const std::filesystem::path path = std::filesystem::path(cache_directory) / filename;
+
+    std::error_code error;
+    const uintmax_t file_size = std::filesystem::file_size(path, error);
+    if (error)
+    {
+        return false;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    ShaderCacheFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != SHADER_CACHE_MAGIC || header.version != SHADER_CACHE_VERSION || header.key != key)
+    {
+        return false;
+    }
+
+    // The count is checked against the file before allocating, a corrupt entry could ask for any size.
+    if (header.word_count > (file_size - sizeof(header)) / sizeof(u32) || sizeof(header) + header.word_count * sizeof(u32) != file_size)
+    {
+        return false;
+    }
+
+    OutSpirv.resize(header.word_count);
+    const std::streamsize byte_count = static_cast<std::streamsize>(header.word_count * sizeof(u32));
+    if (!file.read(reinterpret_cast<char*>(OutSpirv.data()), byte_count) || wyhash(OutSpirv.data(), header.word_count * sizeof(u32), 0, _wyp) != header.spirv_hash)
+    {
+        OutSpirv.clear();
+        return false;
+    }
+
+    return true;
+}
+
+void VulkanShaderCompiler::StoreCached(u64 key, const std::vector<u32>& spirv) const
+{
+    if (cache_directory.empty())
+    {
+        return;
+    }
+
+    char filename[32];
+    snprintf(filename, sizeof(filename), "%016llx.spv", static_cast<unsigned long long>(key));
+
+    const std::filesystem::path path = std::filesystem::path(cache_directory) / filename;
+
+    // Each thread writes its own file and renames it, two threads compiling the same variant never mix their writes.
+    std::filesystem::path temp_path = path;
+    temp_path += "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+
+    ShaderCacheFileHeader header = {};
+    header.magic                 = SHADER_CACHE_MAGIC;
+    header.version               = SHADER_CACHE_VERSION;
+    header.key                   = key;
+    header.spirv_hash            = wyhash(spirv.data(), spirv.size() * sizeof(u32), 0, _wyp);
+    header.word_count            = spirv.size();
+
+    bool bWritten = false;
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(spirv.data()), static_cast<std::streamsize>(spirv.size() * sizeof(u32)));
+        file.close();
+        bWritten = !file.fail();
+    }
+
+    std::error_code error;
+    if (!bWritten)
+    {
+        SWARNING("Could not write shader cache entry '%s'.", path.string().c_str());
+        std::filesystem::remove(temp_path, error);
+        return;
+    }
+
+    std::filesystem::rename(temp_path, path, error);
+    if (error)
+    {
+        std::filesystem::remove(temp_path, error);
+    }
+}
+
+} // namespace Vk
+} // namespace Renderer
+} // namespace Sogas
@@ -86,7 +86,7 @@ void VulkanSwapchain::CreateRenderPass(VulkanRenderPass* render_pass)
     colorAttachment.stencilLoadOp           = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp          = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.initialLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout             = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorAttachment.finalLayout             = present_layout;
 
     VkAttachmentReference colorAttachmentReference = {};
     colorAttachmentReference.attachment            = 0;
@@ -116,7 +116,7 @@ void VulkanSwapchain::CreateRenderPass(VulkanRenderPass* render_pass)
     VkSubpassDependency dependency = {};
     dependency.srcSubpass          = VK_SUBPASS_EXTERNAL;
     dependency.dstSubpass          = 0;
-    dependency.srcAccessMask       = 0;
+    dependency.srcAccessMask       = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT; // Headless frames write the same image.
     dependency.dstAccessMask       = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
     dependency.srcStageMask        = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
     dependency.dstStageMask        = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
@@ -141,14 +141,17 @@ void VulkanSwapchain::CreateRenderPass(VulkanRenderPass* render_pass)
     framebufferInfo.layers                  = 1;
 
     // Create render targets
-    u32 swapchainImageCount = 0;
-    vkGetSwapchainImagesKHR(device->Handle, swapchain, &swapchainImageCount, nullptr);
-    images.resize(swapchainImageCount);
+    u32 swapchainImageCount = static_cast<u32>(images.size());
+    if (swapchain != VK_NULL_HANDLE)
+    {
+        vkGetSwapchainImagesKHR(device->Handle, swapchain, &swapchainImageCount, nullptr);
+        images.resize(swapchainImageCount);
+        vkGetSwapchainImagesKHR(device->Handle,
+                                swapchain,
+                                &swapchainImageCount,
+                                images.data());
+    }
     framebuffers.resize(swapchainImageCount);
-    vkGetSwapchainImagesKHR(device->Handle,
-                            swapchain,
-                            &swapchainImageCount,
-                            images.data());
 
     VkImageView framebuffer_attachments[2];
     framebuffer_attachments[1] = depth_texture->image_view;
@@ -186,9 +189,13 @@ void VulkanSwapchain::CreateRenderPass(VulkanRenderPass* render_pass)
 
     for (auto& image : images)
     {
-        VulkanTexture::TransitionLayout(cmd, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, false);
+        VulkanTexture::TransitionLayout(cmd, image, VK_IMAGE_LAYOUT_UNDEFINED, present_layout, false);
     }
-    VulkanTexture::TransitionLayout(cmd, depth_texture->texture, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, true);
+    if (headless_target.index != INVALID_ID)
+    {
+        device->GetTextureResource(headless_target)->image_layout = present_layout;
+    }
+    VulkanTexture::TransitionLayout(cmd, depth_texture->texture, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true);
 
     vkEndCommandBuffer(cmd->command_buffer);
 
@@ -289,43 +296,107 @@ bool VulkanSwapchain::Create(VulkanDevice* device, std::shared_ptr<VulkanSwapcha
 
     VkSemaphoreCreateInfo semaphoreInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
 
-    if (vkCreateSemaphore(device->Handle, &semaphoreInfo, nullptr, &swapchain->presentCompleteSemaphore) !=
-        VK_SUCCESS)
+    for (auto& semaphore : swapchain->imageAcquiredSemaphores)
     {
-        SERROR("Failed to create swapchain start semaphore!");
-        return false;
+        if (semaphore == VK_NULL_HANDLE && vkCreateSemaphore(device->Handle, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+        {
+            SERROR("Failed to create swapchain start semaphore!");
+            return false;
+        }
     }
 
-    if (vkCreateSemaphore(device->Handle, &semaphoreInfo, nullptr, &swapchain->renderCompleteSemaphore) !=
-        VK_SUCCESS)
+    swapchain->renderCompleteSemaphores.resize(image_count, VK_NULL_HANDLE);
+    for (auto& semaphore : swapchain->renderCompleteSemaphores)
     {
-        SERROR("Failed to create swapchain end semaphore!");
-        return false;
+        if (semaphore == VK_NULL_HANDLE && vkCreateSemaphore(device->Handle, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+        {
+            SERROR("Failed to create swapchain end semaphore!");
+            return false;
+        }
     }
 
+    swapchain->imageFences.assign(image_count, VK_NULL_HANDLE);
+
     STRACE("\tSwapchain image views created.");
     return true;
 }
 
+bool VulkanSwapchain::CreateHeadless(VulkanDevice* device, std::shared_ptr<VulkanSwapchain> swapchain, u16 InWidth, u16 InHeight)
+{
+    STRACE("\tCreating headless render target ...");
+
+    // Fixed format, captures of the same frame are identical whatever the gpu.
+    swapchain->output.Reset();
+    swapchain->output.AddColor(Format::R8G8B8A8_SRGB);
+    swapchain->surfaceFormat  = {VK_FORMAT_R8G8B8A8_SRGB, VK_COLORSPACE_SRGB_NONLINEAR_KHR};
+    swapchain->present_layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    swapchain->width          = InWidth;
+    swapchain->height         = InHeight;
+
+    TextureDescriptor target_descriptor;
+    target_descriptor.SetSize(InWidth, InHeight, 1)
+      .SetFlags(1, TextureFlagsMask::RENDER_TARGET)
+      .SetFormatType(Format::R8G8B8A8_SRGB, TextureDescriptor::TextureType::TEXTURE_TYPE_2D)
+      .SetName("HeadlessTarget");
+    swapchain->headless_target = device->CreateTexture(target_descriptor);
+
+    if (swapchain->headless_target.index == INVALID_ID)
+    {
+        SERROR("Failed to create the headless render target.");
+        return false;
+    }
+
+    // Owned by the texture.
+    const VulkanTexture* target = device->GetTextureResource(swapchain->headless_target);
+    swapchain->images.assign(1, target->texture);
+    swapchain->imageViews.assign(1, target->image_view);
+    swapchain->imageIndex = 0;
+
+    STRACE("\tHeadless render target created.");
+    return true;
+}
+
 void VulkanSwapchain::Destroy()
 {
     vkDeviceWaitIdle(device->Handle);
 
-    vkDestroySemaphore(device->Handle, renderCompleteSemaphore, nullptr);
-    vkDestroySemaphore(device->Handle, presentCompleteSemaphore, nullptr);
+    for (auto& semaphore : renderCompleteSemaphores)
+    {
+        vkDestroySemaphore(device->Handle, semaphore, nullptr);
+    }
+
+    for (auto& semaphore : imageAcquiredSemaphores)
+    {
+        vkDestroySemaphore(device->Handle, semaphore, nullptr);
+    }
+
+    DestroyTargets();
+
+    // The swapchain extension is not enabled when headless.
+    if (swapchain != VK_NULL_HANDLE)
+    {
+        vkDestroySwapchainKHR(device->Handle, swapchain, nullptr);
+        vkDestroySurfaceKHR(device->Instance, surface, nullptr);
+    }
+}
 
+void VulkanSwapchain::DestroyTargets()
+{
     for (auto& framebuffer : framebuffers)
     {
         vkDestroyFramebuffer(device->Handle, framebuffer, nullptr);
     }
+    framebuffers.clear();
 
-    for (auto& imageView : imageViews)
+    // The target texture owns the image view when headless.
+    if (swapchain != VK_NULL_HANDLE)
     {
-        vkDestroyImageView(device->Handle, imageView, nullptr);
+        for (auto& imageView : imageViews)
+        {
+            vkDestroyImageView(device->Handle, imageView, nullptr);
+        }
     }
-
-    vkDestroySwapchainKHR(device->Handle, swapchain, nullptr);
-    vkDestroySurfaceKHR(device->Instance, surface, nullptr);
+    imageViews.clear();
 }
 
 } // namespace Vk
@@ -47,7 +47,8 @@ static void CreateTexture(VkDevice InDevice, const TextureDescriptor& InDescript
     OutTexture->descriptor = InDescriptor;
     OutTexture->handle     = InHandle;
 
-    const bool bIsRenderTarget = (InDescriptor.flags & TextureFlagsMask::RENDER_TARGET) == TextureFlagsMask::RENDER_TARGET;
+    const bool bIsTransient    = (InDescriptor.flags & TextureFlagsMask::TRANSIENT) == TextureFlagsMask::TRANSIENT;
+    const bool bIsRenderTarget = bIsTransient || (InDescriptor.flags & TextureFlagsMask::RENDER_TARGET) == TextureFlagsMask::RENDER_TARGET;
     const bool bIsComputeUsed  = (InDescriptor.flags & TextureFlagsMask::COMPUTE) == TextureFlagsMask::COMPUTE;
 
     VkImageCreateInfo image_info = {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
@@ -71,7 +72,8 @@ static void CreateTexture(VkDevice InDevice, const TextureDescriptor& InDescript
     else
     {
         image_info.usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-        image_info.usage |= bIsRenderTarget ? VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT : 0;
+        // Render targets can be read back.
+        image_info.usage |= bIsRenderTarget ? VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0;
     }
 
     image_info.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
@@ -79,7 +81,13 @@ static void CreateTexture(VkDevice InDevice, const TextureDescriptor& InDescript
 
     vkcheck(vkCreateImage(InDevice, &image_info, nullptr, &OutTexture->texture));
 
-    OutTexture->Allocate_and_bind_texture_memory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    // Render targets get their own allocation, they are big and live as long as the swapchain. Transient ones share
+    // memory with the textures they alias.
+    OutTexture->alias = INVALID_TEXTURE;
+    if (!bIsTransient || InDescriptor.alias.index == INVALID_ID || !OutTexture->Bind_aliased_memory(InDescriptor.alias))
+    {
+        OutTexture->Allocate_and_bind_texture_memory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, bIsRenderTarget || HasDepthOrStencil(InDescriptor.format), bIsTransient);
+    }
 
     // TODO set name
 
@@ -121,71 +129,26 @@ TextureHandle VulkanTexture::Create(VulkanDevice* InDevice, const TextureDescrip
 
     if (InDescriptor.data)
     {
-        // Staging buffer
-        u32          image_size = InDescriptor.width * InDescriptor.height * texture->descriptor.format_stride;
-        VulkanBuffer staging_buffer;
-        staging_buffer.device = InDevice;
-
-        VkBufferCreateInfo buffer_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
-        buffer_info.usage              = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-        buffer_info.size               = image_size;
-
-        vkcheck(vkCreateBuffer(InDevice->Handle, &buffer_info, nullptr, &staging_buffer.buffer));
-
-        staging_buffer.Allocate_buffer_memory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-        vkcheck(vkBindBufferMemory(InDevice->Handle, staging_buffer.buffer, staging_buffer.memory, 0));
-
-        // Copy data
-        void* mapdata;
-        vkMapMemory(InDevice->Handle, staging_buffer.memory, 0, image_size, 0, &mapdata);
-        memcpy(mapdata, InDescriptor.data, image_size);
-        vkUnmapMemory(InDevice->Handle, staging_buffer.memory);
-
-        auto                     command_buffer = static_cast<VulkanCommandBuffer*>(InDevice->GetInstantCommandBuffer());
-        VkCommandBufferBeginInfo begin_info     = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
-        begin_info.flags                        = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-        vkBeginCommandBuffer(command_buffer->command_buffer, &begin_info);
-
-        VkBufferImageCopy region               = {};
-        region.bufferOffset                    = 0;
-        region.bufferImageHeight               = 0;
-        region.bufferRowLength                 = 0;
-        region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.imageSubresource.baseArrayLayer = 0;
-        region.imageSubresource.mipLevel       = 0;
-        region.imageSubresource.layerCount     = 1;
-        region.imageOffset                     = {0, 0, 0};
-        region.imageExtent                     = {texture->descriptor.width, texture->descriptor.height, 1};
-
-        bool is_depth = HasDepth(texture->descriptor.generic_format);
-        TransitionLayout(command_buffer, texture->texture, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, is_depth);
-        vkCmdCopyBufferToImage(command_buffer->command_buffer, staging_buffer.buffer, texture->texture, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-        TransitionLayout(command_buffer, texture->texture, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, is_depth);
-
-        vkEndCommandBuffer(command_buffer->command_buffer);
-
-        VkSubmitInfo submitInfo       = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers    = &command_buffer->command_buffer;
-
-        vkQueueSubmit(InDevice->GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
-        vkQueueWaitIdle(InDevice->GetGraphicsQueue());
-
-        vkResetCommandBuffer(command_buffer->command_buffer, VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT);
-
-        vkDestroyBuffer(InDevice->Handle, staging_buffer.buffer, nullptr);
-        vkFreeMemory(InDevice->Handle, staging_buffer.memory, nullptr);
+        // Copied on the transfer queue, the texture is ready for the first frame submitted after this call.
+        const u32        image_size = InDescriptor.width * InDescriptor.height * texture->descriptor.format_stride;
+        const VkExtent3D extent     = {texture->descriptor.width, texture->descriptor.height, 1};
+        InDevice->upload_manager.UploadTexture(texture->texture, extent, VK_IMAGE_ASPECT_COLOR_BIT, InDescriptor.data, image_size);
 
         texture->image_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
     }
 
+    InDevice->WriteBindlessDescriptor(ResourceType::TEXTURE, handle.index);
+
     return handle;
 }
 
 void VulkanTexture::Release()
 {
     {
-        vkFreeMemory(device->Handle, memory, nullptr);
+        if (alias.index == INVALID_ID)
+        {
+            device->memory_allocator.Free(allocation);
+        }
         vkDestroyImageView(device->Handle, image_view, nullptr);
         vkDestroyImage(device->Handle, texture, nullptr);
     }
@@ -193,7 +156,6 @@ void VulkanTexture::Release()
     VkDevice       device    = VK_NULL_HANDLE;
     VkImage        texture   = VK_NULL_HANDLE;
     VkImageView    imageView = VK_NULL_HANDLE;
-    VkDeviceMemory memory    = VK_NULL_HANDLE;
     VkSampler      sampler   = VK_NULL_HANDLE;
 }
 
@@ -246,6 +208,14 @@ void VulkanTexture::TransitionLayout(
         srcStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
         dstStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
     }
+    else if (source_layout == VK_IMAGE_LAYOUT_UNDEFINED && destination_layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+    {
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+        srcStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    }
     else if (source_layout == VK_IMAGE_LAYOUT_UNDEFINED && destination_layout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
     {
         barrier.srcAccessMask = 0;
@@ -263,18 +233,49 @@ void VulkanTexture::TransitionLayout(
     vkCmdPipelineBarrier(command_buffer->command_buffer, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 }
 
-void VulkanTexture::Allocate_and_bind_texture_memory(VkMemoryPropertyFlags memory_properties)
+void VulkanTexture::Allocate_and_bind_texture_memory(VkMemoryPropertyFlags memory_properties, bool bDedicated, bool bAliasable)
+{
+    allocation = device->memory_allocator.AllocateImage(texture, memory_properties, bDedicated, bAliasable, this);
+
+    if (!allocation.IsValid())
+    {
+        SERROR("Failed to allocate texture memory.");
+    }
+}
+
+bool VulkanTexture::Bind_aliased_memory(TextureHandle InAlias)
 {
-    VkMemoryRequirements memoryRequirements;
-    vkGetImageMemoryRequirements(device->Handle, texture, &memoryRequirements);
+    const VulkanTexture* owner = device->GetTextureResource(InAlias);
+
+    // Aliases of aliases point to the texture owning the allocation.
+    if (owner->alias.index != INVALID_ID)
     {
-        VkMemoryAllocateInfo allocInfo = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
-        allocInfo.allocationSize       = memoryRequirements.size;
-        allocInfo.memoryTypeIndex      = device->FindMemoryType(memoryRequirements.memoryTypeBits, memory_properties);
+        owner = device->GetTextureResource(owner->alias);
+    }
 
-        vkAllocateMemory(device->Handle, &allocInfo, nullptr, &memory);
-        vkBindImageMemory(device->Handle, texture, memory, 0);
+    if (!owner->allocation.aliasable)
+    {
+        return false;
     }
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(device->Handle, texture, &requirements);
+
+    const bool bFits = requirements.size <= owner->allocation.size && (requirements.memoryTypeBits & (1u << owner->allocation.memory_type)) != 0 &&
+                       owner->allocation.offset % requirements.alignment == 0;
+    if (!bFits)
+    {
+        return false;
+    }
+
+    vkBindImageMemory(device->Handle, texture, owner->allocation.memory, owner->allocation.offset);
+
+    // Same range as the owner, only the owner gives it back to the allocator.
+    allocation      = owner->allocation;
+    allocation.size = requirements.size;
+    allocation.node = nullptr;
+    alias           = owner->handle;
+    return true;
 }
 
 } // namespace Vk
@@ -0,0 +1,417 @@
+#include "vulkan/vulkan_upload.h"
+#include "vulkan/vulkan_device.h"
+
+namespace Sogas
+{
+namespace Renderer
+{
+namespace Vk
+{
+
+// Stages where uploaded resources are consumed, the frame waits for the uploads before them.
+static const VkPipelineStageFlags UPLOAD_CONSUMER_STAGES =
+  VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+static const VkAccessFlags BUFFER_CONSUMER_ACCESS =
+  VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+void VulkanUploadManager::Init(VulkanDevice* InDevice)
+{
+    device = InDevice;
+
+    VkCommandPoolCreateInfo pool_info = {VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+    pool_info.flags                   = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pool_info.queueFamilyIndex        = device->TransferFamily;
+    vkcheck(vkCreateCommandPool(device->Handle, &pool_info, nullptr, &transfer_pool));
+
+    pool_info.queueFamilyIndex = device->GraphicsFamily;
+    vkcheck(vkCreateCommandPool(device->Handle, &pool_info, nullptr, &acquire_pool));
+
+    VkCommandBufferAllocateInfo allocate_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+    allocate_info.commandPool                 = transfer_pool;
+    allocate_info.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocate_info.commandBufferCount          = 1;
+    for (auto& batch : batches)
+    {
+        vkcheck(vkAllocateCommandBuffers(device->Handle, &allocate_info, &batch.command_buffer));
+    }
+
+    allocate_info.commandPool        = acquire_pool;
+    allocate_info.commandBufferCount = MAX_FRAMES_IN_FLIGHT;
+    vkcheck(vkAllocateCommandBuffers(device->Handle, &allocate_info, acquire_command_buffers));
+
+    VkSemaphoreTypeCreateInfo timeline_info = {VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO};
+    timeline_info.semaphoreType             = VK_SEMAPHORE_TYPE_TIMELINE;
+    timeline_info.initialValue              = 0;
+
+    VkSemaphoreCreateInfo semaphore_info = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, &timeline_info};
+    vkcheck(vkCreateSemaphore(device->Handle, &semaphore_info, nullptr, &timeline));
+
+    ring_size = UPLOAD_RING_SIZE;
+
+    VkBufferCreateInfo buffer_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    buffer_info.usage              = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    buffer_info.size               = ring_size;
+    vkcheck(vkCreateBuffer(device->Handle, &buffer_info, nullptr, &ring_buffer));
+
+    ring_allocation = device->memory_allocator.AllocateBuffer(ring_buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    SASSERT(ring_allocation.mapped != nullptr);
+
+    STRACE("\tUpload manager using queue family %d, graphics family %d.", device->TransferFamily, device->GraphicsFamily);
+}
+
+void VulkanUploadManager::Shutdown()
+{
+    WaitIdle();
+
+    SINFO("\tUploaded %d KB in %d batches, %d stalls waiting for staging space.", static_cast<u32>(uploaded_bytes / 1024), submitted_count, stall_count);
+
+    vkDestroyBuffer(device->Handle, ring_buffer, nullptr);
+    device->memory_allocator.Free(ring_allocation);
+
+    vkDestroySemaphore(device->Handle, timeline, nullptr);
+    vkDestroyCommandPool(device->Handle, transfer_pool, nullptr);
+    vkDestroyCommandPool(device->Handle, acquire_pool, nullptr);
+}
+
+void VulkanUploadManager::UploadBuffer(VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size)
+{
+    VkBuffer     staging_buffer;
+    VkDeviceSize staging_offset;
+    if (!Stage(data, size, 4, staging_buffer, staging_offset))
+    {
+        return;
+    }
+
+    Batch& batch = GetRecordingBatch();
+
+    VkBufferCopy region = {staging_offset, offset, size};
+    vkCmdCopyBuffer(batch.command_buffer, staging_buffer, buffer, 1, &region);
+
+    if (device->TransferFamily != device->GraphicsFamily)
+    {
+        VkBufferMemoryBarrier barrier = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+        barrier.srcAccessMask         = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask         = 0;
+        barrier.srcQueueFamilyIndex   = device->TransferFamily;
+        barrier.dstQueueFamilyIndex   = device->GraphicsFamily;
+        barrier.buffer                = buffer;
+        barrier.offset                = offset;
+        barrier.size                  = size;
+
+        // Release here, the graphics queue acquires the same range at the beginning of the frame.
+        vkCmdPipelineBarrier(batch.command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = BUFFER_CONSUMER_ACCESS;
+        recording_buffer_acquires.push_back(barrier);
+    }
+
+    uploaded_bytes += size;
+}
+
+void VulkanUploadManager::UploadTexture(VkImage image, VkExtent3D extent, VkImageAspectFlags aspect, const void* data, VkDeviceSize size)
+{
+    VkBuffer     staging_buffer;
+    VkDeviceSize staging_offset;
+    if (!Stage(data, size, 16, staging_buffer, staging_offset))
+    {
+        return;
+    }
+
+    Batch& batch = GetRecordingBatch();
+
+    VkImageMemoryBarrier barrier            = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    barrier.image                           = image;
+    barrier.oldLayout                       = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout                       = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcAccessMask                   = 0;
+    barrier.dstAccessMask                   = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barrier.subresourceRange.aspectMask     = aspect;
+    barrier.subresourceRange.baseMipLevel   = 0;
+    barrier.subresourceRange.levelCount     = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount     = 1;
+    vkCmdPipelineBarrier(batch.command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    VkBufferImageCopy region               = {};
+    region.bufferOffset                    = staging_offset;
+    region.imageSubresource.aspectMask     = aspect;
+    region.imageSubresource.mipLevel       = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount     = 1;
+    region.imageExtent                     = extent;
+    vkCmdCopyBufferToImage(batch.command_buffer, staging_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    // Visibility for the shaders comes with the semaphore the frame waits on.
+    barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    if (device->TransferFamily != device->GraphicsFamily)
+    {
+        barrier.srcQueueFamilyIndex = device->TransferFamily;
+        barrier.dstQueueFamilyIndex = device->GraphicsFamily;
+    }
+    vkCmdPipelineBarrier(batch.command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    if (device->TransferFamily != device->GraphicsFamily)
+    {
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        recording_image_acquires.push_back(barrier);
+    }
+
+    uploaded_bytes += size;
+}
+
+bool VulkanUploadManager::Stage(const void* data, VkDeviceSize size, VkDeviceSize alignment, VkBuffer& OutBuffer, VkDeviceSize& OutOffset)
+{
+    // Recording starts before the ring is reserved. Freeing a batch to record into may retire every batch and reset
+    // the ring, which would hand the staged bytes out again.
+    GetRecordingBatch();
+
+    // Big uploads get their own staging buffer instead of draining the ring, released with their batch.
+    if (size > ring_size / 2)
+    {
+        TemporaryStaging staging;
+
+        VkBufferCreateInfo buffer_info = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+        buffer_info.usage              = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        buffer_info.size               = size;
+        vkcheck(vkCreateBuffer(device->Handle, &buffer_info, nullptr, &staging.buffer));
+
+        staging.allocation = device->memory_allocator.AllocateBuffer(staging.buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        if (staging.allocation.mapped == nullptr)
+        {
+            SERROR("Failed to allocate %d bytes of staging memory.", static_cast<u32>(size));
+            vkDestroyBuffer(device->Handle, staging.buffer, nullptr);
+            device->memory_allocator.Free(staging.allocation);
+            return false;
+        }
+
+        memcpy(staging.allocation.mapped, data, size);
+
+        OutBuffer = staging.buffer;
+        OutOffset = 0;
+        GetRecordingBatch().temporaries.push_back(staging);
+        return true;
+    }
+
+    VkDeviceSize offset = 0;
+    while (!Reserve(size, alignment, offset))
+    {
+        // Ring full, submit what is recorded and wait for the oldest batch to free its space.
+        Flush();
+        ++stall_count;
+        RetireBatches(true);
+        GetRecordingBatch();
+    }
+
+    memcpy(ring_allocation.mapped + offset, data, size);
+
+    OutBuffer = ring_buffer;
+    OutOffset = offset;
+    return true;
+}
+
+bool VulkanUploadManager::Reserve(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& OutOffset)
+{
+    // Head never reaches the tail from behind, head == tail means the ring is empty.
+    VkDeviceSize offset = AlignUp(ring_head, alignment);
+    if (ring_head >= ring_tail)
+    {
+        if (offset + size > ring_size)
+        {
+            offset = 0;
+            if (size >= ring_tail)
+            {
+                return false;
+            }
+        }
+    }
+    else if (offset + size >= ring_tail)
+    {
+        return false;
+    }
+
+    ring_head = offset + size;
+    OutOffset = offset;
+    return true;
+}
+
+VulkanUploadManager::Batch& VulkanUploadManager::GetRecordingBatch()
+{
+    if (!bRecording)
+    {
+        if (in_flight_count == MAX_BATCHES)
+        {
+            ++stall_count;
+            RetireBatches(true);
+        }
+
+        Batch& batch = batches[(first_batch + in_flight_count) % MAX_BATCHES];
+
+        vkResetCommandBuffer(batch.command_buffer, 0);
+
+        VkCommandBufferBeginInfo begin_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+        begin_info.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(batch.command_buffer, &begin_info);
+
+        bRecording = true;
+    }
+
+    return batches[(first_batch + in_flight_count) % MAX_BATCHES];
+}
+
+void VulkanUploadManager::Flush()
+{
+    if (!bRecording)
+    {
+        return;
+    }
+
+    Batch& batch = batches[(first_batch + in_flight_count) % MAX_BATCHES];
+    vkEndCommandBuffer(batch.command_buffer);
+
+    batch.value    = ++submitted_value;
+    batch.ring_end = ring_head;
+
+    VkTimelineSemaphoreSubmitInfo timeline_submit = {VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+    timeline_submit.signalSemaphoreValueCount     = 1;
+    timeline_submit.pSignalSemaphoreValues        = &batch.value;
+
+    VkSubmitInfo submit         = {VK_STRUCTURE_TYPE_SUBMIT_INFO, &timeline_submit};
+    submit.commandBufferCount   = 1;
+    submit.pCommandBuffers      = &batch.command_buffer;
+    submit.signalSemaphoreCount = 1;
+    submit.pSignalSemaphores    = &timeline;
+    vkcheck(vkQueueSubmit(device->TransferQueue, 1, &submit, VK_NULL_HANDLE));
+
+    pending_buffer_acquires.insert(pending_buffer_acquires.end(), recording_buffer_acquires.begin(), recording_buffer_acquires.end());
+    pending_image_acquires.insert(pending_image_acquires.end(), recording_image_acquires.begin(), recording_image_acquires.end());
+    recording_buffer_acquires.clear();
+    recording_image_acquires.clear();
+
+    ++in_flight_count;
+    ++submitted_count;
+    bRecording = false;
+}
+
+bool VulkanUploadManager::PrepareFrameSubmit(u32 frame_index, VkSemaphore& OutSemaphore, u64& OutValue, VkCommandBuffer& OutAcquire)
+{
+    Flush();
+
+    if (submitted_value == waited_value)
+    {
+        return false;
+    }
+
+    OutSemaphore = timeline;
+    OutValue     = submitted_value;
+    OutAcquire   = VK_NULL_HANDLE;
+    waited_value = submitted_value;
+
+    if (!pending_buffer_acquires.empty() || !pending_image_acquires.empty())
+    {
+        // The frame fence was waited in BeginFrame, the command buffer of this frame is free.
+        VkCommandBuffer command_buffer = acquire_command_buffers[frame_index];
+        vkResetCommandBuffer(command_buffer, 0);
+
+        VkCommandBufferBeginInfo begin_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+        begin_info.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(command_buffer, &begin_info);
+
+        vkCmdPipelineBarrier(command_buffer, UPLOAD_CONSUMER_STAGES, UPLOAD_CONSUMER_STAGES, 0, 0, nullptr,
+                             static_cast<u32>(pending_buffer_acquires.size()), pending_buffer_acquires.data(),
+                             static_cast<u32>(pending_image_acquires.size()), pending_image_acquires.data());
+
+        vkEndCommandBuffer(command_buffer);
+
+        pending_buffer_acquires.clear();
+        pending_image_acquires.clear();
+        OutAcquire = command_buffer;
+    }
+
+    return true;
+}
+
+void VulkanUploadManager::Update()
+{
+    RetireBatches(false);
+}
+
+void VulkanUploadManager::WaitIdle()
+{
+    Flush();
+
+    VkSemaphoreWaitInfo wait_info = {VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO};
+    wait_info.semaphoreCount      = 1;
+    wait_info.pSemaphores         = &timeline;
+    wait_info.pValues             = &submitted_value;
+    vkWaitSemaphores(device->Handle, &wait_info, UINT64_MAX);
+
+    RetireBatches(false);
+}
+
+bool VulkanUploadManager::HasPendingAcquire(VkBuffer buffer) const
+{
+    auto matches = [buffer](const VkBufferMemoryBarrier& barrier) { return barrier.buffer == buffer; };
+    return std::any_of(pending_buffer_acquires.begin(), pending_buffer_acquires.end(), matches) ||
+           std::any_of(recording_buffer_acquires.begin(), recording_buffer_acquires.end(), matches);
+}
+
+void VulkanUploadManager::RetireBatches(bool bWait)
+{
+    if (in_flight_count == 0)
+    {
+        return;
+    }
+
+    u64 completed = 0;
+    vkGetSemaphoreCounterValue(device->Handle, timeline, &completed);
+
+    if (bWait && completed < batches[first_batch].value)
+    {
+        VkSemaphoreWaitInfo wait_info = {VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO};
+        wait_info.semaphoreCount      = 1;
+        wait_info.pSemaphores         = &timeline;
+        wait_info.pValues             = &batches[first_batch].value;
+        vkWaitSemaphores(device->Handle, &wait_info, UINT64_MAX);
+
+        completed = batches[first_batch].value;
+    }
+
+    while (in_flight_count > 0 && batches[first_batch].value <= completed)
+    {
+        Batch& batch = batches[first_batch];
+        for (auto& staging : batch.temporaries)
+        {
+            vkDestroyBuffer(device->Handle, staging.buffer, nullptr);
+            device->memory_allocator.Free(staging.allocation);
+        }
+        batch.temporaries.clear();
+
+        ring_tail   = batch.ring_end;
+        first_batch = (first_batch + 1) % MAX_BATCHES;
+        --in_flight_count;
+    }
+
+    // Nothing in use, start again from the beginning to avoid wrapping.
+    if (in_flight_count == 0 && !bRecording)
+    {
+        ring_head = 0;
+        ring_tail = 0;
+    }
+}
+
+} // namespace Vk
+} // namespace Renderer
+} // namespace Sogas
@@ -28,6 +28,7 @@ enum BufferUsage
     INDEX,
     VERTEX,
     UNIFORM,
+    STORAGE,
     UNDEFINED
 };
 
@@ -8,6 +8,8 @@ struct BufferHandle;
 struct PipelineHandle;
 struct RenderPassHandle;
 struct DescriptorSetHandle;
+struct TransientDescriptorSet;
+struct TextureBarrier;
 
 class CommandBuffer
 {
@@ -17,19 +19,35 @@ class CommandBuffer
 
     // interface
 
-    virtual void bind_pass(RenderPassHandle handle)   = 0;
-    virtual void bind_pipeline(PipelineHandle handle) = 0;
+    // With use_secondary the pass contents are recorded in secondary command buffers given to execute_commands.
+    virtual void bind_pass(RenderPassHandle handle, bool use_secondary = false) = 0;
+    virtual void bind_pipeline(PipelineHandle handle)                           = 0;
     virtual void bind_descriptor_set(DescriptorSetHandle handle, u32* offsets, u32 offsets_count) = 0;
+    virtual void bind_descriptor_set(const TransientDescriptorSet& set, u32* offsets, u32 offsets_count) = 0;
+    // Written to the push constant range of the bound pipeline.
+    virtual void push_constants(const void* data, u32 size, u32 offset = 0) = 0;
 
     virtual void bind_vertex_buffer(BufferHandle handle, u32 binding, u32 offset) = 0;
     virtual void bind_index_buffer(BufferHandle handle, u32 offset) = 0;
 
+    // Recorded as a single pipeline barrier, ends the render pass being recorded.
+    virtual void barrier(const TextureBarrier* barriers, u32 count) = 0;
+
+    // Gpu time of the commands in between, reported by GPU_device::GetGpuTimings. Render passes are timed without
+    // them. Zones nest, the name must outlive the device. Primaries only, outside of passes bound with use_secondary.
+    virtual void begin_zone(const char* name) = 0;
+    virtual void end_zone()                   = 0;
+
     virtual void set_viewport() = 0;
     virtual void set_scissors() = 0;
 
     virtual void draw(u32 first_vertex, u32 vertex_count, u32 first_instance, u32 instance_count) = 0;
     virtual void draw_indexed(u32 index_count, u32 instance_count, u32 first_index, i32 vertex_offset, u32 first_instance) = 0;
 
+    // Ends a secondary command buffer, primaries are ended when the frame is submitted.
+    virtual void end() = 0;
+    virtual void execute_commands(CommandBuffer** secondaries, u32 count) = 0;
+
     virtual void reset() = 0;
 };
 } // namespace Renderer
@@ -37,6 +37,11 @@ static const u8 MAX_DESCRIPTOR_PER_SET     = 16;
 static const u8 MAX_VERTEX_STREAMS         = 16;
 static const u8 MAX_VERTEX_ATTRIBUTE       = 16;
 
+// Bindless heap, bound at this set by the pipelines whose shaders declare it.
+static const u8 BINDLESS_SET_INDEX       = 1;
+static const u8 BINDLESS_TEXTURE_BINDING = 0; // sampler2D array, combined with the texture sampler.
+static const u8 BINDLESS_BUFFER_BINDING  = 1; // Storage buffer array.
+
 enum class ResourceType
 {
     BUFFER = 0,
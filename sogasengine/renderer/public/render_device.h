@@ -22,12 +22,82 @@ namespace Renderer
 struct DeviceDescriptor
 {
     Memory::Allocator* allocator;
-    void*              window = nullptr;
-    u16                width  = 0;
-    u16                height = 0;
+    void*              window              = nullptr;
+    u16                width               = 0;
+    u16                height              = 0;
+    u8                 frames_in_flight    = 2;                    // Frames the cpu records ahead of the gpu, 2 or 3.
+    const char*        pipeline_cache_path = "pipeline_cache.bin"; // Loaded at Init and saved at shutdown, null disables it.
+    const char*        shader_cache_path   = "shader_cache";       // Directory for compiled SPIR-V, null disables it.
+    bool               dynamic_rendering   = true;                 // Used when supported, render pass objects otherwise.
+    bool               headless            = false;                // No window, the swapchain pass renders to a texture.
+    bool               gpu_timestamps      = true;                 // Times the render passes and zones, see GetGpuTimings.
+    bool               pipeline_statistics = false;                // Counts the pipeline statistics of each render pass.
 
     DeviceDescriptor& SetWindow(void* InWindow, u16 InWidth, u16 InHeight);
     DeviceDescriptor& SetAllocator(Memory::Allocator* InAllocator);
+    DeviceDescriptor& SetFramesInFlight(u8 InFramesInFlight);
+    DeviceDescriptor& SetPipelineCachePath(const char* InPath);
+    DeviceDescriptor& SetShaderCachePath(const char* InPath);
+    DeviceDescriptor& SetDynamicRendering(bool bEnabled);
+    DeviceDescriptor& SetHeadless(u16 InWidth, u16 InHeight);
+    DeviceDescriptor& SetGpuProfiling(bool bTimestamps, bool bPipelineStatistics);
+};
+
+// Sub allocation of the per frame dynamic buffer, valid until the gpu finishes the frame.
+struct DynamicAllocation
+{
+    void* data   = nullptr;
+    u32   offset = 0; // Offset in the dynamic buffer, for dynamic descriptors or vertex/index bindings.
+};
+
+struct GPUMemoryStats
+{
+    u64 reserved_bytes     = 0; // Device memory allocated from the driver, blocks and dedicated allocations.
+    u64 used_bytes         = 0; // Bytes given to resources.
+    u64 largest_free_range = 0; // Largest allocation a block could serve without growing.
+    u64 device_local_bytes = 0; // Used bytes placed in device local memory.
+    u64 host_visible_bytes = 0; // Used bytes the cpu can write to, device local too with resizable BAR or unified memory.
+    u32 block_count        = 0;
+    u32 allocation_count   = 0; // Sub allocations alive.
+    u32 dedicated_count    = 0;
+};
+
+// Device memory bound to a texture. Aliased textures share the memory of another texture, it is not counted twice.
+struct TextureMemoryInfo
+{
+    u64  size    = 0;
+    bool aliased = false;
+};
+
+enum class PipelineStatistic : u8
+{
+    INPUT_VERTICES,
+    INPUT_PRIMITIVES,
+    VERTEX_INVOCATIONS,
+    CLIPPED_PRIMITIVES, // Primitives left after clipping, those reaching the rasterizer.
+    FRAGMENT_INVOCATIONS,
+    COMPUTE_INVOCATIONS,
+    COUNT
+};
+
+// Gpu time of a render pass, or of a zone recorded with CommandBuffer::begin_zone.
+struct GPUZoneTiming
+{
+    const char* name        = nullptr; // Kept until exit, render pass names are interned.
+    f64         start_ms    = 0.0;     // From the first zone of the frame.
+    f64         duration_ms = 0.0;
+    u32         depth       = 0;       // Zones open around this one.
+    bool        bStatistics = false;   // Render passes only, when pipeline statistics are enabled and supported.
+    u64         statistics[static_cast<u32>(PipelineStatistic::COUNT)] = {};
+};
+
+// Pixels copied back from a texture, rows tightly packed starting from the top.
+struct TextureReadback
+{
+    std::vector<u8> data;
+    u16             width  = 0;
+    u16             height = 0;
+    Format          format = Format::UNDEFINED;
 };
 
 class GPU_device
@@ -55,8 +125,30 @@ class GPU_device
     virtual SamplerHandle             CreateSampler(const SamplerDescriptor& InDescriptor) = 0;
     virtual DescriptorSetHandle       CreateDescriptorSet(const DescriptorSetDescriptor& InDescriptor) = 0;
     virtual DescriptorSetLayoutHandle CreateDescriptorSetLayout(const DescriptorSetLayoutDescriptor& InDescriptor) = 0;
+    // Allocated from the pools of the current frame and released when its slot is reused, never destroyed. For sets
+    // bound by this frame only, created between BeginFrame and Present like dynamic allocations.
+    virtual TransientDescriptorSet    CreateTransientDescriptorSet(const DescriptorSetDescriptor& InDescriptor) = 0;
     virtual PipelineHandle            CreatePipeline(const PipelineDescriptor& InDescriptor) = 0;
     virtual RenderPassHandle          CreateRenderPass(const RenderPassDescriptor& InDescriptor) = 0;
+    // Compiled on a worker thread, binding the pipeline before it is ready waits for it.
+    virtual PipelineHandle            CreatePipelineAsync(const PipelineDescriptor& InDescriptor) = 0;
+    virtual bool                      IsPipelineReady(PipelineHandle InHandle) = 0;
+    // The async compile failed and the error was logged, the pipeline never becomes ready but must still be destroyed.
+    virtual bool                      IsPipelineFailed(PipelineHandle InHandle) = 0;
+    // Compiles the GLSL stages into the shader cache without creating the shader state. Thread safe, used to
+    // build shader variants on worker threads before they are needed.
+    virtual bool                      CompileShaders(const ShaderStateDescriptor& InDescriptor) = 0;
+    // Layout of a set used by the pipeline, to create its descriptor sets. Layouts reflected from the shaders are owned
+    // by the device and shared between pipelines, they must not be destroyed.
+    virtual DescriptorSetLayoutHandle GetDescriptorSetLayout(PipelineHandle InHandle, u32 InSetIndex) = 0;
+    // Index of the resource in the bindless heap, INVALID_ID when bindless is not supported or the resource is not
+    // in the heap. Textures are always in it, buffers when created with STORAGE usage.
+    virtual u32                       GetBindlessIndex(TextureHandle InHandle) = 0;
+    virtual u32                       GetBindlessIndex(BufferHandle InHandle) = 0;
+    virtual TextureMemoryInfo         GetTextureMemoryInfo(TextureHandle InHandle) = 0;
+    // Waits for every submitted frame and copies the first mip of a color render target. Stalls the gpu, meant for
+    // captures and tests.
+    virtual bool                      ReadbackTexture(TextureHandle InHandle, TextureReadback& OutReadback) = 0;
 
     virtual void                      DestroyBuffer(BufferHandle InHandle) = 0;
     virtual void                      DestroyTexture(TextureHandle InHandle) = 0;
@@ -73,16 +165,45 @@ class GPU_device
     virtual void* MapBuffer(const BufferHandle& InHandle, u32 size, u32 offset = 0) = 0;
     virtual void UnmapBuffer(const BufferHandle& InHandle) = 0;
 
+    // Persistently mapped ring split in one partition per frame in flight, offsets are aligned for uniform buffers.
+    virtual DynamicAllocation AllocateDynamic(u32 size) = 0;
+    virtual BufferHandle GetDynamicBuffer() const = 0;
+
     virtual std::vector<i8> ReadShaderBinary(std::string InFilename) = 0; // TODO rename
     virtual char* ReadShader(std::string InFilename, u32& OutSize) = 0;
     virtual CommandBuffer* GetCommandBuffer(bool begin) = 0;
     virtual CommandBuffer* GetInstantCommandBuffer() = 0;
     virtual void QueueCommandBuffer(CommandBuffer* cmd) = 0;
+    // Begun inside the render pass bound on the primary, ended by the recording thread with end() and run with
+    // execute_commands. Threads recording at the same time must use different thread indices.
+    virtual CommandBuffer* GetSecondaryCommandBuffer(u32 thread_index, CommandBuffer* primary) = 0;
+    virtual u32 GetMaxRecordingThreads() const = 0;
 
     // clang-format on
 
     virtual RenderPassHandle        GetSwapchainRenderpass()   = 0;
     virtual const RenderPassOutput& GetSwapchainOutput() const = 0;
+    // Texture the swapchain pass renders to when headless, invalid when presenting to a window.
+    virtual TextureHandle GetBackbufferTexture() const = 0;
+
+    // Per frame resources written by the cpu must be duplicated this many times, indexed by the frame index.
+    virtual u32 GetFramesInFlight() const = 0;
+    virtual u32 GetFrameIndex() const     = 0;
+    // Cpu time the last BeginFrame spent waiting for the gpu to release the frame slot and swapchain image.
+    virtual f32 GetFrameWaitMs() const = 0;
+
+    virtual GPUMemoryStats GetMemoryStats() const = 0;
+    // Moves up to InMaxMoves allocations out of the least used memory blocks and releases the emptied ones. Waits for
+    // the gpu, meant for loading screens and between levels. Returns the number of allocations moved.
+    virtual u32 Defragment(u32 InMaxMoves) = 0;
+
+    // Zones of the last frame the gpu finished, frames_in_flight frames old, in the order they began. Read without
+    // waiting for the gpu. Empty when timestamps are disabled or not supported by the graphics queue.
+    virtual const std::vector<GPUZoneTiming>& GetGpuTimings() const = 0;
+
+    // Shaders are given the BINDLESS_SET_INDEX arrays only when supported, otherwise resources go through sets.
+    bool IsBindlessSupported() const { return bIsBindlessSupported; }
+    bool IsHeadless() const { return bIsHeadless; }
 
     Memory::Allocator* allocator = nullptr;
 
@@ -118,6 +239,7 @@ class GPU_device
 
     bool resized = false;
     bool bIsBindlessSupported{false};
+    bool bIsHeadless{false};
 };
 
 } // namespace Renderer
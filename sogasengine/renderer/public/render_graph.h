@@ -0,0 +1,143 @@
+#pragma once
+
+#include "render_device.h"
+
+#include <functional>
+
+namespace Sogas
+{
+namespace Renderer
+{
+
+// clang-format off
+struct RenderGraphResource { u32 index = INVALID_ID; };
+struct RenderGraphPass { u32 index = INVALID_ID; };
+// clang-format on
+
+static const u8 MAX_PASS_INPUTS = 16;
+
+// Records the pass once the graph transitioned its textures. Binding the render pass is left to the callback, it
+// chooses whether the contents are recorded in secondary command buffers.
+using RenderGraphExecute = std::function<void(CommandBuffer* cmd, RenderPassHandle pass)>;
+
+struct RenderGraphPassDescriptor
+{
+    struct Input
+    {
+        RenderGraphResource Resource;
+        ResourceState       State = ResourceState::SHADER_READ;
+    };
+
+    std::string    Name;
+    RenderPassType Type = RenderPassType::GEOMETRY;
+
+    Input InputTextures[MAX_PASS_INPUTS];
+    u32   InputsCount = 0;
+
+    RenderGraphResource OutputTextures[MAX_IMAGE_OUTPUTS];
+    u32                 RenderTargetsCount = 0;
+    RenderGraphResource DepthStencilTexture;
+
+    // A LOAD keeps what the previous writer of the attachment rendered, that pass is not culled while this one is used.
+    RenderPassOperation ColorOperation = RenderPassOperation::CLEAR;
+    RenderPassOperation DepthOperation = RenderPassOperation::CLEAR;
+
+    RenderGraphExecute Execute;
+
+    RenderGraphPassDescriptor& Reset();
+    RenderGraphPassDescriptor& SetName(std::string InName);
+    RenderGraphPassDescriptor& SetType(RenderPassType InType);
+    RenderGraphPassDescriptor& AddInput(RenderGraphResource InResource, ResourceState InState = ResourceState::SHADER_READ);
+    RenderGraphPassDescriptor& AddRenderTexture(RenderGraphResource InResource);
+    RenderGraphPassDescriptor& SetDepthStencilTexture(RenderGraphResource InResource);
+    RenderGraphPassDescriptor& SetOperations(RenderPassOperation InColor, RenderPassOperation InDepth);
+    RenderGraphPassDescriptor& SetExecute(RenderGraphExecute InExecute);
+};
+
+struct RenderGraphStats
+{
+    u32 passes_count           = 0;
+    u32 culled_passes_count    = 0; // Nothing they write reaches the swapchain or an imported texture.
+    u32 barriers_count         = 0; // Texture barriers recorded by the last Execute.
+    u32 barrier_batches_count  = 0; // Pipeline barriers they were grouped in, at most one per pass.
+    u32 textures_count         = 0; // Transient textures created.
+    u32 aliased_textures_count = 0; // Transient textures placed in the memory of another one.
+    u64 transient_bytes        = 0; // Memory the transient textures would need on their own.
+    u64 allocated_bytes        = 0; // Memory they use with aliasing, the difference is saved.
+};
+
+// Passes of a frame declared with the textures they read and write. Compile culls the passes whose results are not
+// used, creates the transient textures placing those with disjoint lifetimes in the same memory, and plans the
+// barriers between passes. Execute records them every frame in declaration order, a pass only reads textures written
+// by the passes declared before it. The textures and render passes are kept until the graph is compiled again.
+class RenderGraph
+{
+  public:
+    void Init(GPU_device* InDevice);
+    void Shutdown();
+
+    // Forgets the declarations, the compiled resources are destroyed by the next Compile or Shutdown.
+    void Reset();
+
+    // Created by Compile with the TRANSIENT flag, the contents don't survive the frame.
+    RenderGraphResource CreateTexture(const TextureDescriptor& InDescriptor);
+    // Texture owned by the caller, it is in the given state before and after the graph runs.
+    RenderGraphResource ImportTexture(TextureHandle InHandle, Format InFormat, ResourceState InState);
+    RenderGraphPass     AddPass(const RenderGraphPassDescriptor& InDescriptor);
+
+    bool Compile();
+    void Execute(CommandBuffer* cmd);
+
+    TextureHandle    GetTexture(RenderGraphResource InResource) const;
+    RenderPassHandle GetRenderPass(RenderGraphPass InPass) const;
+    // Attachments of the pass, known before compiling, for the pipelines drawing in it.
+    RenderPassOutput GetPassOutput(RenderGraphPass InPass) const;
+    bool             IsCulled(RenderGraphPass InPass) const;
+
+    const RenderGraphStats& GetStats() const { return stats; }
+
+  private:
+    struct Texture
+    {
+        TextureDescriptor descriptor;
+        TextureHandle     handle        = INVALID_TEXTURE;
+        ResourceState     initial_state = ResourceState::UNDEFINED; // Imported textures only.
+        ResourceState     last_state    = ResourceState::UNDEFINED; // State of the last pass using it in the frame.
+        bool              bImported     = false;
+
+        // Lifetime, in pass indices.
+        u32 first_pass = INVALID_ID;
+        u32 last_pass  = INVALID_ID;
+        // Texture whose accesses must finish before this one is first written, the previous user of the memory.
+        u32 previous = INVALID_ID;
+    };
+
+    struct Pass
+    {
+        RenderGraphPassDescriptor   descriptor;
+        RenderPassHandle            render_pass = INVALID_RENDERPASS;
+        std::vector<u32>            dependencies; // Passes writing what this one reads or loads.
+        std::vector<TextureBarrier> barriers;     // Recorded before the pass.
+        bool                        bCulled = false;
+    };
+
+    void CullPasses();
+    void AllocateTextures();
+    void PlanBarriers();
+    void ReleaseResources();
+
+    GPU_device* device = nullptr;
+
+    std::vector<Texture>        textures;
+    std::vector<Pass>           passes;
+    std::vector<TextureBarrier> final_barriers; // Imported textures back to their initial state.
+
+    // Created by the last Compile, destroyed on the next one.
+    std::vector<TextureHandle>    created_textures;
+    std::vector<RenderPassHandle> created_passes;
+
+    RenderGraphStats stats;
+};
+
+} // namespace Renderer
+} // namespace Sogas
@@ -15,7 +15,8 @@ enum class GraphicsAPI
     Vulkan = 0,
     OpenGL = 1,
     Dx11   = 2,
-    Dx12   = 3
+    Dx12   = 3,
+    Null   = 4 // Validates and records commands without a gpu, for benchmarking the cpu side.
 };
 
 enum class PrimitiveTopology
@@ -34,7 +35,7 @@ enum class DrawChannel
     SOLID         = 0,
     SHADOW_CASTER = 1,
     TRANSPARENT   = 2,
-    COUNT         = TRANSPARENT
+    COUNT         = 3
 };
 
 enum class ShaderStageType
@@ -123,9 +124,16 @@ struct ShaderStateDescriptor
     u32         stages_count = 0;
     u32         spv_input    = 0;
 
+    // Macros given to every GLSL stage, each set of values is a variant with its own cache entry.
+    std::vector<std::pair<std::string, std::string>> defines;
+    // #include is resolved against the including file, then against this directory.
+    std::string include_directory;
+
     ShaderStateDescriptor& Reset();
     ShaderStateDescriptor& SetName(const std::string& InName);
     ShaderStateDescriptor& AddStage(const char* InCode, u32 InSize, ShaderStageType InType);
+    ShaderStateDescriptor& AddDefine(const std::string& InName, const std::string& InValue = "");
+    ShaderStateDescriptor& SetIncludeDirectory(const std::string& InDirectory);
     ShaderStateDescriptor& SetSpvInput(bool InValue);
 };
 
@@ -194,6 +202,7 @@ struct DescriptorSetDescriptor
     ResourceHandle resources[MAX_DESCRIPTOR_PER_SET];
     SamplerHandle  samplers[MAX_DESCRIPTOR_PER_SET];
     u16            bindings[MAX_DESCRIPTOR_PER_SET];
+    u32            ranges[MAX_DESCRIPTOR_PER_SET]; // Bytes visible through a buffer descriptor, 0 for the whole buffer.
 
     DescriptorSetLayoutHandle layout;
     u32 resources_count = 0;
@@ -203,11 +212,39 @@ struct DescriptorSetDescriptor
     DescriptorSetDescriptor& Reset();
     DescriptorSetDescriptor& SetLayout(DescriptorSetLayoutHandle InLayout);
     DescriptorSetDescriptor& Texture(TextureHandle InTexture, u16 InBinding);
-    DescriptorSetDescriptor& Buffer(BufferHandle InBuffer, u16 InBinding);
+    DescriptorSetDescriptor& Buffer(BufferHandle InBuffer, u16 InBinding, u32 InRange = 0);
     DescriptorSetDescriptor& TextureSampler(TextureHandle InTexture, SamplerHandle InSampler, u16 InBinding);
     DescriptorSetDescriptor& SetName(std::string InName);
 
 };
+
+// Descriptor set living until the end of the frame it was created in.
+struct TransientDescriptorSet
+{
+    u64 set       = 0; // Api handle, 0 when the allocation failed.
+    u32 set_index = 0;
+};
+
+// How a pass uses a texture, each state has its own layout and the stages and accesses barriers wait for.
+enum class ResourceState
+{
+    UNDEFINED,
+    RENDER_TARGET,
+    DEPTH_WRITE,
+    DEPTH_READ, // Depth test without writes, may be sampled at the same time.
+    SHADER_READ,
+    STORAGE,
+    COUNT
+};
+
+struct TextureBarrier
+{
+    TextureHandle texture;
+    ResourceState before  = ResourceState::UNDEFINED;
+    ResourceState after   = ResourceState::UNDEFINED;
+    bool          discard = false; // Contents are not kept, the accesses of the before state are still waited for.
+};
+
 struct DescriptorSetLayoutDescriptor
 {
     struct Binding
@@ -221,6 +258,7 @@ struct DescriptorSetLayoutDescriptor
     Binding bindings[MAX_DESCRIPTOR_PER_SET];
     u32     bindings_count = 0;
     u32     set_index      = 0;
+    bool    bindless       = false; // Partially bound arrays updated after bind, allocated from the bindless pool.
 
     std::string name;
 
@@ -228,6 +266,7 @@ struct DescriptorSetLayoutDescriptor
     DescriptorSetLayoutDescriptor& AddBinding(const Binding& InBinding);
     DescriptorSetLayoutDescriptor& SetName(std::string InName);
     DescriptorSetLayoutDescriptor& SetSetIndex(u32 InIndex);
+    DescriptorSetLayoutDescriptor& SetBindless(bool InValue);
 };
 
 enum class CompareOperation
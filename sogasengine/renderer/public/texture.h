@@ -3,6 +3,8 @@
 // TODO FIX THIS
 #include "../internal/resources/resource.h"
 
+#include "device_resources.h"
+
 namespace Sogas
 {
 namespace Renderer
@@ -157,6 +159,101 @@ inline bool HasDepthOrStencil(Format InFormat)
     return InFormat >= Format::D16_UNORM && InFormat <= Format::D32_UNORM_S8_UINT;
 }
 
+// Bytes per texel of the uncompressed color formats, 0 for the rest.
+constexpr u32 GetFormatStride(Format format)
+{
+    switch (format)
+    {
+        case Format::R32G32B32A32_SFLOAT:
+        case Format::R32G32B32A32_UINT:
+        case Format::R32G32B32A32_SINT:
+            return 16u;
+        case Format::R32G32B32_SFLOAT:
+        case Format::R32G32B32_UINT:
+        case Format::R32G32B32_SINT:
+            return 12u;
+        case Format::R64_UINT:
+        case Format::R64_SINT:
+        case Format::R64_SFLOAT:
+        case Format::R32G32_SFLOAT:
+        case Format::R32G32_UINT:
+        case Format::R32G32_SINT:
+        case Format::R16G16B16A16_SFLOAT:
+        case Format::R16G16B16A16_SNORM:
+        case Format::R16G16B16A16_UNORM:
+        case Format::R16G16B16A16_SINT:
+        case Format::R16G16B16A16_UINT:
+            return 8u;
+        case Format::R16G16B16_SFLOAT:
+        case Format::R16G16B16_SNORM:
+        case Format::R16G16B16_UNORM:
+        case Format::R16G16B16_SINT:
+        case Format::R16G16B16_UINT:
+            return 6u;
+        case Format::R32_SFLOAT:
+        case Format::R32_UINT:
+        case Format::R32_SINT:
+        case Format::R16G16_SFLOAT:
+        case Format::R16G16_SNORM:
+        case Format::R16G16_UNORM:
+        case Format::R16G16_SINT:
+        case Format::R16G16_UINT:
+        case Format::R8G8B8A8_SRGB:
+        case Format::R8G8B8A8_SSCALED:
+        case Format::R8G8B8A8_USCALED:
+        case Format::R8G8B8A8_SNORM:
+        case Format::R8G8B8A8_UNORM:
+        case Format::R8G8B8A8_SINT:
+        case Format::R8G8B8A8_UINT:
+        case Format::B8G8R8A8_SRGB:
+        case Format::B8G8R8A8_SSCALED:
+        case Format::B8G8R8A8_USCALED:
+        case Format::B8G8R8A8_SNORM:
+        case Format::B8G8R8A8_UNORM:
+        case Format::B8G8R8A8_SINT:
+        case Format::B8G8R8A8_UINT:
+            return 4u;
+        case Format::R8G8B8_SRGB:
+        case Format::R8G8B8_SSCALED:
+        case Format::R8G8B8_USCALED:
+        case Format::R8G8B8_SNORM:
+        case Format::R8G8B8_UNORM:
+        case Format::R8G8B8_SINT:
+        case Format::R8G8B8_UINT:
+        case Format::B8G8R8_SRGB:
+        case Format::B8G8R8_SSCALED:
+        case Format::B8G8R8_USCALED:
+        case Format::B8G8R8_SNORM:
+        case Format::B8G8R8_UNORM:
+        case Format::B8G8R8_SINT:
+        case Format::B8G8R8_UINT:
+            return 3u;
+        case Format::R16_SFLOAT:
+        case Format::R16_SNORM:
+        case Format::R16_UNORM:
+        case Format::R16_SINT:
+        case Format::R16_UINT:
+        case Format::R8G8_SRGB:
+        case Format::R8G8_SSCALED:
+        case Format::R8G8_USCALED:
+        case Format::R8G8_SNORM:
+        case Format::R8G8_UNORM:
+        case Format::R8G8_SINT:
+        case Format::R8G8_UINT:
+            return 2u;
+        case Format::R8_SRGB:
+        case Format::R8_SSCALED:
+        case Format::R8_USCALED:
+        case Format::R8_SNORM:
+        case Format::R8_UNORM:
+        case Format::R8_SINT:
+        case Format::R8_UINT:
+            return 1u;
+        default:
+            return 0;
+    }
+}
+
 enum class Usage
 {
     DEFAULT  = 0, // no CPU access, GPU read/write
@@ -187,7 +284,8 @@ enum TextureFlagsMask
 {
     DEFAULT       = 1 << 0,
     RENDER_TARGET = 1 << 1,
-    COMPUTE       = 1 << 2
+    COMPUTE       = 1 << 2,
+    TRANSIENT     = 1 << 3 // Render target whose memory other transient textures can alias, never dedicated.
 };
 
 struct TextureDescriptor
@@ -211,11 +309,16 @@ struct TextureDescriptor
     TextureType type      = TextureType::TEXTURE_TYPE_2D;
     std::string name;
 
+    // Transient texture whose memory is reused when it fits, the contents of both are undefined after the other one
+    // is written. The alias must outlive the texture. Falls back to its own memory when the requirements differ.
+    TextureHandle alias = INVALID_TEXTURE;
+
     TextureDescriptor& SetSize(u16 InWidth, u16 InHeight, u16 InDepth);
     TextureDescriptor& SetFlags(u8 InMipmaps, u8 InFlags);
     TextureDescriptor& SetFormatType(Format InFormat, TextureType InType);
     TextureDescriptor& SetName(std::string InName);
     TextureDescriptor& SetData(void* InData);
+    TextureDescriptor& SetAlias(TextureHandle InHandle);
 };
 
 } // namespace Renderer